@@ -39,6 +39,48 @@ def generate_noise(filename, duration=2.0, volume=0.3, sample_rate=48000):
             value = int(volume * 32767.0 * (random.random() * 2.0 - 1.0))
             wav_file.writeframes(struct.pack('<h', value))
 
+def generate_impulse_response(filename, duration=2.0, rt60=1.5, reflections=8, modes=(), seed=1, sample_rate=48000):
+    """Stereo reverb impulse response: a few early reflections, then a dense
+    noise tail decaying by 60 dB over rt60 and darkening as it goes, plus
+    optional ringing modes as (frequency, rt60, level)."""
+    print(f"Generating {filename}...")
+    rng = random.Random(seed)
+    num_samples = int(duration * sample_rate)
+    os.makedirs(os.path.dirname(filename), exist_ok=True)
+
+    decay = math.log(1000.0) / (rt60 * sample_rate)
+    early = [(rng.randint(int(0.005 * sample_rate), int(0.08 * sample_rate)), rng.uniform(0.2, 0.6),
+              rng.choice((-1.0, 1.0)), rng.choice((-1.0, 1.0))) for _ in range(reflections)]
+    tail_start = int(0.02 * sample_rate)
+    lp = [0.0, 0.0]
+    frames = []
+    for i in range(num_samples):
+        env = math.exp(-decay * i)
+        # The one-pole closes from bright to dark over the tail.
+        coeff = min(0.9, 0.2 + 0.7 * i / num_samples)
+        out = [0.0, 0.0]
+        for c in range(2):
+            noise = rng.uniform(-1.0, 1.0) if i >= tail_start else 0.0
+            lp[c] = noise + coeff * (lp[c] - noise)
+            out[c] = 0.25 * lp[c] * env
+        for freq, mode_rt60, level in modes:
+            ring = level * math.exp(-math.log(1000.0) * i / (mode_rt60 * sample_rate))
+            out[0] += ring * math.sin(2.0 * math.pi * freq * i / sample_rate)
+            out[1] += ring * math.sin(2.0 * math.pi * freq * 1.003 * i / sample_rate + 0.7)
+        frames.append(out)
+    frames[0] = [0.8, 0.8]
+    for pos, gain, sign_l, sign_r in early:
+        frames[pos][0] += gain * sign_l
+        frames[pos][1] += gain * sign_r
+
+    peak = max(max(abs(l), abs(r)) for l, r in frames)
+    with wave.open(filename, 'w') as wav_file:
+        wav_file.setnchannels(2)
+        wav_file.setsampwidth(2)
+        wav_file.setframerate(sample_rate)
+        wav_file.writeframes(b"".join(struct.pack('<hh', int(32767.0 * l / peak), int(32767.0 * r / peak))
+                                      for l, r in frames))
+
 # Base path
 base_path = "assets/stems"
 
@@ -62,4 +104,9 @@ generate_sine_wave(f"{base_path}/sleep/engine_thrum.wav", frequency=55, duration
 generate_noise(f"{base_path}/sleep/ventilation.wav", duration=4.0, volume=0.1)
 generate_noise(f"{base_path}/sleep/hull_creak.wav", duration=1.0, volume=0.05)
 
+# Impulse responses for the convolution reverb (a mood's dsp.reverb_ir)
+generate_impulse_response("assets/ir/cave.wav", duration=3.0, rt60=2.6, reflections=12, seed=7)
+generate_impulse_response("assets/ir/hull.wav", duration=1.8, rt60=1.4, reflections=6,
+                          modes=((92.0, 1.2, 0.04), (187.0, 0.9, 0.03), (413.0, 0.6, 0.02)), seed=11)
+
 print("Placeholder assets generated.")
@@ -0,0 +1,320 @@
+#include "asset_pack.h"
+#include "../util/logger.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace audio {
+
+namespace {
+// File layout (little-endian, as every supported host is):
+//   Header, at 0
+//   blobs, each at a multiple of kAlignment
+//   IndexRecord[entryCount], then the names they point at
+constexpr char kMagic[4] = {'K', 'P', 'A', 'K'};
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t engineRate;
+    uint32_t entryCount;
+    uint64_t indexOffset;
+    uint64_t indexSize;
+    uint64_t fileSize;
+    uint8_t reserved[24];
+};
+static_assert(sizeof(Header) == 64, "kpak header is 64 bytes");
+
+struct IndexRecord {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t frames;
+    uint64_t contentHash;
+    uint64_t sourceBytes;
+    int64_t sourceMtime;
+    uint32_t sampleRate;
+    uint16_t channels;
+    uint8_t kind;
+    uint8_t format;
+    uint32_t nameOffset; // from the end of the records
+    uint32_t nameLength;
+    uint32_t sourceOffset; // likewise; sourceLength 0 when it is the name
+    uint32_t sourceLength;
+};
+static_assert(sizeof(IndexRecord) == 72, "kpak index records are 72 bytes");
+
+size_t alignUp(size_t v) { return (v + AssetPack::kAlignment - 1) / AssetPack::kAlignment * AssetPack::kAlignment; }
+
+size_t bytesPerSample(SampleFormat format) {
+    return format == SampleFormat::Int16 ? 2 : format == SampleFormat::Int24 ? 3 : 4;
+}
+
+// Size and last write time of a source file; false if it is not on disk.
+bool statSource(const std::string &path, uint64_t &bytes, int64_t &mtime) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    const auto time = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    bytes = size;
+    mtime = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+std::mutex g_mountMutex;
+std::vector<std::shared_ptr<const AssetPack>> g_mounted; // newest last
+} // namespace
+
+bool AssetPack::isPackPath(const std::string &path) {
+    return path.size() > 5 && path.compare(path.size() - 5, 5, ".kpak") == 0;
+}
+
+std::shared_ptr<AssetPack> AssetPack::open(const std::string &path) {
+    std::shared_ptr<AssetPack> pack(new AssetPack());
+    pack->path_ = path;
+    if (!pack->file_.open(path, MappedFile::Access::Normal)) {
+        util::logError("AssetPack: Failed to open " + path);
+        return nullptr;
+    }
+    const uint8_t *base = pack->file_.data();
+    const size_t size = pack->file_.size();
+
+    Header header{};
+    if (size < sizeof(header)) {
+        util::logError("AssetPack: Truncated pack " + path);
+        return nullptr;
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+        util::logError("AssetPack: Not a version " + std::to_string(kVersion) + " pack: " + path);
+        return nullptr;
+    }
+    const uint64_t recordBytes = static_cast<uint64_t>(header.entryCount) * sizeof(IndexRecord);
+    if (header.fileSize != size || header.indexOffset > size || header.indexSize > size - header.indexOffset ||
+        recordBytes > header.indexSize) {
+        util::logError("AssetPack: Corrupt index in " + path);
+        return nullptr;
+    }
+    pack->engineRate_ = header.engineRate;
+    pack->indexOffset_ = header.indexOffset;
+
+    const uint8_t *records = base + header.indexOffset;
+    const uint8_t *names = records + recordBytes;
+    const uint64_t namesSize = header.indexSize - recordBytes;
+    pack->entries_.reserve(header.entryCount);
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        IndexRecord rec{};
+        std::memcpy(&rec, records + i * sizeof(IndexRecord), sizeof(rec));
+        const bool badName = static_cast<uint64_t>(rec.nameOffset) + rec.nameLength > namesSize ||
+                             static_cast<uint64_t>(rec.sourceOffset) + rec.sourceLength > namesSize;
+        const bool badBlob = rec.offset > header.indexOffset || rec.size > header.indexOffset - rec.offset;
+        const bool badKind = rec.kind > static_cast<uint8_t>(Kind::Sample) ||
+                             rec.format > static_cast<uint8_t>(SampleFormat::Float32);
+        Entry entry;
+        entry.kind = static_cast<Kind>(rec.kind);
+        entry.format = static_cast<SampleFormat>(rec.format);
+        const bool badSample = !badKind && entry.kind == Kind::Sample &&
+                               (rec.channels == 0 || rec.frames * rec.channels * bytesPerSample(entry.format) != rec.size);
+        if (badName || badBlob || badKind || badSample) {
+            util::logError("AssetPack: Corrupt entry " + std::to_string(i) + " in " + path);
+            return nullptr;
+        }
+        entry.name.assign(reinterpret_cast<const char *>(names + rec.nameOffset), rec.nameLength);
+        entry.source.assign(reinterpret_cast<const char *>(names + rec.sourceOffset), rec.sourceLength);
+        entry.channels = rec.channels;
+        entry.sampleRate = rec.sampleRate;
+        entry.frames = rec.frames;
+        entry.contentHash = rec.contentHash;
+        entry.sourceBytes = rec.sourceBytes;
+        entry.sourceMtime = rec.sourceMtime;
+        entry.data = base + rec.offset;
+        entry.size = static_cast<size_t>(rec.size);
+        pack->entries_.push_back(std::move(entry));
+    }
+
+    util::logInfo("AssetPack: Mapped " + path + " (" + std::to_string(pack->entries_.size()) + " entries, " +
+                  std::to_string(size >> 10) + " KiB, " + std::to_string(pack->engineRate_) + " Hz)");
+    return pack;
+}
+
+const AssetPack::Entry *AssetPack::find(const std::string &name) const {
+    for (const auto &entry : entries_) {
+        if (entry.name == name) return &entry;
+    }
+    return nullptr;
+}
+
+const AssetPack::Entry *AssetPack::moods() const {
+    for (const auto &entry : entries_) {
+        if (entry.kind == Kind::Moods) return &entry;
+    }
+    return nullptr;
+}
+
+bool AssetPack::sourcesMatch(std::string *name) {
+    std::vector<size_t> moved; // unchanged sources with a new write time
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        Entry &entry = entries_[i];
+        uint64_t bytes = 0;
+        int64_t mtime = 0;
+        if (entry.sourceMtime == 0 || !statSource(entry.sourcePath(), bytes, mtime)) continue;
+        bool same = bytes == entry.sourceBytes;
+        if (same && (entry.kind != Kind::Sample || mtime != entry.sourceMtime)) {
+            MappedFile source;
+            same = source.open(entry.sourcePath());
+            if (same && entry.kind == Kind::Sample) {
+                same = SampleCache::hashBytes(source.data(), source.size()) == entry.contentHash;
+            } else if (same) {
+                same = source.size() == entry.size && std::memcmp(source.data(), entry.data, entry.size) == 0;
+            }
+        }
+        if (!same) {
+            if (name) *name = entry.sourcePath();
+            return false;
+        }
+        if (mtime != entry.sourceMtime) {
+            entry.sourceMtime = mtime;
+            moved.push_back(i);
+        }
+    }
+
+    // Best effort: a read-only install just hashes again next time.
+    if (!moved.empty()) {
+        std::fstream file(path_, std::ios::binary | std::ios::in | std::ios::out);
+        for (size_t i : moved) {
+            const int64_t mtime = entries_[i].sourceMtime;
+            file.seekp(static_cast<std::streamoff>(indexOffset_ + i * sizeof(IndexRecord) +
+                                                   offsetof(IndexRecord, sourceMtime)));
+            file.write(reinterpret_cast<const char *>(&mtime), sizeof(mtime));
+        }
+        if (file) {
+            util::logInfo("AssetPack: Stamped " + std::to_string(moved.size()) + " unchanged source(s) in " + path_);
+        }
+    }
+    return true;
+}
+
+void AssetPack::prefault(const Entry &entry) const { file_.prefault(entry.data, entry.size); }
+
+void AssetPack::mount(std::shared_ptr<const AssetPack> pack) {
+    if (!pack) return;
+    std::lock_guard<std::mutex> lock(g_mountMutex);
+    for (const auto &mounted : g_mounted) {
+        if (mounted == pack) return;
+    }
+    g_mounted.push_back(std::move(pack));
+}
+
+const AssetPack::Entry *AssetPack::findMounted(const std::string &name, std::shared_ptr<const AssetPack> *owner) {
+    std::lock_guard<std::mutex> lock(g_mountMutex);
+    for (auto it = g_mounted.rbegin(); it != g_mounted.rend(); ++it) {
+        if (const Entry *entry = (*it)->find(name)) {
+            if (owner) *owner = *it;
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+bool AssetPack::findText(const std::string &name, std::string &out) {
+    std::shared_ptr<const AssetPack> owner;
+    const Entry *entry = findMounted(name, &owner);
+    if (entry == nullptr || entry->kind == Kind::Sample) return false;
+    out.assign(reinterpret_cast<const char *>(entry->data), entry->size);
+    return true;
+}
+
+void AssetPackWriter::addMoods(const std::string &name, std::string json) {
+    items_.push_back(Item{name, AssetPack::Kind::Moods, std::move(json), nullptr, {}});
+}
+
+void AssetPackWriter::addJson(const std::string &name, std::string json, const std::string &source) {
+    items_.push_back(Item{name, AssetPack::Kind::Json, std::move(json), nullptr,
+                          source == name ? std::string() : source});
+}
+
+void AssetPackWriter::addSample(const std::string &name, SampleRef sample) {
+    if (sample) items_.push_back(Item{name, AssetPack::Kind::Sample, {}, std::move(sample), {}});
+}
+
+bool AssetPackWriter::write(const std::string &path, size_t *bytesWritten) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        util::logError("AssetPackWriter: Cannot write " + path);
+        return false;
+    }
+
+    std::vector<IndexRecord> records;
+    std::string names;
+    std::unordered_map<const SampleBuffer *, uint64_t> written; // shared buffers are stored once
+    size_t pos = alignUp(sizeof(Header));
+    const std::vector<uint8_t> zeros(AssetPack::kAlignment, 0);
+    out.write(reinterpret_cast<const char *>(zeros.data()), static_cast<std::streamsize>(pos));
+
+    for (const auto &item : items_) {
+        IndexRecord rec{};
+        rec.kind = static_cast<uint8_t>(item.kind);
+        rec.nameOffset = static_cast<uint32_t>(names.size());
+        rec.nameLength = static_cast<uint32_t>(item.name.size());
+        names += item.name;
+        rec.sourceOffset = static_cast<uint32_t>(names.size());
+        rec.sourceLength = static_cast<uint32_t>(item.source.size());
+        names += item.source;
+        statSource(item.source.empty() ? item.name : item.source, rec.sourceBytes, rec.sourceMtime);
+
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(item.text.data());
+        size_t size = item.text.size();
+        if (item.sample) {
+            const SampleBuffer &s = *item.sample;
+            rec.format = static_cast<uint8_t>(s.format);
+            rec.channels = s.channels;
+            rec.sampleRate = s.sampleRate;
+            rec.frames = s.frames;
+            rec.contentHash = s.contentHash;
+            rec.sourceBytes = s.sourceBytes;
+            data = s.data();
+            size = s.frames * s.channels * s.bytesPerSample();
+        }
+        rec.size = size;
+
+        auto seen = item.sample ? written.find(item.sample.get()) : written.end();
+        if (seen != written.end()) {
+            rec.offset = seen->second;
+        } else {
+            rec.offset = pos;
+            if (item.sample) written.emplace(item.sample.get(), pos);
+            out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+            const size_t padded = alignUp(size);
+            out.write(reinterpret_cast<const char *>(zeros.data()), static_cast<std::streamsize>(padded - size));
+            pos += padded;
+        }
+        records.push_back(rec);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = AssetPack::kVersion;
+    header.engineRate = engineRate_;
+    header.entryCount = static_cast<uint32_t>(records.size());
+    header.indexOffset = pos;
+    header.indexSize = records.size() * sizeof(IndexRecord) + names.size();
+    header.fileSize = pos + header.indexSize;
+    out.write(reinterpret_cast<const char *>(records.data()),
+              static_cast<std::streamsize>(records.size() * sizeof(IndexRecord)));
+    out.write(names.data(), static_cast<std::streamsize>(names.size()));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        util::logError("AssetPackWriter: Write failed for " + path);
+        return false;
+    }
+    if (bytesWritten) *bytesWritten = static_cast<size_t>(header.fileSize);
+    return true;
+}
+
+} // namespace audio
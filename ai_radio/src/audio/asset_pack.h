@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "sample_cache.h"
+#include "sample_storage.h"
+
+namespace audio {
+
+// A mood pack baked into one file (.kpak) by keegan_pack: the mood and
+// story JSON plus every stem and story clip, already resampled to the
+// engine rate and laid out exactly as SampleBuffer holds them (planar, at
+// native width). Blobs are page aligned, so at runtime the file is mapped
+// and players read straight from it: no parsing, decoding or conversion.
+//
+// Mounted packs are consulted by SampleCache, MoodLoader and StoryBank
+// before the filesystem, under the same paths the JSON uses.
+class AssetPack {
+public:
+    static constexpr uint32_t kVersion = 5;
+    static constexpr size_t kAlignment = 4096;
+
+    enum class Kind : uint8_t {
+        Moods,  // the mood pack JSON (one per file)
+        Json,   // other config, e.g. stories.json
+        Sample
+    };
+
+    struct Entry {
+        std::string name;   // path as written in the JSON
+        std::string source; // file it was baked from, when not name
+        Kind kind = Kind::Json;
+        SampleFormat format = SampleFormat::Int16;
+        uint16_t channels = 0;
+        uint32_t sampleRate = 0;
+        uint64_t frames = 0;
+        uint64_t contentHash = 0; // SampleBuffer::contentHash when baked
+        uint64_t sourceBytes = 0; // size of the source file when baked
+        int64_t sourceMtime = 0;  // its last write time then; 0 if it was not on disk
+
+        const std::string &sourcePath() const { return source.empty() ? name : source; }
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+    };
+
+    static bool isPackPath(const std::string &path);
+
+    // Maps and validates a pack. Returns nullptr (and logs) on failure.
+    static std::shared_ptr<AssetPack> open(const std::string &path);
+
+    const std::string &path() const { return path_; }
+    uint32_t engineRate() const { return engineRate_; }
+    const std::vector<Entry> &entries() const { return entries_; }
+    const Entry *find(const std::string &name) const;
+    const Entry *moods() const;
+
+    // Finds an entry whose source file is still on disk but no longer what
+    // was baked, so a pack left over from before an edit is not used in its
+    // place. JSON is compared byte for byte; a sample whose size matches but
+    // whose write time moved (a fresh checkout, say) is hashed, and if it
+    // is unchanged its new write time is stamped into the pack so the next
+    // check skips it. Entries whose source is gone are fine: a pack may ship
+    // without them. Returns false and sets *name to the first stale source.
+    bool sourcesMatch(std::string *name = nullptr);
+
+    // Faults in (and, with SampleStorage page locking on, locks) an entry's
+    // pages, so the audio thread never waits on the disk for them.
+    void prefault(const Entry &entry) const;
+
+    // Process-wide list of packs to look in. Thread-safe.
+    static void mount(std::shared_ptr<const AssetPack> pack);
+    // The newest mounted entry named name, or nullptr; owner keeps the
+    // mapping alive for as long as the entry is used.
+    static const Entry *findMounted(const std::string &name, std::shared_ptr<const AssetPack> *owner = nullptr);
+    static bool findText(const std::string &name, std::string &out);
+
+private:
+    AssetPack() = default;
+
+    std::string path_;
+    MappedFile file_;
+    uint32_t engineRate_ = 0;
+    uint64_t indexOffset_ = 0;
+    std::vector<Entry> entries_;
+};
+
+// Builds a .kpak file (keegan_pack). Samples are written as they are held,
+// so pass buffers already at the engine rate.
+class AssetPackWriter {
+public:
+    explicit AssetPackWriter(uint32_t engineRate) : engineRate_(engineRate) {}
+
+    void addMoods(const std::string &name, std::string json);
+    // source is the file the JSON was read from, when it is stored under
+    // another name (stories baked from --stories, say).
+    void addJson(const std::string &name, std::string json, const std::string &source = {});
+    void addSample(const std::string &name, SampleRef sample);
+
+    size_t entries() const { return items_.size(); }
+
+    // Writes the pack; identical samples under several names are stored
+    // once. Logs and returns false on failure.
+    bool write(const std::string &path, size_t *bytesWritten = nullptr) const;
+
+private:
+    struct Item {
+        std::string name;
+        AssetPack::Kind kind = AssetPack::Kind::Json;
+        std::string text;
+        SampleRef sample;
+        std::string source;
+    };
+
+    uint32_t engineRate_;
+    std::vector<Item> items_;
+};
+
+} // namespace audio
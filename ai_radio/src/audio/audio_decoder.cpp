@@ -0,0 +1,168 @@
+#include "audio_decoder.h"
+#include "../util/logger.h"
+#include "../../vendor/miniaudio.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace audio {
+
+namespace {
+std::string extensionOf(const std::string &path) {
+    const size_t dot = path.find_last_of('.');
+    const size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return {};
+    std::string ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    return ext;
+}
+
+ma_encoding_format encodingFor(const std::string &path) {
+    const std::string ext = extensionOf(path);
+    if (ext == "flac") return ma_encoding_format_flac;
+    if (ext == "mp3") return ma_encoding_format_mp3;
+    if (ext == "ogg" || ext == "oga") return ma_encoding_format_vorbis;
+    return ma_encoding_format_unknown;
+}
+
+// Bits per sample from a FLAC STREAMINFO block (always the first metadata
+// block), or 0 if the header is not where it should be.
+uint16_t flacBitsPerSample(const uint8_t *header, size_t size) {
+    if (size < 26 || std::memcmp(header, "fLaC", 4) != 0 || (header[4] & 0x7f) != 0) return 0;
+    return static_cast<uint16_t>((((header[20] & 0x01) << 4) | (header[21] >> 4)) + 1);
+}
+} // namespace
+
+struct AudioDecoder::Impl {
+    ma_decoder decoder{};
+    bool open = false;
+    // 24-bit output: miniaudio's FLAC backend would go through float for
+    // s24, so it decodes s32 here and read() keeps the top three bytes.
+    bool pack24 = false;
+    std::vector<int32_t> wide;
+};
+
+AudioDecoder::AudioDecoder() : impl_(std::make_unique<Impl>()) {}
+
+AudioDecoder::~AudioDecoder() { close(); }
+
+bool AudioDecoder::handles(const std::string &path) { return encodingFor(path) != ma_encoding_format_unknown; }
+
+bool AudioDecoder::vorbisAvailable() {
+#if __has_include("../../vendor/stb_vorbis.c")
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool AudioDecoder::open(const std::string &path, Output output) {
+    close();
+    return init(path, output == Output::Native);
+}
+
+bool AudioDecoder::open(const uint8_t *data, size_t size, const std::string &path, Output output) {
+    close();
+    memory_ = data;
+    memorySize_ = size;
+    return init(path, output == Output::Native);
+}
+
+bool AudioDecoder::init(const std::string &path, bool native) {
+    if (encodingFor(path) == ma_encoding_format_vorbis && !vorbisAvailable()) {
+        util::logError("AudioDecoder: Ogg Vorbis support not built (add vendor/stb_vorbis.c): " + path);
+        return false;
+    }
+    // Lossy codecs decode to float anyway; FLAC up to 16 bits stays 16-bit
+    // and up to 24 bits stays packed 24-bit.
+    ma_format format = ma_format_f32;
+    if (native && encodingFor(path) == ma_encoding_format_flac) {
+        uint8_t header[26] = {};
+        size_t got = 0;
+        if (memory_) {
+            got = std::min(memorySize_, sizeof(header));
+            std::memcpy(header, memory_, got);
+        } else {
+            std::ifstream file(path, std::ios::binary);
+            file.read(reinterpret_cast<char *>(header), sizeof(header));
+            got = static_cast<size_t>(file.gcount());
+        }
+        const uint16_t bits = flacBitsPerSample(header, got);
+        if (bits > 0 && bits <= 16) {
+            format = ma_format_s16;
+        } else if (bits > 16 && bits <= 24) {
+            format = ma_format_s32;
+            impl_->pack24 = true;
+        }
+    }
+    ma_decoder_config config = ma_decoder_config_init(format, 0, 0);
+    config.encodingFormat = encodingFor(path);
+    const ma_result result = memory_ ? ma_decoder_init_memory(memory_, memorySize_, &config, &impl_->decoder)
+                                     : ma_decoder_init_file(path.c_str(), &config, &impl_->decoder);
+    if (result != MA_SUCCESS) {
+        util::logError("AudioDecoder: Cannot decode " + path + " (" + ma_result_description(result) + ")");
+        return false;
+    }
+    impl_->open = true;
+    bitsPerSample_ = impl_->pack24 ? 24 : impl_->decoder.outputFormat == ma_format_s16 ? 16 : 32;
+    channels_ = static_cast<uint16_t>(impl_->decoder.outputChannels);
+    sampleRate_ = impl_->decoder.outputSampleRate;
+
+    ma_uint64 length = 0;
+    frames_ = ma_decoder_get_length_in_pcm_frames(&impl_->decoder, &length) == MA_SUCCESS ? length : 0;
+    if (channels_ == 0 || sampleRate_ == 0) {
+        util::logError("AudioDecoder: Invalid channel count or rate: " + path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AudioDecoder::close() {
+    if (impl_->open) ma_decoder_uninit(&impl_->decoder);
+    impl_->open = false;
+    impl_->pack24 = false;
+    impl_->wide.clear();
+    impl_->wide.shrink_to_fit();
+    memory_ = nullptr;
+    memorySize_ = 0;
+    channels_ = 0;
+    sampleRate_ = 0;
+    bitsPerSample_ = 0;
+    frames_ = 0;
+}
+
+size_t AudioDecoder::read(void *out, size_t frames) {
+    if (!impl_->open) return 0;
+    ma_uint64 got = 0;
+    if (impl_->pack24) {
+        impl_->wide.resize(frames * channels_);
+        const ma_result result = ma_decoder_read_pcm_frames(&impl_->decoder, impl_->wide.data(), frames, &got);
+        if (result != MA_SUCCESS && result != MA_AT_END) {
+            util::logError(std::string("AudioDecoder: Read failed (") + ma_result_description(result) + ")");
+        }
+        // Little-endian packed 24-bit: bytes 1..3 of each left-justified
+        // 32-bit sample.
+        uint8_t *dst = static_cast<uint8_t *>(out);
+        for (size_t i = 0; i < static_cast<size_t>(got) * channels_; ++i) {
+            const uint32_t v = static_cast<uint32_t>(impl_->wide[i]);
+            dst[3 * i] = static_cast<uint8_t>(v >> 8);
+            dst[3 * i + 1] = static_cast<uint8_t>(v >> 16);
+            dst[3 * i + 2] = static_cast<uint8_t>(v >> 24);
+        }
+        return static_cast<size_t>(got);
+    }
+    const ma_result result = ma_decoder_read_pcm_frames(&impl_->decoder, out, frames, &got);
+    if (result != MA_SUCCESS && result != MA_AT_END) {
+        util::logError(std::string("AudioDecoder: Read failed (") + ma_result_description(result) + ")");
+    }
+    return static_cast<size_t>(got);
+}
+
+bool AudioDecoder::rewind() {
+    return impl_->open && ma_decoder_seek_to_pcm_frame(&impl_->decoder, 0) == MA_SUCCESS;
+}
+
+} // namespace audio
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace audio {
+
+// Compressed audio (FLAC, MP3, and Ogg Vorbis when stb_vorbis.c is in
+// vendor/) through miniaudio's decoders. Output is interleaved, either as
+// compact as the source allows (16-bit PCM for FLAC of up to 16 bits,
+// packed 24-bit for FLAC of up to 24, float otherwise) or always as float.
+//
+// One decoder per thread; not for the audio thread.
+class AudioDecoder {
+public:
+    enum class Output : uint8_t {
+        Native,  // 16- or packed 24-bit where lossless, else float
+        Float32
+    };
+
+    AudioDecoder();
+    ~AudioDecoder();
+
+    AudioDecoder(const AudioDecoder &) = delete;
+    AudioDecoder &operator=(const AudioDecoder &) = delete;
+
+    // True if path has an extension this decoder handles (.flac, .mp3,
+    // .ogg/.oga). Everything else is read as WAV.
+    static bool handles(const std::string &path);
+    // Whether Ogg Vorbis support was compiled in.
+    static bool vorbisAvailable();
+
+    // Opens a file from disk or from memory that outlives the decoder.
+    // Logs and returns false on failure.
+    bool open(const std::string &path, Output output);
+    bool open(const uint8_t *data, size_t size, const std::string &path, Output output);
+    void close();
+
+    uint16_t channels() const { return channels_; }
+    uint32_t sampleRate() const { return sampleRate_; }
+    // 16 (int16), 24 (packed little-endian, 3 bytes) or 32 (float), per
+    // Output.
+    uint16_t bitsPerSample() const { return bitsPerSample_; }
+    // Frames per channel; 0 when the codec cannot tell without decoding.
+    uint64_t frames() const { return frames_; }
+
+    // Reads up to `frames` interleaved frames into out. Returns the frames
+    // read; fewer means the end of the file (or an error, logged).
+    size_t read(void *out, size_t frames);
+    // Back to the first frame.
+    bool rewind();
+
+private:
+    bool init(const std::string &path, bool native);
+
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+    const uint8_t *memory_ = nullptr;
+    size_t memorySize_ = 0;
+    uint16_t channels_ = 0;
+    uint32_t sampleRate_ = 0;
+    uint16_t bitsPerSample_ = 0;
+    uint64_t frames_ = 0;
+};
+
+} // namespace audio
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "simd/simd.h"
+
+namespace audio {
+
+// Planar multichannel buffer: each channel is its own contiguous run of
+// floats, so per-channel kernels stream through memory and vectorize
+// without de-interleaving. Storage is allocated once (allocate) and reused;
+// nothing here allocates on the audio thread.
+class AudioBus {
+public:
+    static constexpr size_t kMaxChannels = 8;
+
+    AudioBus() = default;
+    AudioBus(size_t channels, size_t capacityFrames) { allocate(channels, capacityFrames); }
+
+    // Not real-time safe.
+    void allocate(size_t channels, size_t capacityFrames) {
+        channels_ = std::min(channels, kMaxChannels);
+        capacity_ = capacityFrames;
+        // Pad each channel to a 64-byte multiple so channel starts keep the
+        // allocation's alignment.
+        stride_ = (capacityFrames + 15) & ~size_t(15);
+        data_.assign(channels_ * stride_, 0.0f);
+    }
+
+    size_t channels() const { return channels_; }
+    size_t capacity() const { return capacity_; }
+
+    float *channel(size_t c) { return data_.data() + c * stride_; }
+    const float *channel(size_t c) const { return data_.data() + c * stride_; }
+
+    void clear(size_t frames) {
+        for (size_t c = 0; c < channels_; ++c) std::fill(channel(c), channel(c) + frames, 0.0f);
+    }
+
+private:
+    size_t channels_ = 0;
+    size_t capacity_ = 0;
+    size_t stride_ = 0;
+    std::vector<float> data_;
+};
+
+// dst[c] = src[c] for the first `frames` frames of every channel.
+inline void copyBus(const AudioBus &src, AudioBus &dst, size_t frames) {
+    const size_t channels = std::min(src.channels(), dst.channels());
+    for (size_t c = 0; c < channels; ++c) {
+        std::copy(src.channel(c), src.channel(c) + frames, dst.channel(c));
+    }
+}
+
+// Adds a mono signal to every channel (centre-panned).
+inline void addMonoToBus(const float *mono, AudioBus &dst, size_t frames) {
+    const auto &k = simd::kernels();
+    for (size_t c = 0; c < dst.channels(); ++c) k.mixAdd(dst.channel(c), mono, 1.0f, frames);
+}
+
+// Sum of squares over `frames`, averaged across channels (divide by frames
+// for the mean square).
+inline float busSumSquares(const AudioBus &bus, size_t frames) {
+    if (bus.channels() == 0 || frames == 0) return 0.0f;
+    const auto &k = simd::kernels();
+    float sum = 0.0f;
+    for (size_t c = 0; c < bus.channels(); ++c) sum += k.sumSquares(bus.channel(c), frames);
+    return sum / static_cast<float>(bus.channels());
+}
+
+} // namespace audio
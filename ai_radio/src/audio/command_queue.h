@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace audio {
+
+// Bounded lock-free multi-producer/single-consumer ring (Vyukov sequence cells).
+// push() may be called from any thread; pop() only from the single consumer.
+// Neither side allocates, locks or blocks, so the consumer can be the audio
+// callback. push() returns false when the ring is full.
+template <typename T, size_t Capacity>
+class CommandQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "CommandQueue capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "CommandQueue payloads must be trivially copyable");
+
+public:
+    CommandQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    CommandQueue(const CommandQueue &) = delete;
+    CommandQueue &operator=(const CommandQueue &) = delete;
+
+    bool push(const T &value) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells_[pos & kMask];
+            const size_t seq = cell.seq.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer side only.
+    bool pop(T &out) {
+        Cell &cell = cells_[tail_ & kMask];
+        const size_t seq = cell.seq.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(tail_ + 1) < 0) {
+            return false; // empty
+        }
+        out = cell.value;
+        cell.seq.store(tail_ + Capacity, std::memory_order_release);
+        ++tail_;
+        return true;
+    }
+
+private:
+    static constexpr size_t kMask = Capacity - 1;
+
+    struct Cell {
+        std::atomic<size_t> seq{0};
+        T value{};
+    };
+
+    std::array<Cell, Capacity> cells_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) size_t tail_ = 0;
+};
+
+} // namespace audio
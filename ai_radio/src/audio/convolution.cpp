@@ -0,0 +1,334 @@
+#include "convolution.h"
+#include "sample_cache.h"
+#include "simd/simd.h"
+#include "../util/logger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace audio {
+
+namespace {
+// Energy (sum of squared taps, averaged over the channels) IRs are
+// normalised to; matches the FDN's wet level for the same reverb_wet.
+constexpr float kIrEnergy = 0.5f;
+
+constexpr size_t kLevelBlock[2] = {ConvolutionIr::kHeadFrames, ConvolutionIr::kLongBlock};
+constexpr size_t kLevelOffset[2] = {ConvolutionIr::kHeadFrames, ConvolutionIr::kLongOffset};
+} // namespace
+
+size_t ConvolutionIr::partitionsFor(size_t level, size_t taps) {
+    const size_t begin = kLevelOffset[level];
+    const size_t end = level == 0 ? std::min(taps, kLongOffset) : taps;
+    return end > begin ? (end - begin + kLevelBlock[level] - 1) / kLevelBlock[level] : 0;
+}
+
+bool ConvolutionIr::load(const std::string &path, float sampleRate, ConvolutionIr &out) {
+    SampleRef sample = SampleCache::instance().load(path, static_cast<uint32_t>(sampleRate));
+    if (!sample || sample->frames == 0 || sample->channels == 0) {
+        util::logWarn("Cannot load impulse response: " + path);
+        return false;
+    }
+    const size_t maxTaps = static_cast<size_t>(kMaxSeconds * sampleRate);
+    const size_t taps = std::min(sample->frames, maxTaps);
+    if (taps < sample->frames) {
+        util::logWarn("Impulse response " + path + " cut to " + std::to_string(static_cast<int>(kMaxSeconds)) + " s");
+    }
+
+    const auto &k = simd::kernels();
+    const size_t channels = std::min<size_t>(sample->channels, 2);
+    std::array<std::vector<float>, 2> taps32;
+    float energy = 0.0f;
+    for (size_t c = 0; c < channels; ++c) {
+        taps32[c].assign(taps, 0.0f);
+        const uint8_t *src = sample->channel(c);
+        switch (sample->format) {
+            case SampleFormat::Int16:
+                k.mixAddI16(taps32[c].data(), reinterpret_cast<const int16_t *>(src), 1.0f / 32768.0f, taps);
+                break;
+            case SampleFormat::Int24:
+                k.mixAddI24(taps32[c].data(), src, 1.0f / 8388608.0f, taps);
+                break;
+            case SampleFormat::Float32:
+                k.mixAdd(taps32[c].data(), reinterpret_cast<const float *>(src), 1.0f, taps);
+                break;
+        }
+        energy += k.sumSquares(taps32[c].data(), taps);
+    }
+    energy /= static_cast<float>(channels);
+    if (energy <= 0.0f) {
+        util::logWarn("Impulse response is silent: " + path);
+        return false;
+    }
+    const float gain = std::sqrt(kIrEnergy / energy);
+    for (size_t c = 0; c < channels; ++c) k.scaledCopy(taps32[c].data(), taps32[c].data(), gain, taps);
+
+    out.path = path;
+    out.build(taps32[0].data(), channels > 1 ? taps32[1].data() : nullptr, taps);
+    return true;
+}
+
+void ConvolutionIr::build(const float *left, const float *right, size_t taps) {
+    frames = taps;
+    const float *src[2] = {left, right ? right : left};
+    for (size_t c = 0; c < 2; ++c) {
+        head[c].assign(kHeadFrames, 0.0f);
+        for (size_t i = 0; i < std::min(taps, kHeadFrames); ++i) head[c][kHeadFrames - 1 - i] = src[c][i];
+    }
+    for (size_t l = 0; l < levels.size(); ++l) {
+        Level &level = levels[l];
+        level.block = kLevelBlock[l];
+        level.offset = kLevelOffset[l];
+        level.partitions = partitionsFor(l, taps);
+        const size_t bins = level.block + 1;
+        RealFft fft(2 * level.block);
+        std::vector<float> padded(2 * level.block);
+        // RealFft's inverse is scaled by size / 2; fold the correction in here.
+        const float scale = 1.0f / static_cast<float>(level.block);
+        const size_t end = l == 0 ? std::min(taps, kLongOffset) : taps;
+        for (size_t c = 0; c < 2; ++c) {
+            level.re[c].assign(level.partitions * bins, 0.0f);
+            level.im[c].assign(level.partitions * bins, 0.0f);
+            for (size_t p = 0; p < level.partitions; ++p) {
+                std::fill(padded.begin(), padded.end(), 0.0f);
+                const size_t first = level.offset + p * level.block;
+                const size_t count = std::min(level.block, end - first);
+                for (size_t i = 0; i < count; ++i) padded[i] = src[c][first + i] * scale;
+                fft.forward(padded.data(), level.re[c].data() + p * bins, level.im[c].data() + p * bins);
+            }
+        }
+    }
+}
+
+ConvolutionReverb::ConvolutionReverb(float sampleRate)
+    : sampleRate_(sampleRate),
+      wet_(0.0f),
+      ffts_{RealFft(2 * kLevelBlock[0]), RealFft(2 * kLevelBlock[1])} {
+    wet_.setTime(kGlideMs, sampleRate_);
+}
+
+void ConvolutionReverb::reserve(size_t maxTaps) {
+    reservedTaps_ = maxTaps;
+    current_ = 0;
+    fading_ = false;
+    clock_ = 0;
+    if (maxTaps == 0) {
+        input_ = {};
+        time_ = {};
+        lanes_ = {};
+        return;
+    }
+    input_.assign(2 * kInputRing, 0.0f);
+    time_.assign(2 * kLevelBlock[1], 0.0f);
+    for (Lane &lane : lanes_) {
+        lane.ir = nullptr;
+        for (size_t l = 0; l < lane.levels.size(); ++l) {
+            const size_t bins = kLevelBlock[l] + 1;
+            const size_t slots = std::max<size_t>(ConvolutionIr::partitionsFor(l, maxTaps), 1);
+            LevelState &st = lane.levels[l];
+            st.fdlRe.assign(slots * bins, 0.0f);
+            st.fdlIm.assign(slots * bins, 0.0f);
+            for (size_t c = 0; c < 2; ++c) {
+                st.accRe[c].assign(bins, 0.0f);
+                st.accIm[c].assign(bins, 0.0f);
+            }
+        }
+        for (auto &out : lane.out) out.assign(kOutputRing, 0.0f);
+    }
+}
+
+const ConvolutionIr *ConvolutionReverb::ir() const {
+    return fading_ ? lanes_[1 - current_].ir : lanes_[current_].ir;
+}
+
+void ConvolutionReverb::resetLane(Lane &lane, const ConvolutionIr *ir) {
+    lane.ir = ir;
+    if (!ir) return;
+    // Only the slots this IR uses can be read before they are rewritten.
+    for (size_t l = 0; l < lane.levels.size(); ++l) {
+        LevelState &st = lane.levels[l];
+        const size_t used = ir->levels[l].partitions * (kLevelBlock[l] + 1);
+        std::fill(st.fdlRe.begin(), st.fdlRe.begin() + used, 0.0f);
+        std::fill(st.fdlIm.begin(), st.fdlIm.begin() + used, 0.0f);
+        st.newest = 0;
+        st.started = false;
+    }
+    for (auto &out : lane.out) std::fill(out.begin(), out.end(), 0.0f);
+}
+
+void ConvolutionReverb::setIr(const ConvolutionIr *ir, size_t fadeFrames) {
+    if ((ir && ir->frames > reservedTaps_) || ir == this->ir()) return;
+    if (!ir) {
+        lanes_[0].ir = lanes_[1].ir = nullptr;
+        fading_ = false;
+        return;
+    }
+    if (fading_) {
+        lanes_[current_].ir = nullptr;
+        current_ = 1 - current_;
+        fading_ = false;
+    }
+    if (!lanes_[current_].ir) {
+        // process() stops feeding the input ring while no IR is set; start
+        // from silence rather than from input left over from the last IR.
+        std::fill(input_.begin(), input_.end(), 0.0f);
+        std::fill(time_.begin(), time_.end(), 0.0f);
+        clock_ = 0;
+    }
+    if (!lanes_[current_].ir || fadeFrames == 0) {
+        resetLane(lanes_[current_], ir);
+        return;
+    }
+    resetLane(lanes_[1 - current_], ir);
+    fading_ = true;
+    fadePos_ = 0;
+    fadeFrames_ = fadeFrames;
+}
+
+void ConvolutionReverb::laneOutput(Lane &lane, size_t n, float *left, float *right) {
+    const auto &k = simd::kernels();
+    const ConvolutionIr &ir = *lane.ir;
+    const size_t outMask = kOutputRing - 1;
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t t = clock_ + i;
+        // The head's window ends at t; the mirrored half keeps it contiguous
+        // across the wrap.
+        const float *window = input_.data() + ((t + 1 - kHead) & (kInputRing - 1));
+        const size_t slot = static_cast<size_t>(t) & outMask;
+        left[i] = k.dot(ir.head[0].data(), window, kHead) + lane.out[0][slot];
+        right[i] = k.dot(ir.head[1].data(), window, kHead) + lane.out[1][slot];
+        lane.out[0][slot] = 0.0f;
+        lane.out[1][slot] = 0.0f;
+    }
+}
+
+void ConvolutionReverb::stepLevel(Lane &lane, size_t l) {
+    const ConvolutionIr::Level &level = lane.ir->levels[l];
+    const size_t partitions = level.partitions;
+    if (partitions == 0) return;
+    const auto &k = simd::kernels();
+    LevelState &st = lane.levels[l];
+    const size_t block = level.block;
+    const size_t bins = block + 1;
+    // Work for a block is spread over its `steps` short blocks: the FFT of
+    // the input on the first, spectral products on the middle ones, the
+    // inverse FFTs on the last. Short partitions do it all in one step.
+    const size_t steps = block / kHead;
+    const size_t step = static_cast<size_t>(clock_ / kHead) % steps;
+
+    if (step == 0) {
+        // Overlap-save window: the last two blocks of input.
+        const float *window = input_.data() + ((clock_ - 2 * block) & (kInputRing - 1));
+        st.newest = st.newest + 1 == partitions ? 0 : st.newest + 1;
+        ffts_[l].forward(window, st.fdlRe.data() + st.newest * bins, st.fdlIm.data() + st.newest * bins);
+        for (size_t c = 0; c < 2; ++c) {
+            std::fill(st.accRe[c].begin(), st.accRe[c].end(), 0.0f);
+            std::fill(st.accIm[c].begin(), st.accIm[c].end(), 0.0f);
+        }
+        st.started = true;
+    }
+    if (!st.started) return;
+
+    size_t first = 0, last = partitions;
+    if (steps > 1) {
+        const size_t perStep = (partitions + steps - 3) / (steps - 2);
+        first = step == 0 ? partitions : std::min(partitions, (step - 1) * perStep);
+        last = step == 0 ? partitions : std::min(partitions, step * perStep);
+    }
+    for (size_t p = first; p < last; ++p) {
+        // Partition p meets the input block p blocks back.
+        const size_t slot = (st.newest + partitions - p) % partitions;
+        const float *xRe = st.fdlRe.data() + slot * bins;
+        const float *xIm = st.fdlIm.data() + slot * bins;
+        for (size_t c = 0; c < 2; ++c) {
+            k.complexMulAdd(st.accRe[c].data(), st.accIm[c].data(), xRe, xIm, level.re[c].data() + p * bins,
+                            level.im[c].data() + p * bins, bins);
+        }
+    }
+
+    if (step == steps - 1) {
+        // The block's input ended `step` short blocks ago; its output starts
+        // level.offset - block after that.
+        const uint64_t blockEnd = clock_ - step * kHead;
+        const uint64_t outStart = blockEnd - block + level.offset;
+        const size_t outMask = kOutputRing - 1;
+        for (size_t c = 0; c < 2; ++c) {
+            ffts_[l].inverse(st.accRe[c].data(), st.accIm[c].data(), time_.data());
+            const float *valid = time_.data() + block;
+            float *out = lane.out[c].data();
+            for (size_t i = 0; i < block; ++i) out[(outStart + i) & outMask] += valid[i];
+        }
+    }
+}
+
+void ConvolutionReverb::tick(Lane &lane) {
+    for (size_t l = 0; l < lane.levels.size(); ++l) stepLevel(lane, l);
+}
+
+void ConvolutionReverb::process(AudioBus &bus, size_t frames, float wetMix) {
+    const size_t channels = bus.channels();
+    if (frames == 0 || channels == 0 || !lanes_[current_].ir) return;
+
+    wet_.setTarget(std::clamp(wetMix, 0.0f, 1.0f));
+    const auto &k = simd::kernels();
+    float *left = bus.channel(0);
+    float *right = channels > 1 ? bus.channel(1) : nullptr;
+
+    for (size_t done = 0; done < frames;) {
+        // Chunks end on kHead boundaries, where the partitions step.
+        const size_t n = std::min(frames - done, kHead - static_cast<size_t>(clock_ % kHead));
+        float *l = left + done;
+        float *r = right ? right + done : nullptr;
+
+        for (size_t i = 0; i < n; ++i) {
+            const size_t pos = static_cast<size_t>(clock_ + i) & (kInputRing - 1);
+            input_[pos] = input_[pos + kInputRing] = r ? 0.5f * (l[i] + r[i]) : l[i];
+        }
+
+        Lane &cur = lanes_[current_];
+        laneOutput(cur, n, wetL_.data(), wetR_.data());
+        if (fading_) {
+            laneOutput(lanes_[1 - current_], n, laneL_.data(), laneR_.data());
+            for (size_t i = 0; i < n; ++i) {
+                const float g = std::min(1.0f, static_cast<float>(fadePos_ + i) / static_cast<float>(fadeFrames_));
+                wetL_[i] += g * (laneL_[i] - wetL_[i]);
+                wetR_[i] += g * (laneR_[i] - wetR_[i]);
+            }
+            fadePos_ += n;
+        }
+
+        if (wet_.settled()) {
+            const float wet = wet_.current();
+            k.crossfade(l, l, wetL_.data(), 1.0f - wet, wet, n);
+            if (r) k.crossfade(r, r, wetR_.data(), 1.0f - wet, wet, n);
+            for (size_t c = 2; c < channels; ++c) {
+                float *s = bus.channel(c) + done;
+                k.crossfade(s, s, wetL_.data(), 1.0f - wet, wet, n);
+            }
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                const float wet = wet_.next();
+                const float dry = 1.0f - wet;
+                l[i] = l[i] * dry + wetL_[i] * wet;
+                if (r) r[i] = r[i] * dry + wetR_[i] * wet;
+                for (size_t c = 2; c < channels; ++c) {
+                    float &s = bus.channel(c)[done + i];
+                    s = s * dry + wetL_[i] * wet;
+                }
+            }
+        }
+
+        clock_ += n;
+        done += n;
+        if (clock_ % kHead == 0) {
+            tick(cur);
+            if (fading_) tick(lanes_[1 - current_]);
+        }
+        if (fading_ && fadePos_ >= fadeFrames_) {
+            cur.ir = nullptr;
+            current_ = 1 - current_;
+            fading_ = false;
+        }
+    }
+}
+
+} // namespace audio
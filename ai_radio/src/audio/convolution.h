@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "bus.h"
+#include "fft.h"
+#include "smoother.h"
+
+namespace audio {
+
+// An impulse response prepared for ConvolutionReverb. The first kHeadFrames
+// taps are kept as a direct-form FIR. The rest is cut into uniform
+// partitions: kHeadFrames long up to kLongOffset, kLongBlock long after
+// that. Each partition is stored as the spectrum the overlap-save stage
+// multiplies by. Built on a control thread at pack load; immutable and
+// shared afterwards.
+struct ConvolutionIr {
+    static constexpr size_t kHeadFrames = 256;
+    static constexpr size_t kLongBlock = 4096;
+    // A block of slack after the long partitions' first input block, so
+    // their work can spread over the short blocks in between.
+    static constexpr size_t kLongOffset = 2 * kLongBlock;
+    static constexpr float kMaxSeconds = 8.0f;
+
+    // Partitions of `block` taps starting at tap `offset`. The spectra hold
+    // partitions * (block + 1) bins per channel, scaled for RealFft's
+    // unnormalised inverse.
+    struct Level {
+        size_t block = 0;
+        size_t offset = 0;
+        size_t partitions = 0;
+        std::array<std::vector<float>, 2> re;
+        std::array<std::vector<float>, 2> im;
+    };
+
+    std::string path;
+    size_t frames = 0;
+    // Head taps per output channel, time-reversed for simd::dot.
+    std::array<std::vector<float>, 2> head;
+    std::array<Level, 2> levels;
+
+    // Loads an IR (any format SampleCache reads, resampled to sampleRate).
+    // Mono IRs feed both outputs. The IR is cut at kMaxSeconds and
+    // normalised to a fixed energy, so a mood's reverb_wet sounds about as
+    // loud as it would through the FDN. Logs and returns false if the file
+    // cannot be read.
+    static bool load(const std::string &path, float sampleRate, ConvolutionIr &out);
+
+    // Prepares taps as they are (right may be nullptr for a mono IR).
+    void build(const float *left, const float *right, size_t taps);
+
+    // Partitions of each level needed for an IR of `taps` taps.
+    static size_t partitionsFor(size_t level, size_t taps);
+};
+
+// Mono-in, stereo-out convolution reverb with no added latency. The head
+// FIR runs per sample. The short partitions run as uniformly partitioned
+// overlap-save, once every kHeadFrames. The long partitions' FFTs and
+// spectral products are sliced across the short blocks of their slack
+// block rather than done all at once, so a multi-second IR costs the same
+// small amount every callback instead of a spike every kLongBlock frames.
+// Everything runs on the audio thread, so offline renders stay
+// deterministic.
+//
+// Switching IRs crossfades between two lanes of convolution state, so an
+// IR change mid-tail does not click. During the fade both lanes run.
+class ConvolutionReverb {
+public:
+    explicit ConvolutionReverb(float sampleRate = 48000.0f);
+
+    ConvolutionReverb(const ConvolutionReverb &) = delete;
+    ConvolutionReverb &operator=(const ConvolutionReverb &) = delete;
+
+    static constexpr float kGlideMs = 60.0f;
+
+    // Not real-time safe (allocates). Sizes the lanes for IRs of up to
+    // maxTaps taps and drops the current IR; 0 frees everything.
+    void reserve(size_t maxTaps);
+
+    // Audio thread. Switches to ir, crossfading from the current IR over
+    // fadeFrames. ir must outlive its use; one longer than the reserved
+    // size is ignored. A switch during a fade completes the earlier one
+    // first. nullptr stops the reverb at once, so fade its wet out first.
+    void setIr(const ConvolutionIr *ir, size_t fadeFrames);
+    const ConvolutionIr *ir() const;
+    // True once the wet level has settled at 0, when dropping the IR is
+    // silent.
+    bool idle() const { return wet_.settled() && wet_.current() == 0.0f; }
+
+    // Audio thread. Dry/wet blend like FdnReverb::process; wetMix glides.
+    // Leaves the bus untouched when no IR is set.
+    void process(AudioBus &bus, size_t frames, float wetMix);
+
+private:
+    static constexpr size_t kHead = ConvolutionIr::kHeadFrames;
+    static constexpr size_t kInputRing = 16384;  // > kLongOffset + kHead
+    static constexpr size_t kOutputRing = 16384; // > kLongOffset + kLongBlock
+
+    struct LevelState {
+        std::vector<float> fdlRe, fdlIm; // input spectra, one slot per partition
+        size_t newest = 0;               // slot of the latest input block
+        std::array<std::vector<float>, 2> accRe, accIm;
+        bool started = false;            // has seen its block's first step
+    };
+
+    struct Lane {
+        const ConvolutionIr *ir = nullptr;
+        std::array<LevelState, 2> levels;
+        std::array<std::vector<float>, 2> out; // kOutputRing, read and cleared by process
+    };
+
+    void resetLane(Lane &lane, const ConvolutionIr *ir);
+    // Writes the head FIR plus the partitions' output for the next n frames.
+    void laneOutput(Lane &lane, size_t n, float *left, float *right);
+    // Runs the partition work due at a kHead boundary.
+    void tick(Lane &lane);
+    void stepLevel(Lane &lane, size_t level);
+
+    float sampleRate_;
+    size_t reservedTaps_ = 0;
+    ParamSmoother wet_;
+
+    // Mono input written twice (at i and i + kInputRing), so any window up
+    // to kInputRing long is contiguous.
+    std::vector<float> input_;
+    uint64_t clock_ = 0;
+
+    std::array<Lane, 2> lanes_;
+    size_t current_ = 0;
+    bool fading_ = false;
+    size_t fadePos_ = 0;
+    size_t fadeFrames_ = 0;
+
+    std::array<RealFft, 2> ffts_;
+    std::vector<float> time_; // inverse FFT output
+    std::array<float, kHead> wetL_{}, wetR_{}, laneL_{}, laneR_{};
+};
+
+} // namespace audio
@@ -1,24 +1,28 @@
 #pragma once
 
 #include <algorithm>
-#include <vector>
+#include <cstddef>
 #include <cmath>
+#include "bus.h"
+#include "fastmath.h"
+#include "simd/simd.h"
 
 namespace audio {
 
-// Equal-power crossfade helper for mono buffers.
-inline void equalPowerCrossfade(const std::vector<float> &a,
-                                const std::vector<float> &b,
+// Equal-power crossfade helper for planar buses (all channels share the gains).
+inline void equalPowerCrossfade(const AudioBus &a,
+                                const AudioBus &b,
                                 float t,
-                                std::vector<float> &out) {
+                                AudioBus &out,
+                                size_t frames) {
     constexpr float kPi = 3.1415926535f;
     const float clamped = std::clamp(t, 0.0f, 1.0f);
-    const float gainA = std::cos(0.5f * kPi * clamped);
-    const float gainB = std::sin(0.5f * kPi * clamped);
-    const size_t frames = std::min(a.size(), b.size());
-    out.resize(frames);
-    for (size_t i = 0; i < frames; ++i) {
-        out[i] = a[i] * gainA + b[i] * gainB;
+    const float gainA = fastmath::sin(0.5f * kPi * (1.0f - clamped));
+    const float gainB = fastmath::sin(0.5f * kPi * clamped);
+    const size_t channels = std::min({a.channels(), b.channels(), out.channels()});
+    const auto &k = simd::kernels();
+    for (size_t c = 0; c < channels; ++c) {
+        k.crossfade(out.channel(c), a.channel(c), b.channel(c), gainA, gainB, frames);
     }
 }
 
@@ -1,4 +1,3 @@
-#define MINIAUDIO_IMPLEMENTATION
 #include "../../vendor/miniaudio.h"
 #include "device.h"
 #include "../util/logger.h"
@@ -1,13 +1,13 @@
 #include "ducking.h"
 #include <algorithm>
 #include <cmath>
+#include "fastmath.h"
 
 namespace audio {
 
 namespace {
-inline float dbToLinear(float db) {
-    return std::pow(10.0f, db / 20.0f);
-}
+// Frames per envelope / gain pass; the gains live on the stack.
+constexpr size_t kChunk = 64;
 }
 
 void DuckingCompressor::setParams(float attackMs, float releaseMs, float ratio, float thresholdDb) {
@@ -15,33 +15,46 @@ void DuckingCompressor::setParams(float attackMs, float releaseMs, float ratio,
     releaseMs_ = releaseMs;
     ratio_ = ratio;
     thresholdDb_ = thresholdDb;
+    coeffRate_ = 0.0f;
 }
 
-void DuckingCompressor::process(const std::vector<float> &sidechain,
-                                std::vector<float> &target,
+void DuckingCompressor::process(const float *sidechain,
+                                AudioBus &target,
+                                size_t frames,
                                 float sampleRate) {
-    if (target.empty()) return;
-    const float attackCoeff = std::exp(-1.0f / (0.001f * attackMs_ * sampleRate));
-    const float releaseCoeff = std::exp(-1.0f / (0.001f * releaseMs_ * sampleRate));
-    const float thresholdLin = dbToLinear(thresholdDb_);
+    if (frames == 0) return;
+    if (sampleRate != coeffRate_) {
+        attackCoeff_ = std::exp(-1.0f / (0.001f * attackMs_ * sampleRate));
+        releaseCoeff_ = std::exp(-1.0f / (0.001f * releaseMs_ * sampleRate));
+        invThreshold_ = 1.0f / fastmath::db2lin(thresholdDb_);
+        coeffRate_ = sampleRate;
+    }
+    const float slopeDb = (ratio_ - 1.0f) * 6.0f; // gentle slope
+    const size_t channels = target.channels();
 
-    for (size_t i = 0; i < target.size(); ++i) {
-        const float sc = i < sidechain.size() ? sidechain[i] : 0.0f;
-        const float scSq = sc * sc;
-        if (scSq > envelopeRms_) {
-            envelopeRms_ = attackCoeff * (envelopeRms_ - scSq) + scSq;
-        } else {
-            envelopeRms_ = releaseCoeff * (envelopeRms_ - scSq) + scSq;
+    float gains[kChunk];
+    for (size_t start = 0; start < frames; start += kChunk) {
+        const size_t n = std::min(kChunk, frames - start);
+        // The envelope is serial; stash it and shape it below.
+        float env = envelopeRms_;
+        for (size_t i = 0; i < n; ++i) {
+            const float sc = sidechain[start + i];
+            const float scSq = sc * sc;
+            env = (scSq > env ? attackCoeff_ : releaseCoeff_) * (env - scSq) + scSq;
+            gains[i] = env;
         }
-        const float rms = std::sqrt(std::max(0.0f, envelopeRms_));
+        envelopeRms_ = env;
 
-        float gain = 1.0f;
-        if (rms > thresholdLin) {
-            float over = rms / thresholdLin;
-            float gainDb = - (over - 1.0f) * (ratio_ - 1.0f) * 6.0f; // gentle slope
-            gain = dbToLinear(gainDb);
+        // Under the threshold over is 0 and the gain exactly 1.
+        for (size_t i = 0; i < n; ++i) {
+            const float rms = std::sqrt(std::max(0.0f, gains[i]));
+            const float over = std::max(rms * invThreshold_ - 1.0f, 0.0f);
+            gains[i] = fastmath::db2lin(-over * slopeDb);
+        }
+        for (size_t c = 0; c < channels; ++c) {
+            float *__restrict out = target.channel(c) + start;
+            for (size_t i = 0; i < n; ++i) out[i] *= gains[i];
         }
-        target[i] *= gain;
     }
 }
 
@@ -1,10 +1,14 @@
 #pragma once
 
-#include <vector>
+#include <cstddef>
+#include "bus.h"
 
 namespace audio {
 
-// Simple sidechain ducking compressor for mono buffers (RMS detector).
+// Simple sidechain ducking compressor (RMS detector on a mono sidechain,
+// one gain applied to every channel of the target bus). Works in chunks:
+// the serial envelope first, then the gain curve and the gains as
+// vectorisable loops.
 class DuckingCompressor {
 public:
     DuckingCompressor(float attackMs = 15.0f,
@@ -19,9 +23,10 @@ public:
 
     void setParams(float attackMs, float releaseMs, float ratio, float thresholdDb);
 
-    // sidechain = voice/TTS buffer, target = music buffer (in-place gain)
-    void process(const std::vector<float> &sidechain,
-                 std::vector<float> &target,
+    // sidechain = voice/TTS buffer, target = music bus (in-place gain)
+    void process(const float *sidechain,
+                 AudioBus &target,
+                 size_t frames,
                  float sampleRate);
 
 private:
@@ -30,6 +35,12 @@ private:
     float ratio_;
     float thresholdDb_;
     float envelopeRms_;
+    // Derived from the settings above and the sample rate; recomputed by
+    // process when coeffRate_ no longer matches (0 = stale).
+    float coeffRate_ = 0.0f;
+    float attackCoeff_ = 0.0f;
+    float releaseCoeff_ = 0.0f;
+    float invThreshold_ = 1.0f;
 };
 
 } // namespace audio
@@ -1,26 +1,23 @@
 #include "engine.h"
+#include "rt_check.h"
+#include "simd/simd.h"
 #include "../util/logger.h"
+#include "../util/startup_profile.h"
 #include <cmath>
 #include <numeric>
 #include <algorithm>
 #include <cstdlib>
 #include <chrono>
+#include <memory>
 
 namespace audio {
 
 namespace {
-constexpr float kPi = 3.1415926535f;
 
 float clamp01(float v) {
     return std::max(0.0f, std::min(1.0f, v));
 }
 
-float rms(const std::vector<float> &buf) {
-    if (buf.empty()) return 0.0f;
-    float sum = 0.0f;
-    for (float v : buf) sum += v * v;
-    return std::sqrt(sum / static_cast<float>(buf.size()));
-}
 } // namespace
 
 Engine::Engine(float sampleRate, size_t blockSize)
@@ -35,26 +32,39 @@ Engine::Engine(float sampleRate, size_t blockSize)
       storyGen_(storyBank_),
       scheduler_(sampleRate),
       reverb_(sampleRate),
-      limiter_(-1.0f, 0.05f),
-      musicPhase_(0.0f),
-      binauralLeft_(sampleRate),
-      binauralRight_(sampleRate),
-      breathingLp_(sampleRate),
-      melatoninShelf_(sampleRate) {
-    musicA_.resize(blockSize_);
-    musicB_.resize(blockSize_);
-    voice_.resize(blockSize_);
-    mixed_.resize(blockSize_);
+      convolution_(sampleRate),
+      limiter_(sampleRate, -1.0f),
+      binaural_(sampleRate),
+      busFilters_(sampleRate),
+      profiler_(sampleRate),
+      synthA_(sampleRate, kMaxBlockFrames),
+      synthB_(sampleRate, kMaxBlockFrames),
+      musicOsc_(sampleRate) {
+    renderIntensity_ = intensity_.load();
+    // Sized once for the largest chunk renderBlock processes; the callback
+    // never resizes them.
+    musicA_.allocate(2, kMaxBlockFrames);
+    musicB_.allocate(2, kMaxBlockFrames);
+    voice_.assign(kMaxBlockFrames, 0.0f);
+    mixed_.allocate(2, kMaxBlockFrames);
 
     // Initial filter settings
-    breathingLp_.setParams(BiquadFilter::LowPass, 20000.0f, 0.707f);
-    melatoninShelf_.setParams(BiquadFilter::HighShelf, 8000.0f, 0.707f, 0.0f);
+    busFilters_.setParams(kBreathingLp, BiquadType::LowPass, 20000.0f, 0.707f);
+    busFilters_.setParams(kMelatoninShelf, BiquadType::HighShelf, 6000.0f, 0.707f, 0.0f);
+    // A slight, slow wander in the reverb's delays keeps sustained pads
+    // from ringing metallically.
+    reverb_.setModulation(0.15f, 0.6f);
+    compileDspTable();
 
     // Load stems for initial mood
-    loadStemsForMood(0, currentStems_);
+    currentStems_ = new StemBank();
+    loadStemsForMood(0, *currentStems_);
+    stemLoader_ = std::make_unique<StemLoader>();
 
+    storyBank_.setOutputRate(static_cast<uint32_t>(sampleRate));
     if (storyBank_.loadFromFile("config/stories.json")) {
         util::logInfo("Engine: Voice stories loaded.");
+        storyBank_.preloadAudio();
     }
 
     // Initialize public state snapshot.
@@ -62,11 +72,11 @@ Engine::Engine(float sampleRate, size_t blockSize)
         std::lock_guard<std::mutex> lock(publicStateMutex_);
         publicState_.moodId = machine_.currentRecipe().id;
         publicState_.targetMoodId = machine_.targetRecipe().id;
-        publicState_.energy = intensity_;
-        publicState_.intensity = intensity_;
+        publicState_.energy = currentEnergy();
+        publicState_.intensity = currentEnergy();
         publicState_.activity = activityMonitor_.activity();
         publicState_.idleSeconds = activityMonitor_.idleTime();
-        publicState_.playing = isPlaying_;
+        publicState_.playing = isPlaying();
         publicState_.updatedAtMs = static_cast<uint64_t>(
             std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::system_clock::now().time_since_epoch())
@@ -74,21 +84,157 @@ Engine::Engine(float sampleRate, size_t blockSize)
     }
 }
 
-void Engine::setMoodPack(brain::MoodPack pack) {
+Engine::~Engine() {
+    // Banks and story players still in flight never reached the audio thread.
+    EngineCommand cmd;
+    while (commands_.pop(cmd)) {
+        delete cmd.bank;
+        delete cmd.voice;
+    }
+    while (scheduler_.popAny(cmd)) {
+        delete cmd.bank;
+        delete cmd.voice;
+    }
+    collectRetired();
+    delete currentStems_;
+    delete targetStems_;
+    delete currentVoice_;
+}
+
+void Engine::setMoodPack(brain::MoodPack pack, const std::string &startMoodId) {
     pack_ = std::move(pack);
     machine_ = brain::MoodStateMachine(pack_);
-    
+    compileDspTable();
+
+    size_t startIndex = 0;
+    for (size_t i = 0; i < pack_.moods.size(); ++i) {
+        if (pack_.moods[i].id == startMoodId) {
+            startIndex = i;
+            machine_.setCurrentMood(startMoodId);
+            break;
+        }
+    }
+
+    EngineCommand pending;
+    while (scheduler_.popAny(pending)) {
+        delete pending.bank;
+    }
+    requestedMoodIndex_ = SIZE_MAX;
+    delete targetStems_;
+    targetStems_ = nullptr;
+    fading_ = false;
+    renderFade_ = 1.0f;
+    renderMoodIndex_ = startIndex;
+    renderTargetIndex_ = startIndex;
+    targetMoodIndex_ = startIndex;
+    postedMoodIndex_ = startIndex;
+    if (stemLoader_) stemLoader_->cancel();
+    renderFadeSeconds_ = machine_.fadeDuration();
+    setSynthMood(*synthCur_, startIndex);
+    synthTgt_->setPatch(nullptr, 0, 0.0f);
+    if (!irTable_.empty()) convolution_.setIr(irTable_[startIndex].get(), 0);
+
     if (!pack_.moods.empty()) {
-        loadStemsForMood(0, currentStems_);
+        delete currentStems_;
+        currentStems_ = new StemBank();
+        if (stemLoader_) {
+            // Start on the base stem; the others join as they decode.
+            currentStems_->loadProgressive(pack_.moods[startIndex].stems, static_cast<uint32_t>(sampleRate_));
+        } else {
+            loadStemsForMood(startIndex, *currentStems_);
+        }
+    }
+}
+
+void Engine::setStemWorkers(size_t workers, int firstCpu) {
+    stemMixer_.setWorkers(workers, kMaxBlockFrames, firstCpu);
+    if (workers > 0) {
+        util::logInfo("Engine: rendering stems on " + std::to_string(workers) + " worker thread(s)");
+    }
+}
+
+void Engine::setAsyncStemLoading(bool async) {
+    if (async == (stemLoader_ != nullptr)) return;
+    if (async) {
+        stemLoader_ = std::make_unique<StemLoader>();
+    } else {
+        stemLoader_.reset();
+        // A load still in flight is gone; make the next tick request it again.
+        targetMoodIndex_ = postedMoodIndex_;
     }
 }
 
+void Engine::setOffline(bool offline, float activity) {
+    offline_ = offline;
+    offlineActivity_ = clamp01(activity);
+    scheduler_.setOffline(offline);
+}
+
+float Engine::currentActivity() const {
+    return offline_ ? offlineActivity_ : activityMonitor_.activity();
+}
+
 void Engine::setIntensity(float value) {
-    intensity_ = clamp01(value);
+    const float v = clamp01(value);
+    intensity_.store(v, std::memory_order_relaxed);
+    EngineCommand cmd;
+    cmd.type = EngineCommand::Type::SetIntensity;
+    cmd.a = v;
+    post(cmd);
 }
 
-void Engine::setMood(const std::string& moodId) {
-    machine_.setTargetMood(moodId);
+void Engine::setPlaying(bool playing) {
+    playing_.store(playing, std::memory_order_relaxed);
+    EngineCommand cmd;
+    cmd.type = EngineCommand::Type::SetPlaying;
+    cmd.a = playing ? 1.0f : 0.0f;
+    post(cmd);
+}
+
+void Engine::setMood(const std::string& moodId, uint64_t atSample) {
+    // pack_ is immutable while running, so the lookup is safe from any thread.
+    for (size_t i = 0; i < pack_.moods.size(); ++i) {
+        if (pack_.moods[i].id == moodId) {
+            if (!moodRequests_.push({i, atSample})) {
+                util::logWarn("Engine: mood request queue full, dropping " + moodId);
+            }
+            return;
+        }
+    }
+}
+
+void Engine::post(const EngineCommand &cmd) {
+    if (!commands_.push(cmd)) {
+        util::logWarn("Engine: command queue full, dropping command");
+        delete cmd.bank;
+        delete cmd.voice;
+    }
+}
+
+void Engine::retireBank(StemBank *bank) {
+    if (bank == nullptr) return;
+    // Deleting would free memory on the audio thread; hand it back instead.
+    // The tick thread drains this every 100 ms, so a full ring means the
+    // control side has stalled and leaking one bank is the lesser evil.
+    (void)retiredBanks_.push(bank);
+}
+
+void Engine::retireVoice(StemPlayer *voice) {
+    if (voice == nullptr) return;
+    // Same as retireBank: the player holds the story's last sample
+    // reference, which must not drop on the audio thread.
+    (void)retiredVoices_.push(voice);
+}
+
+void Engine::collectRetired() {
+    StemBank *bank = nullptr;
+    while (retiredBanks_.pop(bank)) {
+        delete bank;
+    }
+    StemPlayer *voice = nullptr;
+    while (retiredVoices_.pop(voice)) {
+        delete voice;
+    }
 }
 
 const std::string& Engine::currentMoodId() const {
@@ -96,14 +242,32 @@ const std::string& Engine::currentMoodId() const {
 }
 
 void Engine::tick(const std::string &activeProcess, float dtSeconds) {
-    heuristics_.setActiveProcess(activeProcess);
-    activityMonitor_.update(dtSeconds);
+    collectRetired();
+    util::StartupProfile::instance().reportOnce();
+#if KEEGAN_RT_CHECKS
+    rtcheck::logNewViolations();
+#endif
+
+    MoodRequest requested;
+    while (moodRequests_.pop(requested)) {
+        machine_.setTargetMood(pack_.moods[requested.moodIndex].id);
+        requestedMoodIndex_ = requested.moodIndex;
+        requestedAt_ = requested.atSample;
+    }
+
+    if (!offline_) {
+        heuristics_.setActiveProcess(activeProcess);
+        activityMonitor_.update(dtSeconds);
+    }
     
-    float activityBoost = activityMonitor_.activity() * 0.3f;
-    float effectiveIntensity = clamp01(intensity_ + activityBoost);
+    const float intensity = currentEnergy();
+    float activityBoost = currentActivity() * 0.3f;
+    float effectiveIntensity = clamp01(intensity + activityBoost);
     
-    const auto bias = heuristics_.currentBias();
-    machine_.setTargetMood(bias.moodId);
+    if (!offline_) {
+        const auto bias = heuristics_.currentBias();
+        machine_.setTargetMood(bias.moodId);
+    }
     machine_.update(dtSeconds);
 
     size_t newTargetIndex = 0;
@@ -116,15 +280,20 @@ void Engine::tick(const std::string &activeProcess, float dtSeconds) {
     
     if (newTargetIndex != targetMoodIndex_) {
         targetMoodIndex_ = newTargetIndex;
-        loadStemsForMood(newTargetIndex, targetStems_);
+        if (stemLoader_) {
+            stemLoader_->request(newTargetIndex, pack_.moods[newTargetIndex].stems, static_cast<uint32_t>(sampleRate_));
+        } else {
+            auto bank = std::make_unique<StemBank>();
+            loadStemsForMood(newTargetIndex, *bank);
+            beginTransition(newTargetIndex, bank.release());
+        }
     }
-    
-    if (machine_.crossfade() >= 1.0f && currentMoodIndex_ != targetMoodIndex_) {
-        currentMoodIndex_ = targetMoodIndex_;
-        std::swap(currentStems_, targetStems_);
+    StemLoader::Result loaded;
+    if (stemLoader_ && stemLoader_->take(loaded)) {
+        beginTransition(loaded.moodIndex, loaded.bank);
     }
 
-    if (storyBank_.countForMood(machine_.currentRecipe().id) < 5) { 
+    if (!offline_ && storyBank_.countForMood(machine_.currentRecipe().id) < 5) { 
          std::string context = "User is in " + activeProcess + ". Energy: " + std::to_string(effectiveIntensity);
          storyGen_.requestStory(machine_.currentRecipe().id, context);
     }
@@ -142,10 +311,10 @@ void Engine::tick(const std::string &activeProcess, float dtSeconds) {
         publicState_.targetMoodId = machine_.targetRecipe().id;
         publicState_.activeProcess = activeProcess;
         publicState_.energy = effectiveIntensity;
-        publicState_.intensity = intensity_;
-        publicState_.activity = activityMonitor_.activity();
+        publicState_.intensity = intensity;
+        publicState_.activity = currentActivity();
         publicState_.idleSeconds = activityMonitor_.idleTime();
-        publicState_.playing = isPlaying_;
+        publicState_.playing = isPlaying();
         publicState_.updatedAtMs = static_cast<uint64_t>(
             std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::system_clock::now().time_since_epoch())
@@ -154,67 +323,64 @@ void Engine::tick(const std::string &activeProcess, float dtSeconds) {
 }
 
 void Engine::updateBioReactiveDsp(float dt) {
-    const auto& mood = machine_.currentRecipe().id;
-    
-    // 1. Binaural Beats Targeting
-    float targetLeft = 200.0f;
-    float targetRight = 240.0f; // Default Gamma (40Hz offset)
-
-    if (mood == "rain_cave") { // Theta (6Hz)
-        targetLeft = 120.0f;
-        targetRight = 126.0f;
-    } else if (mood == "sleep_ship") { // Delta (2Hz)
-        targetLeft = 80.0f;
-        targetRight = 82.0f;
-    } else if (mood == "arcade_night") { // Beta (25Hz)
-        targetLeft = 150.0f;
-        targetRight = 175.0f;
-    }
-
-    // Smooth transition for frequencies could be added, but sudden shift is okay for < 1Hz diff usually.
-    // We'll set them directly for now.
-    binauralLeft_.setFrequency(targetLeft);
-    binauralRight_.setFrequency(targetRight);
-
-    // 2. Breathing Filter (Activity -> Cutoff)
+    // Binaural beats, reverb, master LP and shelf frequency come from the
+    // mood's dsp table entry on the audio thread (see applyMoodDsp).
+
+    // 1. Breathing Filter (Activity -> Cutoff)
     // Low energy = 500Hz, High energy = 20kHz
-    float activity = activityMonitor_.activity(); // 0..1
+    float activity = currentActivity(); // 0..1
     float targetCutoff = 500.0f + (19500.0f * activity * activity); // Exponential curve
-    breathingLp_.setParams(BiquadFilter::LowPass, targetCutoff, 0.707f);
 
-    // 3. Melatonin Mode (Time -> High Shelf Gain)
-    auto now = std::chrono::system_clock::now();
-    time_t tt = std::chrono::system_clock::to_time_t(now);
-    tm local_tm = *localtime(&tt);
-    
+    // 2. Melatonin Mode (Time -> High Shelf Gain)
     float shelfGain = 0.0f;
-    if (local_tm.tm_hour >= 23 || local_tm.tm_hour < 6) {
-        // Night mode: Cut highs
-        shelfGain = -12.0f; 
-    } else if (local_tm.tm_hour >= 21) {
-        // Evening wind-down
-        shelfGain = -6.0f;
+    if (!offline_) {
+        auto now = std::chrono::system_clock::now();
+        time_t tt = std::chrono::system_clock::to_time_t(now);
+        tm local_tm = *localtime(&tt);
+
+        if (local_tm.tm_hour >= 23 || local_tm.tm_hour < 6) {
+            // Night mode: Cut highs
+            shelfGain = -12.0f; 
+        } else if (local_tm.tm_hour >= 21) {
+            // Evening wind-down
+            shelfGain = -6.0f;
+        }
+    }
+
+    if (targetCutoff != lpCutoffHz_ || shelfGain != shelfGainDb_) {
+        lpCutoffHz_ = targetCutoff;
+        shelfGainDb_ = shelfGain;
+        EngineCommand cmd;
+        cmd.type = EngineCommand::Type::SetFilters;
+        cmd.a = targetCutoff;
+        cmd.b = shelfGain;
+        post(cmd);
     }
-    melatoninShelf_.setParams(BiquadFilter::HighShelf, 6000.0f, 0.707f, shelfGain);
 }
 
 void Engine::updateNarrativeLogic(const brain::MoodRecipe& recipe, float dt) {
     timeSinceLastStory_ += dt;
-    {
-        std::lock_guard<std::mutex> lock(voiceMutex_);
-        if (nextStory_ != nullptr) return;
-    }
     if (timeSinceLastStory_ < 60.0f) return;
 
     float prob = recipe.narrativeFrequency * dt * 0.1f; 
     if (static_cast<float>(rand()) / RAND_MAX < prob) {
-        auto story = storyBank_.pickStory(recipe.id, timeSinceLastStory_, 60.0f);
+        SampleRef audio;
+        auto story = storyBank_.pickStory(recipe.id, timeSinceLastStory_, 60.0f, audio);
         if (story) {
             util::logInfo("Engine: Triggering story: " + story->id);
             storyBank_.markPlayed(story, timeSinceLastStory_);
             timeSinceLastStory_ = 0.0f;
-            std::lock_guard<std::mutex> lock(voiceMutex_);
-            nextStory_ = story;
+            // A fresh player per playback, handed to the audio thread like a
+            // stem bank and retired by it when done, so its sample stays
+            // referenced for exactly as long as it can be read.
+            auto *voice = new StemPlayer();
+            voice->setLooping(false);
+            voice->setSample(std::move(audio));
+            EngineCommand cmd;
+            cmd.type = EngineCommand::Type::PlayStory;
+            cmd.voice = voice;
+            cmd.atSample = scheduler_.eventTime();
+            post(cmd);
         }
     }
 }
@@ -223,144 +389,352 @@ void Engine::loadStemsForMood(size_t moodIndex, StemBank& bank) {
     if (moodIndex >= pack_.moods.size()) return;
     const auto& recipe = pack_.moods[moodIndex];
     if (!recipe.stems.empty()) {
-        bank.loadFromConfig(recipe.stems);
+        bank.loadFromConfig(recipe.stems, static_cast<uint32_t>(sampleRate_));
     }
 }
 
-MoodDspParams Engine::getDspParams(const brain::MoodRecipe& recipe) {
-    MoodDspParams params;
-    if (recipe.id == "focus_room") {
-        params.reverbWet = 0.2f; params.reverbDecay = 0.4f; params.reverbPreDelay = 15.0f;
-        params.masterLpHz = 12000.0f;  
-    } else if (recipe.id == "rain_cave") {
-        params.reverbWet = 0.5f; params.reverbDecay = 0.7f; params.reverbPreDelay = 40.0f;
-        params.masterLpHz = 16000.0f;
-    } else if (recipe.id == "arcade_night") {
-        params.reverbWet = 0.25f; params.reverbDecay = 0.3f; params.reverbPreDelay = 10.0f;
-        params.masterLpHz = 18000.0f; 
-    } else if (recipe.id == "sleep_ship") {
-        params.reverbWet = 0.35f; params.reverbDecay = 0.6f; params.reverbPreDelay = 30.0f;
-        params.masterLpHz = 6000.0f;  
+void Engine::beginTransition(size_t moodIndex, StemBank *bank) {
+    postedMoodIndex_ = moodIndex;
+    EngineCommand cmd;
+    cmd.type = EngineCommand::Type::BeginTransition;
+    cmd.moodIndex = moodIndex;
+    cmd.bank = bank;
+    cmd.a = machine_.fadeDuration();
+    cmd.atSample = scheduler_.eventTime();
+    if (moodIndex == requestedMoodIndex_) {
+        cmd.atSample = std::max(cmd.atSample, requestedAt_);
+        requestedMoodIndex_ = SIZE_MAX;
     }
-    return params;
+    post(cmd);
 }
 
-void Engine::generateMusic(const brain::MoodRecipe &recipe, float density, std::vector<float> &out, float &phase) {
-    const float freq = 110.0f + 220.0f * recipe.energy * intensity_;
-    const float amp = 0.2f + 0.3f * density;
-    for (size_t i = 0; i < blockSize_; ++i) {
-        float v = std::sin(phase) * amp;
-        v += std::sin(phase * 2.0f) * recipe.tension * 0.1f;
-        out[i] = v;
-        phase += 2.0f * kPi * freq / sampleRate_;
-        if (phase > 2.0f * kPi) phase -= 2.0f * kPi;
+void Engine::compileDspTable() {
+    dspTable_.clear();
+    dspTable_.reserve(pack_.moods.size());
+    for (const auto &mood : pack_.moods) dspTable_.push_back(mood.dsp);
+
+    // Moods often share a preset; read each file once.
+    synthTable_.assign(pack_.moods.size(), SynthPatch{});
+    for (size_t i = 0; i < pack_.moods.size(); ++i) {
+        const std::string &file = pack_.moods[i].synth.presetFile;
+        if (file.empty() || file == "default") continue;
+        size_t same = 0;
+        while (same < i && pack_.moods[same].synth.presetFile != file) ++same;
+        if (same < i) {
+            synthTable_[i] = synthTable_[same];
+        } else {
+            SynthPatch::load(file, synthTable_[i]);
+        }
+    }
+
+    // Impulse responses are loaded and transformed here, off the audio
+    // thread; the convolution reverb is sized for the longest.
+    irTable_.assign(pack_.moods.size(), nullptr);
+    size_t longestIr = 0;
+    for (size_t i = 0; i < pack_.moods.size(); ++i) {
+        const std::string &file = pack_.moods[i].reverbIr;
+        if (file.empty()) continue;
+        size_t same = 0;
+        while (same < i && pack_.moods[same].reverbIr != file) ++same;
+        if (same < i) {
+            irTable_[i] = irTable_[same];
+            continue;
+        }
+        auto ir = std::make_shared<ConvolutionIr>();
+        if (!ConvolutionIr::load(file, sampleRate_, *ir)) continue;
+        longestIr = std::max(longestIr, ir->frames);
+        irTable_[i] = std::move(ir);
     }
+    convolution_.reserve(longestIr);
 }
 
-void Engine::renderVoice(std::vector<float> &out, size_t frames) {
-    std::fill(out.begin(), out.end(), 0.0f);
-    {
-        std::lock_guard<std::mutex> lock(voiceMutex_);
-        if (nextStory_) {
-            currentStory_ = nextStory_;
-            nextStory_ = nullptr;
-            currentStory_->player.reset(); 
+void Engine::updateConvolutionIr() {
+    if (fading_) {
+        if (const ConvolutionIr *ir = irTable_[renderTargetIndex_].get()) {
+            const float remaining = (1.0f - renderFade_) * renderFadeSeconds_ * sampleRate_;
+            convolution_.setIr(ir, static_cast<size_t>(std::max(remaining, 0.0f)));
         }
+        return;
+    }
+    const ConvolutionIr *ir = irTable_[renderMoodIndex_].get();
+    if (ir || convolution_.idle()) convolution_.setIr(ir, 0);
+}
+
+void Engine::setSynthMood(ProceduralSynth &synth, size_t moodIndex) {
+    const auto &preset = pack_.moods[moodIndex].synth;
+    synth.setPatch(&synthTable_[moodIndex], static_cast<uint32_t>(preset.seed), preset.patternDensity);
+}
+
+void Engine::applyMoodDsp() {
+    brain::MoodDsp dsp = dspTable_[renderMoodIndex_];
+    // Moods with an impulse response send their reverb_wet to the
+    // convolution reverb instead of the FDN.
+    auto irWet = [this](size_t mood) { return irTable_[mood] ? dspTable_[mood].reverbWet : 0.0f; };
+    float convolutionWet = irWet(renderMoodIndex_);
+    if (fading_) {
+        const auto &to = dspTable_[renderTargetIndex_];
+        const float t = std::clamp(renderFade_, 0.0f, 1.0f);
+        auto mix = [t](float a, float b) { return a + (b - a) * t; };
+        dsp.reverbWet = mix(dsp.reverbWet, to.reverbWet);
+        dsp.reverbDecay = mix(dsp.reverbDecay, to.reverbDecay);
+        dsp.reverbPreDelayMs = mix(dsp.reverbPreDelayMs, to.reverbPreDelayMs);
+        dsp.masterLpHz = mix(dsp.masterLpHz, to.masterLpHz);
+        dsp.binauralLeftHz = mix(dsp.binauralLeftHz, to.binauralLeftHz);
+        dsp.binauralRightHz = mix(dsp.binauralRightHz, to.binauralRightHz);
+        dsp.shelfHz = mix(dsp.shelfHz, to.shelfHz);
+        convolutionWet = mix(convolutionWet, irWet(renderTargetIndex_));
+    }
+
+    convolutionWet_ = convolutionWet;
+    reverbWet_ = std::max(dsp.reverbWet - convolutionWet, 0.0f);
+    if (!fading_ && convolution_.ir() != irTable_[renderMoodIndex_].get()) updateConvolutionIr();
+    reverb_.setParams(dsp.reverbPreDelayMs, dsp.reverbDecay, 0.25f);
+    // The mood's master LP caps the activity-driven breathing cutoff.
+    busFilters_.setTarget(kBreathingLp, BiquadType::LowPass, std::min(renderLpCutoffHz_, dsp.masterLpHz), 0.707f);
+    busFilters_.setTarget(kMelatoninShelf, BiquadType::HighShelf, dsp.shelfHz, 0.707f, renderShelfGainDb_);
+    // Mood crossfades move the beat frequencies every block; glide across
+    // the block rather than stepping at its start.
+    binaural_.glideTo(dsp.binauralLeftHz, dsp.binauralRightHz, blockSize_);
+}
+
+void Engine::generateMusic(const brain::MoodRecipe &recipe, float density, AudioBus &bus, size_t frames, ProceduralSynth &synth) {
+    if (synth.patch()) {
+        bus.clear(frames);
+        synth.render(bus, frames, density);
+        return;
+    }
+    Oscillator &osc = musicOsc_;
+    const float freq = 110.0f + 220.0f * recipe.energy * renderIntensity_;
+    const float amp = 0.2f + 0.3f * density;
+    float *out = bus.channel(0);
+    std::fill(out, out + frames, 0.0f);
+    osc.setFrequency(freq);
+    osc.processBlock(out, frames, amp, recipe.tension * 0.1f);
+    // Procedural fallback is mono; centre it.
+    for (size_t c = 1; c < bus.channels(); ++c) {
+        std::copy(out, out + frames, bus.channel(c));
     }
-    if (currentStory_) {
-        currentStory_->player.render(out.data(), frames, 1.0f); 
-        if (currentStory_->player.isFinished()) {
-            currentStory_ = nullptr;
+}
+
+void Engine::renderVoice(float *out, size_t frames) {
+    std::fill(out, out + frames, 0.0f);
+    if (currentVoice_) {
+        currentVoice_->render(out, frames, 1.0f); 
+        if (currentVoice_->isFinished()) {
+            retireVoice(currentVoice_);
+            currentVoice_ = nullptr;
         }
     }
 }
 
+void Engine::drainCommands() {
+    EngineCommand cmd;
+    const uint64_t now = scheduler_.clock();
+    while (commands_.pop(cmd)) {
+        // Commands already due apply in queue order; a full timeline applies
+        // them early rather than dropping them.
+        if (cmd.atSample > now && scheduler_.schedule(cmd)) continue;
+        applyCommand(cmd);
+    }
+}
+
+void Engine::applyCommand(const EngineCommand &cmd) {
+    switch (cmd.type) {
+        case EngineCommand::Type::SetPlaying:
+            renderPlaying_ = cmd.a > 0.5f;
+            break;
+        case EngineCommand::Type::SetIntensity:
+            renderIntensity_ = cmd.a;
+            break;
+        case EngineCommand::Type::BeginTransition:
+            retireBank(targetStems_);
+            targetStems_ = nullptr;
+            if (cmd.moodIndex == renderMoodIndex_) {
+                // Target fell back to the playing mood: cancel the fade.
+                retireBank(cmd.bank);
+                fading_ = false;
+                renderFade_ = 1.0f;
+                renderTargetIndex_ = renderMoodIndex_;
+            } else {
+                targetStems_ = cmd.bank;
+                renderTargetIndex_ = cmd.moodIndex;
+                renderFadeSeconds_ = std::max(cmd.a, 0.01f);
+                renderFade_ = 0.0f;
+                fading_ = true;
+                setSynthMood(*synthTgt_, cmd.moodIndex);
+            }
+            updateConvolutionIr();
+            break;
+        case EngineCommand::Type::PlayStory:
+            retireVoice(currentVoice_);
+            currentVoice_ = cmd.voice;
+            break;
+        case EngineCommand::Type::SetFilters:
+            // Picked up by applyMoodDsp and glided from there.
+            renderLpCutoffHz_ = cmd.a;
+            renderShelfGainDb_ = cmd.b;
+            break;
+    }
+}
+
+size_t Engine::nextEventChunk(size_t maxFrames) {
+    EngineCommand event;
+    while (scheduler_.popDue(event)) applyCommand(event);
+    return scheduler_.framesUntilEvent(maxFrames);
+}
+
+uint64_t Engine::endStage(DspStage stage, uint64_t mark, size_t frames) {
+#if KEEGAN_RT_CHECKS
+    // Stages are declared in processing order, so whatever runs next is stage + 1.
+    rtcheck::setStage(static_cast<DspStage>(static_cast<size_t>(stage) + 1));
+#endif
+    return profiler_.lap(stage, mark, frames);
+}
+
 float Engine::renderBlock(float *out, size_t frames) {
     if (frames == 0 || out == nullptr) return 0.0f;
-    if (!isPlaying_) {
+#if KEEGAN_RT_CHECKS
+    rtcheck::CallbackScope rtScope;
+#endif
+    uint64_t mark = profiler_.now();
+    drainCommands();
+    endStage(DspStage::Commands, mark, frames);
+
+    if (!renderPlaying_) {
         std::fill(out, out + frames * 2, 0.0f);
+        // The clock keeps running, and timed events fall due, while paused.
+        for (size_t done = 0; done < frames;) {
+            const size_t n = nextEventChunk(frames - done);
+            scheduler_.advance(n);
+            done += n;
+        }
+        scheduler_.publish(frames);
         return 0.0f;
     }
-    
+    util::StartupProfile::instance().markFirstAudio();
+
+    // Hosts may ask for more than the preallocated scratch holds; render in
+    // chunks rather than growing buffers on the audio thread. Timeline
+    // events split the block so each lands on its exact sample.
+    float sum = 0.0f;
+    for (size_t done = 0; done < frames;) {
+        const size_t n = nextEventChunk(std::min(frames - done, kMaxBlockFrames));
+        sum += renderChunk(out + 2 * done, n);
+        scheduler_.advance(n);
+        done += n;
+    }
+    scheduler_.publish(frames);
+    return std::sqrt(sum / static_cast<float>(frames));
+}
+
+float Engine::renderChunk(float *out, size_t frames) {
+#if KEEGAN_RT_CHECKS
+    rtcheck::setStage(DspStage::Stems);
+#endif
     blockSize_ = frames;
-    musicA_.resize(frames);
-    musicB_.resize(frames);
-    voice_.resize(frames);
-    mixed_.resize(frames);
+    uint64_t mark = profiler_.now();
+    const uint64_t blockStart = mark;
+
+    applyMoodDsp();
 
-    const auto &cur = machine_.currentRecipe();
-    const auto &tgt = machine_.targetRecipe();
+    const auto &cur = pack_.moods[renderMoodIndex_];
+    const auto &tgt = pack_.moods[renderTargetIndex_];
 
     scheduler_.setMood(cur);
     const float densityCur = scheduler_.nextDensity(blockSize_);
-    scheduler_.setMood(tgt);
-    const float densityTgt = scheduler_.nextDensity(blockSize_);
+    float densityTgt = 0.0f;
+    if (fading_) {
+        scheduler_.setMood(tgt);
+        densityTgt = scheduler_.nextDensity(blockSize_);
+    }
 
-    // Stems / Procedural
-    if (currentStems_.count() > 0) {
-        currentStems_.renderMixed(musicA_.data(), frames, densityCur);
+    // Stems (both banks in one pass so they can share the workers) /
+    // Procedural
+    StemMixer::Job jobs[StemMixer::kMaxJobs];
+    size_t jobCount = 0;
+    if (currentStems_ && currentStems_->count() > 0) {
+        jobs[jobCount++] = {currentStems_, densityCur, &musicA_};
     } else {
-        generateMusic(cur, densityCur, musicA_, musicPhase_);
+        generateMusic(cur, densityCur, musicA_, frames, *synthCur_);
     }
-    
-    if (targetStems_.count() > 0 && machine_.crossfade() < 1.0f) {
-        targetStems_.renderMixed(musicB_.data(), frames, densityTgt);
+    if (fading_) {
+        if (targetStems_ && targetStems_->count() > 0) {
+            jobs[jobCount++] = {targetStems_, densityTgt, &musicB_};
+        } else {
+            generateMusic(tgt, densityTgt, musicB_, frames, *synthTgt_);
+        }
+    }
+    stemMixer_.render(jobs, jobCount, frames);
+    // Layered synths play over their mood's stems.
+    if (cur.synth.layer && currentStems_ && currentStems_->count() > 0) {
+        synthCur_->render(musicA_, frames, densityCur);
+    }
+    if (fading_ && tgt.synth.layer && targetStems_ && targetStems_->count() > 0) {
+        synthTgt_->render(musicB_, frames, densityTgt);
+    }
+    mark = endStage(DspStage::Stems, mark, frames);
+
+    if (fading_) {
+        equalPowerCrossfade(musicA_, musicB_, renderFade_, mixed_, frames);
+
+        renderFade_ += static_cast<float>(frames) / (sampleRate_ * renderFadeSeconds_);
+        if (renderFade_ >= 1.0f) {
+            retireBank(currentStems_);
+            currentStems_ = targetStems_;
+            targetStems_ = nullptr;
+            renderMoodIndex_ = renderTargetIndex_;
+            renderFade_ = 1.0f;
+            fading_ = false;
+            std::swap(synthCur_, synthTgt_);
+            synthTgt_->setPatch(nullptr, 0, 0.0f);
+        }
     } else {
-        generateMusic(tgt, densityTgt, musicB_, musicPhase_);
+        copyBus(musicA_, mixed_, frames);
     }
-
-    equalPowerCrossfade(musicA_, musicB_, machine_.crossfade(), mixed_);
+    mark = endStage(DspStage::Crossfade, mark, frames);
 
     // Voice
-    renderVoice(voice_, frames);
-    duck_.process(voice_, mixed_, sampleRate_);
-    
-    // Mix Voice & Binaural Beats
-    constexpr float kBinauralGain = 0.03f; // Subtle background hum (-30dB)
-    
-    // Process Binaural directly into mixed
-    // Note: mixed is mono currently? No, mixed is vector<float> representing mono mix before stereo split? 
-    // Wait, renderMixed and equalPowerCrossfade seem to work on mono buffers.
-    // But binaural REQUIRES stereo separation.
-    // My architecture merges to mono 'mixed_' then applies Reverb (which outputs mono? SimplePlateReverb is mono-in-stereo-out or mono-in-mono-out?)
-    // SimplePlateReverb::process(std::vector<float>& buf, ...) - in-place mono?
-    
-    // Engine::renderBlock outputs INTERLEAVED stereo at the end.
-    // So 'mixed_' is mono up until the loop at the end.
-    // If I mix binaural into 'mixed_', I lose the stereo separation (the Beat!).
-    // I must apply binaural modulation AT THE END when creating the stereo buffer.
+    renderVoice(voice_.data(), frames);
+    mark = endStage(DspStage::Voice, mark, frames);
+    duck_.process(voice_.data(), mixed_, frames, sampleRate_);
     
     // Mix Voice
-    for (size_t i = 0; i < frames; ++i) mixed_[i] += voice_[i];
-    
-    // Apply Mono DSP (Limiter, Reverb, Breathing Filter, Melatonin Shelf)
-    // Reverb
-    MoodDspParams dsp = getDspParams(cur);
-    reverb_.setParams(dsp.reverbPreDelay, dsp.reverbDecay, 0.25f);
-    reverb_.process(mixed_, dsp.reverbWet);
+    addMonoToBus(voice_.data(), mixed_, frames);
+    mark = endStage(DspStage::Ducking, mark, frames);
     
-    // Breathing Filter
-    breathingLp_.processBlock(mixed_);
+    // Apply Bus DSP (Reverb, Breathing Filter + Melatonin Shelf, Limiter)
+    reverb_.process(mixed_, frames, reverbWet_);
+    convolution_.process(mixed_, frames, convolutionWet_);
+    mark = endStage(DspStage::Reverb, mark, frames);
     
-    // Melatonin Shelf
-    melatoninShelf_.processBlock(mixed_);
-    
-    limiter_.process(mixed_);
-
-    // Final Stereo Mix + Binaural Injection
-    for (size_t i = 0; i < frames; ++i) {
-        float mono = mixed_[i];
-        
-        // Generate binaural samples
-        float binL = binauralLeft_.process() * kBinauralGain;
-        float binR = binauralRight_.process() * kBinauralGain;
-        
-        out[2 * i]     = mono + binL;
-        out[2 * i + 1] = mono + binR;
-    }
-
-    machine_.update(static_cast<float>(blockSize_) / sampleRate_);
-    return rms(mixed_);
+    // Breathing lowpass and melatonin shelf, in one pass (skipped while
+    // both are flat, e.g. daytime with the lowpass open)
+    busFilters_.processBlock(mixed_, frames);
+    mark = endStage(DspStage::Filters, mark, frames);
+
+    // Loudness is measured before the binaural bed goes in.
+    const float sumSq = busSumSquares(mixed_, frames);
+
+    // Binaural beats need their L/R separation, so they skip the reverb and
+    // filters; they still go through the limiter, which alone holds the
+    // output under its ceiling.
+    binaural_.processBlock(mixed_.channel(0), mixed_.channel(1), frames, kBinauralGain);
+    mark = endStage(DspStage::Binaural, mark, frames);
+
+    // True-peak lookahead limiter; delays the bus by
+    // limiter_.latencyFrames() (about 1.6 ms).
+    limiter_.process(mixed_, frames);
+
+    // Final Stereo Interleave
+    const auto &k = simd::kernels();
+    k.interleave2(out, mixed_.channel(0), mixed_.channel(1), frames);
+    k.clamp(out, -1.0f, 1.0f, 2 * frames);
+    mark = endStage(DspStage::Limiter, mark, frames);
+    if (blockStart != 0) {
+        profiler_.record(DspStage::Total, mark - blockStart, frames);
+    }
+
+    return sumSq;
 }
 
 PublicState Engine::snapshot() const {
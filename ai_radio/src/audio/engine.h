@@ -7,28 +7,28 @@
 #include <mutex>
 #include <cstdint>
 #include "reverb.h"
+#include "convolution.h"
 #include "ducking.h"
 #include "crossfade.h"
 #include "limiter.h"
 #include "scheduler.h"
 #include "stem_player.h"
+#include "stem_mixer.h"
+#include "stem_loader.h"
 #include "../brain/state_machine.h"
 #include "../brain/app_heuristics.h"
 #include "../voice/story_bank.h"
 #include "../brain/story_generator.h"
 #include "oscillator.h"
+#include "synth.h"
 #include "filter.h"
+#include "bus.h"
+#include "command_queue.h"
+#include "engine_command.h"
+#include "profiler.h"
 
 namespace audio {
 
-// DSP parameters per mood for audio processing.
-struct MoodDspParams {
-    float reverbWet = 0.3f;
-    float reverbDecay = 0.5f;
-    float reverbPreDelay = 20.0f;
-    float masterLpHz = 18000.0f;
-};
-
 // Snapshot of state for UI/HTTP/SSE.
 struct PublicState {
     std::string moodId;
@@ -44,31 +44,71 @@ struct PublicState {
 
 class Engine {
 public:
+    // Largest chunk renderBlock processes at once; scratch buffers are
+    // preallocated to this size. Larger host blocks are split.
+    static constexpr size_t kMaxBlockFrames = 4096;
+    // Level of the binaural bed, mixed in just ahead of the limiter.
+    static constexpr float kBinauralGain = 0.03f; // Subtle background hum (-30dB)
+
     Engine(float sampleRate = 48000.0f, size_t blockSize = 256);
+    ~Engine();
+
+    Engine(const Engine &) = delete;
+    Engine &operator=(const Engine &) = delete;
+
+    // Not real-time safe: call before the audio device starts.
+    // startMoodId picks the mood playing at t=0 (defaults to the first one).
+    void setMoodPack(brain::MoodPack pack, const std::string &startMoodId = {});
 
-    void setMoodPack(brain::MoodPack pack);
+    // Offline engines (keegan_render) ignore host inputs: no app heuristics,
+    // no input polling, no LLM story requests and no time-of-day shelf.
+    // Activity is pinned to the given value so renders are reproducible.
+    void setOffline(bool offline, float activity = 1.0f);
+
+    // Not real-time safe: call before the audio device starts. Renders stems
+    // on `workers` extra threads (0 = serial, the default); firstCpu >= 0
+    // pins them to consecutive CPUs.
+    void setStemWorkers(size_t workers, int firstCpu = -1);
+
+    // Mood changes load the incoming stem bank on a background thread (the
+    // default) and start the crossfade only once it is fully decoded. With
+    // async off, tick() loads it inline, so transitions land on the same
+    // tick every run. Call before the audio device starts.
+    void setAsyncStemLoading(bool async);
+
+    // Safe from any thread; applied on the next tick / audio block.
     void setIntensity(float value);
-    void setMood(const std::string& moodId);
+    // With atSample (on the engine's sample clock, which counts rendered
+    // frames from 0) the crossfade starts on that exact sample, provided the
+    // request reaches a tick before then; scripted runs post a tick ahead.
+    void setMood(const std::string& moodId, uint64_t atSample = 0);
 
     // Active process name feeds heuristics to bias target mood/energy.
     void tick(const std::string &activeProcess, float dtSeconds);
 
     // Render one block into interleaved stereo output buffer.
+    // Audio thread only: drains pending commands, never locks.
     // Returns RMS of mixed output.
     float renderBlock(float *out, size_t frames);
 
     // Get current state for UI feedback.
-    float currentEnergy() const { return intensity_; }
+    float currentEnergy() const { return intensity_.load(std::memory_order_relaxed); }
     const std::string& currentMoodId() const;
-    bool isPlaying() const { return isPlaying_; }
-    void setPlaying(bool playing) { isPlaying_ = playing; }
+    bool isPlaying() const { return playing_.load(std::memory_order_relaxed); }
+    void setPlaying(bool playing);
     PublicState snapshot() const;
 
+    // Rolling per-stage renderBlock timings; safe to call while audio runs.
+    DspProfile dspProfile() const { return profiler_.snapshot(); }
+    void setProfilingEnabled(bool enabled) { profiler_.setEnabled(enabled); }
+
 private:
     float sampleRate_;
     size_t blockSize_;
-    float intensity_;
-    bool isPlaying_ = true;
+    std::atomic<float> intensity_;
+    std::atomic<bool> playing_{true};
+    bool offline_ = false;
+    float offlineActivity_ = 1.0f;
     float timeSinceLastStory_ = 0.0f; 
 
     brain::MoodPack pack_;
@@ -79,49 +119,129 @@ private:
     // Voice system
     voice::StoryBank storyBank_;
     brain::StoryGenerator storyGen_;
-    
-    // Thread safety for next story
-    std::mutex voiceMutex_;
-    std::shared_ptr<voice::Story> nextStory_ = nullptr;
-    std::shared_ptr<voice::Story> currentStory_ = nullptr;
 
     Scheduler scheduler_;
     DuckingCompressor duck_;
-    SimplePlateReverb reverb_;
-    SoftLimiter limiter_;
+    FdnReverb reverb_;
+    ConvolutionReverb convolution_;
+    LookaheadLimiter limiter_;
     
     // Audio Intelligence (Phase 3.5)
-    Oscillator binauralLeft_;
-    Oscillator binauralRight_;
-    BiquadFilter breathingLp_;
-    BiquadFilter melatoninShelf_;
+    SineOscPair binaural_;
+    // Breathing lowpass, then melatonin shelf.
+    static constexpr size_t kBreathingLp = 0;
+    static constexpr size_t kMelatoninShelf = 1;
+    BiquadCascade busFilters_;
+    DspProfiler profiler_;
+    StemMixer stemMixer_;
+    // Null when stem banks load synchronously on the tick thread.
+    std::unique_ptr<StemLoader> stemLoader_;
     
-    float binLeftFreq_ = 200.0f;
-    float binRightFreq_ = 240.0f; // 40Hz offset (Gamma)
-
-    // Stem banks for current and target moods
-    StemBank currentStems_;
-    StemBank targetStems_;
-    size_t currentMoodIndex_ = 0;
+    // Last values posted to the audio thread (tick thread only).
+    float lpCutoffHz_ = 20000.0f;
+    float shelfGainDb_ = 0.0f;
     size_t targetMoodIndex_ = 0;
+    // Last mood whose bank went to the audio thread.
+    size_t postedMoodIndex_ = 0;
+    // Latest timed mood request; its transition waits for requestedAt_.
+    size_t requestedMoodIndex_ = SIZE_MAX;
+    uint64_t requestedAt_ = 0;
+
+    struct MoodRequest {
+        size_t moodIndex = 0;
+        uint64_t atSample = 0;
+    };
+
+    // Command queues: any thread -> audio, any thread -> tick, audio -> tick.
+    CommandQueue<EngineCommand, 256> commands_;
+    CommandQueue<MoodRequest, 16> moodRequests_;
+    CommandQueue<StemBank *, 64> retiredBanks_;
+    CommandQueue<StemPlayer *, 16> retiredVoices_;
+
+    // Audio-thread state. Only renderBlock touches these once the device runs;
+    // everything else reaches them through commands_.
+    StemBank *currentStems_ = nullptr;
+    StemBank *targetStems_ = nullptr;
+    // The story playing, on its own player: the audio thread is the only
+    // one that touches it until it is retired.
+    StemPlayer *currentVoice_ = nullptr;
+    size_t renderMoodIndex_ = 0;
+    size_t renderTargetIndex_ = 0;
+    float renderFade_ = 1.0f;
+    float renderFadeSeconds_ = 8.0f;
+    bool fading_ = false;
+    bool renderPlaying_ = true;
+    float renderIntensity_;
+    float renderLpCutoffHz_ = 20000.0f;
+    float renderShelfGainDb_ = 0.0f;
+    float reverbWet_ = 0.3f;
+    float convolutionWet_ = 0.0f;
+
+    // Per-mood DSP settings, indexed like pack_.moods. Rebuilt only by
+    // setMoodPack, so the audio thread reads it without string lookups.
+    std::vector<brain::MoodDsp> dspTable_;
+    // Each mood's synth preset, loaded alongside dspTable_ (loaded == false
+    // when the mood has none).
+    std::vector<SynthPatch> synthTable_;
+    // Each mood's impulse response, transformed at pack load (null when the
+    // mood uses the FDN). Moods naming the same file share one.
+    std::vector<std::shared_ptr<const ConvolutionIr>> irTable_;
 
-    // Fallback procedural generation
-    float musicPhase_;
+    // Procedural music: the mood's synth, or a sine when it has no preset.
+    // The playing and incoming moods each get a synth; they swap when a
+    // crossfade completes.
+    ProceduralSynth synthA_;
+    ProceduralSynth synthB_;
+    ProceduralSynth *synthCur_ = &synthA_;
+    ProceduralSynth *synthTgt_ = &synthB_;
+    Oscillator musicOsc_; // sine fallback, shared by both moods
     
-    // Buffers reused per render
-    std::vector<float> musicA_;
-    std::vector<float> musicB_;
+    // Buffers reused per render. Music runs on planar stereo buses up to the
+    // final interleave; the voice is a mono sidechain panned centre.
+    AudioBus musicA_;
+    AudioBus musicB_;
     std::vector<float> voice_;
-    std::vector<float> mixed_;
+    AudioBus mixed_;
 
-    // DSP params per mood
-    MoodDspParams getDspParams(const brain::MoodRecipe& recipe);
+    void compileDspTable();
+    // Audio thread: points synth at moodIndex's preset and restarts its pattern.
+    void setSynthMood(ProceduralSynth &synth, size_t moodIndex);
+    // Audio thread: points the convolution reverb at the incoming mood's IR
+    // (crossfading over the rest of the mood fade), or drops it once a mood
+    // without one has faded its wet out.
+    void updateConvolutionIr();
+
+    // Audio thread: retargets reverb, filters and binaural for this block
+    // (interpolated between moods while fading); the DSP glides from there.
+    void applyMoodDsp();
 
     void loadStemsForMood(size_t moodIndex, StemBank& bank);
-    void generateMusic(const brain::MoodRecipe &recipe, float density, std::vector<float> &out, float &phase);
+    void beginTransition(size_t moodIndex, StemBank *bank);
+    void post(const EngineCommand &cmd);
+    // Audio thread: applies commands due now and moves timed ones onto the
+    // scheduler's timeline.
+    void drainCommands();
+    void applyCommand(const EngineCommand &cmd);
+    // Audio thread: applies the timeline events due at the clock and returns
+    // how many of maxFrames to render before the next one.
+    size_t nextEventChunk(size_t maxFrames);
+    void retireBank(StemBank *bank);
+    void retireVoice(StemPlayer *voice);
+    // Tick thread: frees the banks and story players the audio thread has
+    // let go of (dropping their sample references).
+    void collectRetired();
+    void generateMusic(const brain::MoodRecipe &recipe, float density, AudioBus &out, size_t frames, ProceduralSynth &synth);
     
     // Renders active voice player or silence
-    void renderVoice(std::vector<float> &out, size_t frames);
+    void renderVoice(float *out, size_t frames);
+
+    // Renders at most kMaxBlockFrames; returns the sum of squares of the mix
+    // (averaged across channels).
+    float renderChunk(float *out, size_t frames);
+
+    // Closes a profiled stage (and, with KEEGAN_RT_CHECKS, attributes what
+    // follows to the next stage).
+    uint64_t endStage(DspStage stage, uint64_t mark, size_t frames);
     
     // Check if we should trigger a story
     void updateNarrativeLogic(const brain::MoodRecipe& recipe, float dt);
@@ -129,6 +249,9 @@ private:
     // Update binaural frequencies and filter settings
     void updateBioReactiveDsp(float dt);
 
+    // Input activity 0..1 (pinned in offline mode).
+    float currentActivity() const;
+
     // Public state for UI/SSE.
     mutable std::mutex publicStateMutex_;
     PublicState publicState_;
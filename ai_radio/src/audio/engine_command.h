@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace audio {
+
+class StemBank;
+class StemPlayer;
+
+// Control-to-audio message. Posted by the tick thread, web handlers and tray
+// callbacks; drained by renderBlock at block boundaries. Commands with an
+// atSample wait on the Scheduler's timeline and apply at that exact sample.
+struct EngineCommand {
+    enum class Type : uint8_t {
+        SetPlaying,      // a = 0/1
+        SetIntensity,    // a = intensity
+        BeginTransition, // moodIndex, bank (ownership passes to the audio thread), a = fade seconds
+        PlayStory,       // voice (ownership passes to the audio thread)
+        SetFilters       // a = breathing LP cutoff Hz, b = melatonin shelf gain dB
+    };
+
+    Type type = Type::SetPlaying;
+    float a = 0.0f;
+    float b = 0.0f;
+    size_t moodIndex = 0;
+    StemBank *bank = nullptr;
+    StemPlayer *voice = nullptr;
+    // Scheduler sample clock time to apply at; 0 applies at the next block.
+    uint64_t atSample = 0;
+};
+
+} // namespace audio
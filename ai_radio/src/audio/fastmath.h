@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+namespace audio::fastmath {
+
+// Float approximations of the transcendentals the audio thread uses for
+// gains, envelopes and filter design. They avoid libm calls, tables and
+// branches, so a loop calling them vectorises (GCC also needs
+// -fno-trapping-math, which the build sets). Polynomials are minimax fits.
+// The error bounds are the worst case `keegan_render --fastmath-check`
+// measures against double-precision libm over each function's range; the
+// check fails if any bound is exceeded.
+
+constexpr float kExp2MaxRelError = 2.5e-7f;
+constexpr float kLog2MaxError = 2e-7f;      // times max(1, |log2 x|)
+constexpr float kDbMaxAbsErrorDb = 2e-5f;   // db2lin (read back) and lin2db, -120..+80 dB
+constexpr float kTanhMaxAbsError = 2e-7f;
+constexpr float kSinMaxAbsError = 2.5e-7f;
+constexpr float kSinMaxArg = 1.0e4f;
+
+namespace detail {
+// Adding and subtracting 1.5 * 2^23 rounds a float with |x| < 2^22 to the
+// nearest integer, in the FPU's rounding mode, with no libm call.
+inline float roundToInt(float x) {
+    constexpr float kMagic = 12582912.0f;
+    return (x + kMagic) - kMagic;
+}
+} // namespace detail
+
+// 2^x. x is clamped to [-125, 127], so very negative inputs give 2^-125
+// rather than 0. Relative error < kExp2MaxRelError.
+inline float exp2(float x) {
+    x = std::clamp(x, -125.0f, 127.0f);
+    const float whole = detail::roundToInt(x);
+    const float f = x - whole; // [-0.5, 0.5]
+    const float p =
+        1.0f + f * (6.931469776e-1f + f * (2.402224208e-1f + f * (5.550733754e-2f +
+                                                               f * (9.671512869e-3f + f * 1.326472392e-3f))));
+    const uint32_t scale = static_cast<uint32_t>(static_cast<int32_t>(whole)) << 23;
+    return std::bit_cast<float>(std::bit_cast<uint32_t>(p) + scale);
+}
+
+// log2(x) for x > 0. Inputs below FLT_MIN, including 0 and negatives, are
+// clamped to it (-126). Error < kLog2MaxError * max(1, |log2 x|): absolute
+// near 1, float rounding of the result further out.
+inline float log2(float x) {
+    x = std::max(x, FLT_MIN);
+    // Split x = 2^e * m with m in [sqrt(1/2), sqrt(2)), then
+    // log2(m) = 2 atanh(t) / ln 2 with t = (m - 1) / (m + 1), |t| < 0.172.
+    const int32_t bits = std::bit_cast<int32_t>(x);
+    const int32_t e = (bits - 0x3f3504f3) >> 23;
+    const float m = std::bit_cast<float>(static_cast<uint32_t>(bits) - (static_cast<uint32_t>(e) << 23));
+    const float t = (m - 1.0f) / (m + 1.0f);
+    const float t2 = t * t;
+    return static_cast<float>(e) + t * (2.885391289f + t2 * (9.614708094e-1f + t2 * 5.989738745e-1f));
+}
+
+// Decibels to linear gain and back, within kDbMaxAbsErrorDb between -120
+// and +80 dB (db2lin measured by reading its result back in dB). lin2db of
+// silence is about -758 dB.
+inline float db2lin(float db) { return exp2(db * 0.16609640474f); }
+inline float lin2db(float gain) { return 6.0205999133f * log2(gain); }
+
+// tanh(x), absolute error < kTanhMaxAbsError (relative error grows near 0,
+// where tanh(x) ~ x).
+inline float tanh(float x) {
+    const float a = std::min(std::fabs(x), 9.0f);
+    const float e = exp2(2.885390082f * a); // e^(2a)
+    return std::copysign(1.0f - 2.0f / (e + 1.0f), x);
+}
+
+// sin(x) for |x| <= kSinMaxArg, absolute error < kSinMaxAbsError.
+inline float sin(float x) {
+    // x = q * pi + r with |r| <= pi / 2, pi split in two so q * pi is exact.
+    const float q = detail::roundToInt(x * 0.31830988618f);
+    const float r = (x - q * 3.140625f) - q * 9.67653589793e-4f;
+    const float r2 = r * r;
+    const float s = r * (9.999999947e-1f + r2 * (-1.666665668e-1f + r2 * (8.333025135e-3f +
+                                                                      r2 * (-1.980741851e-4f + r2 * 2.601902659e-6f))));
+    // sin(r + q pi) = (-1)^q sin(r)
+    const uint32_t sign = static_cast<uint32_t>(static_cast<int32_t>(q)) << 31;
+    return std::bit_cast<float>(std::bit_cast<uint32_t>(s) ^ sign);
+}
+
+} // namespace audio::fastmath
@@ -0,0 +1,149 @@
+#include "fft.h"
+#include <cmath>
+#include <utility>
+
+namespace audio {
+
+RealFft::RealFft(size_t size)
+    : size_(size),
+      half_(size / 2),
+      bitrev_(half_),
+      twRe_(half_),
+      twIm_(half_),
+      splitRe_(half_ + 1),
+      splitIm_(half_ + 1),
+      workRe_(half_),
+      workIm_(half_) {
+    size_t bits = 0;
+    while ((size_t(1) << bits) < half_) ++bits;
+    for (size_t j = 0; j < half_; ++j) {
+        uint32_t r = 0;
+        for (size_t b = 0; b < bits; ++b) r |= static_cast<uint32_t>((j >> b) & 1u) << (bits - 1 - b);
+        bitrev_[j] = r;
+    }
+    constexpr double kTwoPi = 6.283185307179586476925;
+    for (size_t j = 0; j < half_; ++j) {
+        const double phase = -kTwoPi * static_cast<double>(j) / static_cast<double>(half_);
+        twRe_[j] = static_cast<float>(std::cos(phase));
+        twIm_[j] = static_cast<float>(std::sin(phase));
+    }
+    for (size_t k = 0; k <= half_; ++k) {
+        const double phase = -kTwoPi * static_cast<double>(k) / static_cast<double>(size_);
+        splitRe_[k] = static_cast<float>(std::cos(phase));
+        splitIm_[k] = static_cast<float>(std::sin(phase));
+    }
+}
+
+void RealFft::bitReverse() {
+    for (size_t j = 0; j < half_; ++j) {
+        const size_t r = bitrev_[j];
+        if (j < r) {
+            std::swap(workRe_[j], workRe_[r]);
+            std::swap(workIm_[j], workIm_[r]);
+        }
+    }
+}
+
+void RealFft::transform() {
+    float *re = workRe_.data();
+    float *im = workIm_.data();
+    const size_t m = half_;
+    size_t len = 1;
+    // log2(m) odd: one radix-2 stage first, then radix-4 the rest of the way.
+    size_t bits = 0;
+    while ((size_t(1) << bits) < m) ++bits;
+    if (bits & 1) {
+        for (size_t i = 0; i < m; i += 2) {
+            const float ar = re[i], ai = im[i];
+            re[i] = ar + re[i + 1];
+            im[i] = ai + im[i + 1];
+            re[i + 1] = ar - re[i + 1];
+            im[i + 1] = ai - im[i + 1];
+        }
+        len = 2;
+    }
+    // Each stage merges four consecutive length-len transforms. In
+    // bit-reversed order they hold the residues 0, 2, 1, 3 (mod 4) of the
+    // merged sequence, hence the A2 / A1 placement.
+    for (; len < m; len *= 4) {
+        const size_t stride = m / (4 * len);
+        for (size_t base = 0; base < m; base += 4 * len) {
+            float *r0 = re + base, *i0 = im + base;
+            float *r1 = r0 + len, *i1 = i0 + len;
+            float *r2 = r1 + len, *i2 = i1 + len;
+            float *r3 = r2 + len, *i3 = i2 + len;
+            for (size_t k = 0; k < len; ++k) {
+                const float w1r = twRe_[k * stride], w1i = twIm_[k * stride];
+                const float w2r = twRe_[2 * k * stride], w2i = twIm_[2 * k * stride];
+                const float w3r = twRe_[3 * k * stride], w3i = twIm_[3 * k * stride];
+                // A1 sits in the third block, A2 in the second.
+                const float b1r = r2[k] * w1r - i2[k] * w1i, b1i = r2[k] * w1i + i2[k] * w1r;
+                const float b2r = r1[k] * w2r - i1[k] * w2i, b2i = r1[k] * w2i + i1[k] * w2r;
+                const float b3r = r3[k] * w3r - i3[k] * w3i, b3i = r3[k] * w3i + i3[k] * w3r;
+                const float t0r = r0[k] + b2r, t0i = i0[k] + b2i;
+                const float t1r = r0[k] - b2r, t1i = i0[k] - b2i;
+                const float t2r = b1r + b3r, t2i = b1i + b3i;
+                const float t3r = b1r - b3r, t3i = b1i - b3i;
+                r0[k] = t0r + t2r;
+                i0[k] = t0i + t2i;
+                r2[k] = t0r - t2r;
+                i2[k] = t0i - t2i;
+                // t1 -/+ i * t3
+                r1[k] = t1r + t3i;
+                i1[k] = t1i - t3r;
+                r3[k] = t1r - t3i;
+                i3[k] = t1i + t3r;
+            }
+        }
+    }
+}
+
+void RealFft::forward(const float *in, float *re, float *im) {
+    // Even samples as the real part, odd as the imaginary.
+    for (size_t j = 0; j < half_; ++j) {
+        workRe_[j] = in[2 * j];
+        workIm_[j] = in[2 * j + 1];
+    }
+    bitReverse();
+    transform();
+
+    const float *zr = workRe_.data();
+    const float *zi = workIm_.data();
+    re[0] = zr[0] + zi[0];
+    im[0] = 0.0f;
+    re[half_] = zr[0] - zi[0];
+    im[half_] = 0.0f;
+    for (size_t k = 1; k < half_; ++k) {
+        // Even part E = (Z[k] + conj(Z[m-k])) / 2, odd part O = -i (Z[k] -
+        // conj(Z[m-k])) / 2, X[k] = E + w^k O.
+        const float cr = zr[half_ - k], ci = -zi[half_ - k];
+        const float er = 0.5f * (zr[k] + cr), ei = 0.5f * (zi[k] + ci);
+        const float dr = 0.5f * (zr[k] - cr), di = 0.5f * (zi[k] - ci);
+        const float orr = di, oi = -dr;
+        re[k] = er + splitRe_[k] * orr - splitIm_[k] * oi;
+        im[k] = ei + splitRe_[k] * oi + splitIm_[k] * orr;
+    }
+}
+
+void RealFft::inverse(const float *re, const float *im, float *out) {
+    // Rebuild the packed half-size spectrum Z[k] = E + i O, conjugated so
+    // the forward transform computes the inverse.
+    for (size_t k = 0; k < half_; ++k) {
+        const float cr = re[half_ - k], ci = -im[half_ - k];
+        const float er = 0.5f * (re[k] + cr), ei = 0.5f * (im[k] + ci);
+        const float dr = 0.5f * (re[k] - cr), di = 0.5f * (im[k] - ci);
+        // O = D * conj(w^k)
+        const float orr = dr * splitRe_[k] + di * splitIm_[k];
+        const float oi = di * splitRe_[k] - dr * splitIm_[k];
+        workRe_[k] = er - oi;
+        workIm_[k] = -(ei + orr);
+    }
+    bitReverse();
+    transform();
+    for (size_t j = 0; j < half_; ++j) {
+        out[2 * j] = workRe_[j];
+        out[2 * j + 1] = -workIm_[j];
+    }
+}
+
+} // namespace audio
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace audio {
+
+// Real-input FFT of a fixed power-of-two size. The real signal is packed
+// into a complex FFT of half the size (radix-4 stages, plus one radix-2
+// stage when the half size is an odd power of two) and split back into
+// size / 2 + 1 bins. Spectra are split-complex: real and imaginary parts in
+// separate arrays, so spectral products vectorise with
+// simd::complexMulAdd.
+//
+// Tables and scratch are allocated in the constructor; forward and inverse
+// never allocate, so the audio thread can run them.
+class RealFft {
+public:
+    // size must be a power of two >= 4.
+    explicit RealFft(size_t size);
+
+    size_t size() const { return size_; }
+    size_t bins() const { return half_ + 1; }
+
+    // in: size() samples. re, im: bins() values each; the imaginary parts
+    // of DC and Nyquist are zero.
+    void forward(const float *in, float *re, float *im);
+    // Unnormalised: inverse(forward(x)) == size() / 2 * x. Callers fold the
+    // 2 / size() into their spectra. out: size() samples.
+    void inverse(const float *re, const float *im, float *out);
+
+private:
+    // In-place complex FFT of work_, which must already be in bit-reversed
+    // order.
+    void transform();
+    void bitReverse();
+
+    size_t size_;
+    size_t half_;
+    std::vector<uint32_t> bitrev_;
+    // e^(-2 pi i j / half) for the complex stages, and e^(-2 pi i k / size)
+    // for the real split.
+    std::vector<float> twRe_, twIm_;
+    std::vector<float> splitRe_, splitIm_;
+    std::vector<float> workRe_, workIm_;
+};
+
+} // namespace audio
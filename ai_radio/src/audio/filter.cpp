@@ -0,0 +1,202 @@
+#include "filter.h"
+#include <algorithm>
+#include <numbers>
+#include "fastmath.h"
+
+namespace audio {
+
+namespace {
+// Block-end states below this are flushed to zero, so a filter ringing out
+// into silence does not sit in denormals.
+constexpr float kDenormalFloor = 1e-30f;
+
+bool isPassThrough(const BiquadCoeffs &c) {
+    return c.b0 == 1.0f && c.b1 == 0.0f && c.b2 == 0.0f && c.a1 == 0.0f && c.a2 == 0.0f;
+}
+} // namespace
+
+BiquadCoeffs BiquadCoeffs::design(BiquadType type, float freq, float q, float gainDb, float sampleRate) {
+    // Redesigned every sub-block while gliding, so the trig goes through
+    // fastmath. cos comes from the half angle, 1 - cos w = 2 sin^2(w / 2),
+    // which also keeps the lowpass numerator accurate at low cutoffs.
+    freq = std::fmin(freq, 0.45f * sampleRate);
+    const float omega = 2.0f * std::numbers::pi_v<float> * freq / sampleRate;
+    const float sn = fastmath::sin(omega);
+    const float half = fastmath::sin(0.5f * omega);
+    const float oneMinusCs = 2.0f * half * half;
+    const float cs = 1.0f - oneMinusCs;
+    const float alpha = sn / (2.0f * q);
+
+    BiquadCoeffs c;
+    float a0 = 1.0f;
+    switch (type) {
+        case BiquadType::LowPass:
+            c.b0 = oneMinusCs / 2.0f;
+            c.b1 = oneMinusCs;
+            c.b2 = oneMinusCs / 2.0f;
+            a0 = 1.0f + alpha;
+            c.a1 = -2.0f * cs;
+            c.a2 = 1.0f - alpha;
+            break;
+        case BiquadType::HighPass:
+            c.b0 = (1.0f + cs) / 2.0f;
+            c.b1 = -(1.0f + cs);
+            c.b2 = (1.0f + cs) / 2.0f;
+            a0 = 1.0f + alpha;
+            c.a1 = -2.0f * cs;
+            c.a2 = 1.0f - alpha;
+            break;
+        case BiquadType::HighShelf: {
+            const float A = fastmath::db2lin(0.5f * gainDb); // 10^(gainDb / 40)
+            const float sqrtA = fastmath::db2lin(0.25f * gainDb);
+            c.b0 = A * ((A + 1.0f) + (A - 1.0f) * cs + 2.0f * sqrtA * alpha);
+            c.b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cs);
+            c.b2 = A * ((A + 1.0f) + (A - 1.0f) * cs - 2.0f * sqrtA * alpha);
+            a0 = (A + 1.0f) - (A - 1.0f) * cs + 2.0f * sqrtA * alpha;
+            c.a1 = 2.0f * ((A - 1.0f) - (A + 1.0f) * cs);
+            c.a2 = (A + 1.0f) - (A - 1.0f) * cs - 2.0f * sqrtA * alpha;
+            break;
+        }
+    }
+
+    c.b0 /= a0;
+    c.b1 /= a0;
+    c.b2 /= a0;
+    c.a1 /= a0;
+    c.a2 /= a0;
+    return c;
+}
+
+bool biquadIsFlat(BiquadType type, float freq, float gainDb) {
+    switch (type) {
+        case BiquadType::LowPass: return freq >= kFlatLowPassHz;
+        case BiquadType::HighPass: return freq <= kFlatHighPassHz;
+        case BiquadType::HighShelf: return std::fabs(gainDb) < kFlatGainDb;
+    }
+    return false;
+}
+
+BiquadCascade::BiquadCascade(float sampleRate) : sampleRate_(sampleRate) {
+    setGlideTime(50.0f);
+    for (size_t s = 0; s < kSections; ++s) rampSection(s, BiquadCoeffs{}, 0);
+}
+
+void BiquadCascade::setParams(size_t section, BiquadType type, float freq, float q, float gainDb) {
+    Section &s = sections_[section];
+    s.type = type;
+    s.q = q;
+    s.freq = freq;
+    s.gainDb = gainDb;
+    s.logFreq.reset(std::log2(freq));
+    s.gain.reset(gainDb);
+    s.coeffs = designFor(s);
+    rampSection(section, s.coeffs, 0);
+    bypassed_ = false;
+}
+
+void BiquadCascade::setTarget(size_t section, BiquadType type, float freq, float q, float gainDb) {
+    Section &s = sections_[section];
+    if (type != s.type || q != s.q) {
+        setParams(section, type, freq, q, gainDb);
+        return;
+    }
+    // Called every control tick; most ticks change nothing.
+    if (freq == s.freq && gainDb == s.gainDb) return;
+    s.freq = freq;
+    s.gainDb = gainDb;
+    s.logFreq.setTarget(std::log2(freq));
+    s.gain.setTarget(gainDb);
+}
+
+void BiquadCascade::setGlideTime(float ms) {
+    for (Section &s : sections_) {
+        s.logFreq.setTime(ms, sampleRate_ / kSubBlock);
+        s.gain.setTime(ms, sampleRate_ / kSubBlock);
+    }
+}
+
+BiquadCoeffs BiquadCascade::designFor(const Section &s) const {
+    // Settled sections use the target itself: exp2(log2(f)) can round just
+    // below a flat threshold.
+    const float freq = s.logFreq.settled() ? s.freq : std::exp2(s.logFreq.current());
+    const float gainDb = s.gain.current();
+    if (biquadIsFlat(s.type, freq, gainDb)) return BiquadCoeffs{};
+    return BiquadCoeffs::design(s.type, freq, s.q, gainDb, sampleRate_);
+}
+
+void BiquadCascade::rampSection(size_t section, const BiquadCoeffs &to, size_t frames) {
+    const float step = frames > 0 ? 1.0f / static_cast<float>(frames) : 0.0f;
+    for (size_t l = 2 * section; l < 2 * section + 2; ++l) {
+        if (frames == 0) {
+            ramp_.b0[l] = to.b0;
+            ramp_.b1[l] = to.b1;
+            ramp_.b2[l] = to.b2;
+            ramp_.a1[l] = to.a1;
+            ramp_.a2[l] = to.a2;
+        }
+        ramp_.db0[l] = (to.b0 - ramp_.b0[l]) * step;
+        ramp_.db1[l] = (to.b1 - ramp_.b1[l]) * step;
+        ramp_.db2[l] = (to.b2 - ramp_.b2[l]) * step;
+        ramp_.da1[l] = (to.a1 - ramp_.a1[l]) * step;
+        ramp_.da2[l] = (to.a2 - ramp_.a2[l]) * step;
+    }
+}
+
+void BiquadCascade::runRange(AudioBus &bus, size_t offset, size_t frames) {
+    const auto &k = simd::kernels();
+    const size_t channels = bus.channels();
+    for (size_t c = 0; c < channels; c += 2) {
+        PairState &pair = pairs_[c / 2];
+        simd::BiquadState bq = ramp_;
+        std::copy(pair.z1, pair.z1 + simd::kBiquadLanes, bq.z1);
+        std::copy(pair.z2, pair.z2 + simd::kBiquadLanes, bq.z2);
+        float *left = bus.channel(c) + offset;
+        float *right = c + 1 < channels ? bus.channel(c + 1) + offset : left;
+        k.biquad2x2(bq, left, right, frames);
+        for (size_t l = 0; l < simd::kBiquadLanes; ++l) {
+            pair.z1[l] = std::fabs(bq.z1[l]) < kDenormalFloor ? 0.0f : bq.z1[l];
+            pair.z2[l] = std::fabs(bq.z2[l]) < kDenormalFloor ? 0.0f : bq.z2[l];
+        }
+    }
+}
+
+bool BiquadCascade::drained() const {
+    for (const PairState &pair : pairs_) {
+        for (size_t l = 0; l < simd::kBiquadLanes; ++l) {
+            if (pair.z1[l] != 0.0f || pair.z2[l] != 0.0f) return false;
+        }
+    }
+    return true;
+}
+
+void BiquadCascade::processBlock(AudioBus &bus, size_t frames) {
+    if (bus.channels() == 0 || frames == 0) return;
+    const bool gliding = std::any_of(sections_.begin(), sections_.end(), [](const Section &s) {
+        return !s.logFreq.settled() || !s.gain.settled();
+    });
+    if (!gliding) {
+        if (bypassed_) return;
+        runRange(bus, 0, frames);
+    } else {
+        for (size_t offset = 0; offset < frames; offset += kSubBlock) {
+            const size_t n = std::min(kSubBlock, frames - offset);
+            for (size_t i = 0; i < kSections; ++i) {
+                Section &s = sections_[i];
+                if (s.logFreq.settled() && s.gain.settled()) continue;
+                s.logFreq.next();
+                s.gain.next();
+                s.coeffs = designFor(s);
+                rampSection(i, s.coeffs, n);
+            }
+            runRange(bus, offset, n);
+            // Land exactly on each ramp's end rather than on the sum of its
+            // deltas.
+            for (size_t i = 0; i < kSections; ++i) rampSection(i, sections_[i].coeffs, 0);
+        }
+    }
+    bypassed_ = drained() && std::all_of(sections_.begin(), sections_.end(), [](const Section &s) {
+        return s.logFreq.settled() && s.gain.settled() && isPassThrough(s.coeffs);
+    });
+}
+
+} // namespace audio
@@ -1,99 +1,100 @@
 #pragma once
 
+#include <array>
 #include <cmath>
-#include <vector>
-#include <numbers>
+#include <cstddef>
+#include "bus.h"
+#include "simd/simd.h"
+#include "smoother.h"
 
 namespace audio {
 
-class BiquadFilter {
-public:
-    enum Type {
-        LowPass,
-        HighPass,
-        HighShelf
-    };
+enum class BiquadType {
+    LowPass,
+    HighPass,
+    HighShelf
+};
+
+// Normalised biquad coefficients (a0 = 1). The default is a pass-through.
+struct BiquadCoeffs {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+
+    // RBJ cookbook designs; freq is capped at 0.45 * sampleRate.
+    static BiquadCoeffs design(BiquadType type, float freq, float q, float gainDb, float sampleRate);
+};
 
-    BiquadFilter(float sampleRate) 
-        : sampleRate_(sampleRate), b0_(1), b1_(0), b2_(0), a1_(0), a2_(0),
-          z1_(0), z2_(0) {}
+// True when a section is inaudible and can be replaced by a pass-through:
+// a shelf within kFlatGainDb of 0 dB, a lowpass at or above kFlatLowPassHz,
+// a highpass at or below kFlatHighPassHz.
+constexpr float kFlatGainDb = 0.01f;
+constexpr float kFlatLowPassHz = 20000.0f;
+constexpr float kFlatHighPassHz = 20.0f;
+bool biquadIsFlat(BiquadType type, float freq, float gainDb);
 
-    void setParams(Type type, float freq, float q, float gainDb = 0.0f) {
-        float omega = 2.0f * std::numbers::pi_v<float> * freq / sampleRate_;
-        float sn = std::sin(omega);
-        float cs = std::cos(omega);
-        float alpha = sn / (2.0f * q);
-        float A = std::pow(10.0f, gainDb / 40.0f); // only for shelving
-        float sqrtA = std::sqrt(A);
+// Two biquad sections in series over a bus, e.g. the engine's breathing
+// lowpass followed by its melatonin shelf, in a single transposed direct
+// form II pass: simd::Kernels::biquad2x2 runs both sections on both
+// channels of a stereo pair in one 4-wide register.
+//
+// Frequency (in octaves) and gain glide per kSubBlock frames. Coefficients
+// are only redesigned while a glide moves them, and each redesign is ramped
+// in linearly over its sub-block rather than stepped, so sweeps do not
+// zipper. Both ends of a ramp are stable and the biquad stability region
+// is convex in (a1, a2), so every coefficient set on the way is too. A flat
+// section runs as an exact pass-through; once both are flat and their
+// state has drained, processBlock returns without touching the bus.
+class BiquadCascade {
+public:
+    static constexpr size_t kSections = 2;
+    static constexpr size_t kSubBlock = 32;
+
+    explicit BiquadCascade(float sampleRate);
 
-        float a0 = 1.0f;
+    // Jump straight to new settings (no glide).
+    void setParams(size_t section, BiquadType type, float freq, float q, float gainDb = 0.0f);
+    // Glide toward new settings during the following processBlock calls. A
+    // type or Q change snaps; an unchanged target costs nothing.
+    void setTarget(size_t section, BiquadType type, float freq, float q, float gainDb = 0.0f);
+    void setGlideTime(float ms);
 
-        switch (type) {
-            case LowPass:
-                b0_ = (1.0f - cs) / 2.0f;
-                b1_ = 1.0f - cs;
-                b2_ = (1.0f - cs) / 2.0f;
-                a0  = 1.0f + alpha;
-                a1_ = -2.0f * cs;
-                a2_ = 1.0f - alpha;
-                break;
-            case HighPass:
-                b0_ = (1.0f + cs) / 2.0f;
-                b1_ = -(1.0f + cs);
-                b2_ = (1.0f + cs) / 2.0f;
-                a0  = 1.0f + alpha;
-                a1_ = -2.0f * cs;
-                a2_ = 1.0f - alpha;
-                break;
-            case HighShelf:
-                b0_ =    A * ( (A+1.0f) + (A-1.0f)*cs + 2.0f*sqrtA*alpha );
-                b1_ = -2.0f * A * ( (A-1.0f) + (A+1.0f)*cs );
-                b2_ =    A * ( (A+1.0f) + (A-1.0f)*cs - 2.0f*sqrtA*alpha );
-                a0  =        (A+1.0f) - (A-1.0f)*cs + 2.0f*sqrtA*alpha;
-                a1_ =  2.0f * ( (A-1.0f) - (A+1.0f)*cs );
-                a2_ =        (A+1.0f) - (A-1.0f)*cs - 2.0f*sqrtA*alpha;
-                break;
-        }
+    // Filters every channel of the bus with shared coefficients and
+    // per-channel state; channels are taken in pairs, an odd last one alone.
+    void processBlock(AudioBus &bus, size_t frames);
 
-        // Normalize
-        b0_ /= a0;
-        b1_ /= a0;
-        b2_ /= a0;
-        a1_ /= a0;
-        a2_ /= a0;
-    }
+    // Both sections flat and settled, with no state left to drain.
+    bool bypassed() const { return bypassed_; }
 
-    void processBlock(std::vector<float>& buf) {
-        for (float& s : buf) {
-            float out = b0_ * s + b1_ * z1_ + b2_ * z2_ - a1_ * z1_ - a2_ * z2_;
-            // Simple DF1? No, wait, this is not correct for IIR recurrence. 
-            // Standard DF1: y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]
-            // My variables z1/z2 store input history? Need to store x/y history properly or use DF2.
-            // Let's use Transposed Direct Form II for numerical stability? 
-            // Or just simple DF1 with 4 state vars.
-            
-            // Let's fix loop implementation to DF1
-        }
-        
-        // Actually, let's rewrite properly for DF1
-        for (float& s : buf) {
-             float in = s;
-             float out = b0_*in + b1_*x1_ + b2_*x2_ - a1_*y1_ - a2_*y2_;
-             x2_ = x1_;
-             x1_ = in;
-             y2_ = y1_;
-             y1_ = out;
-             s = out;
-        }
-    }
-    
 private:
+    struct Section {
+        BiquadType type = BiquadType::LowPass;
+        float q = 0.707f;
+        float freq = kFlatLowPassHz; // last target, to skip repeats
+        float gainDb = 0.0f;
+        ParamSmoother logFreq{std::log2(kFlatLowPassHz)};
+        ParamSmoother gain{0.0f};
+        BiquadCoeffs coeffs;         // where the current ramp ends
+    };
+
+    // Coefficients for the section's current smoothed settings.
+    BiquadCoeffs designFor(const Section &s) const;
+    // Ramps lanes of `section` from their current coefficients to `to`
+    // across `frames` samples (0 = set at once).
+    void rampSection(size_t section, const BiquadCoeffs &to, size_t frames);
+    void runRange(AudioBus &bus, size_t offset, size_t frames);
+    bool drained() const;
+
     float sampleRate_;
-    // Coefficients
-    float b0_, b1_, b2_, a1_, a2_;
-    // State
-    float x1_ = 0, x2_ = 0, y1_ = 0, y2_ = 0;
-    float z1_ = 0, z2_ = 0; // Unused in DF1
+    std::array<Section, kSections> sections_;
+    // Coefficients and per-sample deltas of the four lanes (section 0
+    // left/right, section 1 left/right); z1/z2 are unused here.
+    simd::BiquadState ramp_{};
+    // Filter state per channel pair.
+    struct PairState {
+        float z1[simd::kBiquadLanes] = {};
+        float z2[simd::kBiquadLanes] = {};
+    };
+    std::array<PairState, (AudioBus::kMaxChannels + 1) / 2> pairs_{};
+    bool bypassed_ = true;
 };
 
 } // namespace audio
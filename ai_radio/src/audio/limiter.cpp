@@ -1,29 +1,205 @@
 #include "limiter.h"
+#include <algorithm>
+#include <bit>
 #include <cmath>
+#include <cstring>
+#include "simd/simd.h"
 
 namespace audio {
 
-namespace {
-inline float dbToLinear(float db) {
-    return std::pow(10.0f, db / 20.0f);
-}
-}
-
 void SoftLimiter::setParams(float ceilingDb, float softness) {
     ceilingDb_ = ceilingDb;
     softness_ = softness;
+    ceiling_ = fastmath::db2lin(ceilingDb);
 }
 
-void SoftLimiter::process(std::vector<float> &buffer) {
-    const float ceiling = dbToLinear(ceilingDb_);
+void SoftLimiter::process(AudioBus &bus, size_t frames) {
+    const float ceiling = ceiling_;
     const float knee = softness_;
-    for (auto &sample : buffer) {
-        const float absSample = std::fabs(sample);
-        if (absSample <= ceiling) continue;
-        const float over = absSample - ceiling;
-        const float t = over / (over + knee);
-        const float limited = ceiling + t * knee;
-        sample = (sample >= 0.0f) ? limited : -limited;
+    for (size_t c = 0; c < bus.channels(); ++c) {
+        float *__restrict buffer = bus.channel(c);
+        // Branch-free so the loop vectorizes: samples under the ceiling get
+        // over = 0 and pass through unchanged.
+        for (size_t i = 0; i < frames; ++i) {
+            const float sample = buffer[i];
+            const float absSample = std::fabs(sample);
+            const float over = std::max(absSample - ceiling, 0.0f);
+            const float t = over / std::max(over + knee, 1e-9f);
+            const float shaped = absSample > ceiling ? ceiling + t * knee : absSample;
+            buffer[i] = std::copysign(shaped, sample);
+        }
+    }
+}
+
+namespace {
+constexpr size_t kPhases = LookaheadLimiter::kOversample - 1; // phase 0 is the sample itself
+constexpr size_t kTaps = LookaheadLimiter::kTapsPerPhase;
+constexpr size_t kDetectorDelay = kTaps / 2;
+constexpr double kKaiserBeta = 3.0; // flattest top octave at 12 taps per phase
+constexpr double kPi = 3.14159265358979323846;
+// Upward envelope steps closer than this to the target land on it, so the
+// gain returns to exactly 1 after limiting.
+constexpr float kEnvelopeSnap = 1e-6f;
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    const double q = 0.25 * x * x;
+    for (int k = 1; k < 64; ++k) {
+        term *= q / (static_cast<double>(k) * static_cast<double>(k));
+        sum += term;
+        if (term < 1e-12 * sum) break;
+    }
+    return sum;
+}
+
+// Phases 1..3 of a 4x interpolator: a Kaiser-windowed sinc cut at the input
+// Nyquist frequency, so the sinc's zeros make phase 0 the input sample.
+// phase[r - 1][j] weights x[n - 11 + j] for the point r / 4 of a sample
+// after x[n - 6]. Each phase is normalised to unity DC gain.
+struct PhaseTaps {
+    float taps[kPhases][kTaps];
+    PhaseTaps() {
+        const double half = static_cast<double>(kDetectorDelay);
+        const double norm = besselI0(kKaiserBeta);
+        for (size_t r = 1; r <= kPhases; ++r) {
+            double h[kTaps];
+            double sum = 0.0;
+            for (size_t j = 0; j < kTaps; ++j) {
+                // Distance, in input samples, from x[n - 11 + j] to the point.
+                const double d = static_cast<double>(kDetectorDelay - 1) - static_cast<double>(j) +
+                                 static_cast<double>(r) / LookaheadLimiter::kOversample;
+                const double x = d / half;
+                const double w = besselI0(kKaiserBeta * std::sqrt(std::max(0.0, 1.0 - x * x))) / norm;
+                h[j] = std::sin(kPi * d) / (kPi * d) * w;
+                sum += h[j];
+            }
+            for (size_t j = 0; j < kTaps; ++j) taps[r - 1][j] = static_cast<float>(h[j] / sum);
+        }
+    }
+};
+const PhaseTaps kPhaseTaps;
+} // namespace
+
+LookaheadLimiter::LookaheadLimiter(float sampleRate, float ceilingDb, float lookaheadMs, float releaseMs)
+    : sampleRate_(sampleRate) {
+    // At least the interpolator's history, so it can read it from the delay
+    // line.
+    window_ = std::max(kHistory, static_cast<size_t>(std::lround(lookaheadMs * 0.001f * sampleRate)));
+    delay_ = window_ + kDetectorDelay;
+    invWindow_ = 1.0f / static_cast<float>(window_);
+    setCeiling(ceilingDb);
+    setRelease(releaseMs);
+    for (auto &h : history_) h.assign(delay_ + kChunk, 0.0f);
+    // The hold covers window_ + 2 detector values (see process), so the
+    // deque never holds more.
+    const size_t capacity = std::bit_ceil(window_ + 3);
+    dequeIndex_.assign(capacity, 0);
+    dequePeak_.assign(capacity, 0.0f);
+    dequeMask_ = capacity - 1;
+    box_.assign(window_, 1.0f);
+    boxSum_ = static_cast<double>(window_);
+}
+
+void LookaheadLimiter::setCeiling(float ceilingDb) { ceiling_ = fastmath::db2lin(ceilingDb); }
+
+void LookaheadLimiter::setRelease(float releaseMs) {
+    // One-pole coefficient, 1 - e^(-1 / (tau * fs)).
+    const float samples = std::max(releaseMs, 0.01f) * 0.001f * sampleRate_;
+    releaseCoeff_ = 1.0f - fastmath::exp2(-1.44269504f / samples);
+}
+
+float LookaheadLimiter::holdPeak(float peak) {
+    while (tail_ != head_ && dequePeak_[(tail_ - 1) & dequeMask_] <= peak) --tail_;
+    dequeIndex_[tail_ & dequeMask_] = clock_;
+    dequePeak_[tail_ & dequeMask_] = peak;
+    ++tail_;
+    // Indices are distinct and increasing, so at most the head expires.
+    if (dequeIndex_[head_ & dequeMask_] + window_ + 2 <= clock_) ++head_;
+    ++clock_;
+    return dequePeak_[head_ & dequeMask_];
+}
+
+void LookaheadLimiter::process(AudioBus &bus, size_t frames) {
+    const auto &k = simd::kernels();
+    const size_t channels = std::min(bus.channels(), AudioBus::kMaxChannels);
+    for (size_t offset = 0; offset < frames; offset += kChunk) {
+        const size_t n = std::min(kChunk, frames - offset);
+
+        // Detector value per frame: the largest true peak over the channels.
+        std::fill_n(peak_.begin(), n, 0.0f);
+        for (size_t c = 0; c < channels; ++c) {
+            float *hist = history_[c].data();
+            std::memcpy(hist + delay_, bus.channel(c) + offset, n * sizeof(float));
+            // Each phase is a 12-tap FIR over the history, run as weighted
+            // sums of shifted copies through the SIMD kernels.
+            const float *window = hist + delay_ - kHistory;
+            for (size_t r = 0; r < kPhases; ++r) {
+                float *y = phase_[r].data();
+                k.scaledCopy(y, window, kPhaseTaps.taps[r][0], n);
+                for (size_t j = 1; j < kTaps; ++j) k.mixAdd(y, window + j, kPhaseTaps.taps[r][j], n);
+            }
+            const float *__restrict x = window + kHistory - kDetectorDelay;
+            float *__restrict peak = peak_.data();
+            const float *__restrict y0 = phase_[0].data();
+            const float *__restrict y1 = phase_[1].data();
+            const float *__restrict y2 = phase_[2].data();
+            for (size_t i = 0; i < n; ++i) {
+                const float a = std::max(std::fabs(x[i]), std::fabs(y0[i]));
+                const float b = std::max(std::fabs(y1[i]), std::fabs(y2[i]));
+                peak[i] = std::max(peak[i], std::max(a, b));
+            }
+        }
+
+        // Nothing in the window or in this chunk reaches the ceiling and the
+        // gain is back at 1: the chunk passes through delayed. Every held
+        // value maps to gain 1, so the deque can restart empty.
+        const bool idle = envelope_ == 1.0f && boxSum_ == static_cast<double>(window_) &&
+                          (head_ == tail_ || dequePeak_[head_ & dequeMask_] <= ceiling_) &&
+                          *std::max_element(peak_.begin(), peak_.begin() + n) <= ceiling_;
+        if (idle) {
+            head_ = tail_;
+            clock_ += n;
+        } else {
+            // Detector value k covers x[k - 6] and the points up to x[k - 5],
+            // which leave the delay line at k + window_ and k + window_ + 1.
+            // Holding it over window_ + 2 values keeps it in every box mean
+            // those two outputs take, so the gain is fully down for both.
+            for (size_t i = 0; i < n; ++i) {
+                const float held = holdPeak(peak_[i]);
+                const float g = ceiling_ / std::max(held, ceiling_);
+                boxSum_ += static_cast<double>(g) - static_cast<double>(box_[boxPos_]);
+                box_[boxPos_] = g;
+                if (++boxPos_ == window_) {
+                    // Re-add from scratch once per window so rounding cannot
+                    // build up.
+                    boxPos_ = 0;
+                    boxSum_ = 0.0;
+                    for (float v : box_) boxSum_ += static_cast<double>(v);
+                }
+                const float target = std::min(1.0f, static_cast<float>(boxSum_ * invWindow_));
+                if (target <= envelope_) {
+                    envelope_ = target;
+                } else {
+                    envelope_ += releaseCoeff_ * (target - envelope_);
+                    if (target - envelope_ < kEnvelopeSnap) envelope_ = target;
+                }
+                gain_[i] = envelope_;
+            }
+        }
+
+        for (size_t c = 0; c < channels; ++c) {
+            float *hist = history_[c].data();
+            float *__restrict out = bus.channel(c) + offset;
+            if (idle) {
+                std::memcpy(out, hist, n * sizeof(float));
+            } else {
+                const float *__restrict in = hist;
+                const float *__restrict gain = gain_.data();
+                for (size_t i = 0; i < n; ++i) out[i] = in[i] * gain[i];
+            }
+            std::memmove(hist, hist + n, delay_ * sizeof(float));
+        }
     }
 }
 
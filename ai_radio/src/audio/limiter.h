@@ -1,21 +1,103 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
+#include "bus.h"
+#include "fastmath.h"
 
 namespace audio {
 
-// Simple soft limiter with fixed ceiling.
+// Simple soft limiter with fixed ceiling (memoryless, so channels are
+// shaped independently). Superseded in the engine by LookaheadLimiter; kept
+// as the reference keegan_render --limiter-bench compares against.
 class SoftLimiter {
 public:
     explicit SoftLimiter(float ceilingDb = -1.0f, float softness = 0.1f)
-        : ceilingDb_(ceilingDb), softness_(softness) {}
+        : ceilingDb_(ceilingDb), softness_(softness), ceiling_(fastmath::db2lin(ceilingDb)) {}
 
     void setParams(float ceilingDb, float softness);
-    void process(std::vector<float> &buffer);
+    void process(AudioBus &bus, size_t frames);
 
 private:
     float ceilingDb_;
     float softness_;
+    float ceiling_; // linear, kept in step with ceilingDb_
+};
+
+// Brickwall limiter that holds the bus's true (inter-sample) peak under a
+// ceiling in dBTP. One gain, shared by all channels, so the stereo image
+// does not shift under limiting.
+//
+// Each channel is upsampled 4x by a polyphase windowed sinc to find the
+// peaks between samples. The loudest peak in the next lookahead window is
+// tracked with a monotonic deque (O(1) amortised per sample). The gain that
+// brings it to the ceiling is averaged over the window, so the gain ramps
+// down linearly across the lookahead and is fully down when the peak
+// arrives, then recovers exponentially over the release time. Audio is
+// delayed by latencyFrames(): the lookahead plus the interpolator's delay.
+//
+// Every buffer is sized in the constructor; process does not allocate.
+class LookaheadLimiter {
+public:
+    static constexpr size_t kOversample = 4;
+    static constexpr size_t kTapsPerPhase = 12;
+
+    explicit LookaheadLimiter(float sampleRate, float ceilingDb = -1.0f, float lookaheadMs = 1.5f,
+                              float releaseMs = 80.0f);
+
+    LookaheadLimiter(const LookaheadLimiter &) = delete;
+    LookaheadLimiter &operator=(const LookaheadLimiter &) = delete;
+
+    // Take effect from the next sample, but a lowered ceiling is only
+    // guaranteed for peaks entering the window after the call. The
+    // lookahead is fixed at construction.
+    void setCeiling(float ceilingDb);
+    void setRelease(float releaseMs);
+
+    // Limits every channel of the bus in place (up to AudioBus::kMaxChannels).
+    void process(AudioBus &bus, size_t frames);
+
+    size_t latencyFrames() const { return delay_; }
+    // Gain applied to the last sample processed (1 = not limiting).
+    float currentGain() const { return envelope_; }
+
+private:
+    static constexpr size_t kChunk = 256;
+    static constexpr size_t kHistory = kTapsPerPhase - 1;
+
+    // Pushes one detector value; returns the largest over the hold window.
+    float holdPeak(float peak);
+
+    float sampleRate_;
+    float ceiling_;
+    float releaseCoeff_ = 0.0f;
+    size_t window_;       // lookahead, in frames
+    size_t delay_;        // window_ + interpolator delay
+    float envelope_ = 1.0f;
+
+    // Per channel: the last delay_ input samples, then the current chunk.
+    std::array<std::vector<float>, AudioBus::kMaxChannels> history_;
+
+    // Monotonic deque over the hold window: (detector index, peak), peaks
+    // strictly decreasing from head to tail. Power-of-two ring.
+    std::vector<uint64_t> dequeIndex_;
+    std::vector<float> dequePeak_;
+    size_t dequeMask_ = 0;
+    size_t head_ = 0;
+    size_t tail_ = 0;
+    uint64_t clock_ = 0;
+
+    // Running mean of the held gain over the lookahead window.
+    std::vector<float> box_;
+    size_t boxPos_ = 0;
+    double boxSum_ = 0.0;
+    float invWindow_ = 1.0f;
+
+    std::array<float, kChunk> peak_{};
+    std::array<float, kChunk> gain_{};
+    std::array<std::array<float, kChunk>, kOversample - 1> phase_{};
 };
 
 } // namespace audio
@@ -0,0 +1,16 @@
+// The one translation unit that compiles miniaudio (device I/O for the app,
+// decoders for everything). Dropping stb_vorbis.c into vendor/ enables Ogg
+// Vorbis; it has to be seen in two halves around the implementation.
+#if __has_include("../../vendor/stb_vorbis.c")
+#define STB_VORBIS_HEADER_ONLY
+#include "../../vendor/stb_vorbis.c"
+#define KEEGAN_HAS_STB_VORBIS 1
+#endif
+
+#define MINIAUDIO_IMPLEMENTATION
+#include "../../vendor/miniaudio.h"
+
+#if defined(KEEGAN_HAS_STB_VORBIS)
+#undef STB_VORBIS_HEADER_ONLY
+#include "../../vendor/stb_vorbis.c"
+#endif
@@ -1,49 +1,189 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <numbers>
+#include "simd/simd.h"
 
 namespace audio {
 
+// Sine oscillator as a rotating unit phasor z = e^{i*phase}: each sample is
+// one complex multiply (z *= e^{i*delta}) instead of a sin(). The rotor is
+// computed only when the frequency changes. Once per block z is re-anchored
+// to a double-precision phase, so float rounding can drift neither the
+// amplitude nor the pitch. Phase continuous across frequency changes.
 class Oscillator {
 public:
-    Oscillator(float sampleRate) : sampleRate_(sampleRate), phase_(0.0f), freq_(440.0f) {}
+    Oscillator(float sampleRate) : sampleRate_(sampleRate) { setFrequency(440.0f); }
 
     void setFrequency(float freq) {
+        if (freq == freq_) return;
+        anchor();
         freq_ = freq;
+        delta_ = 2.0 * std::numbers::pi * freq / sampleRate_;
+        rotRe_ = static_cast<float>(std::cos(delta_));
+        rotIm_ = static_cast<float>(std::sin(delta_));
     }
 
     // Process one sample
     float process() {
-        // Basic sine wave
-        float val = std::sin(phase_);
-        
-        // Advance phase
-        float delta = 2.0f * std::numbers::pi_v<float> * freq_ / sampleRate_;
-        phase_ += delta;
-        if (phase_ > 2.0f * std::numbers::pi_v<float>) {
-            phase_ -= 2.0f * std::numbers::pi_v<float>;
-        }
-        
+        const float val = im_;
+        advance();
+        if (++sinceAnchor_ >= kAnchorInterval) anchor();
         return val;
     }
-    
-    // Process block
-    void processBlock(float* out, size_t frames, float gain) {
-        float delta = 2.0f * std::numbers::pi_v<float> * freq_ / sampleRate_;
+
+    // out[i] += gain * sin + harmonic2 * sin(2 * phase), the second
+    // harmonic coming free from sin(2x) = 2 sin(x) cos(x).
+    void processBlock(float* out, size_t frames, float gain, float harmonic2 = 0.0f) {
+        const float h2 = 2.0f * harmonic2;
         for (size_t i = 0; i < frames; ++i) {
-            out[i] += std::sin(phase_) * gain;
-            phase_ += delta;
-            if (phase_ > 2.0f * std::numbers::pi_v<float>) {
-                phase_ -= 2.0f * std::numbers::pi_v<float>;
-            }
+            out[i] += im_ * gain + im_ * re_ * h2;
+            advance();
+        }
+        sinceAnchor_ += frames;
+        anchor();
+    }
+
+private:
+    static constexpr size_t kAnchorInterval = 256;
+
+    void advance() {
+        const float re = re_ * rotRe_ - im_ * rotIm_;
+        im_ = re_ * rotIm_ + im_ * rotRe_;
+        re_ = re;
+    }
+
+    // Advances the exact phase over the samples since the last anchor and
+    // resets z to it.
+    void anchor() {
+        phase_ = std::fmod(phase_ + delta_ * static_cast<double>(sinceAnchor_), 2.0 * std::numbers::pi);
+        re_ = static_cast<float>(std::cos(phase_));
+        im_ = static_cast<float>(std::sin(phase_));
+        sinceAnchor_ = 0;
+    }
+
+    float sampleRate_;
+    float freq_ = -1.0f;
+    double delta_ = 0.0;
+    double phase_ = 0.0;
+    size_t sinceAnchor_ = 0;
+    float re_ = 1.0f; // cos(phase)
+    float im_ = 0.0f; // sin(phase)
+    float rotRe_ = 1.0f;
+    float rotIm_ = 0.0f;
+};
+
+// Two sine oscillators rendered together by the simd::sinePair kernel, for
+// the binaural bed: both channels come out of one four-wide pass. As with
+// Oscillator, the phasors are re-anchored to a double-precision phase after
+// every kernel call. Frequency changes can glide; the rotors are then
+// recomputed every kGlideStep samples (a stepped glide, inaudible at this
+// granularity) rather than per sample.
+class SineOscPair {
+public:
+    static constexpr size_t kGlideStep = 64;
+
+    explicit SineOscPair(float sampleRate) : sampleRate_(sampleRate) {
+        setRotors(0.0f, 0.0f);
+    }
+
+    // Jumps to the new frequencies (phase continuous).
+    void setFrequencies(float left, float right) {
+        target_[0] = left;
+        target_[1] = right;
+        glideFrames_ = 0;
+        tuned_ = true;
+        setRotors(left, right);
+    }
+
+    // Moves linearly to the new frequencies over the next `frames` samples;
+    // the first call, with nothing to glide from, jumps.
+    void glideTo(float left, float right, size_t frames) {
+        if (!tuned_) {
+            setFrequencies(left, right);
+            return;
         }
+        if (left == target_[0] && right == target_[1]) return;
+        target_[0] = left;
+        target_[1] = right;
+        glideFrames_ = frames;
+        if (frames == 0) setRotors(left, right);
+    }
+
+    // left[i] += gain * sin(left phase), likewise right.
+    void processBlock(float* left, float* right, size_t frames, float gain) {
+        const simd::Kernels& k = simd::kernels();
+        size_t done = 0;
+        while (glideFrames_ > 0 && done < frames) {
+            const size_t n = std::min({kGlideStep, glideFrames_, frames - done});
+            const float t = static_cast<float>(n) / static_cast<float>(glideFrames_);
+            setRotors(freq_[0] + (target_[0] - freq_[0]) * t, freq_[1] + (target_[1] - freq_[1]) * t);
+            k.sinePair(state_, left + done, right + done, gain, n);
+            advance(n);
+            glideFrames_ -= n;
+            done += n;
+        }
+        if (done < frames) {
+            k.sinePair(state_, left + done, right + done, gain, frames - done);
+            advance(frames - done);
+        }
+        realign();
     }
 
 private:
+    // Recomputes the rotors for new frequencies (one sin/cos pair per
+    // oscillator; the other powers are complex products) and realigns the
+    // lanes to them.
+    void setRotors(float left, float right) {
+        freq_[0] = left;
+        freq_[1] = right;
+        for (size_t k = 0; k < 2; ++k) {
+            delta_[k] = 2.0 * std::numbers::pi * freq_[k] / sampleRate_;
+            const double c1 = std::cos(delta_[k]), s1 = std::sin(delta_[k]);
+            const double c2 = c1 * c1 - s1 * s1, s2 = 2.0 * c1 * s1;
+            const double c[4] = {1.0, c1, c2, c2 * c1 - s2 * s1};
+            const double s[4] = {0.0, s1, s2, s2 * c1 + c2 * s1};
+            for (size_t j = 0; j < 4; ++j) {
+                state_.rotRe[4 * k + j] = static_cast<float>(c2 * c2 - s2 * s2);
+                state_.rotIm[4 * k + j] = static_cast<float>(2.0 * c2 * s2);
+                state_.stepRe[4 * k + j] = static_cast<float>(c[j]);
+                state_.stepIm[4 * k + j] = static_cast<float>(s[j]);
+            }
+        }
+        realign();
+    }
+
+    void advance(size_t frames) {
+        for (size_t k = 0; k < 2; ++k) {
+            phase_[k] = std::fmod(phase_[k] + delta_[k] * static_cast<double>(frames), 2.0 * std::numbers::pi);
+        }
+    }
+
+    // Resets lane 0 of each oscillator to its exact phase and rebuilds
+    // lanes 1-3 from it, so rounding can neither drift the pitch or
+    // amplitude nor skew the lanes.
+    void realign() {
+        for (size_t k = 0; k < 2; ++k) {
+            const size_t b = 4 * k;
+            const float re = static_cast<float>(std::cos(phase_[k]));
+            const float im = static_cast<float>(std::sin(phase_[k]));
+            for (size_t j = 0; j < 4; ++j) {
+                state_.re[b + j] = re * state_.stepRe[b + j] - im * state_.stepIm[b + j];
+                state_.im[b + j] = re * state_.stepIm[b + j] + im * state_.stepRe[b + j];
+            }
+        }
+    }
+
     float sampleRate_;
-    float phase_;
-    float freq_;
+    float freq_[2] = {0.0f, 0.0f};
+    float target_[2] = {0.0f, 0.0f};
+    double delta_[2] = {0.0, 0.0};
+    double phase_[2] = {0.0, 0.0};
+    size_t glideFrames_ = 0;
+    bool tuned_ = false;
+    simd::SinePairState state_{};
 };
 
 } // namespace audio
@@ -0,0 +1,64 @@
+#include "profiler.h"
+#include <algorithm>
+
+namespace audio {
+
+const char *dspStageName(DspStage stage) {
+    switch (stage) {
+        case DspStage::Commands: return "commands";
+        case DspStage::Stems: return "stems";
+        case DspStage::Crossfade: return "crossfade";
+        case DspStage::Voice: return "voice";
+        case DspStage::Ducking: return "ducking";
+        case DspStage::Reverb: return "reverb";
+        case DspStage::Filters: return "filters";
+        case DspStage::Binaural: return "binaural";
+        case DspStage::Limiter: return "limiter";
+        case DspStage::Total: return "total";
+        case DspStage::Count: break;
+    }
+    return "unknown";
+}
+
+DspProfile DspProfiler::snapshot() const {
+    DspProfile profile;
+    profile.budgetNsPerSample = sampleRate_ > 0.0f ? 1.0e9f / sampleRate_ : 0.0f;
+
+    std::array<float, kWindow> window{};
+    for (size_t s = 0; s < kDspStageCount; ++s) {
+        const auto &ring = rings_[s];
+        auto &stats = profile.stages[s];
+        stats.name = dspStageName(static_cast<DspStage>(s));
+        stats.blocks = ring.count.load(std::memory_order_acquire);
+
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(stats.blocks, kWindow));
+        if (n == 0) continue;
+
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            window[i] = ring.nsPerSample[i].load(std::memory_order_relaxed);
+            sum += window[i];
+        }
+        stats.avgNsPerSample = static_cast<float>(sum / static_cast<double>(n));
+
+        const size_t p99 = std::min(n - 1, (n * 99) / 100);
+        std::nth_element(window.begin(), window.begin() + p99, window.begin() + n);
+        stats.p99NsPerSample = window[p99];
+        stats.maxNsPerSample = *std::max_element(window.begin() + p99, window.begin() + n);
+    }
+
+    const auto &total = profile.stages[static_cast<size_t>(DspStage::Total)];
+    if (profile.budgetNsPerSample > 0.0f) {
+        profile.avgLoad = total.avgNsPerSample / profile.budgetNsPerSample;
+        profile.p99Load = total.p99NsPerSample / profile.budgetNsPerSample;
+    }
+    return profile;
+}
+
+void DspProfiler::reset() {
+    for (auto &ring : rings_) {
+        ring.count.store(0, std::memory_order_release);
+    }
+}
+
+} // namespace audio
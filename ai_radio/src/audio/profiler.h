@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace audio {
+
+// Stages of Engine::renderBlock, in processing order.
+enum class DspStage : uint8_t {
+    Commands,
+    Stems,
+    Crossfade,
+    Voice,
+    Ducking,
+    Reverb,
+    Filters,
+    Binaural,
+    Limiter,
+    Total,
+    Count
+};
+
+constexpr size_t kDspStageCount = static_cast<size_t>(DspStage::Count);
+
+const char *dspStageName(DspStage stage);
+
+struct DspStageStats {
+    const char *name = "";
+    float avgNsPerSample = 0.0f;
+    float p99NsPerSample = 0.0f;
+    float maxNsPerSample = 0.0f;
+    uint64_t blocks = 0;
+};
+
+struct DspProfile {
+    std::array<DspStageStats, kDspStageCount> stages{};
+    float budgetNsPerSample = 0.0f; // 1e9 / sampleRate
+    float avgLoad = 0.0f;           // Total avg / budget
+    float p99Load = 0.0f;           // Total p99 / budget
+};
+
+// Per-stage block timer for the audio callback.
+// The audio thread records with lap(); any thread may call snapshot() while
+// audio runs. Each stage keeps the last kWindow blocks as ns-per-sample in a
+// ring of relaxed atomics, so recording never locks or allocates and readers
+// never stall the callback (a snapshot may mix adjacent blocks, which is fine
+// for statistics).
+class DspProfiler {
+public:
+    static constexpr size_t kWindow = 1024;
+
+    explicit DspProfiler(float sampleRate = 48000.0f) : sampleRate_(sampleRate) {}
+
+    void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Audio thread: timestamp to start a chain of laps (0 when disabled).
+    uint64_t now() const {
+        if (!enabled()) return 0;
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Audio thread: record the time since `mark` against `stage` and return a
+    // fresh mark for the next stage.
+    uint64_t lap(DspStage stage, uint64_t mark, size_t frames) {
+        if (mark == 0 || frames == 0) return now();
+        const uint64_t t = now();
+        record(stage, t - mark, frames);
+        return t;
+    }
+
+    void record(DspStage stage, uint64_t ns, size_t frames) {
+        auto &ring = rings_[static_cast<size_t>(stage)];
+        const uint64_t n = ring.count.load(std::memory_order_relaxed);
+        ring.nsPerSample[n % kWindow].store(static_cast<float>(ns) / static_cast<float>(frames),
+                                            std::memory_order_relaxed);
+        ring.count.store(n + 1, std::memory_order_release);
+    }
+
+    // Any thread.
+    DspProfile snapshot() const;
+    void reset();
+
+private:
+    struct Ring {
+        std::array<std::atomic<float>, kWindow> nsPerSample{};
+        std::atomic<uint64_t> count{0};
+    };
+
+    float sampleRate_;
+    std::atomic<bool> enabled_{true};
+    std::array<Ring, kDspStageCount> rings_;
+};
+
+} // namespace audio
@@ -0,0 +1,196 @@
+#include "resampler.h"
+#include "simd/simd.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <numeric>
+
+namespace audio {
+
+namespace {
+constexpr size_t kBaseTaps = 64;   // taps when not decimating
+constexpr size_t kMaxTaps = 512;
+constexpr double kCutoff = 0.90;   // of the lower Nyquist frequency
+constexpr double kKaiserBeta = 8.0; // about -80 dB stopband
+constexpr double kPi = 3.14159265358979323846;
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    const double q = 0.25 * x * x;
+    for (int k = 1; k < 64; ++k) {
+        term *= q / (static_cast<double>(k) * static_cast<double>(k));
+        sum += term;
+        if (term < 1e-12 * sum) break;
+    }
+    return sum;
+}
+
+double sinc(double x) {
+    if (std::fabs(x) < 1e-12) return 1.0;
+    return std::sin(kPi * x) / (kPi * x);
+}
+} // namespace
+
+struct Resampler::Table {
+    uint64_t up = 1;     // L
+    uint64_t down = 1;   // M
+    uint64_t phases = 1; // L, or kMaxPhases when L is larger
+    size_t taps = 0;     // multiple of 16
+    size_t half = 0;     // taps / 2
+    std::vector<float> coeffs; // phases * taps
+
+    const float* phase(uint64_t p) const {
+        const uint64_t index = phases == up ? p : p * phases / up;
+        return coeffs.data() + index * taps;
+    }
+};
+
+namespace {
+std::shared_ptr<const Resampler::Table> buildTable(uint64_t up, uint64_t down) {
+    auto table = std::make_shared<Resampler::Table>();
+    table->up = up;
+    table->down = down;
+    table->phases = std::min<uint64_t>(up, Resampler::kMaxPhases);
+
+    // Decimating narrows the passband, so the filter needs proportionally
+    // more taps for the same transition width.
+    const double ratio = std::min(1.0, static_cast<double>(up) / static_cast<double>(down));
+    const double fc = kCutoff * ratio;
+    size_t taps = static_cast<size_t>(std::ceil(static_cast<double>(kBaseTaps) / ratio));
+    taps = std::min(kMaxTaps, (taps + 15) / 16 * 16);
+    table->taps = taps;
+    table->half = taps / 2;
+
+    const double half = static_cast<double>(table->half);
+    const double norm = besselI0(kKaiserBeta);
+    table->coeffs.resize(table->phases * taps);
+    std::vector<double> h(taps);
+    for (uint64_t p = 0; p < table->phases; ++p) {
+        const double frac = static_cast<double>(p) / static_cast<double>(table->phases);
+        double sum = 0.0;
+        for (size_t j = 0; j < taps; ++j) {
+            // Distance from the output position to input sample j.
+            const double d = static_cast<double>(j) - (half - 1.0) - frac;
+            const double x = d / half;
+            const double w = besselI0(kKaiserBeta * std::sqrt(std::max(0.0, 1.0 - x * x))) / norm;
+            h[j] = fc * sinc(fc * d) * w;
+            sum += h[j];
+        }
+        // Unity DC gain for every phase.
+        float* dst = table->coeffs.data() + p * taps;
+        for (size_t j = 0; j < taps; ++j) dst[j] = static_cast<float>(h[j] / sum);
+    }
+    return table;
+}
+
+// One table per ratio, shared by every resampler using it.
+std::shared_ptr<const Resampler::Table> tableFor(uint64_t up, uint64_t down) {
+    static std::mutex mutex;
+    static std::map<std::pair<uint64_t, uint64_t>, std::weak_ptr<const Resampler::Table>> tables;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& slot = tables[{up, down}];
+    if (auto table = slot.lock()) return table;
+    auto table = buildTable(up, down);
+    slot = table;
+    return table;
+}
+} // namespace
+
+Resampler::Resampler(uint32_t inRate, uint32_t outRate) : inRate_(inRate), outRate_(outRate) {
+    if (inRate == 0 || outRate == 0 || inRate == outRate) return;
+    const uint64_t g = std::gcd<uint64_t>(inRate, outRate);
+    table_ = tableFor(outRate / g, inRate / g);
+}
+
+size_t Resampler::outputFrames(size_t inFrames) const {
+    if (!table_) return inFrames;
+    return static_cast<size_t>((static_cast<uint64_t>(inFrames) * table_->up + table_->down / 2) / table_->down);
+}
+
+void Resampler::processLoop(const float* in, size_t inFrames, float* out, size_t outFrames) const {
+    if (inFrames == 0) {
+        std::fill(out, out + outFrames, 0.0f);
+        return;
+    }
+    if (!table_) {
+        for (size_t k = 0; k < outFrames; ++k) out[k] = in[k % inFrames];
+        return;
+    }
+
+    // Input with the wrap-around context laid out contiguously:
+    // ext[i + j] = in[(i + j - (half - 1)) mod inFrames].
+    const Table& t = *table_;
+    std::vector<float> ext(inFrames + t.taps);
+    for (size_t j = 0; j < ext.size(); ++j) {
+        const int64_t src = static_cast<int64_t>(j) - static_cast<int64_t>(t.half - 1);
+        const int64_t n = static_cast<int64_t>(inFrames);
+        ext[j] = in[static_cast<size_t>(((src % n) + n) % n)];
+    }
+
+    const auto& k = simd::kernels();
+    uint64_t index = 0;
+    uint64_t phase = 0;
+    for (size_t o = 0; o < outFrames; ++o) {
+        out[o] = k.dot(ext.data() + index % inFrames, t.phase(phase), t.taps);
+        phase += t.down;
+        index += phase / t.up;
+        phase %= t.up;
+    }
+}
+
+ResamplerStream::ResamplerStream(const Resampler& resampler, size_t channels)
+    : table_(resampler.table_), pending_(channels) {
+    // Silence before the first input sample, so output 0 lines up with
+    // input 0 like processLoop.
+    const size_t lead = table_ ? table_->half - 1 : 0;
+    for (auto& p : pending_) p.assign(lead, 0.0f);
+    inputBase_ = -static_cast<int64_t>(lead);
+}
+
+void ResamplerStream::push(const float* const* in, size_t frames) {
+    for (size_t c = 0; c < pending_.size(); ++c) pending_[c].insert(pending_[c].end(), in[c], in[c] + frames);
+}
+
+size_t ResamplerStream::pull(float* ring, size_t capacity, uint64_t writePos, size_t maxOut) {
+    if (pending_.empty()) return 0;
+    const size_t mask = capacity - 1;
+    const size_t available = pending_[0].size();
+
+    if (!table_) {
+        const size_t n = std::min(maxOut, available);
+        for (size_t c = 0; c < pending_.size(); ++c) {
+            for (size_t i = 0; i < n; ++i) ring[c * capacity + ((writePos + i) & mask)] = pending_[c][i];
+            pending_[c].erase(pending_[c].begin(), pending_[c].begin() + static_cast<std::ptrdiff_t>(n));
+        }
+        return n;
+    }
+
+    const Resampler::Table& t = *table_;
+    const auto& k = simd::kernels();
+    size_t produced = 0;
+    while (produced < maxOut) {
+        const int64_t start = static_cast<int64_t>(inputIndex_) - static_cast<int64_t>(t.half - 1) - inputBase_;
+        if (start + static_cast<int64_t>(t.taps) > static_cast<int64_t>(available)) break;
+        const float* coeffs = t.phase(phase_);
+        const size_t pos = static_cast<size_t>((writePos + produced) & mask);
+        for (size_t c = 0; c < pending_.size(); ++c) {
+            ring[c * capacity + pos] = k.dot(pending_[c].data() + start, coeffs, t.taps);
+        }
+        ++produced;
+        phase_ += t.down;
+        inputIndex_ += phase_ / t.up;
+        phase_ %= t.up;
+    }
+
+    // Drop input no later output can reach, in batches.
+    const int64_t consumed = static_cast<int64_t>(inputIndex_) - static_cast<int64_t>(t.half - 1) - inputBase_;
+    if (consumed >= 8192) {
+        for (auto& p : pending_) p.erase(p.begin(), p.begin() + consumed);
+        inputBase_ += consumed;
+    }
+    return produced;
+}
+
+} // namespace audio
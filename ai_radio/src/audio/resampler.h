@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace audio {
+
+// Band-limited sample-rate conversion by the rational factor L/M
+// (outRate/inRate reduced), as a polyphase Kaiser-windowed sinc filter.
+// Coefficient tables are built once per ratio and shared; output sample k
+// sits at input position k * M / L and takes one dot product (SIMD kernel)
+// of the phase's taps against the input around it. Ratios needing more
+// than kMaxPhases phases round the phase down to the nearest table entry.
+//
+// Not for the audio thread: construction may build a table, and both
+// conversion paths below run at load time or on the stream reader.
+class Resampler {
+public:
+    static constexpr uint32_t kMaxPhases = 4096;
+
+    Resampler(uint32_t inRate, uint32_t outRate);
+
+    // Equal rates: nothing to do.
+    bool passthrough() const { return table_ == nullptr; }
+    uint32_t inRate() const { return inRate_; }
+    uint32_t outRate() const { return outRate_; }
+
+    // Output frames for a whole signal of inFrames (rounded to nearest).
+    size_t outputFrames(size_t inFrames) const;
+
+    // Converts one whole channel, treating it as a loop: the filter wraps
+    // around the ends, so looping stems stay seamless (one-shots only see
+    // a few milliseconds of their far end, usually silence).
+    void processLoop(const float* in, size_t inFrames, float* out, size_t outFrames) const;
+
+    struct Table;
+
+private:
+    friend class ResamplerStream;
+
+    uint32_t inRate_;
+    uint32_t outRate_;
+    std::shared_ptr<const Table> table_;
+};
+
+// Incremental conversion of a multichannel stream: push input as it is
+// read, pull output as there is room for it. The stream starts as if
+// preceded by silence and keeps its filter history across pushes, so
+// splitting the input anywhere gives the same output.
+class ResamplerStream {
+public:
+    ResamplerStream(const Resampler& resampler, size_t channels);
+
+    // Appends `frames` planar input frames (in[c] for channel c).
+    void push(const float* const* in, size_t frames);
+
+    // Writes up to maxOut output frames into a planar ring (channel c at
+    // ring + c * capacity, capacity a power of two) starting at writePos.
+    // Returns the frames written; fewer than maxOut means it needs input.
+    size_t pull(float* ring, size_t capacity, uint64_t writePos, size_t maxOut);
+
+private:
+    std::shared_ptr<const Resampler::Table> table_;
+    std::vector<std::vector<float>> pending_; // per channel, from inputBase_
+    int64_t inputBase_ = 0;                   // input index of pending_[c][0]
+    uint64_t inputIndex_ = 0;                 // i of the next output
+    uint64_t phase_ = 0;                      // (k * M) mod L of the next output
+};
+
+} // namespace audio
@@ -1,19 +1,46 @@
 #include "reverb.h"
 #include <cmath>
 #include <algorithm>
+#include "fastmath.h"
 
 namespace audio {
 
 namespace {
 constexpr float kPi = 3.1415926535f;
+
+// FDN line lengths in ms, rounded up to primes so no two lines share
+// echoes; the feedback per kFdnRefMs is what `decay` means.
+constexpr std::array<float, simd::kFdnLines> kFdnLengthsMs = {29.7f, 33.3f, 37.1f, 41.1f,
+                                                             45.7f, 51.9f, 58.3f, 67.1f};
+constexpr float kFdnRefMs = 30.0f;
+// Input and output tap weight; sets the tail's level against the plate's.
+constexpr float kFdnTap = 0.6f;
+// Added to the network input so a silent tail settles here rather than
+// decaying into denormals.
+constexpr float kAntiDenormal = 1e-18f;
+
+bool isPrime(size_t n) {
+    if (n < 2) return false;
+    for (size_t d = 2; d * d <= n; ++d) {
+        if (n % d == 0) return false;
+    }
+    return true;
+}
+
+size_t nextPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
 }
 
 SimplePlateReverb::SimplePlateReverb(float sampleRate)
     : sampleRate_(sampleRate),
       decay_(0.5f),
       damping_(0.25f),
-      preDelaySamples_(static_cast<size_t>(0.02f * sampleRate)),
-      preDelay_(preDelaySamples_, 0.0f),
+      preDelaySamples_(0.02f * sampleRate),
+      wet_(0.3f),
+      preDelay_(static_cast<size_t>(kMaxPreDelayMs * 0.001f * sampleRate) + 1, 0.0f),
       preDelayIdx_(0) {
     const std::array<size_t, 2> combSizes = {
         static_cast<size_t>(0.0297f * sampleRate_),
@@ -28,37 +55,55 @@ SimplePlateReverb::SimplePlateReverb(float sampleRate)
     for (size_t i = 0; i < allpasses_.size(); ++i) {
         allpasses_[i].data.assign(allpassSizes[i], 0.0f);
     }
+    widthAllpass_.data.assign(static_cast<size_t>(0.0023f * sampleRate_), 0.0f);
+
+    decay_.setTime(kGlideMs, sampleRate_);
+    preDelaySamples_.setTime(kGlideMs, sampleRate_);
+    wet_.setTime(kGlideMs, sampleRate_);
 }
 
 void SimplePlateReverb::setParams(float preDelayMs, float decay, float damping) {
-    decay_ = std::clamp(decay, 0.05f, 0.95f);
+    decay_.setTarget(std::clamp(decay, 0.05f, 0.95f));
     damping_ = std::clamp(damping, 0.0f, 0.9f);
-    preDelaySamples_ = static_cast<size_t>((preDelayMs / 1000.0f) * sampleRate_);
-    preDelay_.assign(std::max<size_t>(1, preDelaySamples_), 0.0f);
-    preDelayIdx_ = 0;
+    // One sample of headroom for the fractional read.
+    preDelaySamples_.setTarget(std::clamp((preDelayMs / 1000.0f) * sampleRate_, 0.0f,
+                                          static_cast<float>(preDelay_.size() - 2)));
 }
 
-void SimplePlateReverb::process(std::vector<float> &buffer, float wetMix) {
-    if (buffer.empty()) return;
+void SimplePlateReverb::process(AudioBus &bus, size_t frames, float wetMix) {
+    const size_t channels = bus.channels();
+    if (frames == 0 || channels == 0) return;
     
     // Clamp wetMix to valid range
-    wetMix = std::clamp(wetMix, 0.0f, 1.0f);
-    
-    std::vector<float> wet(buffer.size(), 0.0f);
-
-    for (size_t n = 0; n < buffer.size(); ++n) {
-        // Predelay tap
-        const float preOut = preDelay_.empty() ? buffer[n] : preDelay_[preDelayIdx_];
-        if (!preDelay_.empty()) {
-            preDelay_[preDelayIdx_] = buffer[n];
-            preDelayIdx_ = (preDelayIdx_ + 1) % preDelay_.size();
-        }
+    wet_.setTarget(std::clamp(wetMix, 0.0f, 1.0f));
+    const size_t lineSize = preDelay_.size();
+    // Once everything has settled the smoothers are skipped for the block.
+    const bool gliding = !(decay_.settled() && preDelaySamples_.settled() && wet_.settled());
+    float *left = bus.channel(0);
+    float *right = channels > 1 ? bus.channel(1) : nullptr;
+
+    for (size_t n = 0; n < frames; ++n) {
+        // Predelay tap (write head leads the read head by preDelaySamples_)
+        const float dryL = left[n];
+        const float dryR = right ? right[n] : dryL;
+        preDelay_[preDelayIdx_] = 0.5f * (dryL + dryR);
+        const float delay = gliding ? preDelaySamples_.next() : preDelaySamples_.current();
+        const size_t whole = static_cast<size_t>(delay);
+        const float frac = delay - static_cast<float>(whole);
+        const size_t readIdx = preDelayIdx_ >= whole ? preDelayIdx_ - whole : preDelayIdx_ + lineSize - whole;
+        const size_t olderIdx = readIdx == 0 ? lineSize - 1 : readIdx - 1;
+        const float preOut = preDelay_[readIdx] + frac * (preDelay_[olderIdx] - preDelay_[readIdx]);
+        if (++preDelayIdx_ == lineSize) preDelayIdx_ = 0;
+
+        const float decay = gliding ? decay_.next() : decay_.current();
+        const float wetMix = gliding ? wet_.next() : wet_.current();
+        const float dryMix = 1.0f - wetMix;
 
         // Comb filters in parallel
         float combSum = 0.0f;
         for (auto &comb : combs_) {
             float delayed = comb.read();
-            float feedback = preOut + delayed * decay_;
+            float feedback = preOut + delayed * decay;
             comb.write(feedback);
             comb.advance();
             // simple one-pole damping
@@ -77,13 +122,172 @@ void SimplePlateReverb::process(std::vector<float> &buffer, float wetMix) {
             apOut = bufOut + (0.5f * input);
         }
 
-        wet[n] = apOut;
+        // Mix dry and wet in place; the dry samples were already consumed above.
+        left[n] = dryL * dryMix + apOut * wetMix;
+        if (!right) continue;
+
+        // Decorrelate the right tail with one more short allpass.
+        const float widthOut = widthAllpass_.read();
+        const float widthIn = apOut + (-0.5f * widthOut);
+        widthAllpass_.write(widthIn);
+        widthAllpass_.advance();
+        const float wetR = widthOut + (0.5f * widthIn);
+        right[n] = dryR * dryMix + wetR * wetMix;
+
+        // Extra channels of an N-channel bus share the left tail.
+        for (size_t c = 2; c < channels; ++c) {
+            float &s = bus.channel(c)[n];
+            s = s * dryMix + apOut * wetMix;
+        }
+    }
+}
+
+FdnReverb::FdnReverb(float sampleRate)
+    : sampleRate_(sampleRate),
+      decay_(0.5f),
+      preDelaySamples_(0.02f * sampleRate),
+      wet_(0.3f) {
+    preDelay_.assign(nextPowerOfTwo(static_cast<size_t>(kMaxPreDelayMs * 0.001f * sampleRate_) + 2), 0.0f);
+    preDelayMask_ = preDelay_.size() - 1;
+
+    size_t longest = 0;
+    for (size_t j = 0; j < kLines; ++j) {
+        size_t len = static_cast<size_t>(kFdnLengthsMs[j] * 0.001f * sampleRate_);
+        while (!isPrime(len)) ++len;
+        lengths_[j] = static_cast<float>(len);
+        longest = std::max(longest, len);
+        modPhase_[j] = 2.0f * kPi * static_cast<float>(j) / static_cast<float>(kLines);
+        // Signs chosen so each output mixes every line with a different
+        // polarity pattern, decorrelating left from right.
+        net_.inGain[j] = (j & 2) ? -kFdnTap : kFdnTap;
+        net_.outL[j] = kFdnTap;
+        net_.outR[j] = (j & 1) ? -kFdnTap : kFdnTap;
+    }
+    const size_t slots =
+        nextPowerOfTwo(longest + static_cast<size_t>(kMaxModDepthMs * 0.001f * sampleRate_) + 2);
+    ring_.assign(slots * kLines, 0.0f);
+    net_.ring = ring_.data();
+    net_.mask = static_cast<uint32_t>(slots - 1);
+    net_.write = 0;
+    setModulation(0.0f, 0.5f);
+    updateDelays();
+
+    decay_.setTime(kGlideMs, sampleRate_ / static_cast<float>(kControlFrames));
+    preDelaySamples_.setTime(kGlideMs, sampleRate_);
+    wet_.setTime(kGlideMs, sampleRate_);
+}
+
+void FdnReverb::setParams(float preDelayMs, float decay, float damping) {
+    decay_.setTarget(std::clamp(decay, 0.05f, 0.95f));
+    damping_ = std::clamp(damping, 0.0f, 0.9f);
+    loopDirty_ = true;
+    // One sample of headroom for the fractional read.
+    preDelaySamples_.setTarget(std::clamp((preDelayMs / 1000.0f) * sampleRate_, 0.0f,
+                                          static_cast<float>(preDelay_.size() - 2)));
+}
+
+void FdnReverb::setModulation(float depthMs, float rateHz) {
+    modDepth_ = std::clamp(depthMs, 0.0f, kMaxModDepthMs) * 0.001f * sampleRate_;
+    const float perBlock = 2.0f * kPi * std::max(rateHz, 0.0f) * static_cast<float>(kControlFrames) / sampleRate_;
+    // Spread the rates so the lines never move in step.
+    for (size_t j = 0; j < kLines; ++j) {
+        modRate_[j] = perBlock * (1.0f + 0.137f * static_cast<float>(j));
+    }
+}
+
+void FdnReverb::updateLoop() {
+    // The unnormalised Hadamard butterfly has gain sqrt(8); fold 1/sqrt(8)
+    // into the line gains so the matrix is orthonormal. Scaling by length
+    // gives every line the same decay per second.
+    const float hadamard = 1.0f / std::sqrt(static_cast<float>(kLines));
+    const float refSamples = kFdnRefMs * 0.001f * sampleRate_;
+    // Runs every control block while the decay glides, so the powers go
+    // through fastmath: decay^passes = 2^(passes * log2(decay)).
+    const float log2Decay = fastmath::log2(decay_.current());
+    const float log2Damping = fastmath::log2(damping_);
+    for (size_t j = 0; j < kLines; ++j) {
+        const float passes = lengths_[j] / refSamples;
+        net_.gain[j] = hadamard * fastmath::exp2(passes * log2Decay);
+        // Longer lines lowpass harder so the high end decays evenly too.
+        net_.damp[j] = damping_ > 0.0f ? fastmath::exp2(log2Damping / passes) : 0.0f;
+    }
+    loopDirty_ = false;
+}
+
+void FdnReverb::updateDelays() {
+    for (size_t j = 0; j < kLines; ++j) {
+        float delay = lengths_[j];
+        if (modDepth_ > 0.0f) {
+            delay += modDepth_ * fastmath::sin(modPhase_[j]);
+            modPhase_[j] += modRate_[j];
+            if (modPhase_[j] > 2.0f * kPi) modPhase_[j] -= 2.0f * kPi;
+        }
+        const float whole = std::floor(delay);
+        net_.delay[j] = static_cast<uint32_t>(whole);
+        net_.frac[j] = delay - whole;
     }
+}
+
+void FdnReverb::process(AudioBus &bus, size_t frames, float wetMix) {
+    const size_t channels = bus.channels();
+    if (frames == 0 || channels == 0) return;
 
-    // Mix dry and wet signals
-    const float dryMix = 1.0f - wetMix;
-    for (size_t i = 0; i < buffer.size(); ++i) {
-        buffer[i] = buffer[i] * dryMix + wet[i] * wetMix;
+    wet_.setTarget(std::clamp(wetMix, 0.0f, 1.0f));
+    const auto &k = simd::kernels();
+    float *left = bus.channel(0);
+    float *right = channels > 1 ? bus.channel(1) : nullptr;
+
+    for (size_t done = 0; done < frames;) {
+        const size_t n = std::min(kControlFrames, frames - done);
+        float *l = left + done;
+        float *r = right ? right + done : nullptr;
+
+        if (!decay_.settled()) {
+            decay_.next();
+            updateLoop();
+        } else if (loopDirty_) {
+            updateLoop();
+        }
+        if (modDepth_ > 0.0f) updateDelays();
+
+        // Predelay the mono sum into the network input.
+        const bool gliding = !preDelaySamples_.settled();
+        for (size_t i = 0; i < n; ++i) {
+            preDelay_[preDelayIdx_] = r ? 0.5f * (l[i] + r[i]) : l[i];
+            const float delay = gliding ? preDelaySamples_.next() : preDelaySamples_.current();
+            const size_t whole = static_cast<size_t>(delay);
+            const float frac = delay - static_cast<float>(whole);
+            const float a = preDelay_[(preDelayIdx_ - whole) & preDelayMask_];
+            const float b = preDelay_[(preDelayIdx_ - whole - 1) & preDelayMask_];
+            in_[i] = a + frac * (b - a) + kAntiDenormal;
+            preDelayIdx_ = (preDelayIdx_ + 1) & preDelayMask_;
+        }
+
+        k.fdn(net_, in_.data(), wetL_.data(), wetR_.data(), n);
+
+        // Mix dry and wet in place; extra channels of an N-channel bus share
+        // the left tail.
+        if (wet_.settled()) {
+            const float wet = wet_.current();
+            k.crossfade(l, l, wetL_.data(), 1.0f - wet, wet, n);
+            if (r) k.crossfade(r, r, wetR_.data(), 1.0f - wet, wet, n);
+            for (size_t c = 2; c < channels; ++c) {
+                float *s = bus.channel(c) + done;
+                k.crossfade(s, s, wetL_.data(), 1.0f - wet, wet, n);
+            }
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                const float wet = wet_.next();
+                const float dry = 1.0f - wet;
+                l[i] = l[i] * dry + wetL_[i] * wet;
+                if (r) r[i] = r[i] * dry + wetR_[i] * wet;
+                for (size_t c = 2; c < channels; ++c) {
+                    float &s = bus.channel(c)[done + i];
+                    s = s * dry + wetL_[i] * wet;
+                }
+            }
+        }
+        done += n;
     }
 }
 
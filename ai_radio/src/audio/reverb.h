@@ -1,28 +1,44 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <vector>
+#include "bus.h"
+#include "smoother.h"
+#include "simd/simd.h"
 
 namespace audio {
 
 // Lightweight plate-inspired reverb: two combs + two allpasses + predelay.
+// Mono-summed input; the right wet output goes through one extra allpass so
+// the tail decorrelates across a stereo bus while the dry signal keeps its
+// width. Superseded in the engine by FdnReverb; kept as the reference
+// keegan_render --reverb-bench compares against.
 class SimplePlateReverb {
 public:
     explicit SimplePlateReverb(float sampleRate = 48000.0f);
 
+    static constexpr float kMaxPreDelayMs = 250.0f;
+
+    static constexpr float kGlideMs = 60.0f;
+
+    // Does not allocate or clear state: the predelay line is sized for
+    // kMaxPreDelayMs up front. Predelay and decay glide to the new values
+    // over ~kGlideMs (the predelay tap reads fractionally while it moves).
     void setParams(float preDelayMs, float decay, float damping);
 
-    // Process buffer with reverb. wetMix controls dry/wet blend (0.0 = dry, 1.0 = fully wet).
-    void process(std::vector<float> &buffer, float wetMix = 0.3f);
+    // Process bus with reverb. wetMix controls dry/wet blend (0.0 = dry, 1.0 = fully wet)
+    // and glides like the other parameters.
+    void process(AudioBus &bus, size_t frames, float wetMix = 0.3f);
 
 private:
     float sampleRate_;
-    float decay_;
+    ParamSmoother decay_;
     float damping_;
-    size_t preDelaySamples_;
+    ParamSmoother preDelaySamples_;
+    ParamSmoother wet_;
     std::vector<float> preDelay_;
     size_t preDelayIdx_;
-
     struct DelayLine {
         std::vector<float> data;
         size_t idx{0};
@@ -33,6 +49,72 @@ private:
 
     std::array<DelayLine, 2> combs_;
     std::array<DelayLine, 2> allpasses_;
+    DelayLine widthAllpass_;
+};
+
+// Feedback-delay-network reverb: eight delay lines of prime lengths
+// (29-67 ms) fed back through a Hadamard matrix, each line with its own
+// damping lowpass and a feedback gain that gives every line the same decay
+// time. The network runs in the simd::fdn kernel; the lines share one
+// power-of-two ring indexed with a mask. Optionally each line's delay is
+// modulated by a slow sine (updated every kControlFrames) to break up
+// metallic ringing. The cost per sample is the same whatever the
+// parameters, so it fits a fixed budget on every station.
+//
+// Same interface and parameter meanings as SimplePlateReverb: decay is the
+// feedback per ~33 ms (a plate comb's length), damping the in-loop lowpass.
+class FdnReverb {
+public:
+    explicit FdnReverb(float sampleRate = 48000.0f);
+
+    FdnReverb(const FdnReverb &) = delete;
+    FdnReverb &operator=(const FdnReverb &) = delete;
+
+    static constexpr float kMaxPreDelayMs = 250.0f;
+    static constexpr float kGlideMs = 60.0f;
+    // Largest modulation depth; the ring is sized for it up front.
+    static constexpr float kMaxModDepthMs = 2.0f;
+
+    // Does not allocate or clear state. Predelay, decay and wet glide over
+    // ~kGlideMs; damping applies from the next control block.
+    void setParams(float preDelayMs, float decay, float damping);
+    // Delay modulation depth (0 = off) and base rate; lines run at spread
+    // rates around it.
+    void setModulation(float depthMs, float rateHz);
+
+    // Process bus with reverb. wetMix controls dry/wet blend (0.0 = dry, 1.0 = fully wet)
+    // and glides like the other parameters.
+    void process(AudioBus &bus, size_t frames, float wetMix = 0.3f);
+
+private:
+    static constexpr size_t kLines = simd::kFdnLines;
+    static constexpr size_t kControlFrames = 32;
+
+    // Recomputes per-line gains and damping from the current decay.
+    void updateLoop();
+    // Sets the kernel's read delays for the next control block.
+    void updateDelays();
+
+    float sampleRate_;
+    ParamSmoother decay_;
+    float damping_ = 0.25f;
+    bool loopDirty_ = true;
+    ParamSmoother preDelaySamples_;
+    ParamSmoother wet_;
+    std::vector<float> preDelay_;
+    size_t preDelayMask_ = 0;
+    size_t preDelayIdx_ = 0;
+
+    std::array<float, kLines> lengths_{}; // base delay per line, samples
+    std::array<float, kLines> modRate_{}; // LFO cycles per control block
+    std::array<float, kLines> modPhase_{};
+    float modDepth_ = 0.0f;               // samples
+
+    std::vector<float> ring_;
+    simd::FdnState net_{};
+    std::array<float, kControlFrames> in_{};
+    std::array<float, kControlFrames> wetL_{};
+    std::array<float, kControlFrames> wetR_{};
 };
 
 } // namespace audio
@@ -0,0 +1,147 @@
+#include "rt_check.h"
+#include "../util/logger.h"
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#if KEEGAN_RT_CHECKS && !defined(_WIN32)
+#include <dlfcn.h>
+#include <pthread.h>
+#endif
+
+namespace audio::rtcheck {
+
+namespace {
+std::array<std::array<std::atomic<uint64_t>, kKindCount>, kDspStageCount> g_counts{};
+
+thread_local int t_depth = 0;
+thread_local DspStage t_stage = DspStage::Commands;
+
+std::mutex g_reportMutex;
+std::array<std::array<uint64_t, kKindCount>, kDspStageCount> g_reported{};
+} // namespace
+
+const char *kindName(Kind kind) {
+    switch (kind) {
+        case Kind::Allocation: return "allocation";
+        case Kind::Deallocation: return "deallocation";
+        case Kind::Lock: return "mutex lock";
+        case Kind::Count: break;
+    }
+    return "unknown";
+}
+
+void beginCallback() {
+    if (t_depth++ == 0) t_stage = DspStage::Commands;
+}
+
+void endCallback() {
+    --t_depth;
+}
+
+void setStage(DspStage stage) {
+    if (stage >= DspStage::Count) stage = DspStage::Total;
+    t_stage = stage;
+}
+
+void note(Kind kind) {
+    if (t_depth <= 0) return;
+    g_counts[static_cast<size_t>(t_stage)][static_cast<size_t>(kind)].fetch_add(
+        1, std::memory_order_relaxed);
+}
+
+uint64_t totalViolations() {
+    uint64_t total = 0;
+    for (const auto &stage : g_counts) {
+        for (const auto &count : stage) total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::vector<Violation> violations() {
+    std::vector<Violation> out;
+    for (size_t s = 0; s < kDspStageCount; ++s) {
+        for (size_t k = 0; k < kKindCount; ++k) {
+            const uint64_t n = g_counts[s][k].load(std::memory_order_relaxed);
+            if (n > 0) out.push_back({static_cast<DspStage>(s), static_cast<Kind>(k), n});
+        }
+    }
+    return out;
+}
+
+void logNewViolations() {
+    std::lock_guard<std::mutex> lock(g_reportMutex);
+    for (size_t s = 0; s < kDspStageCount; ++s) {
+        for (size_t k = 0; k < kKindCount; ++k) {
+            const uint64_t n = g_counts[s][k].load(std::memory_order_relaxed);
+            if (n <= g_reported[s][k]) continue;
+            util::logWarn(std::string("RT check: ") + std::to_string(n - g_reported[s][k]) +
+                          " " + kindName(static_cast<Kind>(k)) + "(s) on the audio thread in stage '" +
+                          dspStageName(static_cast<DspStage>(s)) + "' (total " + std::to_string(n) + ")");
+            g_reported[s][k] = n;
+        }
+    }
+}
+
+} // namespace audio::rtcheck
+
+#if KEEGAN_RT_CHECKS
+
+// Replaced global allocation functions. Aligned overloads keep the library
+// defaults, which never route through these.
+void *operator new(std::size_t size) {
+    audio::rtcheck::note(audio::rtcheck::Kind::Allocation);
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    audio::rtcheck::note(audio::rtcheck::Kind::Allocation);
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    audio::rtcheck::note(audio::rtcheck::Kind::Allocation);
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    audio::rtcheck::note(audio::rtcheck::Kind::Allocation);
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void *p) noexcept {
+    if (p) audio::rtcheck::note(audio::rtcheck::Kind::Deallocation);
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    if (p) audio::rtcheck::note(audio::rtcheck::Kind::Deallocation);
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    if (p) audio::rtcheck::note(audio::rtcheck::Kind::Deallocation);
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    if (p) audio::rtcheck::note(audio::rtcheck::Kind::Deallocation);
+    std::free(p);
+}
+
+#if !defined(_WIN32)
+// std::mutex and friends lock through pthread_mutex_lock; a definition in the
+// executable takes precedence over libc's, so forward to the real one.
+extern "C" int pthread_mutex_lock(pthread_mutex_t *mutex) {
+    using LockFn = int (*)(pthread_mutex_t *);
+    static LockFn real = reinterpret_cast<LockFn>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    audio::rtcheck::note(audio::rtcheck::Kind::Lock);
+    return real(mutex);
+}
+#endif
+
+#endif // KEEGAN_RT_CHECKS
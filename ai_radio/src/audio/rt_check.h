@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "profiler.h"
+
+// Real-time safety checker (debug builds: cmake -DKEEGAN_RT_CHECKS=ON).
+//
+// While a thread is inside Engine::renderBlock, replaced global operator
+// new/delete and (on POSIX) an interposed pthread_mutex_lock count every
+// allocation, free and mutex acquisition against the DSP stage running at
+// the time. Counting is lock-free and allocation-free; reporting happens
+// on non-real-time threads. In normal builds every hook compiles away.
+
+#ifndef KEEGAN_RT_CHECKS
+#define KEEGAN_RT_CHECKS 0
+#endif
+
+namespace audio::rtcheck {
+
+enum class Kind : uint8_t { Allocation, Deallocation, Lock, Count };
+
+constexpr size_t kKindCount = static_cast<size_t>(Kind::Count);
+
+const char *kindName(Kind kind);
+
+struct Violation {
+    DspStage stage;
+    Kind kind;
+    uint64_t count;
+};
+
+// Audio thread. Marks the extent of one callback and the stage in progress.
+void beginCallback();
+void endCallback();
+void setStage(DspStage stage);
+
+// Called by the hooks; counts only inside a callback.
+void note(Kind kind);
+
+// Any thread.
+uint64_t totalViolations();
+std::vector<Violation> violations();
+
+// Non-real-time thread: logs counts that grew since the previous call.
+void logNewViolations();
+
+class CallbackScope {
+public:
+    CallbackScope() { beginCallback(); }
+    ~CallbackScope() { endCallback(); }
+    CallbackScope(const CallbackScope &) = delete;
+    CallbackScope &operator=(const CallbackScope &) = delete;
+};
+
+} // namespace audio::rtcheck
@@ -0,0 +1,428 @@
+#include "sample_cache.h"
+#include "asset_pack.h"
+#include "audio_decoder.h"
+#include "wav_format.h"
+#include "resampler.h"
+#include "../util/logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace audio {
+
+namespace {
+constexpr size_t kDefaultBudgetMb = 512;
+constexpr size_t kDecodeChunkFrames = 16384;
+
+// De-interleaves the data chunk into out.storage, keeping integer PCM at
+// its native width.
+bool convertSamples(const uint8_t* data, const WavFormat& fmt, SampleBuffer& out) {
+    const size_t bytesIn = fmt.bitsPerSample / 8;
+    const size_t channels = fmt.channels;
+    out.format = fmt.bitsPerSample == 24 ? SampleFormat::Int24
+               : fmt.bitsPerSample == 32 ? SampleFormat::Float32
+                                         : SampleFormat::Int16;
+    out.frames = fmt.dataSize / bytesIn / channels;
+    const size_t bytesOut = out.bytesPerSample();
+    if (!out.storage.allocate(out.frames * channels * bytesOut)) return false;
+
+    // Sample i belongs to channel i % channels.
+    const size_t totalSamples = out.frames * channels;
+    uint8_t* base = out.storage.data();
+    for (size_t i = 0; i < totalSamples; ++i) {
+        const uint8_t* src = data + i * bytesIn;
+        uint8_t* dst = base + ((i % channels) * out.frames + i / channels) * bytesOut;
+
+        if (fmt.bitsPerSample == 8) {
+            // 8-bit unsigned: recentre and scale to 16-bit full scale.
+            const int16_t sample = static_cast<int16_t>((static_cast<int>(src[0]) - 128) * 256);
+            std::memcpy(dst, &sample, sizeof(sample));
+        } else if (fmt.bitsPerSample == 16 || fmt.bitsPerSample == 24 || fmt.bitsPerSample == 32) {
+            // Little-endian 16/24-bit PCM or 32-bit float: copied as is.
+            std::memcpy(dst, src, bytesOut);
+        }
+        // Other widths stay silent (storage is zero-filled).
+    }
+    return true;
+}
+
+bool decodeWav(const MappedFile& file, const std::string& path, SampleBuffer& out) {
+    WavFormat fmt;
+    if (!parseWavHeader(file.data(), file.size(), file.size(), fmt)) {
+        util::logError("SampleCache: Invalid WAV header: " + path);
+        return false;
+    }
+    if (fmt.channels == 0 || fmt.bitsPerSample < 8) {
+        util::logError("SampleCache: Invalid channel count or sample size: " + path);
+        return false;
+    }
+    out.channels = fmt.channels;
+    out.sampleRate = fmt.sampleRate;
+    if (!convertSamples(file.data() + fmt.dataOffset, fmt, out)) {
+        util::logError("SampleCache: Out of memory decoding " + path);
+        return false;
+    }
+    return out.frames > 0;
+}
+
+// Decodes a FLAC or MP3 file (or Ogg Vorbis, when built with stb_vorbis),
+// keeping FLAC's integer width: 16-bit or packed 24-bit.
+// decoder is open on the file with Output::Native and not yet read.
+bool decodeCompressed(AudioDecoder& decoder, const std::string& path, SampleBuffer& out) {
+    out.channels = decoder.channels();
+    out.sampleRate = decoder.sampleRate();
+    out.format = decoder.bitsPerSample() == 16 ? SampleFormat::Int16
+               : decoder.bitsPerSample() == 24 ? SampleFormat::Int24
+                                               : SampleFormat::Float32;
+    const size_t bytesOut = out.bytesPerSample();
+    const size_t channels = out.channels;
+    const size_t frameBytes = bytesOut * channels;
+
+    // Decode interleaved first: some codecs only know their length once
+    // they reach the end, so the reported length is just a hint.
+    std::vector<uint8_t> interleaved;
+    interleaved.reserve(static_cast<size_t>(decoder.frames() + kDecodeChunkFrames) * frameBytes);
+    size_t frames = 0;
+    for (;;) {
+        interleaved.resize((frames + kDecodeChunkFrames) * frameBytes);
+        const size_t n = decoder.read(interleaved.data() + frames * frameBytes, kDecodeChunkFrames);
+        frames += n;
+        if (n < kDecodeChunkFrames) break;
+    }
+
+    out.frames = frames;
+    if (!out.storage.allocate(frames * frameBytes)) {
+        util::logError("SampleCache: Out of memory decoding " + path);
+        return false;
+    }
+    uint8_t* base = out.storage.data();
+    for (size_t c = 0; c < channels; ++c) {
+        uint8_t* dst = base + c * frames * bytesOut;
+        const uint8_t* src = interleaved.data() + c * bytesOut;
+        for (size_t i = 0; i < frames; ++i) std::memcpy(dst + i * bytesOut, src + i * frameBytes, bytesOut);
+    }
+    return frames > 0;
+}
+
+// Opens decoder on a compressed file; the cache probes the rate with it
+// and then decodes from the same handle.
+bool openDecoder(const MappedFile& file, const std::string& path, AudioDecoder& decoder) {
+    return decoder.open(file.data(), file.size(), path, AudioDecoder::Output::Native);
+}
+
+bool decodeFile(const MappedFile& file, const std::string& path, SampleBuffer& out) {
+    if (!AudioDecoder::handles(path)) return decodeWav(file, path, out);
+    AudioDecoder decoder;
+    return openDecoder(file, path, decoder) && decodeCompressed(decoder, path, out);
+}
+
+// Channel c of a buffer as float.
+void channelToFloat(const SampleBuffer& in, size_t c, std::vector<float>& out) {
+    out.resize(in.frames);
+    const uint8_t* src = in.channel(c);
+    for (size_t i = 0; i < in.frames; ++i) {
+        switch (in.format) {
+            case SampleFormat::Int16: {
+                int16_t v;
+                std::memcpy(&v, src + 2 * i, sizeof(v));
+                out[i] = static_cast<float>(v) / 32768.0f;
+                break;
+            }
+            case SampleFormat::Int24:
+                out[i] = wavSampleToFloat(src + 3 * i, 24);
+                break;
+            case SampleFormat::Float32:
+                std::memcpy(&out[i], src + 4 * i, sizeof(float));
+                break;
+        }
+    }
+}
+
+// Stores float samples into channel c of out, requantising to its format.
+void storeChannel(const std::vector<float>& in, size_t c, SampleBuffer& out) {
+    uint8_t* dst = out.storage.data() + c * out.frames * out.bytesPerSample();
+    for (size_t i = 0; i < out.frames; ++i) {
+        const float v = in[i];
+        switch (out.format) {
+            case SampleFormat::Int16: {
+                const int16_t q = static_cast<int16_t>(std::lrint(std::clamp(v * 32768.0f, -32768.0f, 32767.0f)));
+                std::memcpy(dst + 2 * i, &q, sizeof(q));
+                break;
+            }
+            case SampleFormat::Int24: {
+                const int32_t q = static_cast<int32_t>(std::lrint(std::clamp(v * 8388608.0f, -8388608.0f, 8388607.0f)));
+                for (size_t b = 0; b < 3; ++b) dst[3 * i + b] = static_cast<uint8_t>(q >> (8 * b));
+                break;
+            }
+            case SampleFormat::Float32:
+                std::memcpy(dst + 4 * i, &v, sizeof(float));
+                break;
+        }
+    }
+}
+
+// Converts every channel of in to outRate, keeping its sample format.
+bool resampleBuffer(const SampleBuffer& in, uint32_t outRate, SampleBuffer& out) {
+    const Resampler resampler(in.sampleRate, outRate);
+    out.format = in.format;
+    out.channels = in.channels;
+    out.sampleRate = outRate;
+    out.contentHash = in.contentHash;
+    out.sourceBytes = in.sourceBytes;
+    out.frames = resampler.outputFrames(in.frames);
+    if (!out.storage.allocate(out.frames * out.channels * out.bytesPerSample())) return false;
+
+    std::vector<float> src, dst(out.frames);
+    for (size_t c = 0; c < in.channels; ++c) {
+        channelToFloat(in, c, src);
+        resampler.processLoop(src.data(), in.frames, dst.data(), out.frames);
+        storeChannel(dst, c, out);
+    }
+    return out.frames > 0;
+}
+} // namespace
+
+SampleCache &SampleCache::instance() {
+    static SampleCache cache;
+    return cache;
+}
+
+SampleCache::SampleCache() : budgetBytes_(kDefaultBudgetMb << 20) {
+    if (const char *mb = std::getenv("KEEGAN_SAMPLE_CACHE_MB")) {
+        const long value = std::atol(mb);
+        if (value > 0) budgetBytes_ = static_cast<size_t>(value) << 20;
+    }
+}
+
+SampleRef SampleCache::touchLocked(Entry &entry) {
+    lru_.splice(lru_.begin(), lru_, entry.lru);
+    return entry.sample;
+}
+
+SampleRef SampleCache::adoptLocked(Entry &entry, const std::string &key, const ContentKey &content) {
+    if (std::find(entry.paths.begin(), entry.paths.end(), key) == entry.paths.end()) {
+        entry.paths.push_back(key);
+    }
+    pathIndex_[key] = content;
+    return touchLocked(entry);
+}
+
+SampleRef SampleCache::load(const std::string &path, uint32_t outputRate) {
+    // Resampled copies are separate entries, keyed by path and rate.
+    const std::string key = outputRate ? path + "@" + std::to_string(outputRate) : path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pathIndex_.find(key);
+        if (it != pathIndex_.end()) {
+            auto entry = entries_.find(it->second);
+            if (entry != entries_.end()) {
+                ++hits_;
+                SampleRef ref = touchLocked(entry->second);
+                // Banks retired since the last load may have freed entries.
+                evictLocked();
+                return ref;
+            }
+        }
+    }
+
+    // Baked into a mounted pack: no file I/O and no decoding.
+    if (SampleRef packed = loadPacked(key, path, outputRate)) return packed;
+
+    // Miss: read and hash outside the lock so other loads keep going.
+    MappedFile file;
+    if (!file.open(path)) {
+        util::logError("SampleCache: Failed to open file: " + path);
+        return nullptr;
+    }
+    // The file's rate from its header; a compressed file's decoder stays
+    // open for the decode below.
+    const bool compressed = AudioDecoder::handles(path);
+    AudioDecoder decoder;
+    uint32_t fileRate = 0;
+    if (compressed) {
+        if (openDecoder(file, path, decoder)) fileRate = decoder.sampleRate();
+    } else {
+        WavFormat fmt;
+        if (parseWavHeader(file.data(), file.size(), file.size(), fmt)) fileRate = fmt.sampleRate;
+    }
+    const bool resample = outputRate != 0 && fileRate != 0 && fileRate != outputRate;
+    const ContentKey content{hashBytes(file.data(), file.size()), file.size(), resample ? outputRate : fileRate};
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++misses_;
+        auto it = entries_.find(content);
+        if (it != entries_.end()) {
+            ++shared_;
+            return adoptLocked(it->second, key, content);
+        }
+    }
+
+    auto decoded = std::make_shared<SampleBuffer>();
+    const bool ok = compressed ? fileRate != 0 && decodeCompressed(decoder, path, *decoded)
+                               : decodeWav(file, path, *decoded);
+    if (!ok) return nullptr;
+    if (resample) {
+        auto converted = std::make_shared<SampleBuffer>();
+        if (!resampleBuffer(*decoded, outputRate, *converted)) {
+            util::logError("SampleCache: Out of memory resampling " + path);
+            return nullptr;
+        }
+        util::logInfo("SampleCache: Resampled " + path + " from " + std::to_string(decoded->sampleRate) +
+                      " to " + std::to_string(outputRate) + " Hz");
+        decoded = std::move(converted);
+    }
+    decoded->contentHash = content.hash;
+    decoded->sourceBytes = content.sourceBytes;
+    return publish(key, path, std::move(decoded));
+}
+
+SampleRef SampleCache::loadPacked(const std::string &key, const std::string &path, uint32_t outputRate) {
+    std::shared_ptr<const AssetPack> pack;
+    const AssetPack::Entry *packed = AssetPack::findMounted(path, &pack);
+    if (packed == nullptr || packed->kind != AssetPack::Kind::Sample ||
+        (outputRate != 0 && packed->sampleRate != outputRate)) {
+        return nullptr;
+    }
+    const ContentKey content{packed->contentHash, packed->sourceBytes, packed->sampleRate};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++misses_;
+        ++packed_;
+        auto it = entries_.find(content);
+        if (it != entries_.end()) {
+            ++shared_;
+            return adoptLocked(it->second, key, content);
+        }
+    }
+
+    pack->prefault(*packed);
+    auto sample = std::make_shared<SampleBuffer>();
+    sample->format = packed->format;
+    sample->frames = static_cast<size_t>(packed->frames);
+    sample->channels = packed->channels;
+    sample->sampleRate = packed->sampleRate;
+    sample->contentHash = content.hash;
+    sample->sourceBytes = content.sourceBytes;
+    sample->mapped = packed->data;
+    sample->mappedOwner = pack;
+    return publish(key, path, std::move(sample));
+}
+
+SampleRef SampleCache::publish(const std::string &key, const std::string &path, std::shared_ptr<SampleBuffer> sample) {
+    const ContentKey content{sample->contentHash, sample->sourceBytes, sample->sampleRate};
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(content);
+    if (it != entries_.end()) {
+        // Another thread loaded the same content meanwhile; keep theirs.
+        return adoptLocked(it->second, key, content);
+    }
+    Entry &entry = entries_[content];
+    entry.sample = std::move(sample);
+    lru_.push_front(content);
+    entry.lru = lru_.begin();
+    residentBytes_ += entry.sample->bytes();
+    util::logInfo(std::string("SampleCache: ") + (entry.sample->mapped ? "Mapped " : "Decoded ") + path + " (" +
+                  std::to_string(entry.sample->frames) + " frames, " + std::to_string(entry.sample->channels) +
+                  " ch, " + std::to_string(entry.sample->sampleRate) + " Hz, " +
+                  std::to_string(entry.sample->bytesPerSample() * 8) + "-bit" +
+                  (entry.sample->storage.locked() ? ", locked" : "") + ")");
+    SampleRef ref = adoptLocked(entry, key, content);
+    evictLocked();
+    return ref;
+}
+
+bool SampleCache::decode(const std::string &path, SampleBuffer &out) {
+    MappedFile file;
+    if (!file.open(path)) {
+        util::logError("SampleCache: Failed to open file: " + path);
+        return false;
+    }
+    return decodeFile(file, path, out);
+}
+
+uint64_t SampleCache::hashBytes(const uint8_t *data, size_t size) {
+    // FNV-1a over 64-bit words rather than bytes, with an xor-shift after
+    // each multiply so high bits feed back into low ones. The tail is
+    // zero-padded; the cache keys on the size as well.
+    constexpr uint64_t kPrime = 0x100000001b3ull;
+    uint64_t h = 0xcbf29ce484222325ull;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = (h ^ word) * kPrime;
+        h ^= h >> 32;
+    }
+    if (i < size) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + i, size - i);
+        h = (h ^ word) * kPrime;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+void SampleCache::evictLocked() {
+    auto it = lru_.end();
+    while (residentBytes_ > budgetBytes_ && it != lru_.begin()) {
+        --it;
+        auto entry = entries_.find(*it);
+        // use_count() == 1: only the cache holds it. Nobody can take a new
+        // reference without the lock, so this cannot race.
+        if (entry->second.sample.use_count() != 1) continue;
+        residentBytes_ -= entry->second.sample->bytes();
+        for (const auto &p : entry->second.paths) {
+            auto idx = pathIndex_.find(p);
+            if (idx != pathIndex_.end() && idx->second == entry->first) pathIndex_.erase(idx);
+        }
+        entries_.erase(entry);
+        it = lru_.erase(it);
+        ++evictions_;
+    }
+}
+
+void SampleCache::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budgetBytes_ = bytes;
+    evictLocked();
+}
+
+void SampleCache::invalidate(const std::string &path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::string rated = path + "@";
+    for (auto it = pathIndex_.begin(); it != pathIndex_.end();) {
+        if (it->first == path || it->first.compare(0, rated.size(), rated) == 0) {
+            it = pathIndex_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+SampleCache::Stats SampleCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s;
+    s.hits = hits_;
+    s.misses = misses_;
+    s.shared = shared_;
+    s.packed = packed_;
+    s.evictions = evictions_;
+    s.entries = entries_.size();
+    s.residentBytes = residentBytes_;
+    s.budgetBytes = budgetBytes_;
+    return s;
+}
+
+std::string SampleCache::statsLine() const {
+    const Stats s = stats();
+    std::ostringstream ss;
+    ss << "sample cache: " << s.hits << " hits, " << s.misses << " misses (" << s.shared << " shared, " << s.packed << " from packs), "
+       << s.evictions << " evictions, " << s.entries << " entries, " << (s.residentBytes >> 10) << " KiB of "
+       << (s.budgetBytes >> 20) << " MiB";
+    return ss.str();
+}
+
+} // namespace audio
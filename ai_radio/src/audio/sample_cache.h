@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "sample_storage.h"
+
+namespace audio {
+
+// How a SampleBuffer stores its samples. Integer PCM keeps its file width
+// (8-bit is widened to Int16); players convert to float as they mix.
+enum class SampleFormat : uint8_t {
+    Int16,   // int16_t, full scale 32768
+    Int24,   // packed little-endian, 3 bytes per sample, full scale 2^23
+    Float32
+};
+
+// Decoded audio, planar (channel c starts at byte c * frames *
+// bytesPerSample()). Immutable once published by the cache, so any number
+// of players can read it at once. The samples are either in storage or,
+// for a mounted AssetPack, in the pack's mapping (mapped, kept alive by
+// mappedOwner).
+struct SampleBuffer {
+    SampleStorage storage;
+    const uint8_t *mapped = nullptr;
+    std::shared_ptr<const void> mappedOwner;
+    SampleFormat format = SampleFormat::Float32;
+    size_t frames = 0;
+    uint16_t channels = 0;
+    uint32_t sampleRate = 0;
+    // Hash and byte size of the file it was decoded from. With sampleRate
+    // they identify the buffer in SampleCache.
+    uint64_t contentHash = 0;
+    uint64_t sourceBytes = 0;
+
+    size_t bytesPerSample() const {
+        return format == SampleFormat::Int16 ? 2 : format == SampleFormat::Int24 ? 3 : 4;
+    }
+    const uint8_t *data() const { return mapped ? mapped : storage.data(); }
+    const uint8_t *channel(size_t c) const { return data() + c * frames * bytesPerSample(); }
+    size_t bytes() const { return mapped ? frames * channels * bytesPerSample() : storage.size(); }
+};
+
+using SampleRef = std::shared_ptr<const SampleBuffer>;
+
+// Process-wide cache of decoded samples shared by stems and stories.
+// Reads WAV, and FLAC/MP3/Ogg Vorbis by file extension (see AudioDecoder).
+// Paths found in a mounted AssetPack at the requested rate are served from
+// the pack's mapping without touching the file.
+//
+// Lookups go by path first (a hit does no I/O at all), then by the file's
+// content (a hash of its bytes, its size and the rate it is held at), so
+// identical files under different paths share one buffer. Entries are
+// refcounted through SampleRef; once only the cache holds one it becomes
+// evictable, least recently used first, whenever resident memory is over
+// budget. Referenced samples are never evicted, so the budget can be
+// exceeded by what is actually playing.
+//
+// Thread-safe. Not for the audio thread: misses read and decode files.
+// Dropping a SampleRef never frees memory, because the cache keeps its own
+// reference until eviction.
+class SampleCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;       // path lookups served from memory
+        uint64_t misses = 0;     // file reads
+        uint64_t shared = 0;     // misses whose content was already resident
+        uint64_t packed = 0;     // misses served from a mounted AssetPack
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t residentBytes = 0;
+        size_t budgetBytes = 0;
+    };
+
+    static SampleCache &instance();
+
+    // Returns nullptr (and logs) if the file cannot be read or decoded.
+    // A non-zero outputRate resamples files recorded at another rate once,
+    // at load; the converted copy is cached separately from the original.
+    SampleRef load(const std::string &path, uint32_t outputRate = 0);
+
+    // Decodes path into out without caching it (tools and benchmarks).
+    static bool decode(const std::string &path, SampleBuffer &out);
+
+    // The hash SampleBuffer::contentHash holds: FNV-1a over the file's
+    // bytes, eight at a time.
+    static uint64_t hashBytes(const uint8_t *data, size_t size);
+
+    // Evicts unreferenced entries down to the new budget.
+    void setBudget(size_t bytes);
+    // Forgets path mappings (at every rate) so the next load re-reads the
+    // file.
+    void invalidate(const std::string &path);
+
+    Stats stats() const;
+    std::string statsLine() const;
+
+private:
+    SampleCache();
+
+    // A 64-bit hash alone is not trusted as identity: two files only share
+    // an entry if their size and held rate match too.
+    struct ContentKey {
+        uint64_t hash = 0;
+        uint64_t sourceBytes = 0;
+        uint32_t sampleRate = 0;
+        bool operator==(const ContentKey &) const = default;
+    };
+    struct ContentKeyHash {
+        size_t operator()(const ContentKey &k) const {
+            return static_cast<size_t>(k.hash ^ (k.sourceBytes * 0x9e3779b97f4a7c15ull) ^
+                                       (static_cast<uint64_t>(k.sampleRate) << 32));
+        }
+    };
+
+    struct Entry {
+        SampleRef sample;
+        std::vector<std::string> paths;
+        std::list<ContentKey>::iterator lru;
+    };
+
+    SampleRef touchLocked(Entry &entry);
+    SampleRef adoptLocked(Entry &entry, const std::string &key, const ContentKey &content);
+    // Caches a freshly decoded (or mapped) sample under key, unless another
+    // thread got the same content in first.
+    SampleRef publish(const std::string &key, const std::string &path, std::shared_ptr<SampleBuffer> sample);
+    SampleRef loadPacked(const std::string &key, const std::string &path, uint32_t outputRate);
+    void evictLocked();
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, ContentKey> pathIndex_;
+    std::unordered_map<ContentKey, Entry, ContentKeyHash> entries_;
+    std::list<ContentKey> lru_; // most recently used first
+    size_t budgetBytes_;
+    size_t residentBytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t shared_ = 0;
+    uint64_t packed_ = 0;
+    uint64_t evictions_ = 0;
+};
+
+} // namespace audio
@@ -0,0 +1,200 @@
+#include "sample_storage.h"
+#include "../util/logger.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace audio {
+
+namespace {
+bool lockFromEnv() {
+    const char *v = std::getenv("KEEGAN_SAMPLE_MLOCK");
+    return v != nullptr && std::strcmp(v, "0") != 0 && v[0] != '\0';
+}
+
+std::atomic<bool> g_lockPages{lockFromEnv()};
+std::atomic<bool> g_lockWarned{false};
+
+void warnLockFailed() {
+    if (!g_lockWarned.exchange(true)) {
+        util::logWarn("SampleStorage: could not lock sample memory into RAM (raise the memlock limit); "
+                      "continuing unlocked");
+    }
+}
+} // namespace
+
+void SampleStorage::setLockPages(bool lock) { g_lockPages.store(lock); }
+bool SampleStorage::lockPages() { return g_lockPages.load(); }
+
+bool SampleStorage::allocate(size_t bytes) {
+    release();
+    if (bytes == 0) return true;
+
+#if defined(_WIN32)
+    void *p = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (p != nullptr) {
+        data_ = static_cast<uint8_t *>(p);
+        mapped_ = true;
+        // Commit only reserves pagefile space; touch every page now.
+        for (size_t off = 0; off < bytes; off += 4096) data_[off] = 0;
+        if (lockPages()) {
+            locked_ = VirtualLock(p, bytes) != 0;
+            if (!locked_) warnLockFailed();
+        }
+    }
+#else
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_POPULATE)
+    flags |= MAP_POPULATE;
+#endif
+    void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (p != MAP_FAILED) {
+        data_ = static_cast<uint8_t *>(p);
+        mapped_ = true;
+#if !defined(MAP_POPULATE)
+        const long page = sysconf(_SC_PAGESIZE);
+        for (size_t off = 0; off < bytes; off += static_cast<size_t>(page > 0 ? page : 4096)) data_[off] = 0;
+#endif
+        if (lockPages()) {
+            locked_ = mlock(p, bytes) == 0;
+            if (!locked_) warnLockFailed();
+        }
+    }
+#endif
+
+    if (data_ == nullptr) {
+        data_ = new (std::nothrow) uint8_t[bytes]();
+        if (data_ == nullptr) return false;
+    }
+    size_ = bytes;
+    return true;
+}
+
+void SampleStorage::release() {
+    if (data_ == nullptr) return;
+    if (mapped_) {
+#if defined(_WIN32)
+        if (locked_) VirtualUnlock(data_, size_);
+        VirtualFree(data_, 0, MEM_RELEASE);
+#else
+        munmap(data_, size_); // also drops any lock
+#endif
+    } else {
+        delete[] data_;
+    }
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    locked_ = false;
+}
+
+bool MappedFile::open(const std::string &path, Access access) {
+    close();
+
+#if defined(_WIN32)
+    const DWORD flags = FILE_ATTRIBUTE_NORMAL | (access == Access::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : 0);
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size{};
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (view != nullptr) {
+            file_ = file;
+            mapping_ = mapping;
+            data_ = static_cast<const uint8_t *>(view);
+            size_ = static_cast<size_t>(size.QuadPart);
+            mapped_ = true;
+            return true;
+        }
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(file);
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st {};
+        void *view = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd); // the mapping keeps the file referenced
+        if (view != MAP_FAILED) {
+            if (access == Access::Sequential) madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            data_ = static_cast<const uint8_t *>(view);
+            size_ = static_cast<size_t>(st.st_size);
+            mapped_ = true;
+            return true;
+        }
+    }
+#endif
+
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+    copy_.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char *>(copy_.data()), static_cast<std::streamsize>(copy_.size()));
+    if (!in.good() && !in.eof()) {
+        copy_.clear();
+        return false;
+    }
+    data_ = copy_.data();
+    size_ = copy_.size();
+    return true;
+}
+
+void MappedFile::prefault(const uint8_t *p, size_t bytes) const {
+    if (p == nullptr || bytes == 0) return;
+    if (mapped_) {
+#if !defined(_WIN32)
+        // madvise wants a page-aligned start.
+        const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE) > 0 ? sysconf(_SC_PAGESIZE) : 4096);
+        const uintptr_t start = reinterpret_cast<uintptr_t>(p) & ~(page - 1);
+        madvise(reinterpret_cast<void *>(start), bytes + (reinterpret_cast<uintptr_t>(p) - start), MADV_WILLNEED);
+#endif
+    }
+    volatile uint8_t sink = 0;
+    for (size_t off = 0; off < bytes; off += 4096) sink = sink + p[off];
+    sink = sink + p[bytes - 1];
+    if (mapped_ && SampleStorage::lockPages()) {
+#if defined(_WIN32)
+        const bool locked = VirtualLock(const_cast<uint8_t *>(p), bytes) != 0;
+#else
+        const bool locked = mlock(p, bytes) == 0;
+#endif
+        if (!locked) warnLockFailed();
+    }
+}
+
+void MappedFile::close() {
+    if (mapped_) {
+#if defined(_WIN32)
+        UnmapViewOfFile(data_);
+        CloseHandle(static_cast<HANDLE>(mapping_));
+        CloseHandle(static_cast<HANDLE>(file_));
+        file_ = mapping_ = nullptr;
+#else
+        munmap(const_cast<uint8_t *>(data_), size_);
+#endif
+    }
+    copy_.clear();
+    copy_.shrink_to_fit();
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+}
+
+} // namespace audio
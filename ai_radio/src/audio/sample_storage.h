@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace audio {
+
+// Zero-filled memory for decoded samples. Where the platform allows it this
+// is an anonymous mapping whose pages are all faulted in at allocate() time
+// (and locked into RAM when page locking is on), so the audio thread never
+// takes a page fault reading it. Falls back to the heap otherwise.
+class SampleStorage {
+public:
+    SampleStorage() = default;
+    ~SampleStorage() { release(); }
+
+    SampleStorage(const SampleStorage &) = delete;
+    SampleStorage &operator=(const SampleStorage &) = delete;
+
+    bool allocate(size_t bytes);
+    void release();
+
+    uint8_t *data() { return data_; }
+    const uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+    bool locked() const { return locked_; }
+
+    // Lock newly allocated storage into RAM (mlock / VirtualLock). Off by
+    // default; KEEGAN_SAMPLE_MLOCK=1 turns it on at startup. A failed lock
+    // is logged once and the memory is used unlocked.
+    static void setLockPages(bool lock);
+    static bool lockPages();
+
+private:
+    uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    bool locked_ = false;
+};
+
+// Read-only view of a whole file, memory mapped where possible so decoding
+// does not need a heap copy of the raw bytes. Falls back to reading the file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // How the mapping will be read. Sequential (decodes, hashing) tells the
+    // kernel to read ahead and drop pages behind the reader; Normal keeps
+    // them, for mappings players loop over (AssetPack).
+    enum class Access { Sequential, Normal };
+
+    bool open(const std::string &path, Access access = Access::Sequential);
+    void close();
+
+    const uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // Faults in the pages of [p, p + bytes) within the file, and locks them
+    // into RAM when SampleStorage page locking is on.
+    void prefault(const uint8_t *p, size_t bytes) const;
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<uint8_t> copy_; // fallback when mapping fails
+#if defined(_WIN32)
+    void *file_ = nullptr;
+    void *mapping_ = nullptr;
+#endif
+};
+
+} // namespace audio
@@ -1,12 +1,19 @@
 #include "scheduler.h"
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 
 namespace audio {
 
 namespace {
 constexpr float kPi = 3.1415926535f;
+
+int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
 }
+} // namespace
 
 void Scheduler::setMood(const brain::MoodRecipe &mood) {
     // Derive tempo from energy if not specified; clamp to sensible range.
@@ -27,8 +34,49 @@ float Scheduler::nextDensity(size_t blockSize) {
     if (phase_ > 1.0f) phase_ -= 1.0f;
     float wobble = 0.05f * std::sin(2.0f * kPi * phase_);
     float density = std::clamp(baseDensity_ + wobble, 0.05f, 1.0f);
-    (void)lookaheadSamples_; // reserved for future event emission
     return density;
 }
 
+uint64_t Scheduler::clock() const {
+    return publishedClock_.load(std::memory_order_acquire);
+}
+
+uint64_t Scheduler::eventTime() const {
+    uint64_t clock = 0;
+    int64_t ns = 0;
+    uint32_t frames = 0;
+    for (;;) {
+        const uint32_t seq = publishSeq_.load(std::memory_order_acquire);
+        if (seq & 1u) continue; // mid-publish
+        clock = publishedClock_.load(std::memory_order_relaxed);
+        ns = publishedNs_.load(std::memory_order_relaxed);
+        frames = publishedFrames_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (publishSeq_.load(std::memory_order_relaxed) == seq) break;
+    }
+    if (offline_) return clock;
+    // Callbacks come once per chunk, so between them the output position
+    // moves on by up to one chunk.
+    const double elapsed = static_cast<double>(std::max<int64_t>(steadyNs() - ns, 0)) * 1e-9 * sampleRate_;
+    return clock + static_cast<uint64_t>(std::min(elapsed, static_cast<double>(frames))) + lookaheadSamples_;
+}
+
+size_t Scheduler::framesUntilEvent(size_t frames) const {
+    if (events_.empty()) return frames;
+    const uint64_t at = events_.nextTime();
+    if (at <= clock_) return 0;
+    return static_cast<size_t>(std::min<uint64_t>(at - clock_, frames));
+}
+
+void Scheduler::publish(size_t frames) {
+    const int64_t ns = offline_ ? 0 : steadyNs();
+    const uint32_t seq = publishSeq_.load(std::memory_order_relaxed);
+    publishSeq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    publishedClock_.store(clock_, std::memory_order_relaxed);
+    publishedNs_.store(ns, std::memory_order_relaxed);
+    publishedFrames_.store(static_cast<uint32_t>(frames), std::memory_order_relaxed);
+    publishSeq_.store(seq + 2, std::memory_order_release);
+}
+
 } // namespace audio
@@ -1,14 +1,87 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <utility>
 #include <vector>
+#include "engine_command.h"
 #include "../brain/state_machine.h"
 
 namespace audio {
 
-// Minimal lookahead scheduler that outputs a density scalar per block.
+// Fixed-capacity binary min-heap of values keyed by sample time; values due
+// at the same sample come out in the order they were pushed. Never
+// allocates, so the audio thread can own it.
+template <typename T, size_t Capacity>
+class EventTimeline {
+public:
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    // Time of the earliest event; only valid when not empty.
+    uint64_t nextTime() const { return heap_[0].at; }
+
+    // False (and nothing queued) when full.
+    bool push(uint64_t atSample, const T &value) {
+        if (size_ == Capacity) return false;
+        size_t i = size_++;
+        heap_[i] = {atSample, order_++, value};
+        while (i > 0) {
+            const size_t parent = (i - 1) / 2;
+            if (!before(heap_[i], heap_[parent])) break;
+            std::swap(heap_[i], heap_[parent]);
+            i = parent;
+        }
+        return true;
+    }
+
+    // Removes the earliest event if it is due at or before now.
+    bool popDue(uint64_t now, T &out) {
+        if (size_ == 0 || heap_[0].at > now) return false;
+        out = heap_[0].value;
+        heap_[0] = heap_[--size_];
+        for (size_t i = 0;;) {
+            const size_t l = 2 * i + 1, r = l + 1;
+            size_t m = i;
+            if (l < size_ && before(heap_[l], heap_[m])) m = l;
+            if (r < size_ && before(heap_[r], heap_[m])) m = r;
+            if (m == i) break;
+            std::swap(heap_[i], heap_[m]);
+            i = m;
+        }
+        return true;
+    }
+
+private:
+    struct Entry {
+        uint64_t at = 0;
+        uint64_t order = 0;
+        T value{};
+    };
+
+    static bool before(const Entry &a, const Entry &b) {
+        return a.at < b.at || (a.at == b.at && a.order < b.order);
+    }
+
+    std::array<Entry, Capacity> heap_{};
+    size_t size_ = 0;
+    uint64_t order_ = 0;
+};
+
+// Lookahead scheduler: a density scalar per block, the engine's sample
+// clock, and a timeline of timestamped commands the render loop applies at
+// their exact sample (splitting the block there).
+//
+// Control threads stamp commands with eventTime() and post them through
+// the engine's lock-free command queue; the audio thread moves them onto
+// the timeline as it drains the queue. The lookahead absorbs the tick
+// thread's jitter: an event lands a fixed time after its tick, wherever the
+// tick fell between audio callbacks, rather than at the next block.
 class Scheduler {
 public:
+    static constexpr size_t kMaxEvents = 128;
+
     Scheduler(float sampleRate, float lookaheadMs = 50.0f)
         : sampleRate_(sampleRate),
           lookaheadSamples_(static_cast<size_t>(lookaheadMs * 0.001f * sampleRate)),
@@ -19,12 +92,51 @@ public:
     // Advance time and return a density multiplier [0..1] for the next block.
     float nextDensity(size_t blockSize);
 
+    // Offline engines tick between blocks, in step with the clock, so
+    // events land on the next sample rendered with no lookahead. Call
+    // before rendering starts.
+    void setOffline(bool offline) { offline_ = offline; }
+
+    // Any thread. The next sample the audio thread will render.
+    uint64_t clock() const;
+    // Any thread. The sample an event decided now should land on: the clock
+    // (interpolated from wall time since the last block) plus the lookahead.
+    uint64_t eventTime() const;
+
+    // Audio thread. Queues cmd for cmd.atSample; false when the timeline is
+    // full.
+    bool schedule(const EngineCommand &cmd) { return events_.push(cmd.atSample, cmd); }
+    // Audio thread. Frames from the clock to the next event, at most frames.
+    size_t framesUntilEvent(size_t frames) const;
+    // Audio thread. Pops the next event due at or before the clock.
+    bool popDue(EngineCommand &out) { return events_.popDue(clock_, out); }
+    // Removes every event whatever its time (teardown, with audio stopped).
+    bool popAny(EngineCommand &out) { return events_.popDue(UINT64_MAX, out); }
+    // Audio thread. Moves the clock past a rendered chunk.
+    void advance(size_t frames) { clock_ += frames; }
+    // Audio thread, once per callback of `frames`: makes the clock visible
+    // to clock() and eventTime().
+    void publish(size_t frames);
+
 private:
     float sampleRate_;
     size_t lookaheadSamples_;
     float phase_;
     float tempoHz_{1.0f};
     float baseDensity_{0.5f};
+    bool offline_ = false;
+
+    // Audio-thread clock and timeline.
+    uint64_t clock_ = 0;
+    EventTimeline<EngineCommand, kMaxEvents> events_;
+
+    // Clock as last published for eventTime(), with the wall time and size
+    // of the callback that got it there; a seqlock keeps the three
+    // consistent.
+    std::atomic<uint32_t> publishSeq_{0};
+    std::atomic<uint64_t> publishedClock_{0};
+    std::atomic<int64_t> publishedNs_{0};
+    std::atomic<uint32_t> publishedFrames_{0};
 };
 
 } // namespace audio
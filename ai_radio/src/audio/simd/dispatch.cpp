@@ -0,0 +1,273 @@
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace audio::simd {
+
+namespace {
+struct CpuFeatures {
+    bool avx2 = false;
+    bool avx512f = false;
+};
+
+CpuFeatures detectCpu() {
+    CpuFeatures f;
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    f.avx2 = __builtin_cpu_supports("avx2");
+    f.avx512f = __builtin_cpu_supports("avx512f");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int regs[4] = {};
+    __cpuid(regs, 0);
+    const int maxLeaf = regs[0];
+    __cpuid(regs, 1);
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    if (maxLeaf >= 7 && osxsave && avx) {
+        const unsigned long long xcr0 = _xgetbv(0);
+        const bool ymmState = (xcr0 & 0x6) == 0x6;
+        const bool zmmState = (xcr0 & 0xe6) == 0xe6;
+        __cpuidex(regs, 7, 0);
+        f.avx2 = ymmState && (regs[1] & (1 << 5)) != 0;
+        f.avx512f = zmmState && (regs[1] & (1 << 16)) != 0;
+    }
+#endif
+    return f;
+}
+
+// Best first.
+std::vector<const Kernels *> runnableKernels() {
+    const CpuFeatures cpu = detectCpu();
+    std::vector<const Kernels *> out;
+    if (cpu.avx512f && avx512Kernels()) out.push_back(avx512Kernels());
+    if (cpu.avx2 && avx2Kernels()) out.push_back(avx2Kernels());
+    if (sse2Kernels()) out.push_back(sse2Kernels());
+    if (neonKernels()) out.push_back(neonKernels());
+    out.push_back(&scalarKernels());
+    return out;
+}
+
+const Kernels *selectKernels() {
+    const auto runnable = runnableKernels();
+    if (const char *forced = std::getenv("KEEGAN_SIMD")) {
+        // Cap at the requested ISA: take the first runnable set at or below it.
+        bool reached = false;
+        for (const Kernels *k : runnable) {
+            reached = reached || std::strcmp(forced, isaName(k->isa)) == 0;
+            if (reached) return k;
+        }
+    }
+    return runnable.front();
+}
+
+// Resolved before main so the audio thread never hits a guarded static.
+const Kernels *g_active = selectKernels();
+
+bool near(float got, float want, float tol) {
+    return std::fabs(got - want) <= tol * (1.0f + std::fabs(want));
+}
+} // namespace
+
+const char *isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::Sse2: return "sse2";
+        case Isa::Avx2: return "avx2";
+        case Isa::Avx512: return "avx512";
+        case Isa::Neon: return "neon";
+    }
+    return "unknown";
+}
+
+const Kernels &kernels() { return *g_active; }
+
+std::vector<const Kernels *> availableKernels() { return runnableKernels(); }
+
+bool verifyAgainstScalar(const Kernels &k, std::string *failure) {
+    const Kernels &ref = scalarKernels();
+    auto fail = [&](const char *what, size_t n, size_t offset) {
+        if (failure) {
+            *failure = std::string(isaName(k.isa)) + " " + what + " mismatch (n=" +
+                       std::to_string(n) + ", offset=" + std::to_string(offset) + ")";
+        }
+        return false;
+    };
+
+    constexpr size_t kSizes[] = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 255, 1031};
+    constexpr float kTol = 1e-5f;
+    uint32_t seed = 12345u;
+    auto random = [&]() {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<float>(seed >> 8) / 8388608.0f - 1.0f; // [-1, 1)
+    };
+
+    for (size_t n : kSizes) {
+        for (size_t offset = 0; offset < 4; ++offset) {
+            // Slack on both sides so misaligned starts stay in bounds.
+            std::vector<float> a(n + 8), b(n + 8), d0(n + 8), d1(n + 8);
+            std::vector<float> i0(2 * n + 8), i1(2 * n + 8);
+            std::vector<int16_t> s16(n + 8);
+            std::vector<uint8_t> s24(3 * (n + 8));
+            for (size_t i = 0; i < a.size(); ++i) {
+                a[i] = 2.0f * random();
+                b[i] = 2.0f * random();
+                d0[i] = d1[i] = random();
+                s16[i] = static_cast<int16_t>(random() * 32767.0f);
+                const int32_t v24 = static_cast<int32_t>(random() * 8388607.0f);
+                for (size_t byte = 0; byte < 3; ++byte) s24[3 * i + byte] = static_cast<uint8_t>(v24 >> (8 * byte));
+            }
+            const float *pa = a.data() + offset;
+            const float *pb = b.data() + offset;
+            float *p0 = d0.data() + offset;
+            float *p1 = d1.data() + offset;
+            auto same = [&](const float *x, const float *y, size_t count) {
+                for (size_t i = 0; i < count; ++i) {
+                    if (!near(x[i], y[i], kTol)) return false;
+                }
+                return true;
+            };
+
+            ref.mixAdd(p0, pa, 0.7f, n);
+            k.mixAdd(p1, pa, 0.7f, n);
+            if (!same(p1, p0, n) || d0[offset + n] != d1[offset + n]) return fail("mixAdd", n, offset);
+
+            ref.scaledCopy(p0, pb, -0.3f, n);
+            k.scaledCopy(p1, pb, -0.3f, n);
+            if (!same(p1, p0, n)) return fail("scaledCopy", n, offset);
+
+            ref.crossfade(p0, pa, pb, 0.8f, 0.6f, n);
+            k.crossfade(p1, pa, pb, 0.8f, 0.6f, n);
+            if (!same(p1, p0, n)) return fail("crossfade", n, offset);
+
+            ref.interleave2(i0.data() + offset, pa, pb, n);
+            k.interleave2(i1.data() + offset, pa, pb, n);
+            if (!same(i1.data() + offset, i0.data() + offset, 2 * n)) return fail("interleave2", n, offset);
+
+            if (!near(k.sumSquares(pa, n), ref.sumSquares(pa, n), 1e-4f)) return fail("sumSquares", n, offset);
+            // Signed terms can cancel, so compare against the magnitude sum.
+            if (std::fabs(k.dot(pa, pb, n) - ref.dot(pa, pb, n)) > 1e-4f * (1.0f + 4.0f * static_cast<float>(n))) {
+                return fail("dot", n, offset);
+            }
+            if (k.peak(pa, n) != ref.peak(pa, n)) return fail("peak", n, offset);
+
+            ref.mixAddI16(p0, s16.data() + offset, 1.0f / 32768.0f, n);
+            k.mixAddI16(p1, s16.data() + offset, 1.0f / 32768.0f, n);
+            if (!same(p1, p0, n) || d0[offset + n] != d1[offset + n]) return fail("mixAddI16", n, offset);
+
+            ref.mixAddI24(p0, s24.data() + 3 * offset, 1.0f / 8388608.0f, n);
+            k.mixAddI24(p1, s24.data() + 3 * offset, 1.0f / 8388608.0f, n);
+            if (!same(p1, p0, n) || d0[offset + n] != d1[offset + n]) return fail("mixAddI24", n, offset);
+
+            // Phasors at unrelated frequencies; both sides start identical.
+            SinePairState osc0{};
+            for (size_t l = 0; l < 8; ++l) {
+                const float delta = 0.01f + 0.05f * static_cast<float>(l / 4) + 0.001f * random();
+                const float phase = 3.0f * random() + delta * static_cast<float>(l % 4);
+                osc0.re[l] = std::cos(phase);
+                osc0.im[l] = std::sin(phase);
+                osc0.rotRe[l] = std::cos(4.0f * delta);
+                osc0.rotIm[l] = std::sin(4.0f * delta);
+                osc0.stepRe[l] = std::cos(delta * static_cast<float>(l % 4));
+                osc0.stepIm[l] = std::sin(delta * static_cast<float>(l % 4));
+            }
+            SinePairState osc1 = osc0;
+            std::copy(b.begin(), b.end(), i0.begin());
+            std::copy(b.begin(), b.end(), i1.begin());
+            ref.sinePair(osc0, p0, i0.data() + offset, 0.5f, n);
+            k.sinePair(osc1, p1, i1.data() + offset, 0.5f, n);
+            if (!same(p1, p0, n) || !same(i1.data() + offset, i0.data() + offset, n) ||
+                !same(osc1.re, osc0.re, 8) || !same(osc1.im, osc0.im, 8)) {
+                return fail("sinePair", n, offset);
+            }
+
+            // A small network (64-slot ring) with fractional reads, so the
+            // lines wrap and feed back within the longer runs.
+            std::vector<float> ring0(64 * kFdnLines), ring1;
+            for (float &s : ring0) s = 0.5f * random();
+            ring1 = ring0;
+            FdnState net0{};
+            net0.ring = ring0.data();
+            net0.mask = 63;
+            net0.write = 5;
+            for (size_t l = 0; l < kFdnLines; ++l) {
+                net0.delay[l] = static_cast<uint32_t>(7 + 5 * l);
+                net0.frac[l] = 0.5f + 0.5f * random();
+                net0.gain[l] = 0.3f;
+                net0.damp[l] = 0.25f + 0.2f * random();
+                net0.lp[l] = 0.1f * random();
+                net0.inGain[l] = random();
+                net0.outL[l] = random();
+                net0.outR[l] = random();
+            }
+            FdnState net1 = net0;
+            net1.ring = ring1.data();
+            ref.fdn(net0, pa, p0, i0.data() + offset, n);
+            k.fdn(net1, pa, p1, i1.data() + offset, n);
+            if (!same(p1, p0, n) || !same(i1.data() + offset, i0.data() + offset, n) ||
+                !same(ring1.data(), ring0.data(), ring0.size()) || !same(net1.lp, net0.lp, kFdnLines) ||
+                net1.write != net0.write) {
+                return fail("fdn", n, offset);
+            }
+
+            // Accumulators start from b (real) and d (imaginary).
+            std::copy(b.begin(), b.end(), i0.begin());
+            std::copy(b.begin(), b.end(), i1.begin());
+            std::copy(d0.begin(), d0.end(), d1.begin());
+            ref.complexMulAdd(i0.data() + offset, p0, pa, pb, pb + 1, pa + 1, n);
+            k.complexMulAdd(i1.data() + offset, p1, pa, pb, pb + 1, pa + 1, n);
+            if (!same(i1.data() + offset, i0.data() + offset, n) || !same(p1, p0, n) ||
+                d0[offset + n] != d1[offset + n]) {
+                return fail("complexMulAdd", n, offset);
+            }
+
+            // Lowpass-like sections with random ramps that stay inside the
+            // stability triangle; left is a, right is b. Then a mono pass
+            // with both pointers on the same buffer.
+            BiquadState bq0{};
+            for (size_t l = 0; l < kBiquadLanes; ++l) {
+                bq0.b0[l] = 0.2f + 0.1f * random();
+                bq0.b1[l] = 0.4f + 0.1f * random();
+                bq0.b2[l] = 0.2f + 0.1f * random();
+                bq0.a1[l] = -0.9f + 0.2f * random();
+                bq0.a2[l] = 0.3f + 0.1f * random();
+                bq0.db0[l] = 1e-4f * random();
+                bq0.db1[l] = 1e-4f * random();
+                bq0.db2[l] = 1e-4f * random();
+                bq0.da1[l] = 1e-4f * random();
+                bq0.da2[l] = 1e-4f * random();
+                bq0.z1[l] = 0.1f * random();
+                bq0.z2[l] = 0.1f * random();
+            }
+            for (bool mono : {false, true}) {
+                std::copy(a.begin(), a.end(), d0.begin());
+                std::copy(a.begin(), a.end(), d1.begin());
+                std::copy(b.begin(), b.end(), i0.begin());
+                std::copy(b.begin(), b.end(), i1.begin());
+                BiquadState bq1 = bq0, bq2 = bq0;
+                ref.biquad2x2(bq1, p0, mono ? p0 : i0.data() + offset, n);
+                k.biquad2x2(bq2, p1, mono ? p1 : i1.data() + offset, n);
+                if (!same(p1, p0, n) || !same(i1.data() + offset, i0.data() + offset, n) ||
+                    d0[offset + n] != d1[offset + n] || !same(bq2.z1, bq1.z1, kBiquadLanes) ||
+                    !same(bq2.z2, bq1.z2, kBiquadLanes) || !same(bq2.a1, bq1.a1, kBiquadLanes)) {
+                    return fail("biquad2x2", n, offset);
+                }
+            }
+
+            std::copy(a.begin(), a.end(), d0.begin());
+            std::copy(a.begin(), a.end(), d1.begin());
+            ref.clamp(p0, -0.5f, 0.9f, n);
+            k.clamp(p1, -0.5f, 0.9f, n);
+            if (!same(p1, p0, n) || d0[offset + n] != d1[offset + n]) return fail("clamp", n, offset);
+        }
+    }
+    return true;
+}
+
+} // namespace audio::simd
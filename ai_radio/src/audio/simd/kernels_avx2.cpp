@@ -0,0 +1,275 @@
+#include "simd.h"
+
+// Built with -mavx2 on GCC/Clang (see CMakeLists.txt); MSVC exposes the
+// intrinsics on x64 without an /arch switch. Only reached after the
+// dispatcher has confirmed AVX2 support.
+#if defined(__AVX2__) || (defined(_MSC_VER) && defined(_M_X64))
+#define KEEGAN_HAVE_AVX2 1
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#endif
+
+namespace audio::simd {
+
+#if KEEGAN_HAVE_AVX2
+namespace {
+inline float hsum(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+inline float hmax(__m256 v) {
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+    return _mm_cvtss_f32(m);
+}
+
+void mixAdd(float *dst, const float *src, float gain, size_t n) {
+    const __m256 g = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i),
+                                                _mm256_mul_ps(_mm256_loadu_ps(src + i), g)));
+    }
+    for (; i < n; ++i) dst[i] += src[i] * gain;
+}
+
+void scaledCopy(float *dst, const float *src, float gain, size_t n) {
+    const __m256 g = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), g));
+    for (; i < n; ++i) dst[i] = src[i] * gain;
+}
+
+void crossfade(float *dst, const float *a, const float *b, float gainA, float gainB, size_t n) {
+    const __m256 ga = _mm256_set1_ps(gainA);
+    const __m256 gb = _mm256_set1_ps(gainB);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(a + i), ga),
+                                                _mm256_mul_ps(_mm256_loadu_ps(b + i), gb)));
+    }
+    for (; i < n; ++i) dst[i] = a[i] * gainA + b[i] * gainB;
+}
+
+void interleave2(float *out, const float *left, const float *right, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 l = _mm256_loadu_ps(left + i);
+        const __m256 r = _mm256_loadu_ps(right + i);
+        // unpack works per 128-bit lane: lo = l0 r0 l1 r1 | l4 r4 l5 r5,
+        // hi = l2 r2 l3 r3 | l6 r6 l7 r7. Recombine the lanes in order.
+        const __m256 lo = _mm256_unpacklo_ps(l, r);
+        const __m256 hi = _mm256_unpackhi_ps(l, r);
+        _mm256_storeu_ps(out + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(out + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    for (; i < n; ++i) {
+        out[2 * i] = left[i];
+        out[2 * i + 1] = right[i];
+    }
+}
+
+float sumSquares(const float *src, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256 a = _mm256_loadu_ps(src + i);
+        const __m256 b = _mm256_loadu_ps(src + i + 8);
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(a, a));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(b, b));
+    }
+    float sum = hsum(_mm256_add_ps(acc0, acc1));
+    for (; i < n; ++i) sum += src[i] * src[i];
+    return sum;
+}
+
+float peak(const float *src, size_t n) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) acc = _mm256_max_ps(acc, _mm256_and_ps(_mm256_loadu_ps(src + i), absMask));
+    float p = hmax(acc);
+    for (; i < n; ++i) p = std::max(p, std::fabs(src[i]));
+    return p;
+}
+
+void clamp(float *buf, float lo, float hi, size_t n) {
+    const __m256 vlo = _mm256_set1_ps(lo);
+    const __m256 vhi = _mm256_set1_ps(hi);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(buf + i, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(buf + i), vlo), vhi));
+    }
+    for (; i < n; ++i) buf[i] = std::min(std::max(buf[i], lo), hi);
+}
+
+void mixAddI16(float *dst, const int16_t *src, float gain, size_t n) {
+    const __m256 g = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_cvtepi32_ps(v), g)));
+    }
+    for (; i < n; ++i) dst[i] += static_cast<float>(src[i]) * gain;
+}
+
+void mixAddI24(float *dst, const uint8_t *src, float gain, size_t n) {
+    // 8 samples are 24 bytes. Move bytes 12..23 into the upper lane, then
+    // place each sample in the top three bytes of its 32-bit lane (byte 0
+    // zeroed) and shift arithmetically to sign-extend.
+    const __m256i spread = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+    const __m256i place = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                                           -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m256 g = _mm256_set1_ps(gain);
+    size_t i = 0;
+    // Each load reads 32 bytes, 8 past the samples it converts.
+    for (; 3 * i + 32 <= 3 * n; i += 8) {
+        const __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 3 * i));
+        const __m256i v = _mm256_srai_epi32(_mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(raw, spread), place), 8);
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_cvtepi32_ps(v), g)));
+    }
+    for (; i < n; ++i) dst[i] += static_cast<float>(loadI24(src + 3 * i)) * gain;
+}
+
+float dot(const float *a, const float *b, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+    float sum = hsum(_mm256_add_ps(acc0, acc1));
+    for (; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+void sinePair(SinePairState &osc, float *left, float *right, float gain, size_t n) {
+    // One register holds both oscillators: lanes 0-3 left, 4-7 right.
+    const __m128 g = _mm_set1_ps(gain);
+    __m256 re = _mm256_loadu_ps(osc.re), im = _mm256_loadu_ps(osc.im);
+    const __m256 cr = _mm256_loadu_ps(osc.rotRe), ci = _mm256_loadu_ps(osc.rotIm);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(left + i, _mm_add_ps(_mm_loadu_ps(left + i), _mm_mul_ps(_mm256_castps256_ps128(im), g)));
+        _mm_storeu_ps(right + i, _mm_add_ps(_mm_loadu_ps(right + i), _mm_mul_ps(_mm256_extractf128_ps(im, 1), g)));
+        const __m256 next = _mm256_sub_ps(_mm256_mul_ps(re, cr), _mm256_mul_ps(im, ci));
+        im = _mm256_add_ps(_mm256_mul_ps(re, ci), _mm256_mul_ps(im, cr));
+        re = next;
+    }
+    _mm256_storeu_ps(osc.re, re);
+    _mm256_storeu_ps(osc.im, im);
+    sinePairTail(osc, left + i, right + i, gain, n - i);
+}
+
+void fdn(FdnState &fdn, const float *in, float *left, float *right, size_t n) {
+    constexpr size_t L = kFdnLines;
+    // One register holds all eight lines; the reads are hardware gathers.
+    const __m256 frac = _mm256_loadu_ps(fdn.frac);
+    const __m256 damp = _mm256_loadu_ps(fdn.damp);
+    const __m256 gain = _mm256_loadu_ps(fdn.gain);
+    const __m256 inG = _mm256_loadu_ps(fdn.inGain);
+    const __m256 oL = _mm256_loadu_ps(fdn.outL), oR = _mm256_loadu_ps(fdn.outR);
+    const __m256 sign4 = _mm256_setr_ps(1.0f, 1.0f, 1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f);
+    const __m256 sign2 = _mm256_setr_ps(1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f);
+    const __m256 sign1 = _mm256_setr_ps(1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>(fdn.mask));
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i delay = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(fdn.delay));
+    __m256 lp = _mm256_loadu_ps(fdn.lp);
+    uint32_t w = fdn.write;
+    for (size_t i = 0; i < n; ++i) {
+        const __m256i pos = _mm256_sub_epi32(_mm256_set1_epi32(static_cast<int>(w)), delay);
+        const __m256i ia = _mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256(pos, mask), 3), lanes);
+        const __m256i ib = _mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256(_mm256_sub_epi32(pos, one), mask), 3), lanes);
+        const __m256 a = _mm256_i32gather_ps(fdn.ring, ia, 4);
+        const __m256 y = _mm256_add_ps(a, _mm256_mul_ps(frac, _mm256_sub_ps(_mm256_i32gather_ps(fdn.ring, ib, 4), a)));
+        lp = _mm256_add_ps(y, _mm256_mul_ps(damp, _mm256_sub_ps(lp, y)));
+        left[i] = hsum(_mm256_mul_ps(lp, oL));
+        right[i] = hsum(_mm256_mul_ps(lp, oR));
+
+        __m256 x = _mm256_mul_ps(lp, gain);
+        x = _mm256_add_ps(_mm256_permute2f128_ps(x, x, 1), _mm256_mul_ps(x, sign4));
+        x = _mm256_add_ps(_mm256_shuffle_ps(x, x, _MM_SHUFFLE(1, 0, 3, 2)), _mm256_mul_ps(x, sign2));
+        x = _mm256_add_ps(_mm256_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1)), _mm256_mul_ps(x, sign1));
+        _mm256_storeu_ps(fdn.ring + static_cast<size_t>(w) * L, _mm256_add_ps(x, _mm256_mul_ps(_mm256_set1_ps(in[i]), inG)));
+        w = (w + 1) & fdn.mask;
+    }
+    _mm256_storeu_ps(fdn.lp, lp);
+    fdn.write = w;
+}
+
+void complexMulAdd(float *accRe, float *accIm, const float *aRe, const float *aIm, const float *bRe,
+                   const float *bIm, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 ar = _mm256_loadu_ps(aRe + i), ai = _mm256_loadu_ps(aIm + i);
+        const __m256 br = _mm256_loadu_ps(bRe + i), bi = _mm256_loadu_ps(bIm + i);
+        _mm256_storeu_ps(accRe + i, _mm256_add_ps(_mm256_loadu_ps(accRe + i),
+                                                  _mm256_sub_ps(_mm256_mul_ps(ar, br), _mm256_mul_ps(ai, bi))));
+        _mm256_storeu_ps(accIm + i, _mm256_add_ps(_mm256_loadu_ps(accIm + i),
+                                                  _mm256_add_ps(_mm256_mul_ps(ar, bi), _mm256_mul_ps(ai, br))));
+    }
+    for (; i < n; ++i) {
+        accRe[i] += aRe[i] * bRe[i] - aIm[i] * bIm[i];
+        accIm[i] += aRe[i] * bIm[i] + aIm[i] * bRe[i];
+    }
+}
+
+void biquad2x2(BiquadState &bq, float *left, float *right, size_t n) {
+    if (n == 0) return;
+    // Four lanes fill an SSE register; a wider one would only add idle lanes
+    // to a loop bound by the recurrence latency.
+    // Section 0 takes sample i while section 1 takes its output for i - 1:
+    // lanes 2 and 3 of the input are lanes 0 and 1 of the last output.
+    __m128 y = _mm_setr_ps(biquadStep(bq, 0, left[0]), biquadStep(bq, 1, right[0]), 0.0f, 0.0f);
+    __m128 b0 = _mm_loadu_ps(bq.b0), b1 = _mm_loadu_ps(bq.b1), b2 = _mm_loadu_ps(bq.b2);
+    __m128 a1 = _mm_loadu_ps(bq.a1), a2 = _mm_loadu_ps(bq.a2);
+    const __m128 db0 = _mm_loadu_ps(bq.db0), db1 = _mm_loadu_ps(bq.db1), db2 = _mm_loadu_ps(bq.db2);
+    const __m128 da1 = _mm_loadu_ps(bq.da1), da2 = _mm_loadu_ps(bq.da2);
+    __m128 z1 = _mm_loadu_ps(bq.z1), z2 = _mm_loadu_ps(bq.z2);
+    for (size_t i = 1; i < n; ++i) {
+        const __m128 in = _mm_unpacklo_ps(_mm_load_ss(left + i), _mm_load_ss(right + i));
+        const __m128 x = _mm_shuffle_ps(in, y, _MM_SHUFFLE(1, 0, 1, 0));
+        y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        b0 = _mm_add_ps(b0, db0);
+        b1 = _mm_add_ps(b1, db1);
+        b2 = _mm_add_ps(b2, db2);
+        a1 = _mm_add_ps(a1, da1);
+        a2 = _mm_add_ps(a2, da2);
+        _mm_store_ss(left + i - 1, _mm_movehl_ps(y, y));
+        _mm_store_ss(right + i - 1, _mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+    _mm_storeu_ps(bq.b0, b0);
+    _mm_storeu_ps(bq.b1, b1);
+    _mm_storeu_ps(bq.b2, b2);
+    _mm_storeu_ps(bq.a1, a1);
+    _mm_storeu_ps(bq.a2, a2);
+    _mm_storeu_ps(bq.z1, z1);
+    _mm_storeu_ps(bq.z2, z2);
+    alignas(16) float mid[4];
+    _mm_store_ps(mid, y);
+    left[n - 1] = biquadStep(bq, 2, mid[0]);
+    right[n - 1] = biquadStep(bq, 3, mid[1]);
+}
+
+const Kernels kAvx2 = {Isa::Avx2, mixAdd, scaledCopy, crossfade, interleave2, sumSquares, peak, clamp,
+                       mixAddI16, mixAddI24, dot, sinePair, fdn,
+                       complexMulAdd, biquad2x2};
+} // namespace
+
+const Kernels *avx2Kernels() { return &kAvx2; }
+#else
+const Kernels *avx2Kernels() { return nullptr; }
+#endif
+
+} // namespace audio::simd
@@ -0,0 +1,262 @@
+#include "simd.h"
+
+// AArch64 only: NEON is part of the baseline there, so no runtime check.
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define KEEGAN_HAVE_NEON 1
+#include <arm_neon.h>
+#include <algorithm>
+#include <cmath>
+#endif
+
+namespace audio::simd {
+
+#if KEEGAN_HAVE_NEON
+namespace {
+void mixAdd(float *dst, const float *src, float gain, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) vst1q_f32(dst + i, vmlaq_n_f32(vld1q_f32(dst + i), vld1q_f32(src + i), gain));
+    for (; i < n; ++i) dst[i] += src[i] * gain;
+}
+
+void scaledCopy(float *dst, const float *src, float gain, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) vst1q_f32(dst + i, vmulq_n_f32(vld1q_f32(src + i), gain));
+    for (; i < n; ++i) dst[i] = src[i] * gain;
+}
+
+void crossfade(float *dst, const float *a, const float *b, float gainA, float gainB, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(dst + i, vmlaq_n_f32(vmulq_n_f32(vld1q_f32(a + i), gainA), vld1q_f32(b + i), gainB));
+    }
+    for (; i < n; ++i) dst[i] = a[i] * gainA + b[i] * gainB;
+}
+
+void interleave2(float *out, const float *left, const float *right, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4x2_t lr;
+        lr.val[0] = vld1q_f32(left + i);
+        lr.val[1] = vld1q_f32(right + i);
+        vst2q_f32(out + 2 * i, lr);
+    }
+    for (; i < n; ++i) {
+        out[2 * i] = left[i];
+        out[2 * i + 1] = right[i];
+    }
+}
+
+float sumSquares(const float *src, size_t n) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const float32x4_t a = vld1q_f32(src + i);
+        const float32x4_t b = vld1q_f32(src + i + 4);
+        acc0 = vmlaq_f32(acc0, a, a);
+        acc1 = vmlaq_f32(acc1, b, b);
+    }
+    float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; i < n; ++i) sum += src[i] * src[i];
+    return sum;
+}
+
+float peak(const float *src, size_t n) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) acc = vmaxq_f32(acc, vabsq_f32(vld1q_f32(src + i)));
+    float p = vmaxvq_f32(acc);
+    for (; i < n; ++i) p = std::max(p, std::fabs(src[i]));
+    return p;
+}
+
+void clamp(float *buf, float lo, float hi, size_t n) {
+    const float32x4_t vlo = vdupq_n_f32(lo);
+    const float32x4_t vhi = vdupq_n_f32(hi);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) vst1q_f32(buf + i, vminq_f32(vmaxq_f32(vld1q_f32(buf + i), vlo), vhi));
+    for (; i < n; ++i) buf[i] = std::min(std::max(buf[i], lo), hi);
+}
+
+void mixAddI16(float *dst, const int16_t *src, float gain, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const int16x8_t v = vld1q_s16(src + i);
+        const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(dst + i, vmlaq_n_f32(vld1q_f32(dst + i), lo, gain));
+        vst1q_f32(dst + i + 4, vmlaq_n_f32(vld1q_f32(dst + i + 4), hi, gain));
+    }
+    for (; i < n; ++i) dst[i] += static_cast<float>(src[i]) * gain;
+}
+
+// Bytes b0 b1 b2 -> (b2 << 24 | b1 << 16 | b0 << 8) >> 8, four lanes.
+inline float32x4_t widenI24(uint16x4_t b0, uint16x4_t b1, uint16x4_t b2) {
+    const uint32x4_t w = vorrq_u32(vshlq_n_u32(vmovl_u16(b2), 24),
+                                   vorrq_u32(vshlq_n_u32(vmovl_u16(b1), 16), vshlq_n_u32(vmovl_u16(b0), 8)));
+    return vcvtq_f32_s32(vshrq_n_s32(vreinterpretq_s32_u32(w), 8));
+}
+
+void mixAddI24(float *dst, const uint8_t *src, float gain, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // De-interleaving load: val[k] holds byte k of eight samples.
+        const uint8x8x3_t v = vld3_u8(src + 3 * i);
+        const uint16x8_t b0 = vmovl_u8(v.val[0]);
+        const uint16x8_t b1 = vmovl_u8(v.val[1]);
+        const uint16x8_t b2 = vmovl_u8(v.val[2]);
+        const float32x4_t lo = widenI24(vget_low_u16(b0), vget_low_u16(b1), vget_low_u16(b2));
+        const float32x4_t hi = widenI24(vget_high_u16(b0), vget_high_u16(b1), vget_high_u16(b2));
+        vst1q_f32(dst + i, vmlaq_n_f32(vld1q_f32(dst + i), lo, gain));
+        vst1q_f32(dst + i + 4, vmlaq_n_f32(vld1q_f32(dst + i + 4), hi, gain));
+    }
+    for (; i < n; ++i) dst[i] += static_cast<float>(loadI24(src + 3 * i)) * gain;
+}
+
+float dot(const float *a, const float *b, size_t n) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+void sinePair(SinePairState &osc, float *left, float *right, float gain, size_t n) {
+    float32x4_t reL = vld1q_f32(osc.re), imL = vld1q_f32(osc.im);
+    float32x4_t reR = vld1q_f32(osc.re + 4), imR = vld1q_f32(osc.im + 4);
+    const float32x4_t crL = vld1q_f32(osc.rotRe), ciL = vld1q_f32(osc.rotIm);
+    const float32x4_t crR = vld1q_f32(osc.rotRe + 4), ciR = vld1q_f32(osc.rotIm + 4);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(left + i, vmlaq_n_f32(vld1q_f32(left + i), imL, gain));
+        vst1q_f32(right + i, vmlaq_n_f32(vld1q_f32(right + i), imR, gain));
+        const float32x4_t nL = vsubq_f32(vmulq_f32(reL, crL), vmulq_f32(imL, ciL));
+        imL = vaddq_f32(vmulq_f32(reL, ciL), vmulq_f32(imL, crL));
+        reL = nL;
+        const float32x4_t nR = vsubq_f32(vmulq_f32(reR, crR), vmulq_f32(imR, ciR));
+        imR = vaddq_f32(vmulq_f32(reR, ciR), vmulq_f32(imR, crR));
+        reR = nR;
+    }
+    vst1q_f32(osc.re, reL);
+    vst1q_f32(osc.im, imL);
+    vst1q_f32(osc.re + 4, reR);
+    vst1q_f32(osc.im + 4, imR);
+    sinePairTail(osc, left + i, right + i, gain, n - i);
+}
+
+void fdn(FdnState &fdn, const float *in, float *left, float *right, size_t n) {
+    constexpr size_t L = kFdnLines;
+    // Lines 0-3 in the first register of each pair, 4-7 in the second.
+    const float32x4_t frac0 = vld1q_f32(fdn.frac), frac1 = vld1q_f32(fdn.frac + 4);
+    const float32x4_t damp0 = vld1q_f32(fdn.damp), damp1 = vld1q_f32(fdn.damp + 4);
+    const float32x4_t gain0 = vld1q_f32(fdn.gain), gain1 = vld1q_f32(fdn.gain + 4);
+    const float32x4_t inG0 = vld1q_f32(fdn.inGain), inG1 = vld1q_f32(fdn.inGain + 4);
+    const float32x4_t oL0 = vld1q_f32(fdn.outL), oL1 = vld1q_f32(fdn.outL + 4);
+    const float32x4_t oR0 = vld1q_f32(fdn.outR), oR1 = vld1q_f32(fdn.outR + 4);
+    const float sign2Values[4] = {1.0f, 1.0f, -1.0f, -1.0f};
+    const float sign1Values[4] = {1.0f, -1.0f, 1.0f, -1.0f};
+    const float32x4_t sign2 = vld1q_f32(sign2Values), sign1 = vld1q_f32(sign1Values);
+    float32x4_t lp0 = vld1q_f32(fdn.lp), lp1 = vld1q_f32(fdn.lp + 4);
+    const uint32_t mask = fdn.mask;
+    uint32_t w = fdn.write;
+    float a[L], b[L];
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < L; ++j) {
+            a[j] = fdn.ring[((w - fdn.delay[j]) & mask) * L + j];
+            b[j] = fdn.ring[((w - fdn.delay[j] - 1) & mask) * L + j];
+        }
+        const float32x4_t a0 = vld1q_f32(a), a1 = vld1q_f32(a + 4);
+        const float32x4_t y0 = vaddq_f32(a0, vmulq_f32(frac0, vsubq_f32(vld1q_f32(b), a0)));
+        const float32x4_t y1 = vaddq_f32(a1, vmulq_f32(frac1, vsubq_f32(vld1q_f32(b + 4), a1)));
+        lp0 = vaddq_f32(y0, vmulq_f32(damp0, vsubq_f32(lp0, y0)));
+        lp1 = vaddq_f32(y1, vmulq_f32(damp1, vsubq_f32(lp1, y1)));
+        left[i] = vaddvq_f32(vaddq_f32(vmulq_f32(lp0, oL0), vmulq_f32(lp1, oL1)));
+        right[i] = vaddvq_f32(vaddq_f32(vmulq_f32(lp0, oR0), vmulq_f32(lp1, oR1)));
+
+        float32x4_t x0 = vmulq_f32(lp0, gain0), x1 = vmulq_f32(lp1, gain1);
+        const float32x4_t t0 = vaddq_f32(x1, x0);
+        x1 = vsubq_f32(x0, x1);
+        x0 = t0;
+        x0 = vaddq_f32(vextq_f32(x0, x0, 2), vmulq_f32(x0, sign2));
+        x1 = vaddq_f32(vextq_f32(x1, x1, 2), vmulq_f32(x1, sign2));
+        x0 = vaddq_f32(vrev64q_f32(x0), vmulq_f32(x0, sign1));
+        x1 = vaddq_f32(vrev64q_f32(x1), vmulq_f32(x1, sign1));
+
+        float *slot = fdn.ring + static_cast<size_t>(w) * L;
+        vst1q_f32(slot, vaddq_f32(x0, vmulq_n_f32(inG0, in[i])));
+        vst1q_f32(slot + 4, vaddq_f32(x1, vmulq_n_f32(inG1, in[i])));
+        w = (w + 1) & mask;
+    }
+    vst1q_f32(fdn.lp, lp0);
+    vst1q_f32(fdn.lp + 4, lp1);
+    fdn.write = w;
+}
+
+void complexMulAdd(float *accRe, float *accIm, const float *aRe, const float *aIm, const float *bRe,
+                   const float *bIm, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t ar = vld1q_f32(aRe + i), ai = vld1q_f32(aIm + i);
+        const float32x4_t br = vld1q_f32(bRe + i), bi = vld1q_f32(bIm + i);
+        vst1q_f32(accRe + i, vaddq_f32(vld1q_f32(accRe + i), vsubq_f32(vmulq_f32(ar, br), vmulq_f32(ai, bi))));
+        vst1q_f32(accIm + i, vaddq_f32(vld1q_f32(accIm + i), vaddq_f32(vmulq_f32(ar, bi), vmulq_f32(ai, br))));
+    }
+    for (; i < n; ++i) {
+        accRe[i] += aRe[i] * bRe[i] - aIm[i] * bIm[i];
+        accIm[i] += aRe[i] * bIm[i] + aIm[i] * bRe[i];
+    }
+}
+
+void biquad2x2(BiquadState &bq, float *left, float *right, size_t n) {
+    if (n == 0) return;
+    // Section 0 takes sample i while section 1 takes its output for i - 1:
+    // lanes 2 and 3 of the input are lanes 0 and 1 of the last output.
+    const float first[4] = {biquadStep(bq, 0, left[0]), biquadStep(bq, 1, right[0]), 0.0f, 0.0f};
+    float32x4_t y = vld1q_f32(first);
+    float32x4_t b0 = vld1q_f32(bq.b0), b1 = vld1q_f32(bq.b1), b2 = vld1q_f32(bq.b2);
+    float32x4_t a1 = vld1q_f32(bq.a1), a2 = vld1q_f32(bq.a2);
+    const float32x4_t db0 = vld1q_f32(bq.db0), db1 = vld1q_f32(bq.db1), db2 = vld1q_f32(bq.db2);
+    const float32x4_t da1 = vld1q_f32(bq.da1), da2 = vld1q_f32(bq.da2);
+    float32x4_t z1 = vld1q_f32(bq.z1), z2 = vld1q_f32(bq.z2);
+    for (size_t i = 1; i < n; ++i) {
+        const float32x2_t in = vset_lane_f32(right[i], vdup_n_f32(left[i]), 1);
+        const float32x4_t x = vcombine_f32(in, vget_low_f32(y));
+        // Separate multiplies and adds, not vfmaq, to match the scalar bits.
+        y = vaddq_f32(vmulq_f32(b0, x), z1);
+        z1 = vaddq_f32(vsubq_f32(vmulq_f32(b1, x), vmulq_f32(a1, y)), z2);
+        z2 = vsubq_f32(vmulq_f32(b2, x), vmulq_f32(a2, y));
+        b0 = vaddq_f32(b0, db0);
+        b1 = vaddq_f32(b1, db1);
+        b2 = vaddq_f32(b2, db2);
+        a1 = vaddq_f32(a1, da1);
+        a2 = vaddq_f32(a2, da2);
+        left[i - 1] = vgetq_lane_f32(y, 2);
+        right[i - 1] = vgetq_lane_f32(y, 3);
+    }
+    vst1q_f32(bq.b0, b0);
+    vst1q_f32(bq.b1, b1);
+    vst1q_f32(bq.b2, b2);
+    vst1q_f32(bq.a1, a1);
+    vst1q_f32(bq.a2, a2);
+    vst1q_f32(bq.z1, z1);
+    vst1q_f32(bq.z2, z2);
+    left[n - 1] = biquadStep(bq, 2, vgetq_lane_f32(y, 0));
+    right[n - 1] = biquadStep(bq, 3, vgetq_lane_f32(y, 1));
+}
+
+const Kernels kNeon = {Isa::Neon, mixAdd, scaledCopy, crossfade, interleave2, sumSquares, peak, clamp,
+                       mixAddI16, mixAddI24, dot, sinePair, fdn,
+                       complexMulAdd, biquad2x2};
+} // namespace
+
+const Kernels *neonKernels() { return &kNeon; }
+#else
+const Kernels *neonKernels() { return nullptr; }
+#endif
+
+} // namespace audio::simd
@@ -0,0 +1,134 @@
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+
+namespace audio::simd {
+
+namespace {
+void mixAdd(float *dst, const float *src, float gain, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] += src[i] * gain;
+}
+
+void scaledCopy(float *dst, const float *src, float gain, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] = src[i] * gain;
+}
+
+void crossfade(float *dst, const float *a, const float *b, float gainA, float gainB, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] = a[i] * gainA + b[i] * gainB;
+}
+
+void interleave2(float *out, const float *left, const float *right, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[2 * i] = left[i];
+        out[2 * i + 1] = right[i];
+    }
+}
+
+float sumSquares(const float *src, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) sum += src[i] * src[i];
+    return sum;
+}
+
+float peak(const float *src, size_t n) {
+    float p = 0.0f;
+    for (size_t i = 0; i < n; ++i) p = std::max(p, std::fabs(src[i]));
+    return p;
+}
+
+void clamp(float *buf, float lo, float hi, size_t n) {
+    for (size_t i = 0; i < n; ++i) buf[i] = std::min(std::max(buf[i], lo), hi);
+}
+
+void mixAddI16(float *dst, const int16_t *src, float gain, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] += static_cast<float>(src[i]) * gain;
+}
+
+void mixAddI24(float *dst, const uint8_t *src, float gain, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] += static_cast<float>(loadI24(src + 3 * i)) * gain;
+}
+
+float dot(const float *a, const float *b, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+void sinePair(SinePairState &osc, float *left, float *right, float gain, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (size_t j = 0; j < 4; ++j) {
+            left[i + j] += osc.im[j] * gain;
+            right[i + j] += osc.im[4 + j] * gain;
+        }
+        for (size_t l = 0; l < 8; ++l) {
+            const float re = osc.re[l] * osc.rotRe[l] - osc.im[l] * osc.rotIm[l];
+            const float im = osc.re[l] * osc.rotIm[l] + osc.im[l] * osc.rotRe[l];
+            osc.re[l] = re;
+            osc.im[l] = im;
+        }
+    }
+    sinePairTail(osc, left + i, right + i, gain, n - i);
+}
+
+void fdn(FdnState &fdn, const float *in, float *left, float *right, size_t n) {
+    constexpr size_t L = kFdnLines;
+    for (size_t i = 0; i < n; ++i) {
+        float x[L];
+        float outL = 0.0f, outR = 0.0f;
+        for (size_t j = 0; j < L; ++j) {
+            const float a = fdn.ring[((fdn.write - fdn.delay[j]) & fdn.mask) * L + j];
+            const float b = fdn.ring[((fdn.write - fdn.delay[j] - 1) & fdn.mask) * L + j];
+            const float y = a + fdn.frac[j] * (b - a);
+            fdn.lp[j] = y + fdn.damp[j] * (fdn.lp[j] - y);
+            outL += fdn.lp[j] * fdn.outL[j];
+            outR += fdn.lp[j] * fdn.outR[j];
+            x[j] = fdn.lp[j] * fdn.gain[j];
+        }
+        left[i] = outL;
+        right[i] = outR;
+        // Butterflies at distance 4, 2, 1; written as partner + self * sign
+        // so every ISA computes the same bits.
+        for (size_t d = 4; d > 0; d >>= 1) {
+            float t[L];
+            for (size_t j = 0; j < L; ++j) t[j] = x[j ^ d] + x[j] * ((j & d) ? -1.0f : 1.0f);
+            std::copy(t, t + L, x);
+        }
+        float *slot = fdn.ring + static_cast<size_t>(fdn.write) * L;
+        for (size_t j = 0; j < L; ++j) slot[j] = x[j] + in[i] * fdn.inGain[j];
+        fdn.write = (fdn.write + 1) & fdn.mask;
+    }
+}
+
+void complexMulAdd(float *accRe, float *accIm, const float *aRe, const float *aIm, const float *bRe,
+                   const float *bIm, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        accRe[i] += aRe[i] * bRe[i] - aIm[i] * bIm[i];
+        accIm[i] += aRe[i] * bIm[i] + aIm[i] * bRe[i];
+    }
+}
+
+void biquad2x2(BiquadState &bq, float *left, float *right, size_t n) {
+    if (n == 0) return;
+    // Section 0 takes sample i while section 1 takes its output for i - 1.
+    float midL = biquadStep(bq, 0, left[0]);
+    float midR = biquadStep(bq, 1, right[0]);
+    for (size_t i = 1; i < n; ++i) {
+        const float inL = left[i], inR = right[i];
+        left[i - 1] = biquadStep(bq, 2, midL);
+        right[i - 1] = biquadStep(bq, 3, midR);
+        midL = biquadStep(bq, 0, inL);
+        midR = biquadStep(bq, 1, inR);
+    }
+    left[n - 1] = biquadStep(bq, 2, midL);
+    right[n - 1] = biquadStep(bq, 3, midR);
+}
+
+const Kernels kScalar = {Isa::Scalar, mixAdd, scaledCopy, crossfade, interleave2, sumSquares, peak, clamp,
+                         mixAddI16, mixAddI24, dot, sinePair, fdn,
+                         complexMulAdd, biquad2x2};
+} // namespace
+
+const Kernels &scalarKernels() { return kScalar; }
+
+} // namespace audio::simd
@@ -0,0 +1,278 @@
+#include "simd.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KEEGAN_HAVE_SSE2 1
+#include <emmintrin.h>
+#include <algorithm>
+#include <cmath>
+#endif
+
+namespace audio::simd {
+
+#if KEEGAN_HAVE_SSE2
+namespace {
+inline float hsum(__m128 v) {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+inline float hmax(__m128 v) {
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(v);
+}
+
+void mixAdd(float *dst, const float *src, float gain, size_t n) {
+    const __m128 g = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+    }
+    for (; i < n; ++i) dst[i] += src[i] * gain;
+}
+
+void scaledCopy(float *dst, const float *src, float gain, size_t n) {
+    const __m128 g = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), g));
+    for (; i < n; ++i) dst[i] = src[i] * gain;
+}
+
+void crossfade(float *dst, const float *a, const float *b, float gainA, float gainB, size_t n) {
+    const __m128 ga = _mm_set1_ps(gainA);
+    const __m128 gb = _mm_set1_ps(gainB);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i), ga),
+                                          _mm_mul_ps(_mm_loadu_ps(b + i), gb)));
+    }
+    for (; i < n; ++i) dst[i] = a[i] * gainA + b[i] * gainB;
+}
+
+void interleave2(float *out, const float *left, const float *right, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 l = _mm_loadu_ps(left + i);
+        const __m128 r = _mm_loadu_ps(right + i);
+        _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(l, r));
+    }
+    for (; i < n; ++i) {
+        out[2 * i] = left[i];
+        out[2 * i + 1] = right[i];
+    }
+}
+
+float sumSquares(const float *src, size_t n) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128 a = _mm_loadu_ps(src + i);
+        const __m128 b = _mm_loadu_ps(src + i + 4);
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(a, a));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(b, b));
+    }
+    float sum = hsum(_mm_add_ps(acc0, acc1));
+    for (; i < n; ++i) sum += src[i] * src[i];
+    return sum;
+}
+
+float peak(const float *src, size_t n) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) acc = _mm_max_ps(acc, _mm_and_ps(_mm_loadu_ps(src + i), absMask));
+    float p = hmax(acc);
+    for (; i < n; ++i) p = std::max(p, std::fabs(src[i]));
+    return p;
+}
+
+void clamp(float *buf, float lo, float hi, size_t n) {
+    const __m128 vlo = _mm_set1_ps(lo);
+    const __m128 vhi = _mm_set1_ps(hi);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(buf + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(buf + i), vlo), vhi));
+    }
+    for (; i < n; ++i) buf[i] = std::min(std::max(buf[i], lo), hi);
+}
+
+void mixAddI16(float *dst, const int16_t *src, float gain, size_t n) {
+    const __m128 g = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        // Unpacking a register with itself puts each sample in the high half
+        // of a 32-bit lane; the arithmetic shift sign-extends it down.
+        const __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+        const __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(lo, g)));
+        _mm_storeu_ps(dst + i + 4, _mm_add_ps(_mm_loadu_ps(dst + i + 4), _mm_mul_ps(hi, g)));
+    }
+    for (; i < n; ++i) dst[i] += static_cast<float>(src[i]) * gain;
+}
+
+void mixAddI24(float *dst, const uint8_t *src, float gain, size_t n) {
+    // No byte shuffle before SSSE3: gather the lanes in scalar, convert and
+    // scale in vector.
+    const __m128 g = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const uint8_t *p = src + 3 * i;
+        const __m128i v = _mm_set_epi32(loadI24(p + 9), loadI24(p + 6), loadI24(p + 3), loadI24(p));
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_cvtepi32_ps(v), g)));
+    }
+    for (; i < n; ++i) dst[i] += static_cast<float>(loadI24(src + 3 * i)) * gain;
+}
+
+float dot(const float *a, const float *b, size_t n) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float sum = hsum(_mm_add_ps(acc0, acc1));
+    for (; i < n; ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+void sinePair(SinePairState &osc, float *left, float *right, float gain, size_t n) {
+    const __m128 g = _mm_set1_ps(gain);
+    __m128 reL = _mm_loadu_ps(osc.re), imL = _mm_loadu_ps(osc.im);
+    __m128 reR = _mm_loadu_ps(osc.re + 4), imR = _mm_loadu_ps(osc.im + 4);
+    const __m128 crL = _mm_loadu_ps(osc.rotRe), ciL = _mm_loadu_ps(osc.rotIm);
+    const __m128 crR = _mm_loadu_ps(osc.rotRe + 4), ciR = _mm_loadu_ps(osc.rotIm + 4);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(left + i, _mm_add_ps(_mm_loadu_ps(left + i), _mm_mul_ps(imL, g)));
+        _mm_storeu_ps(right + i, _mm_add_ps(_mm_loadu_ps(right + i), _mm_mul_ps(imR, g)));
+        const __m128 nL = _mm_sub_ps(_mm_mul_ps(reL, crL), _mm_mul_ps(imL, ciL));
+        imL = _mm_add_ps(_mm_mul_ps(reL, ciL), _mm_mul_ps(imL, crL));
+        reL = nL;
+        const __m128 nR = _mm_sub_ps(_mm_mul_ps(reR, crR), _mm_mul_ps(imR, ciR));
+        imR = _mm_add_ps(_mm_mul_ps(reR, ciR), _mm_mul_ps(imR, crR));
+        reR = nR;
+    }
+    _mm_storeu_ps(osc.re, reL);
+    _mm_storeu_ps(osc.im, imL);
+    _mm_storeu_ps(osc.re + 4, reR);
+    _mm_storeu_ps(osc.im + 4, imR);
+    sinePairTail(osc, left + i, right + i, gain, n - i);
+}
+
+void fdn(FdnState &fdn, const float *in, float *left, float *right, size_t n) {
+    constexpr size_t L = kFdnLines;
+    // Lines 0-3 in the first register of each pair, 4-7 in the second.
+    const __m128 frac0 = _mm_loadu_ps(fdn.frac), frac1 = _mm_loadu_ps(fdn.frac + 4);
+    const __m128 damp0 = _mm_loadu_ps(fdn.damp), damp1 = _mm_loadu_ps(fdn.damp + 4);
+    const __m128 gain0 = _mm_loadu_ps(fdn.gain), gain1 = _mm_loadu_ps(fdn.gain + 4);
+    const __m128 inG0 = _mm_loadu_ps(fdn.inGain), inG1 = _mm_loadu_ps(fdn.inGain + 4);
+    const __m128 oL0 = _mm_loadu_ps(fdn.outL), oL1 = _mm_loadu_ps(fdn.outL + 4);
+    const __m128 oR0 = _mm_loadu_ps(fdn.outR), oR1 = _mm_loadu_ps(fdn.outR + 4);
+    const __m128 sign2 = _mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f);
+    const __m128 sign1 = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+    __m128 lp0 = _mm_loadu_ps(fdn.lp), lp1 = _mm_loadu_ps(fdn.lp + 4);
+    const uint32_t mask = fdn.mask;
+    uint32_t w = fdn.write;
+    alignas(16) float a[L], b[L];
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < L; ++j) {
+            a[j] = fdn.ring[((w - fdn.delay[j]) & mask) * L + j];
+            b[j] = fdn.ring[((w - fdn.delay[j] - 1) & mask) * L + j];
+        }
+        const __m128 a0 = _mm_load_ps(a), a1 = _mm_load_ps(a + 4);
+        const __m128 y0 = _mm_add_ps(a0, _mm_mul_ps(frac0, _mm_sub_ps(_mm_load_ps(b), a0)));
+        const __m128 y1 = _mm_add_ps(a1, _mm_mul_ps(frac1, _mm_sub_ps(_mm_load_ps(b + 4), a1)));
+        lp0 = _mm_add_ps(y0, _mm_mul_ps(damp0, _mm_sub_ps(lp0, y0)));
+        lp1 = _mm_add_ps(y1, _mm_mul_ps(damp1, _mm_sub_ps(lp1, y1)));
+        left[i] = hsum(_mm_add_ps(_mm_mul_ps(lp0, oL0), _mm_mul_ps(lp1, oL1)));
+        right[i] = hsum(_mm_add_ps(_mm_mul_ps(lp0, oR0), _mm_mul_ps(lp1, oR1)));
+
+        __m128 x0 = _mm_mul_ps(lp0, gain0), x1 = _mm_mul_ps(lp1, gain1);
+        const __m128 t0 = _mm_add_ps(x1, x0);
+        x1 = _mm_sub_ps(x0, x1);
+        x0 = t0;
+        x0 = _mm_add_ps(_mm_shuffle_ps(x0, x0, _MM_SHUFFLE(1, 0, 3, 2)), _mm_mul_ps(x0, sign2));
+        x1 = _mm_add_ps(_mm_shuffle_ps(x1, x1, _MM_SHUFFLE(1, 0, 3, 2)), _mm_mul_ps(x1, sign2));
+        x0 = _mm_add_ps(_mm_shuffle_ps(x0, x0, _MM_SHUFFLE(2, 3, 0, 1)), _mm_mul_ps(x0, sign1));
+        x1 = _mm_add_ps(_mm_shuffle_ps(x1, x1, _MM_SHUFFLE(2, 3, 0, 1)), _mm_mul_ps(x1, sign1));
+
+        const __m128 s = _mm_set1_ps(in[i]);
+        float *slot = fdn.ring + static_cast<size_t>(w) * L;
+        _mm_storeu_ps(slot, _mm_add_ps(x0, _mm_mul_ps(s, inG0)));
+        _mm_storeu_ps(slot + 4, _mm_add_ps(x1, _mm_mul_ps(s, inG1)));
+        w = (w + 1) & mask;
+    }
+    _mm_storeu_ps(fdn.lp, lp0);
+    _mm_storeu_ps(fdn.lp + 4, lp1);
+    fdn.write = w;
+}
+
+void complexMulAdd(float *accRe, float *accIm, const float *aRe, const float *aIm, const float *bRe,
+                   const float *bIm, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 ar = _mm_loadu_ps(aRe + i), ai = _mm_loadu_ps(aIm + i);
+        const __m128 br = _mm_loadu_ps(bRe + i), bi = _mm_loadu_ps(bIm + i);
+        _mm_storeu_ps(accRe + i, _mm_add_ps(_mm_loadu_ps(accRe + i), _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi))));
+        _mm_storeu_ps(accIm + i, _mm_add_ps(_mm_loadu_ps(accIm + i), _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br))));
+    }
+    for (; i < n; ++i) {
+        accRe[i] += aRe[i] * bRe[i] - aIm[i] * bIm[i];
+        accIm[i] += aRe[i] * bIm[i] + aIm[i] * bRe[i];
+    }
+}
+
+void biquad2x2(BiquadState &bq, float *left, float *right, size_t n) {
+    if (n == 0) return;
+    // Section 0 takes sample i while section 1 takes its output for i - 1:
+    // lanes 2 and 3 of the input are lanes 0 and 1 of the last output.
+    __m128 y = _mm_setr_ps(biquadStep(bq, 0, left[0]), biquadStep(bq, 1, right[0]), 0.0f, 0.0f);
+    __m128 b0 = _mm_loadu_ps(bq.b0), b1 = _mm_loadu_ps(bq.b1), b2 = _mm_loadu_ps(bq.b2);
+    __m128 a1 = _mm_loadu_ps(bq.a1), a2 = _mm_loadu_ps(bq.a2);
+    const __m128 db0 = _mm_loadu_ps(bq.db0), db1 = _mm_loadu_ps(bq.db1), db2 = _mm_loadu_ps(bq.db2);
+    const __m128 da1 = _mm_loadu_ps(bq.da1), da2 = _mm_loadu_ps(bq.da2);
+    __m128 z1 = _mm_loadu_ps(bq.z1), z2 = _mm_loadu_ps(bq.z2);
+    for (size_t i = 1; i < n; ++i) {
+        const __m128 in = _mm_unpacklo_ps(_mm_load_ss(left + i), _mm_load_ss(right + i));
+        const __m128 x = _mm_shuffle_ps(in, y, _MM_SHUFFLE(1, 0, 1, 0));
+        y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        b0 = _mm_add_ps(b0, db0);
+        b1 = _mm_add_ps(b1, db1);
+        b2 = _mm_add_ps(b2, db2);
+        a1 = _mm_add_ps(a1, da1);
+        a2 = _mm_add_ps(a2, da2);
+        _mm_store_ss(left + i - 1, _mm_movehl_ps(y, y));
+        _mm_store_ss(right + i - 1, _mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+    _mm_storeu_ps(bq.b0, b0);
+    _mm_storeu_ps(bq.b1, b1);
+    _mm_storeu_ps(bq.b2, b2);
+    _mm_storeu_ps(bq.a1, a1);
+    _mm_storeu_ps(bq.a2, a2);
+    _mm_storeu_ps(bq.z1, z1);
+    _mm_storeu_ps(bq.z2, z2);
+    alignas(16) float mid[4];
+    _mm_store_ps(mid, y);
+    left[n - 1] = biquadStep(bq, 2, mid[0]);
+    right[n - 1] = biquadStep(bq, 3, mid[1]);
+}
+
+const Kernels kSse2 = {Isa::Sse2, mixAdd, scaledCopy, crossfade, interleave2, sumSquares, peak, clamp,
+                       mixAddI16, mixAddI24, dot, sinePair, fdn,
+                       complexMulAdd, biquad2x2};
+} // namespace
+
+const Kernels *sse2Kernels() { return &kSse2; }
+#else
+const Kernels *sse2Kernels() { return nullptr; }
+#endif
+
+} // namespace audio::simd
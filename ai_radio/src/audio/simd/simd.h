@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace audio::simd {
+
+// Instruction sets with a kernel implementation, best last.
+enum class Isa { Scalar, Sse2, Avx2, Avx512, Neon };
+
+const char *isaName(Isa isa);
+
+// Two sine oscillators (left and right) as unit phasors, four samples wide:
+// element 4k + j holds oscillator k's phasor j samples ahead,
+// e^{i(phase + j * delta)}. One complex multiply by rot advances a lane four
+// samples, so the loop has no sin(). Owned by audio::SineOscPair, which
+// sets the rotors and renormalises between calls.
+struct SinePairState {
+    float re[8];
+    float im[8];
+    float rotRe[8];  // e^{i * 4 * delta}, the same in all four lanes
+    float rotIm[8];
+    float stepRe[8]; // lane j: e^{i * j * delta}, for tails shorter than 4
+    float stepIm[8];
+};
+
+// Eight-line feedback delay network, one sample per step (owned by
+// audio::FdnReverb, which sets the delays and gains between calls). The
+// lines share one ring of frame-major slots of kFdnLines floats, so slot s
+// holds every line's sample s and the feedback write is a single vector
+// store; each line reads at its own delay.
+constexpr size_t kFdnLines = 8;
+
+struct FdnState {
+    float *ring;                // (mask + 1) * kFdnLines floats
+    uint32_t mask;              // slots - 1; slots is a power of two
+    uint32_t write;             // slot written next
+    uint32_t delay[kFdnLines];  // whole samples, >= 1
+    float frac[kFdnLines];      // blend towards delay + 1 (modulated lines)
+    float gain[kFdnLines];      // feedback gain, including the Hadamard scale
+    float damp[kFdnLines];      // one-pole lowpass coefficient (0 = none)
+    float lp[kFdnLines];        // lowpass state
+    float inGain[kFdnLines];
+    float outL[kFdnLines];
+    float outR[kFdnLines];
+};
+
+// Two transposed direct form II biquads in series on a stereo pair, as four
+// lanes: section 0 left and right (lanes 0, 1), then section 1 (2, 3).
+// Section 1 runs one sample behind section 0, so all four lanes step
+// together in one 4-wide register. After every sample each lane's
+// coefficients move by their deltas, which ramps them across a block.
+// Owned by audio::BiquadCascade.
+constexpr size_t kBiquadLanes = 4;
+
+struct BiquadState {
+    float b0[kBiquadLanes], b1[kBiquadLanes], b2[kBiquadLanes];
+    float a1[kBiquadLanes], a2[kBiquadLanes]; // normalised, a0 = 1
+    float db0[kBiquadLanes], db1[kBiquadLanes], db2[kBiquadLanes];
+    float da1[kBiquadLanes], da2[kBiquadLanes];
+    float z1[kBiquadLanes], z2[kBiquadLanes];
+};
+
+// Hot-loop kernels for the mixing path. All pointers may be unaligned; in
+// place operation is allowed where dst aliases src. None of them allocate.
+struct Kernels {
+    Isa isa;
+    // dst[i] += src[i] * gain
+    void (*mixAdd)(float *dst, const float *src, float gain, size_t n);
+    // dst[i] = src[i] * gain
+    void (*scaledCopy)(float *dst, const float *src, float gain, size_t n);
+    // dst[i] = a[i] * gainA + b[i] * gainB
+    void (*crossfade)(float *dst, const float *a, const float *b, float gainA, float gainB, size_t n);
+    // out[2i] = left[i], out[2i + 1] = right[i]
+    void (*interleave2)(float *out, const float *left, const float *right, size_t n);
+    // sum of src[i]^2 (accumulation order differs per ISA)
+    float (*sumSquares)(const float *src, size_t n);
+    // max |src[i]|
+    float (*peak)(const float *src, size_t n);
+    // buf[i] = min(max(buf[i], lo), hi)
+    void (*clamp)(float *buf, float lo, float hi, size_t n);
+    // dst[i] += float(src[i]) * gain for native-width samples; the caller
+    // folds the integer full-scale factor into gain.
+    void (*mixAddI16)(float *dst, const int16_t *src, float gain, size_t n);
+    // src is packed little-endian signed 24-bit, 3 bytes per sample.
+    void (*mixAddI24)(float *dst, const uint8_t *src, float gain, size_t n);
+    // sum of a[i] * b[i] (accumulation order differs per ISA)
+    float (*dot)(const float *a, const float *b, size_t n);
+    // left[i] += gain * sin(left phase + i * delta), likewise right; moves
+    // both oscillators on n samples.
+    void (*sinePair)(SinePairState &osc, float *left, float *right, float gain, size_t n);
+    // Runs the network n samples on the mono input: per sample each line's
+    // delayed output is read and lowpassed, left/right[i] are set to their
+    // weighted sums, and the lines' gained outputs go back in through an
+    // unnormalised 8x8 Hadamard butterfly plus in[i] * inGain.
+    void (*fdn)(FdnState &fdn, const float *in, float *left, float *right, size_t n);
+    // Split-complex multiply-accumulate: acc[i] += a[i] * b[i], with real
+    // and imaginary parts in separate arrays (convolution spectra).
+    void (*complexMulAdd)(float *accRe, float *accIm, const float *aRe, const float *aIm, const float *bRe,
+                          const float *bIm, size_t n);
+    // Filters left and right in place through both sections of bq; right
+    // may equal left for a mono buffer. Advances the states and ramps.
+    void (*biquad2x2)(BiquadState &bq, float *left, float *right, size_t n);
+};
+
+// Sign-extended value of the packed 24-bit sample at p (tails and scalar).
+inline int32_t loadI24(const uint8_t *p) {
+    return static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 8 | static_cast<uint32_t>(p[1]) << 16 |
+                                static_cast<uint32_t>(p[2]) << 24) >> 8;
+}
+
+// The last n < 4 samples of a sinePair call, shared by every ISA: lanes
+// 0..n-1 are the output, then each lane steps on n samples.
+inline void sinePairTail(SinePairState &osc, float *left, float *right, float gain, size_t n) {
+    if (n == 0) return;
+    for (size_t j = 0; j < n; ++j) {
+        left[j] += osc.im[j] * gain;
+        right[j] += osc.im[4 + j] * gain;
+    }
+    for (size_t l = 0; l < 8; ++l) {
+        const size_t s = (l & ~size_t(3)) + n;
+        const float re = osc.re[l] * osc.stepRe[s] - osc.im[l] * osc.stepIm[s];
+        const float im = osc.re[l] * osc.stepIm[s] + osc.im[l] * osc.stepRe[s];
+        osc.re[l] = re;
+        osc.im[l] = im;
+    }
+}
+
+// One sample through biquad lane l, then its coefficient ramp. The
+// biquad2x2 kernels run their first and last half-step with it; the vector
+// loops repeat its exact operation order.
+inline float biquadStep(BiquadState &bq, size_t l, float x) {
+    const float y = bq.b0[l] * x + bq.z1[l];
+    bq.z1[l] = (bq.b1[l] * x - bq.a1[l] * y) + bq.z2[l];
+    bq.z2[l] = bq.b2[l] * x - bq.a2[l] * y;
+    bq.b0[l] += bq.db0[l];
+    bq.b1[l] += bq.db1[l];
+    bq.b2[l] += bq.db2[l];
+    bq.a1[l] += bq.da1[l];
+    bq.a2[l] += bq.da2[l];
+    return y;
+}
+
+// Kernels picked once at static-initialisation time from CPUID (or the
+// KEEGAN_SIMD=scalar|sse2|avx2|avx512|neon override, capped at what the CPU
+// supports). Safe to call from the audio thread.
+const Kernels &kernels();
+
+// Reference implementation.
+const Kernels &scalarKernels();
+
+// Every implementation this build contains that the CPU can run.
+std::vector<const Kernels *> availableKernels();
+
+// Runs `k` against scalarKernels() over odd sizes and misaligned offsets.
+// Returns false and fills *failure on the first mismatch.
+bool verifyAgainstScalar(const Kernels &k, std::string *failure);
+
+// Implementation tables; nullptr when the ISA is not compiled in.
+const Kernels *sse2Kernels();
+const Kernels *avx2Kernels();
+const Kernels *avx512Kernels();
+const Kernels *neonKernels();
+
+} // namespace audio::simd
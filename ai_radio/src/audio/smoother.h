@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cmath>
+
+namespace audio {
+
+// One-pole parameter smoother: each step moves a fixed fraction of the way
+// to the target, reaching ~63% after the time constant. Snaps onto the
+// target once within a relative epsilon, or once a step no longer moves
+// the value, so settled() eventually holds and callers can skip
+// recomputing derived coefficients.
+class ParamSmoother {
+public:
+    explicit ParamSmoother(float value = 0.0f) : current_(value), target_(value) {}
+
+    // stepRate = how often next() is called per second (sample rate, or
+    // sample rate / sub-block size).
+    void setTime(float timeMs, float stepRate) {
+        const float steps = 0.001f * timeMs * stepRate;
+        coeff_ = steps > 1.0f ? 1.0f - std::exp(-1.0f / steps) : 1.0f;
+    }
+
+    void setTarget(float value) { target_ = value; }
+    void reset(float value) { current_ = target_ = value; }
+
+    float next() {
+        const float diff = target_ - current_;
+        const float stepped = current_ + coeff_ * diff;
+        // With slow per-sample glides the step eventually rounds away before
+        // the epsilon is reached; snap then too.
+        if (std::fabs(diff) <= 1e-5f * (1.0f + std::fabs(target_)) || stepped == current_) {
+            current_ = target_;
+        } else {
+            current_ = stepped;
+        }
+        return current_;
+    }
+
+    float current() const { return current_; }
+    float target() const { return target_; }
+    bool settled() const { return current_ == target_; }
+
+private:
+    float current_;
+    float target_;
+    float coeff_ = 1.0f;
+};
+
+} // namespace audio
@@ -0,0 +1,132 @@
+#include "station_host.h"
+#include "../util/logger.h"
+#include <algorithm>
+#include <chrono>
+
+namespace audio {
+
+StationHost::StationHost(float sampleRate, size_t blockFrames)
+    : sampleRate_(sampleRate), blockFrames_(std::clamp<size_t>(blockFrames, 16, Engine::kMaxBlockFrames)) {}
+
+StationHost::~StationHost() {
+    stop();
+}
+
+Engine &StationHost::addStation(const std::string &id, brain::MoodPack pack, const std::string &startMood,
+                                float intensity, float activity, const std::string &pcmOutPath) {
+    auto station = std::make_unique<Station>();
+    station->id = id;
+    station->engine = std::make_unique<Engine>(sampleRate_, blockFrames_);
+    station->engine->setOffline(true, activity);
+    station->engine->setMoodPack(std::move(pack), startMood);
+    station->engine->setIntensity(intensity);
+    station->block.assign(blockFrames_ * 2, 0.0f);
+    station->pcmPath = pcmOutPath;
+    stations_.push_back(std::move(station));
+    return *stations_.back()->engine;
+}
+
+bool StationHost::start(size_t workers, int firstCpu) {
+    if (running_) return true;
+    if (stations_.empty()) {
+        util::logError("StationHost: no stations configured");
+        return false;
+    }
+    for (auto &station : stations_) {
+        if (station->pcmPath.empty() || station->pcm) continue;
+        station->pcm = std::fopen(station->pcmPath.c_str(), "wb");
+        if (!station->pcm) {
+            util::logWarn("StationHost: cannot open " + station->pcmPath + " for " + station->id);
+        }
+    }
+
+    // More threads than stations would never get a task.
+    workers = std::min(workers, stations_.size() - 1);
+    pool_ = std::make_unique<RtWorkerPool>(workers, firstCpu);
+    running_ = true;
+    renderThread_ = std::thread(&StationHost::renderLoop, this);
+    tickThread_ = std::thread(&StationHost::tickLoop, this);
+    util::logInfo("StationHost: " + std::to_string(stations_.size()) + " stations on " +
+                  std::to_string(workers + 1) + " render thread(s)");
+    return true;
+}
+
+void StationHost::stop() {
+    if (!running_) return;
+    running_ = false;
+    if (renderThread_.joinable()) renderThread_.join();
+    if (tickThread_.joinable()) tickThread_.join();
+    pool_.reset();
+    for (auto &station : stations_) {
+        if (station->pcm) {
+            std::fclose(station->pcm);
+            station->pcm = nullptr;
+        }
+    }
+}
+
+StationHost::Stats StationHost::stats() const {
+    Stats s;
+    s.blocks = blocks_.load(std::memory_order_relaxed);
+    s.lateBlocks = lateBlocks_.load(std::memory_order_relaxed);
+    s.loadAvg = loadAvg_.load(std::memory_order_relaxed);
+    s.loadPeak = loadPeak_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void StationHost::renderStation(void *ctx, size_t index) {
+    auto *self = static_cast<StationHost *>(ctx);
+    Station &station = *self->stations_[index];
+    station.engine->renderBlock(station.block.data(), self->blockFrames_);
+}
+
+void StationHost::renderLoop() {
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(blockFrames_) / sampleRate_));
+    auto deadline = Clock::now() + period;
+
+    while (running_) {
+        const auto start = Clock::now();
+        pool_->run(&StationHost::renderStation, this, stations_.size());
+        const auto rendered = Clock::now();
+
+        // Writes can block on a slow FIFO reader; that shows up as late
+        // blocks rather than inside the render load.
+        for (auto &station : stations_) {
+            if (station->pcm) std::fwrite(station->block.data(), sizeof(float), station->block.size(), station->pcm);
+        }
+
+        const float load = std::chrono::duration<float>(rendered - start).count() /
+                           std::chrono::duration<float>(period).count();
+        const float avg = loadAvg_.load(std::memory_order_relaxed);
+        loadAvg_.store(avg + 0.05f * (load - avg), std::memory_order_relaxed);
+        loadPeak_.store(std::max(loadPeak_.load(std::memory_order_relaxed), load), std::memory_order_relaxed);
+        blocks_.fetch_add(1, std::memory_order_relaxed);
+
+        const auto now = Clock::now();
+        if (now > deadline) {
+            lateBlocks_.fetch_add(1, std::memory_order_relaxed);
+            // Catch up block by block, but never try to make up more than
+            // a second: restart the clock instead.
+            if (now - deadline > std::chrono::seconds(1)) {
+                util::logWarn("StationHost: render fell more than 1 s behind; resyncing");
+                deadline = now;
+            }
+        } else {
+            std::this_thread::sleep_until(deadline);
+        }
+        deadline += period;
+    }
+}
+
+void StationHost::tickLoop() {
+    while (running_) {
+        for (auto &station : stations_) {
+            station->engine->tick("", 0.1f);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+} // namespace audio
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "engine.h"
+#include "worker_pool.h"
+
+namespace audio {
+
+// Runs several engines in one process without audio devices. A render
+// thread paces blocks to the wall clock and renders every station's block
+// for a period as one RtWorkerPool job (one task per station), so stations
+// share one set of render threads instead of each owning a process. A
+// tick thread drives Engine::tick for every station at 100 ms.
+class StationHost {
+public:
+    struct Stats {
+        uint64_t blocks = 0;
+        uint64_t lateBlocks = 0; // finished after their deadline
+        float loadAvg = 0.0f;    // render time / block period, smoothed
+        float loadPeak = 0.0f;
+    };
+
+    StationHost(float sampleRate = 48000.0f, size_t blockFrames = 512);
+    ~StationHost();
+
+    StationHost(const StationHost &) = delete;
+    StationHost &operator=(const StationHost &) = delete;
+
+    // Not real-time safe; call before start(). Hosted stations have no local
+    // user, so host inputs are off (see Engine::setOffline) and activity is
+    // pinned to the given value. pcmOutPath, if set, receives
+    // the station's interleaved float32 stereo (e.g. a FIFO that ffmpeg
+    // reads for RTMP ingest); opening a FIFO waits for its reader.
+    Engine &addStation(const std::string &id, brain::MoodPack pack, const std::string &startMood,
+                       float intensity, float activity, const std::string &pcmOutPath = {});
+
+    // workers = extra render threads besides the host's render thread.
+    bool start(size_t workers, int firstCpu = -1);
+    void stop();
+
+    size_t stationCount() const { return stations_.size(); }
+    const std::string &stationId(size_t index) const { return stations_[index]->id; }
+    Engine &engine(size_t index) { return *stations_[index]->engine; }
+
+    Stats stats() const;
+
+private:
+    struct Station {
+        std::string id;
+        std::unique_ptr<Engine> engine;
+        std::vector<float> block;
+        std::string pcmPath;
+        std::FILE *pcm = nullptr;
+    };
+
+    static void renderStation(void *ctx, size_t index);
+    void renderLoop();
+    void tickLoop();
+
+    float sampleRate_;
+    size_t blockFrames_;
+    std::vector<std::unique_ptr<Station>> stations_;
+    std::unique_ptr<RtWorkerPool> pool_;
+    std::atomic<bool> running_{false};
+    std::thread renderThread_;
+    std::thread tickThread_;
+
+    std::atomic<uint64_t> blocks_{0};
+    std::atomic<uint64_t> lateBlocks_{0};
+    std::atomic<float> loadAvg_{0.0f};
+    std::atomic<float> loadPeak_{0.0f};
+};
+
+} // namespace audio
@@ -0,0 +1,101 @@
+#include "stem_loader.h"
+#include <algorithm>
+#include <atomic>
+
+namespace audio {
+
+void parallelFor(size_t count, const std::function<void(size_t)> &fn, size_t maxThreads) {
+    if (maxThreads == 0) {
+        maxThreads = std::min<size_t>(kMaxLoadThreads, std::max(1u, std::thread::hardware_concurrency()));
+    }
+    const size_t threads = std::min(count, maxThreads);
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i = next++; i < count; i = next++) fn(i);
+    };
+    std::vector<std::thread> helpers;
+    helpers.reserve(threads > 0 ? threads - 1 : 0);
+    for (size_t t = 1; t < threads; ++t) helpers.emplace_back(work);
+    work();
+    for (auto &helper : helpers) helper.join();
+}
+
+StemLoader::StemLoader() {
+    thread_ = std::thread([this] { loop(); });
+}
+
+StemLoader::~StemLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    if (thread_.joinable()) thread_.join();
+}
+
+void StemLoader::request(size_t moodIndex, std::vector<brain::StemConfig> stems, uint32_t outputRate) {
+    // Freed after unlocking, as in cancel(): tearing down a large bank must
+    // not hold up take() or busy().
+    std::unique_ptr<StemBank> stale;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+        pending_ = std::make_unique<Request>(Request{moodIndex, std::move(stems), outputRate});
+        stale = std::move(ready_);
+    }
+    wake_.notify_one();
+}
+
+void StemLoader::cancel() {
+    std::unique_ptr<StemBank> stale;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+        pending_.reset();
+        stale = std::move(ready_);
+    }
+}
+
+bool StemLoader::take(Result &out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ready_) return false;
+    out.moodIndex = readyMoodIndex_;
+    out.bank = ready_.release();
+    return true;
+}
+
+bool StemLoader::busy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_ || loading_ || ready_;
+}
+
+void StemLoader::loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return stop_ || pending_; });
+        if (stop_) return;
+
+        std::unique_ptr<Request> req = std::move(pending_);
+        const uint64_t generation = generation_;
+        loading_ = true;
+        lock.unlock();
+
+        auto bank = std::make_unique<StemBank>();
+        if (!req->stems.empty()) bank->loadFromConfig(req->stems, req->outputRate);
+
+        lock.lock();
+        loading_ = false;
+        if (generation == generation_) {
+            ready_ = std::move(bank);
+            readyMoodIndex_ = req->moodIndex;
+        } else {
+            // Superseded while loading; free it here rather than on the
+            // caller's thread.
+            lock.unlock();
+            bank.reset();
+            lock.lock();
+        }
+    }
+}
+
+} // namespace audio
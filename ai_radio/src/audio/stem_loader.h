@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "stem_player.h"
+#include "../brain/state_machine.h"
+
+namespace audio {
+
+// Calls fn(0) .. fn(count - 1) spread over up to maxThreads threads (the
+// caller's included; 0 picks one per core, at most kMaxLoadThreads) and
+// returns when all have run. For decoding and file I/O off the audio thread.
+constexpr size_t kMaxLoadThreads = 4;
+void parallelFor(size_t count, const std::function<void(size_t)> &fn, size_t maxThreads = 0);
+
+// Builds StemBanks on a background thread so decoding and file I/O stay off
+// the tick and audio threads. Only the newest request matters: a request
+// that has not started yet is replaced, and a bank finished for a request
+// that has since been superseded is dropped on the loader thread.
+//
+// Banks are handed out fully decoded; the caller owns them from take() on.
+class StemLoader {
+public:
+    struct Result {
+        size_t moodIndex = 0;
+        StemBank *bank = nullptr;
+    };
+
+    StemLoader();
+    ~StemLoader();
+
+    StemLoader(const StemLoader &) = delete;
+    StemLoader &operator=(const StemLoader &) = delete;
+
+    // Queues a bank for stems, superseding any earlier request. Samples are
+    // resampled to outputRate when it is non-zero.
+    void request(size_t moodIndex, std::vector<brain::StemConfig> stems, uint32_t outputRate = 0);
+
+    // Drops the pending request and any finished bank not yet taken.
+    void cancel();
+
+    // Non-blocking: returns true and hands over the bank for the newest
+    // request once it is fully loaded.
+    bool take(Result &out);
+
+    // True while a request is queued, loading or waiting to be taken.
+    bool busy() const;
+
+private:
+    void loop();
+
+    struct Request {
+        size_t moodIndex = 0;
+        std::vector<brain::StemConfig> stems;
+        uint32_t outputRate = 0;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::unique_ptr<Request> pending_;
+    std::unique_ptr<StemBank> ready_;
+    size_t readyMoodIndex_ = 0;
+    uint64_t generation_ = 0; // bumped by request() and cancel()
+    bool loading_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace audio
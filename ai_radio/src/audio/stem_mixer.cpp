@@ -0,0 +1,91 @@
+#include "stem_mixer.h"
+#include "rt_check.h"
+#include <algorithm>
+
+namespace audio {
+
+StemMixer::~StemMixer() = default;
+
+void StemMixer::setWorkers(size_t workers, size_t maxFrames, int firstCpu) {
+    pool_.reset();
+    scratch_.clear();
+    tasks_.clear();
+    if (workers == 0) return;
+
+    pool_ = std::make_unique<RtWorkerPool>(workers, firstCpu);
+    // One group per thread, plus at most one extra per job where a group
+    // boundary falls inside a bank.
+    const size_t maxTasks = workers + 1 + kMaxJobs;
+    tasks_.resize(maxTasks);
+    scratch_.resize(maxTasks);
+    for (auto &bus : scratch_) bus.allocate(2, maxFrames);
+}
+
+void StemMixer::runTask(void *ctx, size_t index) {
+    auto *self = static_cast<StemMixer *>(ctx);
+    const Task &task = self->tasks_[index];
+#if KEEGAN_RT_CHECKS
+    // Workers run outside renderBlock, so open a scope of their own.
+    rtcheck::CallbackScope scope;
+    rtcheck::setStage(DspStage::Stems);
+#endif
+    task.out->clear(self->frames_);
+    task.bank->renderActiveRange(task.begin, task.end, *task.out, self->frames_);
+}
+
+void StemMixer::render(const Job *jobs, size_t count, size_t frames) {
+    count = std::min(count, kMaxJobs);
+    std::array<size_t, kMaxJobs> active{};
+    size_t totalActive = 0;
+    for (size_t j = 0; j < count; ++j) {
+        active[j] = jobs[j].bank->selectActive(jobs[j].density);
+        totalActive += active[j];
+    }
+
+    if (!pool_ || frames < kMinParallelFrames || totalActive < kMinParallelStems) {
+        for (size_t j = 0; j < count; ++j) {
+            jobs[j].out->clear(frames);
+            jobs[j].bank->renderActiveRange(0, active[j], *jobs[j].out, frames);
+        }
+        return;
+    }
+
+    // Cut the concatenated active lists into one group per thread.
+    const size_t threads = pool_->workers() + 1;
+    const size_t groupSize = (totalActive + threads - 1) / threads;
+    taskCount_ = 0;
+    size_t scratchUsed = 0;
+    size_t cursor = 0; // position in the concatenated list
+    for (size_t j = 0; j < count; ++j) {
+        const size_t jobStart = cursor;
+        if (active[j] == 0) jobs[j].out->clear(frames);
+        for (size_t begin = 0; begin < active[j] && taskCount_ < tasks_.size();) {
+            const size_t groupEnd = (cursor / groupSize + 1) * groupSize;
+            const size_t end = std::min(active[j], groupEnd - jobStart);
+            Task &task = tasks_[taskCount_++];
+            task.bank = jobs[j].bank;
+            task.begin = begin;
+            task.end = end;
+            task.dest = jobs[j].out;
+            task.out = begin == 0 ? task.dest : &scratch_[scratchUsed++];
+            cursor += end - begin;
+            begin = end;
+        }
+        cursor = jobStart + active[j];
+    }
+
+    frames_ = frames;
+    pool_->run(&StemMixer::runTask, this, taskCount_);
+
+    const auto &k = simd::kernels();
+    for (size_t t = 0; t < taskCount_; ++t) {
+        const Task &task = tasks_[t];
+        if (task.out == task.dest) continue;
+        const size_t channels = std::min(task.out->channels(), task.dest->channels());
+        for (size_t c = 0; c < channels; ++c) {
+            k.mixAdd(task.dest->channel(c), task.out->channel(c), 1.0f, frames);
+        }
+    }
+}
+
+} // namespace audio
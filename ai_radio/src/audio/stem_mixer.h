@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "bus.h"
+#include "stem_player.h"
+#include "worker_pool.h"
+
+namespace audio {
+
+// Renders one or more stem banks per block, optionally spread across an
+// RtWorkerPool. Active stems are split into contiguous groups; the first
+// group of each bank mixes straight into that bank's output and the rest
+// into per-task scratch buses that are summed in after the join. Small
+// blocks and thin mixes render serially, where the handoff would cost more
+// than it saves.
+class StemMixer {
+public:
+    struct Job {
+        StemBank *bank = nullptr;
+        float density = 1.0f;
+        AudioBus *out = nullptr; // cleared and overwritten
+    };
+
+    static constexpr size_t kMaxJobs = 2;
+    static constexpr size_t kMinParallelFrames = 128;
+    static constexpr size_t kMinParallelStems = 4;
+
+    StemMixer() = default;
+    ~StemMixer();
+
+    // Not real-time safe. workers == 0 (the default) renders serially on
+    // the audio thread. firstCpu >= 0 pins the workers (see RtWorkerPool).
+    void setWorkers(size_t workers, size_t maxFrames, int firstCpu = -1);
+    size_t workers() const { return pool_ ? pool_->workers() : 0; }
+
+    // Audio thread. Rolls each bank's active set serially (so renders stay
+    // reproducible) and then mixes them; jobs beyond kMaxJobs are ignored.
+    void render(const Job *jobs, size_t count, size_t frames);
+
+private:
+    struct Task {
+        StemBank *bank = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        AudioBus *out = nullptr;  // job output, or a scratch bus
+        AudioBus *dest = nullptr; // job output the scratch is summed into
+    };
+
+    static void runTask(void *ctx, size_t index);
+
+    std::unique_ptr<RtWorkerPool> pool_;
+    std::vector<AudioBus> scratch_;
+    std::vector<Task> tasks_;    // capacity fixed by setWorkers
+    size_t taskCount_ = 0;
+    size_t frames_ = 0;
+};
+
+} // namespace audio
@@ -1,257 +1,258 @@
 #include "stem_player.h"
+#include "asset_pack.h"
+#include "stem_loader.h"
+#include "../util/startup_profile.h"
 #include "../util/logger.h"
 #include "../brain/state_machine.h"
-#include <fstream>
-#include <cstring>
+#include "simd/simd.h"
 #include <algorithm>
 #include <cmath>
+#include <filesystem>
 
 namespace audio {
 
-namespace {
-// WAV file format constants
-constexpr uint32_t RIFF_ID = 0x46464952;  // "RIFF"
-constexpr uint32_t WAVE_ID = 0x45564157;  // "WAVE"
-constexpr uint32_t FMT_ID  = 0x20746D66;  // "fmt "
-constexpr uint32_t DATA_ID = 0x61746164;  // "data"
-
-template<typename T>
-T readLE(const uint8_t* data) {
-    T result = 0;
-    for (size_t i = 0; i < sizeof(T); ++i) {
-        result |= static_cast<T>(data[i]) << (8 * i);
-    }
-    return result;
-}
-} // namespace
-
-bool StemPlayer::load(const std::string& path) {
-    buffer_.clear();
-    readPos_ = 0;
-
-    // Read entire file into memory
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        util::logError("StemPlayer: Failed to open file: " + path);
-        return false;
-    }
-
-    size_t fileSize = static_cast<size_t>(file.tellg());
-    if (fileSize < 44) {
-        util::logError("StemPlayer: File too small to be valid WAV: " + path);
-        return false;
-    }
-
-    file.seekg(0);
-    std::vector<uint8_t> fileData(fileSize);
-    file.read(reinterpret_cast<char*>(fileData.data()), fileSize);
-    file.close();
-
-    // Parse WAV header
-    size_t dataOffset = 0;
-    size_t dataSize = 0;
-    if (!parseWavHeader(fileData, dataOffset, dataSize)) {
-        util::logError("StemPlayer: Invalid WAV header: " + path);
-        return false;
-    }
-
-    // Get bits per sample from header (offset 34 in standard WAV)
-    uint16_t bitsPerSample = readLE<uint16_t>(&fileData[34]);
-
-    // Convert audio data to float
-    convertToFloat(fileData.data() + dataOffset, dataSize, bitsPerSample);
-
-    util::logInfo("StemPlayer: Loaded " + path + " (" + 
-                  std::to_string(totalSamples()) + " samples, " +
-                  std::to_string(channels_) + " ch, " +
-                  std::to_string(sampleRate_) + " Hz)");
-
-    return true;
-}
-
-bool StemPlayer::parseWavHeader(const std::vector<uint8_t>& data, size_t& dataOffset, size_t& dataSize) {
-    if (data.size() < 44) return false;
-
-    // Check RIFF header
-    if (readLE<uint32_t>(&data[0]) != RIFF_ID) return false;
-    if (readLE<uint32_t>(&data[8]) != WAVE_ID) return false;
-
-    // Find fmt chunk
-    size_t pos = 12;
-    bool foundFmt = false;
-    while (pos + 8 <= data.size()) {
-        uint32_t chunkId = readLE<uint32_t>(&data[pos]);
-        uint32_t chunkSize = readLE<uint32_t>(&data[pos + 4]);
-
-        if (chunkId == FMT_ID) {
-            if (pos + 8 + chunkSize > data.size()) return false;
-            
-            uint16_t audioFormat = readLE<uint16_t>(&data[pos + 8]);
-            if (audioFormat != 1 && audioFormat != 3) {
-                util::logError("StemPlayer: Unsupported audio format (only PCM/float supported)");
-                return false;
-            }
-
-            channels_ = readLE<uint16_t>(&data[pos + 10]);
-            sampleRate_ = readLE<uint32_t>(&data[pos + 12]);
-            foundFmt = true;
-        } else if (chunkId == DATA_ID) {
-            if (!foundFmt) return false;
-            dataOffset = pos + 8;
-            dataSize = chunkSize;
-            return true;
+bool StemPlayer::load(const std::string& path, uint32_t outputRate, uint64_t streamAboveBytes) {
+    // Baked pack entries are already mapped, so they are never streamed.
+    std::error_code ec;
+    const uintmax_t size = std::filesystem::file_size(path, ec);
+    if (!ec && size > streamAboveBytes && !AssetPack::findMounted(path)) {
+        auto stream = StemStream::open(path, looping_, outputRate);
+        if (!stream) {
+            unload();
+            return false;
         }
-
-        pos += 8 + chunkSize;
-        if (chunkSize % 2 == 1) pos++; // Padding byte
+        setSample(nullptr);
+        stream_ = std::move(stream);
+        frames_ = stream_->frames();
+        channels_ = std::max<uint16_t>(stream_->channels(), 1);
+        sampleRate_ = stream_->sampleRate();
+        format_ = SampleFormat::Float32;
+        bytesPerSample_ = sizeof(float);
+        return true;
     }
 
-    return false;
+    SampleRef sample = SampleCache::instance().load(path, outputRate);
+    setSample(sample);
+    return sample != nullptr;
 }
 
-void StemPlayer::convertToFloat(const uint8_t* data, size_t dataSize, uint16_t bitsPerSample) {
-    size_t bytesPerSample = bitsPerSample / 8;
-    size_t totalSamples = dataSize / bytesPerSample;
-    buffer_.resize(totalSamples);
-
-    for (size_t i = 0; i < totalSamples; ++i) {
-        const uint8_t* samplePtr = data + i * bytesPerSample;
-
-        if (bitsPerSample == 8) {
-            // 8-bit unsigned
-            buffer_[i] = (static_cast<float>(samplePtr[0]) - 128.0f) / 128.0f;
-        } else if (bitsPerSample == 16) {
-            // 16-bit signed little-endian
-            int16_t sample = static_cast<int16_t>(samplePtr[0] | (samplePtr[1] << 8));
-            buffer_[i] = static_cast<float>(sample) / 32768.0f;
-        } else if (bitsPerSample == 24) {
-            // 24-bit signed little-endian
-            int32_t sample = samplePtr[0] | (samplePtr[1] << 8) | (samplePtr[2] << 16);
-            if (sample & 0x800000) sample |= 0xFF000000; // Sign extend
-            buffer_[i] = static_cast<float>(sample) / 8388608.0f;
-        } else if (bitsPerSample == 32) {
-            // 32-bit float
-            float sample;
-            std::memcpy(&sample, samplePtr, sizeof(float));
-            buffer_[i] = sample;
-        }
-    }
+void StemPlayer::setSample(SampleRef sample) {
+    stream_.reset();
+    sample_ = std::move(sample);
+    data_ = sample_ ? sample_->data() : nullptr;
+    format_ = sample_ ? sample_->format : SampleFormat::Float32;
+    bytesPerSample_ = sample_ ? sample_->bytesPerSample() : 4;
+    frames_ = sample_ ? sample_->frames : 0;
+    channels_ = sample_ ? std::max<uint16_t>(sample_->channels, 1) : 1;
+    sampleRate_ = sample_ ? sample_->sampleRate : 48000;
+    readPos_ = 0;
 }
 
 void StemPlayer::render(float* out, size_t frames, float gain) {
-    if (buffer_.empty() || frames == 0) {
+    if (frames_ == 0 || frames == 0) {
         std::fill(out, out + frames, 0.0f);
         return;
     }
 
-    for (size_t i = 0; i < frames; ++i) {
-        if (readPos_ >= buffer_.size()) {
-            if (looping_) {
-                readPos_ = 0;
-            } else {
-                out[i] = 0.0f;
-                continue;
-            }
-        }
-
-        // For stereo files, mix down to mono
-        if (channels_ == 2 && readPos_ + 1 < buffer_.size()) {
-            out[i] = (buffer_[readPos_] + buffer_[readPos_ + 1]) * 0.5f * gain;
-            readPos_ += 2;
-        } else {
-            out[i] = buffer_[readPos_] * gain;
-            readPos_++;
-        }
-    }
+    // Mono downmix: average all channels.
+    const float scale = gain / static_cast<float>(channels_);
+    std::fill(out, out + frames, 0.0f);
+    forEachRun(frames, [&](size_t off, size_t pos, size_t n) {
+        for (size_t c = 0; c < channels_; ++c) mixChannel(out + off, c, pos, scale, n);
+    });
 }
 
-void StemPlayer::renderMix(float* out, size_t frames, float gain) {
-    if (buffer_.empty() || frames == 0) return;
+void StemPlayer::renderMix(AudioBus& out, size_t frames, float gain) {
+    if (frames_ == 0 || frames == 0 || out.channels() == 0) return;
 
-    for (size_t i = 0; i < frames; ++i) {
-        if (readPos_ >= buffer_.size()) {
-            if (looping_) {
-                readPos_ = 0;
-            } else {
-                continue;
-            }
+    const size_t outChannels = out.channels();
+    forEachRun(frames, [&](size_t off, size_t pos, size_t n) {
+        if (outChannels == 1 && channels_ > 1) {
+            const float scale = gain / static_cast<float>(channels_);
+            for (size_t c = 0; c < channels_; ++c) mixChannel(out.channel(0) + off, c, pos, scale, n);
+            return;
         }
-
-        // For stereo files, mix down to mono
-        if (channels_ == 2 && readPos_ + 1 < buffer_.size()) {
-            out[i] += (buffer_[readPos_] + buffer_[readPos_ + 1]) * 0.5f * gain;
-            readPos_ += 2;
-        } else {
-            out[i] += buffer_[readPos_] * gain;
-            readPos_++;
+        // Channel for channel; a mono stem (or the last stem channel) feeds
+        // any remaining bus channels.
+        for (size_t c = 0; c < outChannels; ++c) {
+            mixChannel(out.channel(c) + off, std::min<size_t>(c, channels_ - 1), pos, gain, n);
         }
+    });
+}
+
+void StemPlayer::mixChannel(float* dst, size_t c, size_t pos, float gain, size_t n) const {
+    const auto& k = simd::kernels();
+    if (stream_) {
+        k.mixAdd(dst, stream_->channel(c) + pos, gain, n);
+        return;
+    }
+    const uint8_t* src = data_ + (c * frames_ + pos) * bytesPerSample_;
+    // The full-scale factors are powers of two, so folding them into the
+    // gain rounds exactly like converting first.
+    switch (format_) {
+        case SampleFormat::Int16:
+            k.mixAddI16(dst, reinterpret_cast<const int16_t*>(src), gain * (1.0f / 32768.0f), n);
+            break;
+        case SampleFormat::Int24:
+            k.mixAddI24(dst, src, gain * (1.0f / 8388608.0f), n);
+            break;
+        case SampleFormat::Float32:
+            k.mixAdd(dst, reinterpret_cast<const float*>(src), gain, n);
+            break;
     }
 }
 
 void StemPlayer::seek(size_t sampleOffset) {
-    size_t maxPos = buffer_.size() / channels_;
-    readPos_ = std::min(sampleOffset * channels_, buffer_.size());
+    readPos_ = std::min(sampleOffset, frames_);
 }
 
 // --- StemBank implementation ---
 
-bool StemBank::loadFromConfig(const std::vector<brain::StemConfig>& configs) {
+StemBank::~StemBank() { cancelDeferred(); }
+
+bool StemBank::loadEntry(const brain::StemConfig& cfg, uint32_t outputRate, StemEntry& entry) {
+    entry.role = cfg.role;
+    entry.gainDb = cfg.gainDb;
+    entry.gain = dbToLinear(cfg.gainDb);
+    entry.probability = cfg.probability;
+    entry.active = true;
+
+    const uint64_t streamAbove = cfg.streamAboveMb < 0.0f
+        ? UINT64_MAX
+        : static_cast<uint64_t>(static_cast<double>(cfg.streamAboveMb) * 1024.0 * 1024.0);
+    entry.player.setLooping(cfg.loop);
+    if (!entry.player.load(cfg.file, outputRate, streamAbove)) {
+        util::logError("StemBank: Failed to load stem: " + cfg.file);
+        return false;
+    }
+    return true;
+}
+
+bool StemBank::loadFromConfig(const std::vector<brain::StemConfig>& configs, uint32_t outputRate) {
     clear();
-    
-    for (const auto& cfg : configs) {
-        StemEntry entry;
-        entry.role = cfg.role;
-        entry.gainDb = cfg.gainDb;
-        entry.probability = cfg.probability;
-        entry.active = true;
-
-        if (!entry.player.load(cfg.file)) {
-            util::logError("StemBank: Failed to load stem: " + cfg.file);
-            // Continue loading other stems, this one just won't play
-            continue;
-        }
 
-        stems_.push_back(std::move(entry));
+    std::vector<StemEntry> entries(configs.size());
+    std::unique_ptr<bool[]> loaded(new bool[configs.size()]());
+    parallelFor(configs.size(), [&](size_t i) { loaded[i] = loadEntry(configs[i], outputRate, entries[i]); });
+
+    // Failed stems are dropped; the rest keep their config order.
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (loaded[i]) stems_.push_back(std::move(entries[i]));
     }
 
+    active_.assign(stems_.size(), 0);
     util::logInfo("StemBank: Loaded " + std::to_string(stems_.size()) + " stems");
     return !stems_.empty();
 }
 
+bool StemBank::loadProgressive(const std::vector<brain::StemConfig>& configs, uint32_t outputRate) {
+    clear();
+    if (configs.empty()) return false;
+
+    size_t first = 0;
+    for (size_t i = 0; i < configs.size(); ++i) {
+        if (configs[i].role == "base") {
+            first = i;
+            break;
+        }
+    }
+
+    // Every slot exists up front so the audio thread never sees stems_
+    // change size; slots that fail to load simply never play.
+    stems_.resize(configs.size());
+    active_.assign(stems_.size(), 0);
+    ready_.reset(new std::atomic<bool>[stems_.size()]);
+    for (size_t i = 0; i < stems_.size(); ++i) ready_[i].store(false, std::memory_order_relaxed);
+
+    const bool firstLoaded = loadEntry(configs[first], outputRate, stems_[first]);
+    ready_[first].store(true, std::memory_order_release);
+    if (stems_.size() == 1) {
+        util::logInfo(std::string("StemBank: Loaded ") + (firstLoaded ? "1 stem" : "0 stems"));
+        return firstLoaded;
+    }
+
+    pending_.store(stems_.size() - 1, std::memory_order_relaxed);
+    cancel_.store(false, std::memory_order_relaxed);
+    deferred_ = std::thread([this, configs, outputRate, first] {
+        auto &profile = util::StartupProfile::instance();
+        const double startMs = profile.nowMs();
+        std::atomic<size_t> loaded{0};
+        parallelFor(configs.size() - 1, [&](size_t n) {
+            const size_t i = n < first ? n : n + 1;
+            if (cancel_.load(std::memory_order_relaxed)) return;
+            if (loadEntry(configs[i], outputRate, stems_[i])) ++loaded;
+            ready_[i].store(true, std::memory_order_release);
+            pending_.fetch_sub(1, std::memory_order_release);
+        });
+        if (cancel_.load(std::memory_order_relaxed)) return;
+        const double endMs = profile.nowMs();
+        profile.record("background_stems", startMs, endMs);
+        util::logInfo("StemBank: Loaded " + std::to_string(loaded.load()) + " more stem(s) in the background in " +
+                      std::to_string(static_cast<int>(endMs - startMs)) + " ms");
+    });
+    util::logInfo("StemBank: Started on " + configs[first].file + ", loading " + std::to_string(stems_.size() - 1) +
+                  " more stem(s) in the background");
+    return true;
+}
+
+bool StemBank::fullyLoaded() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+void StemBank::cancelDeferred() {
+    if (!deferred_.joinable()) return;
+    cancel_.store(true, std::memory_order_relaxed);
+    deferred_.join();
+    pending_.store(0, std::memory_order_relaxed);
+}
+
 void StemBank::clear() {
+    cancelDeferred();
     stems_.clear();
-    tempBuffer_.clear();
+    active_.clear();
+    ready_.reset();
+    activeCount_ = 0;
 }
 
-void StemBank::renderMixed(float* out, size_t frames, float densityThreshold) {
+void StemBank::renderMixed(AudioBus& out, size_t frames, float densityThreshold) {
     // Clear output buffer
-    std::fill(out, out + frames, 0.0f);
+    out.clear(frames);
 
     if (stems_.empty()) return;
 
-    // Ensure temp buffer is sized
-    if (tempBuffer_.size() < frames) {
-        tempBuffer_.resize(frames);
-    }
+    renderActiveRange(0, selectActive(densityThreshold), out, frames);
+}
+
+size_t StemBank::selectActive(float densityThreshold) {
+    activeCount_ = 0;
+    if (stems_.empty()) return 0;
 
     // Determine how many stems to activate based on density
     size_t maxActive = static_cast<size_t>(std::ceil(stems_.size() * densityThreshold));
     maxActive = std::max<size_t>(1, maxActive); // At least one stem
 
-    size_t activeCount = 0;
-    for (auto& stem : stems_) {
+    for (size_t i = 0; i < stems_.size(); ++i) {
+        auto& stem = stems_[i];
+        if (ready_ && !ready_[i].load(std::memory_order_acquire)) continue;
         if (!stem.player.isLoaded()) continue;
-        if (activeCount >= maxActive) break;
+        if (activeCount_ >= maxActive) break;
 
         // Apply probability check
         if (stem.probability < 1.0f) {
-            float roll = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+            // Per-bank LCG: rand() takes a lock in some C runtimes.
+            rngState_ = rngState_ * 1664525u + 1013904223u;
+            float roll = static_cast<float>(rngState_ >> 8) / 16777216.0f;
             if (roll > stem.probability) continue;
         }
 
-        float gain = dbToLinear(stem.gainDb);
-        stem.player.renderMix(out, frames, gain);
-        activeCount++;
+        active_[activeCount_++] = static_cast<uint32_t>(i);
+    }
+    return activeCount_;
+}
+
+void StemBank::renderActiveRange(size_t begin, size_t end, AudioBus& out, size_t frames) {
+    end = std::min(end, activeCount_);
+    for (size_t i = begin; i < end; ++i) {
+        auto& stem = stems_[active_[i]];
+        stem.player.renderMix(out, frames, stem.gain);
     }
 }
 
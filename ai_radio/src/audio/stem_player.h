@@ -1,26 +1,57 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 #include <cstdint>
 #include <cmath>
+#include "bus.h"
+#include "sample_cache.h"
+#include "stem_stream.h"
 #include "../brain/state_machine.h"
 
 namespace audio {
 
-// Decodes and plays WAV audio files with seamless looping support.
-// Audio is decoded upfront into memory for low-latency playback.
+// Plays a decoded sample with seamless looping support. The planar sample
+// data comes from SampleCache and may be shared with other players; each
+// player only owns its read position. Integer samples stay at their stored
+// width and are converted to float inside the mixing kernels.
+//
+// Files larger than the load threshold are streamed from disk through a
+// StemStream instead, so memory stays at a few seconds of audio however
+// long the bed is.
 class StemPlayer {
 public:
     StemPlayer() = default;
     ~StemPlayer() = default;
 
-    // Load and decode a WAV file into memory.
+    // Load a WAV, FLAC, MP3 or Ogg Vorbis file through the shared
+    // SampleCache (no I/O if it is already resident), or stream it when the
+    // file is larger than streamAboveBytes. A non-zero outputRate resamples
+    // files recorded at another rate. Uses the current looping setting. Not
+    // for the audio thread.
     // Returns true on success. Logs error and returns false on failure.
-    bool load(const std::string& path);
+    bool load(const std::string& path, uint32_t outputRate = 0, uint64_t streamAboveBytes = UINT64_MAX);
+
+    // Play an already decoded sample.
+    void setSample(SampleRef sample);
+
+    // Drop the sample reference so the cache may evict it. The player must
+    // not be rendering.
+    void unload() { setSample(nullptr); }
+
+    // True when playing from a disk stream rather than a decoded sample.
+    bool isStreaming() const { return stream_ != nullptr; }
+
+    // Frames a stream could not supply in time (always 0 when not
+    // streaming).
+    uint64_t underruns() const { return stream_ ? stream_->underruns() : 0; }
 
     // Check if audio data is loaded and ready for playback.
-    bool isLoaded() const { return !buffer_.empty(); }
+    bool isLoaded() const { return frames_ > 0; }
 
     // Get the sample rate of the loaded audio.
     uint32_t sampleRate() const { return sampleRate_; }
@@ -29,39 +60,70 @@ public:
     uint16_t channels() const { return channels_; }
 
     // Get total number of samples (per channel).
-    size_t totalSamples() const { return buffer_.size() / channels_; }
+    size_t totalSamples() const { return frames_; }
 
-    // Render audio into output buffer with specified gain.
+    // Render a mono downmix into output buffer with specified gain.
     // Output should be sized for (frames) samples.
     // Automatically loops when reaching end of audio.
     void render(float* out, size_t frames, float gain = 1.0f);
 
-    // Render and mix (add) into existing buffer rather than overwrite.
-    void renderMix(float* out, size_t frames, float gain = 1.0f);
+    // Render and mix (add) into a planar bus, channel for channel. Mono
+    // stems feed every bus channel; a mono bus gets the averaged downmix.
+    void renderMix(AudioBus& out, size_t frames, float gain = 1.0f);
 
-    // Seek to a specific sample position.
+    // Seek to a specific sample position. Streams play straight through
+    // and ignore seeks.
     void seek(size_t sampleOffset);
 
-    // Reset playback to beginning.
+    // Reset playback to beginning (decoded samples only, as for seek).
     void reset() { readPos_ = 0; }
 
-    // Set whether this stem should loop (default: true).
+    // Set whether this stem should loop (default: true). A stream takes the
+    // setting in effect when it is loaded.
     void setLooping(bool loop) { looping_ = loop; }
     bool isLooping() const { return looping_; }
 
     // Check if playback has finished (only relevant if not looping).
-    bool isFinished() const { return !looping_ && readPos_ >= buffer_.size(); }
+    bool isFinished() const {
+        return stream_ ? stream_->finished() : !looping_ && readPos_ >= frames_;
+    }
 
 private:
-    std::vector<float> buffer_;     // Interleaved audio samples
-    size_t readPos_ = 0;            // Current read position in samples
+    SampleRef sample_;              // Planar audio: channel c starts at c * frames_
+    std::shared_ptr<StemStream> stream_; // set instead of sample_ when streaming
+    const uint8_t* data_ = nullptr; // sample_->data(), cached for the render path
+    SampleFormat format_ = SampleFormat::Float32;
+    size_t bytesPerSample_ = 4;
+    size_t frames_ = 0;             // Frames per channel
+    size_t readPos_ = 0;            // Current read position in frames
     uint32_t sampleRate_ = 48000;
     uint16_t channels_ = 1;
     bool looping_ = true;
 
-    // Internal WAV parsing helpers
-    bool parseWavHeader(const std::vector<uint8_t>& data, size_t& dataOffset, size_t& dataSize);
-    void convertToFloat(const uint8_t* data, size_t dataSize, uint16_t bitsPerSample);
+    // dst[i] += channel c at frames [pos, pos + n) * gain, as float. When
+    // streaming, pos is an offset into the stream's ring.
+    void mixChannel(float* dst, size_t c, size_t pos, float gain, size_t n) const;
+
+    // Splits the next `frames` of playback into contiguous runs (handling
+    // the loop wrap) and calls fn(outOffset, readPos, count) for each.
+    // Returns the number of frames produced; less than `frames` only when
+    // a non-looping stem reaches its end or a stream underruns.
+    template <typename Fn>
+    size_t forEachRun(size_t frames, Fn&& fn) {
+        if (stream_) return stream_->consume(frames, fn);
+        size_t done = 0;
+        while (done < frames) {
+            if (readPos_ >= frames_) {
+                if (!looping_) break;
+                readPos_ = 0;
+            }
+            const size_t n = std::min(frames - done, frames_ - readPos_);
+            fn(done, readPos_, n);
+            readPos_ += n;
+            done += n;
+        }
+        return done;
+    }
 };
 
 // Collection of stems for a mood, manages loading and mixing.
@@ -71,19 +133,43 @@ public:
         StemPlayer player;
         std::string role;       // "base", "rhythm", "env", "melodic"
         float gainDb = 0.0f;
+        float gain = 1.0f;      // linear, from gainDb
         float probability = 1.0f;
         bool active = true;
     };
 
-    // Load all stems for a mood from config.
-    bool loadFromConfig(const std::vector<brain::StemConfig>& configs);
+    StemBank() = default;
+    ~StemBank();
+    StemBank(const StemBank&) = delete;
+    StemBank& operator=(const StemBank&) = delete;
+
+    // Load all stems for a mood from config, resampled to outputRate when
+    // it is non-zero. Stems are decoded in parallel; returns once all are in.
+    bool loadFromConfig(const std::vector<brain::StemConfig>& configs, uint32_t outputRate = 0);
 
-    // Clear all loaded stems.
+    // Loads only the first "base" stem (or the first stem) before returning
+    // and decodes the rest on a background thread. Each joins the mix from
+    // the first block after it is ready, so the bank can play straight away.
+    // Not for offline renders: when stems come in depends on the disk.
+    bool loadProgressive(const std::vector<brain::StemConfig>& configs, uint32_t outputRate = 0);
+
+    // True once no stems are still loading in the background.
+    bool fullyLoaded() const;
+
+    // Clear all loaded stems (cancelling a background load).
     void clear();
 
-    // Render all active stems mixed together.
-    // Output is mono, sized for (frames) samples.
-    void renderMixed(float* out, size_t frames, float densityThreshold);
+    // Render all active stems mixed together into a planar bus (stereo
+    // stems keep their width on a stereo bus).
+    void renderMixed(AudioBus& out, size_t frames, float densityThreshold);
+
+    // Split form of renderMixed for parallel rendering: selectActive picks
+    // this block's stems (density cap and probability rolls) and returns
+    // how many; renderActiveRange then mixes active stems [begin, end) into
+    // out without clearing it. Disjoint ranges may render concurrently
+    // into different buses.
+    size_t selectActive(float densityThreshold);
+    void renderActiveRange(size_t begin, size_t end, AudioBus& out, size_t frames);
 
     // Get number of loaded stems.
     size_t count() const { return stems_.size(); }
@@ -93,8 +179,19 @@ public:
     const StemEntry& at(size_t index) const { return stems_[index]; }
 
 private:
+    static bool loadEntry(const brain::StemConfig& cfg, uint32_t outputRate, StemEntry& entry);
+    void cancelDeferred();
+
     std::vector<StemEntry> stems_;
-    std::vector<float> tempBuffer_;
+    std::vector<uint32_t> active_; // indices into stems_, sized at load
+    // Progressive loads: per-stem ready flags (released by the loader
+    // thread, acquired by selectActive); null for banks loaded in one go.
+    std::unique_ptr<std::atomic<bool>[]> ready_;
+    std::atomic<bool> cancel_{false};
+    std::atomic<size_t> pending_{0};
+    std::thread deferred_;
+    size_t activeCount_ = 0;
+    uint32_t rngState_ = 0x9e3779b9u;
 };
 
 // Convert decibels to linear gain.
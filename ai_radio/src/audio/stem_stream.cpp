@@ -0,0 +1,318 @@
+#include "stem_stream.h"
+#include "../util/logger.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace audio {
+
+namespace {
+constexpr size_t kHeaderBytes = 64 * 1024; // the data chunk must start within this
+constexpr size_t kChunkFrames = 8192;      // largest single file read
+constexpr size_t kMinFillFrames = 2048;    // skip top-ups smaller than this
+constexpr size_t kMaxStreamChannels = 8;
+constexpr auto kReaderInterval = std::chrono::milliseconds(10);
+
+std::atomic<bool> g_blockingReads{false};
+std::atomic<uint64_t> g_underruns{0};
+std::atomic<uint64_t> g_opened{0};
+
+size_t nextPowerOfTwo(size_t v) {
+    size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+} // namespace
+
+// Services every open stream from one thread, topping each ring up every
+// few milliseconds (or at once when a blocking consumer asks).
+class StreamReader {
+public:
+    static StreamReader& instance() {
+        static StreamReader reader;
+        return reader;
+    }
+
+    ~StreamReader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    void add(const std::shared_ptr<StemStream>& stream) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        streams_.push_back(stream);
+        if (!thread_.joinable()) thread_ = std::thread([this] { loop(); });
+    }
+
+    void wake() { wake_.notify_one(); }
+
+    StemStream::Stats stats() {
+        StemStream::Stats s;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& weak : streams_) {
+            if (auto stream = weak.lock()) {
+                ++s.streams;
+                s.bufferBytes += stream->storage_.size();
+            }
+        }
+        s.underruns = g_underruns.load(std::memory_order_relaxed);
+        s.opened = g_opened.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    StreamReader() = default;
+
+    void loop() {
+        std::vector<std::shared_ptr<StemStream>> live;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            live.clear();
+            for (auto it = streams_.begin(); it != streams_.end();) {
+                if (auto stream = it->lock()) {
+                    live.push_back(std::move(stream));
+                    ++it;
+                } else {
+                    it = streams_.erase(it);
+                }
+            }
+            lock.unlock();
+
+            for (auto& stream : live) {
+                stream->fill();
+                const uint64_t underruns = stream->underruns();
+                if (underruns != stream->reportedUnderruns_) {
+                    g_underruns.fetch_add(underruns - stream->reportedUnderruns_, std::memory_order_relaxed);
+                    util::logWarn("StemStream: " + std::to_string(underruns - stream->reportedUnderruns_) +
+                                  " underrun(s) on " + stream->path_);
+                    stream->reportedUnderruns_ = underruns;
+                }
+            }
+            // Streams whose players are gone are closed here, off the audio
+            // thread.
+            live.clear();
+
+            lock.lock();
+            wake_.wait_for(lock, kReaderInterval);
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<std::weak_ptr<StemStream>> streams_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+std::shared_ptr<StemStream> StemStream::open(const std::string& path, bool loop, uint32_t outputRate) {
+    std::shared_ptr<StemStream> stream(new StemStream());
+    stream->path_ = path;
+    stream->loop_ = loop;
+
+    auto& file = stream->file_;
+    WavFormat& fmt = stream->fmt_;
+    if (AudioDecoder::handles(path)) {
+        // Compressed: the decoder reads the file and hands out float frames.
+        stream->decoder_ = std::make_unique<AudioDecoder>();
+        if (!stream->decoder_->open(path, AudioDecoder::Output::Float32)) return nullptr;
+        fmt.channels = stream->decoder_->channels();
+        fmt.sampleRate = stream->decoder_->sampleRate();
+        fmt.bitsPerSample = 32;
+        if (stream->decoder_->frames() == 0) {
+            util::logError("StemStream: Length unknown, cannot stream " + path);
+            return nullptr;
+        }
+    } else {
+        file.open(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            util::logError("StemStream: Failed to open file: " + path);
+            return nullptr;
+        }
+        const size_t fileSize = static_cast<size_t>(file.tellg());
+        std::vector<uint8_t> header(std::min(fileSize, kHeaderBytes));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()));
+
+        if (!parseWavHeader(header.data(), static_cast<size_t>(file.gcount()), fileSize, fmt)) {
+            util::logError("StemStream: Invalid WAV header: " + path);
+            return nullptr;
+        }
+    }
+    if (fmt.channels == 0 || fmt.channels > kMaxStreamChannels || fmt.bitsPerSample < 8 || fmt.sampleRate == 0) {
+        util::logError("StemStream: Invalid channel count or sample size: " + path);
+        return nullptr;
+    }
+    const size_t frameBytes = static_cast<size_t>(fmt.channels) * (fmt.bitsPerSample / 8);
+    stream->fileFrames_ = stream->decoder_ ? static_cast<size_t>(stream->decoder_->frames()) : fmt.dataSize / frameBytes;
+    if (stream->fileFrames_ == 0) {
+        util::logError("StemStream: No audio in " + path);
+        return nullptr;
+    }
+
+    stream->outRate_ = outputRate != 0 ? outputRate : fmt.sampleRate;
+    const Resampler resampler(fmt.sampleRate, stream->outRate_);
+    stream->outFrames_ = resampler.outputFrames(stream->fileFrames_);
+    if (!resampler.passthrough()) {
+        stream->resampler_ = std::make_unique<ResamplerStream>(resampler, fmt.channels);
+        stream->staged_.resize(kChunkFrames * fmt.channels);
+    }
+
+    stream->capacity_ = nextPowerOfTwo(std::max<size_t>(
+        kChunkFrames, static_cast<size_t>(kBufferSeconds * static_cast<float>(stream->outRate_))));
+    if (!stream->storage_.allocate(stream->capacity_ * fmt.channels * sizeof(float))) {
+        util::logError("StemStream: Out of memory for " + path);
+        return nullptr;
+    }
+    stream->ring_ = reinterpret_cast<float*>(stream->storage_.data());
+    stream->chunk_.resize(kChunkFrames * frameBytes);
+
+    if (!stream->decoder_) {
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(fmt.dataOffset));
+    }
+    stream->fill(); // nobody consumes yet, so this thread may produce
+
+    util::logInfo("StemStream: Streaming " + path + " (" + std::to_string(stream->fileFrames_) + " frames, " +
+                  std::to_string(fmt.channels) + " ch, " + std::to_string(fmt.sampleRate) + " Hz" +
+                  (stream->resampler_ ? " -> " + std::to_string(stream->outRate_) + " Hz" : std::string()) + ", " +
+                  std::to_string(stream->storage_.size() >> 10) + " KiB buffer)");
+    StreamReader::instance().add(stream);
+    g_opened.fetch_add(1, std::memory_order_relaxed);
+    return stream;
+}
+
+StemStream::~StemStream() {
+    if (underruns() > reportedUnderruns_) {
+        g_underruns.fetch_add(underruns() - reportedUnderruns_, std::memory_order_relaxed);
+    }
+}
+
+void StemStream::setBlockingReads(bool blocking) { g_blockingReads.store(blocking); }
+
+StemStream::Stats StemStream::stats() { return StreamReader::instance().stats(); }
+
+std::string StemStream::statsLine() {
+    const Stats s = stats();
+    std::ostringstream ss;
+    ss << "stem streams: " << s.streams << " open (" << s.opened << " opened), " << (s.bufferBytes >> 10) << " KiB buffered, " << s.underruns
+       << " underrun(s)";
+    return ss.str();
+}
+
+bool StemStream::fill() {
+    if (eof_.load(std::memory_order_relaxed)) return false;
+
+    const size_t channels = fmt_.channels;
+    const size_t bytesPerSample = fmt_.bitsPerSample / 8;
+    const size_t frameBytes = channels * bytesPerSample;
+    uint64_t write = writePos_.load(std::memory_order_relaxed);
+    bool first = true;
+
+    for (;;) {
+        const size_t space = capacity_ - static_cast<size_t>(write - readPos_.load(std::memory_order_acquire));
+        if (space == 0 || (first && space < kMinFillFrames && write != 0)) return true;
+        first = false;
+
+        if (resampler_) {
+            // Drain converted frames first; read more only when it starves.
+            // A one-shot ends at its converted length, not after the flush.
+            const size_t left = loop_ ? space : std::min<size_t>(space, outFrames_ - static_cast<size_t>(write));
+            const size_t n = left > 0 ? resampler_->pull(ring_, capacity_, write, left) : 0;
+            if (n > 0) {
+                write += n;
+                writePos_.store(write, std::memory_order_release);
+                continue;
+            }
+            if (flushed_ || (!loop_ && left == 0)) {
+                eof_.store(true, std::memory_order_release);
+                return false;
+            }
+        }
+
+        if (nextFrame_ >= fileFrames_) {
+            if (!loop_) {
+                if (resampler_) {
+                    // Push silence through so the last frames come out.
+                    std::fill(staged_.begin(), staged_.end(), 0.0f);
+                    const float* planes[kMaxStreamChannels];
+                    for (size_t c = 0; c < channels; ++c) planes[c] = staged_.data() + c * kChunkFrames;
+                    resampler_->push(planes, kChunkFrames / 2);
+                    flushed_ = true;
+                    continue;
+                }
+                eof_.store(true, std::memory_order_release);
+                return false;
+            }
+            // Loop: carry on from the top of the data chunk, straight after
+            // the last frame, so the wrap is seamless.
+            nextFrame_ = 0;
+            if (decoder_) {
+                decoder_->rewind();
+            } else {
+                file_.clear();
+                file_.seekg(static_cast<std::streamoff>(fmt_.dataOffset));
+            }
+        }
+
+        const size_t n = resampler_ ? std::min(kChunkFrames, fileFrames_ - nextFrame_)
+                                    : std::min({space, kChunkFrames, fileFrames_ - nextFrame_});
+        if (decoder_) {
+            // Codec lengths can be estimates; pad a short read with silence
+            // so the stream keeps the length it was opened with.
+            const size_t got = decoder_->read(chunk_.data(), n);
+            if (got < n) std::fill(chunk_.begin() + static_cast<std::ptrdiff_t>(got * frameBytes),
+                                   chunk_.begin() + static_cast<std::ptrdiff_t>(n * frameBytes), uint8_t{0});
+        } else {
+            file_.read(reinterpret_cast<char*>(chunk_.data()), static_cast<std::streamsize>(n * frameBytes));
+            if (static_cast<size_t>(file_.gcount()) != n * frameBytes) {
+                util::logError("StemStream: Read failed at frame " + std::to_string(nextFrame_) + " of " + path_);
+                eof_.store(true, std::memory_order_release);
+                return false;
+            }
+        }
+        nextFrame_ += n;
+
+        if (resampler_) {
+            const float* planes[kMaxStreamChannels];
+            for (size_t c = 0; c < channels; ++c) {
+                float* dst = staged_.data() + c * kChunkFrames;
+                for (size_t i = 0; i < n; ++i) {
+                    dst[i] = wavSampleToFloat(chunk_.data() + i * frameBytes + c * bytesPerSample, fmt_.bitsPerSample);
+                }
+                planes[c] = dst;
+            }
+            resampler_->push(planes, n);
+            continue;
+        }
+
+        // De-interleave into the planar ring.
+        for (size_t i = 0; i < n; ++i) {
+            const size_t pos = static_cast<size_t>((write + i) & (capacity_ - 1));
+            const uint8_t* frame = chunk_.data() + i * frameBytes;
+            for (size_t c = 0; c < channels; ++c) {
+                ring_[c * capacity_ + pos] = wavSampleToFloat(frame + c * bytesPerSample, fmt_.bitsPerSample);
+            }
+        }
+        write += n;
+        writePos_.store(write, std::memory_order_release);
+    }
+}
+
+uint64_t StemStream::waitForData(uint64_t read, size_t frames) const {
+    uint64_t available = writePos_.load(std::memory_order_acquire) - read;
+    if (!g_blockingReads.load(std::memory_order_relaxed)) return available;
+    while (available < frames && !eof_.load(std::memory_order_acquire)) {
+        StreamReader::instance().wake();
+        std::this_thread::yield();
+        available = writePos_.load(std::memory_order_acquire) - read;
+    }
+    return writePos_.load(std::memory_order_acquire) - read;
+}
+
+} // namespace audio
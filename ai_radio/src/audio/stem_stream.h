@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "audio_decoder.h"
+#include "resampler.h"
+#include "sample_storage.h"
+#include "wav_format.h"
+
+namespace audio {
+
+// Plays a WAV (or FLAC/MP3/Vorbis, decoded as it goes) straight from disk
+// for beds too long to decode into memory.
+// A shared reader thread keeps a per-stream ring of kBufferSeconds of
+// planar float audio filled ahead of the play head; looping streams wrap
+// back to the start of the data chunk in the reader, so the ring is one
+// continuous signal and the wrap is sample-exact. Files at another rate
+// than the engine's are resampled incrementally by the reader.
+//
+// The ring is single-producer (the reader, or open() while prefilling) /
+// single-consumer (whichever thread renders the owning StemPlayer). The
+// consumer side never locks or allocates. If the ring runs dry before the
+// end of a non-looping file, the missing frames are left silent and an
+// underrun is counted.
+class StemStream {
+public:
+    static constexpr float kBufferSeconds = 4.0f;
+
+    struct Stats {
+        size_t streams = 0;       // open now
+        uint64_t opened = 0;      // since start
+        uint64_t underruns = 0;   // since start, all streams
+        size_t bufferBytes = 0;   // ring memory of open streams
+    };
+
+    // Opens path, prefills the ring and hands the stream to the reader
+    // thread; a non-zero outputRate resamples to it. Returns nullptr (and
+    // logs) on failure. Not for the audio thread.
+    static std::shared_ptr<StemStream> open(const std::string& path, bool loop, uint32_t outputRate = 0);
+
+    // Offline renders (keegan_render) run faster than the disk may keep up:
+    // with blocking reads the consumer waits for the reader instead of
+    // underrunning. Not real-time safe; off by default.
+    static void setBlockingReads(bool blocking);
+
+    static Stats stats();
+    static std::string statsLine();
+
+    ~StemStream();
+
+    StemStream(const StemStream&) = delete;
+    StemStream& operator=(const StemStream&) = delete;
+
+    uint16_t channels() const { return fmt_.channels; }
+    // Rate of the frames consume() hands out.
+    uint32_t sampleRate() const { return outRate_; }
+    // Frames per channel at that rate.
+    size_t frames() const { return outFrames_; }
+    bool looping() const { return loop_; }
+
+    // A non-looping stream that has played everything.
+    bool finished() const {
+        return eof_.load(std::memory_order_acquire) &&
+               readPos_.load(std::memory_order_relaxed) == writePos_.load(std::memory_order_acquire);
+    }
+    uint64_t underruns() const { return underruns_.load(std::memory_order_relaxed); }
+
+    // Ring channel c; consume() hands out offsets into it.
+    const float* channel(size_t c) const { return ring_ + c * capacity_; }
+
+    // Consumer: takes up to `frames` buffered frames, calling
+    // fn(outOffset, ringOffset, count) for each contiguous run (at most two,
+    // split at the ring wrap). Returns the frames taken.
+    template <typename Fn>
+    size_t consume(size_t frames, Fn&& fn) {
+        const uint64_t read = readPos_.load(std::memory_order_relaxed);
+        uint64_t available = writePos_.load(std::memory_order_acquire) - read;
+        if (available < frames) available = waitForData(read, frames);
+        const size_t take = static_cast<size_t>(std::min<uint64_t>(available, frames));
+        if (take < frames && !eof_.load(std::memory_order_acquire)) {
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+        size_t done = 0;
+        while (done < take) {
+            const size_t pos = static_cast<size_t>((read + done) & (capacity_ - 1));
+            const size_t n = std::min(take - done, capacity_ - pos);
+            fn(done, pos, n);
+            done += n;
+        }
+        readPos_.store(read + take, std::memory_order_release);
+        return take;
+    }
+
+private:
+    StemStream() = default;
+
+    friend class StreamReader;
+
+    // Producer: tops up the ring from the file. Returns false once there is
+    // nothing left to read.
+    bool fill();
+    // Only waits with blocking reads on; returns the frames now buffered.
+    uint64_t waitForData(uint64_t read, size_t frames) const;
+
+    std::string path_;
+    std::ifstream file_;
+    std::unique_ptr<AudioDecoder> decoder_; // compressed files instead of file_
+    WavFormat fmt_;
+    size_t fileFrames_ = 0;
+    size_t nextFrame_ = 0; // producer's position in the file
+    bool loop_ = true;
+    uint32_t outRate_ = 0;
+    size_t outFrames_ = 0;
+
+    // Set when the file rate differs from the output rate.
+    std::unique_ptr<ResamplerStream> resampler_;
+    std::vector<float> staged_; // planar float input for the resampler
+    bool flushed_ = false;      // non-looping tail pushed through
+
+    SampleStorage storage_;
+    float* ring_ = nullptr;
+    size_t capacity_ = 0; // frames, power of two
+    std::vector<uint8_t> chunk_; // producer's read buffer
+
+    std::atomic<uint64_t> writePos_{0};
+    std::atomic<uint64_t> readPos_{0};
+    std::atomic<bool> eof_{false};
+    std::atomic<uint64_t> underruns_{0};
+    uint64_t reportedUnderruns_ = 0; // reader thread only
+};
+
+} // namespace audio
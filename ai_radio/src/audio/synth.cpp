@@ -0,0 +1,386 @@
+#include "synth.h"
+#include "asset_pack.h"
+#include "fastmath.h"
+#include "../util/logger.h"
+#include "../../vendor/vjson/vjson.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace audio {
+
+namespace {
+constexpr float kPi = 3.1415926535f;
+// Release ends (and the voice is freed) below this level, about -80 dB.
+constexpr float kSilent = 1e-4f;
+
+float getNumber(const vjson::Value &obj, const std::string &key, float def) {
+    if (!obj.has(key)) return def;
+    return obj[key].asFloat(def);
+}
+
+// Oscillator output for phase p in [0, 1) advancing dt cycles per sample.
+// The triangle and saw are band-limited with 2-point polynomial residuals:
+// PolyBLEP for the saw's step, its integral (PolyBLAMP) for the triangle's
+// corners. No branches, so the voice loops still vectorise.
+struct Wave {
+    float sine, triangle, saw;
+
+    float operator()(float p, float invDt, float dt) const {
+        // t: time to the nearest wrap in samples; u = 1 - |t|, 0 beyond one
+        // sample. Likewise h for the triangle's peak at p = 0.5.
+        const float t = (p < 0.5f ? p : p - 1.0f) * invDt;
+        const float u = 1.0f - std::min(std::fabs(t), 1.0f);
+        const float h = 1.0f - std::min(std::fabs((p - 0.5f) * invDt), 1.0f);
+        // Unit-step residual, +u^2 / 2 before the step and -u^2 / 2 after;
+        // the saw steps down by 2.
+        const float blep = std::copysign(0.5f * u * u, -t);
+        // Triangle slopes change by +-8 dt per sample; the BLAMP residual
+        // of a unit change is u^3 / 6.
+        const float blamp = (8.0f / 6.0f) * dt * (u * u * u - h * h * h);
+        return sine * fastmath::sin(2.0f * kPi * p) + triangle * (1.0f - 4.0f * std::fabs(p - 0.5f) + blamp) +
+               saw * (2.0f * p - 1.0f - 2.0f * blep);
+    }
+};
+
+// Phase step for the residuals: its magnitude (FM can run the phase
+// backwards), held at 0.5, where the two edges' residuals would overlap.
+inline float residualDt(float dt) { return std::clamp(std::fabs(dt), 1e-7f, 0.5f); }
+
+inline float wrap(float p) { return p - std::floor(p); }
+
+// Per-sample multiplier that decays to -60 dB in `seconds`.
+float decayCoefficient(float seconds, float sampleRate) {
+    return std::exp(std::log(0.001f) / std::max(seconds * sampleRate, 1.0f));
+}
+} // namespace
+
+bool SynthPatch::load(const std::string &path, SynthPatch &out) {
+    std::string data;
+    if (!AssetPack::findText(path, data)) {
+        std::ifstream f(path);
+        if (!f.good()) {
+            util::logWarn("SynthPatch: Preset not found: " + path);
+            return false;
+        }
+        std::stringstream ss;
+        ss << f.rdbuf();
+        data = ss.str();
+    }
+    auto root = vjson::parse(data);
+    if (!root || !root->isObject()) {
+        util::logError("SynthPatch: Invalid JSON in " + path);
+        return false;
+    }
+    const vjson::Value &obj = *root;
+
+    SynthPatch p;
+    p.name = obj["name"].asString(path);
+    if (obj.has("wave") && obj["wave"].isObject()) {
+        const auto &wave = obj["wave"];
+        p.sine = std::max(0.0f, getNumber(wave, "sine", 0.0f));
+        p.triangle = std::max(0.0f, getNumber(wave, "triangle", 0.0f));
+        p.saw = std::max(0.0f, getNumber(wave, "saw", 0.0f));
+        const float sum = p.sine + p.triangle + p.saw;
+        if (sum <= 0.0f) {
+            p.sine = 1.0f;
+        } else {
+            p.sine /= sum;
+            p.triangle /= sum;
+            p.saw /= sum;
+        }
+    }
+    if (obj.has("fm") && obj["fm"].isObject()) {
+        p.fmRatio = std::clamp(getNumber(obj["fm"], "ratio", p.fmRatio), 0.125f, 16.0f);
+        p.fmIndex = std::clamp(getNumber(obj["fm"], "index", p.fmIndex), 0.0f, 4.0f);
+    }
+    p.unison = std::clamp(obj["unison"].asInt(p.unison), 1, 8);
+    p.detuneCents = std::clamp(getNumber(obj, "detune_cents", p.detuneCents), 0.0f, 100.0f);
+    p.stereoSpread = std::clamp(getNumber(obj, "stereo_spread", p.stereoSpread), 0.0f, 1.0f);
+    if (obj.has("envelope") && obj["envelope"].isObject()) {
+        const auto &env = obj["envelope"];
+        p.attack = std::clamp(getNumber(env, "attack", p.attack), 0.001f, 30.0f);
+        p.decay = std::clamp(getNumber(env, "decay", p.decay), 0.01f, 30.0f);
+        p.sustain = std::clamp(getNumber(env, "sustain", p.sustain), 0.0f, 1.0f);
+        p.release = std::clamp(getNumber(env, "release", p.release), 0.01f, 30.0f);
+    }
+    if (obj.has("scale") && obj["scale"].isObject()) {
+        const auto &scale = obj["scale"];
+        p.root = std::clamp(scale["root"].asInt(p.root), 12, 108);
+        if (scale.has("intervals") && scale["intervals"].isArray()) {
+            std::vector<int> intervals;
+            for (const auto &v : scale["intervals"].asArray()) intervals.push_back(std::clamp(v.asInt(0), 0, 24));
+            if (!intervals.empty()) p.intervals = std::move(intervals);
+        }
+        p.octaves = std::clamp(scale["octaves"].asInt(p.octaves), 1, 5);
+    }
+    if (obj.has("pattern") && obj["pattern"].isObject()) {
+        const auto &pattern = obj["pattern"];
+        p.tempoBpm = std::clamp(getNumber(pattern, "tempo_bpm", p.tempoBpm), 10.0f, 300.0f);
+        p.stepBeats = std::clamp(getNumber(pattern, "step_beats", p.stepBeats), 0.0625f, 16.0f);
+        p.noteBeats = std::clamp(getNumber(pattern, "note_beats", p.noteBeats), 0.0625f, 64.0f);
+        p.chordMin = std::clamp(pattern["chord_min"].asInt(p.chordMin), 1, 8);
+        p.chordMax = std::clamp(pattern["chord_max"].asInt(p.chordMax), p.chordMin, 8);
+    }
+    p.gain = std::pow(10.0f, std::clamp(getNumber(obj, "gain_db", -12.0f), -60.0f, 6.0f) / 20.0f);
+    p.lowpassHz = std::clamp(getNumber(obj, "lowpass_hz", p.lowpassHz), 0.0f, 20000.0f);
+    p.loaded = true;
+    out = std::move(p);
+    return true;
+}
+
+ProceduralSynth::ProceduralSynth(float sampleRate, size_t maxFrames)
+    : sampleRate_(sampleRate), voiceBuf_(maxFrames, 0.0f), mix_(2, maxFrames) {}
+
+void ProceduralSynth::setPatch(const SynthPatch *patch, uint32_t seed, float patternDensity) {
+    patch_ = (patch && patch->loaded) ? patch : nullptr;
+    patternDensity_ = std::clamp(patternDensity, 0.0f, 1.0f);
+    rng_ = seed * 2654435761u + 1u;
+    samplesToStep_ = 0.0;
+    active_ = 0;
+    lpState_[0] = lpState_[1] = 0.0f;
+    if (!patch_) return;
+
+    attackStep_ = 1.0f / std::max(patch_->attack * sampleRate_, 1.0f);
+    const float decay = decayCoefficient(patch_->decay, sampleRate_);
+    const float release = decayCoefficient(patch_->release, sampleRate_);
+    decayPow_[0] = releasePow_[0] = 1.0f;
+    for (size_t n = 1; n <= kControlFrames; ++n) {
+        decayPow_[n] = decayPow_[n - 1] * decay;
+        releasePow_[n] = releasePow_[n - 1] * release;
+    }
+    lpCoef_ = patch_->lowpassHz > 0.0f ? 1.0f - std::exp(-2.0f * kPi * patch_->lowpassHz / sampleRate_) : 0.0f;
+}
+
+uint32_t ProceduralSynth::nextRandom() {
+    rng_ = rng_ * 1664525u + 1013904223u;
+    return rng_;
+}
+
+size_t ProceduralSynth::allocateVoice() {
+    if (active_ < kMaxVoices) return active_++;
+    // Full: steal the quietest voice, preferring ones already releasing.
+    size_t best = 0;
+    float bestScore = 2.0f;
+    for (size_t v = 0; v < active_; ++v) {
+        const float score = voices_.env[v] - (voices_.stage[v] == Release ? 1.0f : 0.0f);
+        if (score < bestScore) {
+            bestScore = score;
+            best = v;
+        }
+    }
+    return best;
+}
+
+void ProceduralSynth::removeVoice(size_t v) {
+    const size_t last = --active_;
+    if (v == last) return;
+    voices_.phase[v] = voices_.phase[last];
+    voices_.inc[v] = voices_.inc[last];
+    voices_.modPhase[v] = voices_.modPhase[last];
+    voices_.modInc[v] = voices_.modInc[last];
+    voices_.env[v] = voices_.env[last];
+    voices_.gainL[v] = voices_.gainL[last];
+    voices_.gainR[v] = voices_.gainR[last];
+    voices_.hold[v] = voices_.hold[last];
+    voices_.delay[v] = voices_.delay[last];
+    voices_.stage[v] = voices_.stage[last];
+}
+
+void ProceduralSynth::noteOn(float midiNote, float velocity, float holdSeconds, size_t offset) {
+    if (!patch_) return;
+    const int unison = patch_->unison;
+    const float gain = patch_->gain * velocity / std::sqrt(static_cast<float>(unison));
+    for (int u = 0; u < unison; ++u) {
+        // -1..1 across the unison stack (0 for a single voice).
+        const float spread = unison > 1 ? 2.0f * static_cast<float>(u) / static_cast<float>(unison - 1) - 1.0f : 0.0f;
+        const float note = midiNote + spread * patch_->detuneCents * 0.01f;
+        const float freq = 440.0f * std::exp2((note - 69.0f) / 12.0f);
+        const float pan = std::clamp(spread * patch_->stereoSpread, -1.0f, 1.0f);
+        const float angle = (pan + 1.0f) * 0.25f * kPi; // equal power
+
+        const size_t v = allocateVoice();
+        voices_.phase[v] = randomUnit();
+        voices_.inc[v] = freq / sampleRate_;
+        voices_.modPhase[v] = 0.0f;
+        voices_.modInc[v] = voices_.inc[v] * patch_->fmRatio;
+        voices_.env[v] = 0.0f;
+        voices_.gainL[v] = gain * std::cos(angle);
+        voices_.gainR[v] = gain * std::sin(angle);
+        voices_.hold[v] = static_cast<int32_t>(std::min(holdSeconds * sampleRate_, 2.0e9f));
+        voices_.delay[v] = static_cast<uint32_t>(offset);
+        voices_.stage[v] = Attack;
+    }
+}
+
+void ProceduralSynth::releaseAll() {
+    for (size_t v = 0; v < active_; ++v) voices_.stage[v] = Release;
+}
+
+void ProceduralSynth::triggerStep(size_t offset, float density) {
+    const float chance = std::clamp(patternDensity_ * (0.5f + density), 0.0f, 1.0f);
+    if (randomUnit() >= chance) return;
+
+    const SynthPatch &p = *patch_;
+    const int span = p.chordMax - p.chordMin + 1;
+    const int notes = p.chordMin + static_cast<int>(nextRandom() % static_cast<uint32_t>(span));
+    const size_t degrees = p.intervals.size() * static_cast<size_t>(p.octaves);
+    const float hold = 60.0f / p.tempoBpm * p.noteBeats;
+    for (int n = 0; n < notes; ++n) {
+        const size_t degree = nextRandom() % degrees;
+        const int note = p.root + 12 * static_cast<int>(degree / p.intervals.size()) +
+                         p.intervals[degree % p.intervals.size()];
+        noteOn(static_cast<float>(note), 0.6f + 0.4f * randomUnit(), hold, offset);
+    }
+}
+
+bool ProceduralSynth::renderVoice(size_t v, size_t begin, size_t frames) {
+    const SynthPatch &p = *patch_;
+    const Wave wave{p.sine, p.triangle, p.saw};
+    const bool edges = p.triangle != 0.0f || p.saw != 0.0f;
+    const float fm = p.fmIndex;
+    float phase = voices_.phase[v];
+    float modPhase = voices_.modPhase[v];
+    const float inc = voices_.inc[v];
+    const float modInc = voices_.modInc[v];
+    float env = voices_.env[v];
+    uint8_t stage = voices_.stage[v];
+    int32_t hold = voices_.hold[v];
+    float *buf = voiceBuf_.data();
+
+    for (size_t pos = begin; pos < frames;) {
+        const size_t n = std::min(kControlFrames, frames - pos);
+
+        // Envelope at the end of this control block; the block ramps to it
+        // linearly.
+        float target = env;
+        switch (stage) {
+            case Attack:
+                target = env + attackStep_ * static_cast<float>(n);
+                if (target >= 1.0f) {
+                    target = 1.0f;
+                    stage = Decay;
+                }
+                break;
+            case Decay:
+                target = p.sustain + (env - p.sustain) * decayPow_[n];
+                if (std::fabs(target - p.sustain) < kSilent) {
+                    target = p.sustain;
+                    stage = Sustain;
+                }
+                break;
+            case Sustain:
+                break;
+            case Release:
+                target = env * releasePow_[n];
+                break;
+        }
+        hold -= static_cast<int32_t>(n);
+        if (hold <= 0 && stage != Release) stage = Release;
+        const float envStep = (target - env) / static_cast<float>(n);
+
+        // Closed-form phases: no state carried from one sample to the next.
+        float *out = buf + pos;
+        auto fill = [&](const auto &shape) {
+            if (fm > 0.0f) {
+                // mod[i + 1] is the modulator at sample i; the residuals
+                // take the phase step from the sample before.
+                float mod[kControlFrames + 1];
+                for (size_t i = 0; i <= n; ++i) {
+                    const float fi = static_cast<float>(i) - 1.0f;
+                    mod[i] = fm * fastmath::sin(2.0f * kPi * wrap(modPhase + fi * modInc));
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    const float fi = static_cast<float>(i);
+                    const float ph = wrap(phase + fi * inc + mod[i + 1]);
+                    const float dt = residualDt(inc + mod[i + 1] - mod[i]);
+                    out[i] = shape(ph, 1.0f / dt, dt) * (env + fi * envStep);
+                }
+            } else {
+                const float dt = residualDt(inc);
+                const float invDt = 1.0f / dt;
+                for (size_t i = 0; i < n; ++i) {
+                    const float fi = static_cast<float>(i);
+                    const float ph = wrap(phase + fi * inc);
+                    out[i] = shape(ph, invDt, dt) * (env + fi * envStep);
+                }
+            }
+        };
+        // Sine-only patches skip the residuals (and, with FM, the rate).
+        if (edges) {
+            fill(wave);
+        } else {
+            fill([&](float ph, float, float) { return p.sine * fastmath::sin(2.0f * kPi * ph); });
+        }
+        phase = wrap(phase + static_cast<float>(n) * inc);
+        modPhase = wrap(modPhase + static_cast<float>(n) * modInc);
+        env = target;
+        pos += n;
+
+        if (stage == Release && env < kSilent) {
+            std::fill(buf + pos, buf + frames, 0.0f);
+            return false;
+        }
+    }
+
+    voices_.phase[v] = phase;
+    voices_.modPhase[v] = modPhase;
+    voices_.env[v] = env;
+    voices_.stage[v] = stage;
+    voices_.hold[v] = hold;
+    return true;
+}
+
+void ProceduralSynth::render(AudioBus &out, size_t frames, float density) {
+    frames = std::min(frames, voiceBuf_.size());
+    if (!patch_) return;
+
+    // Steps that fall inside this block start their voices at the exact
+    // sample, through the voice delay.
+    const double stepFrames = 60.0 / patch_->tempoBpm * patch_->stepBeats * sampleRate_;
+    while (samplesToStep_ < static_cast<double>(frames)) {
+        triggerStep(static_cast<size_t>(samplesToStep_), density);
+        samplesToStep_ += stepFrames;
+    }
+    samplesToStep_ -= static_cast<double>(frames);
+    if (active_ == 0) return;
+
+    const auto &k = simd::kernels();
+    mix_.clear(frames);
+    float *left = mix_.channel(0);
+    float *right = mix_.channel(1);
+    for (size_t v = 0; v < active_;) {
+        const size_t begin = std::min<size_t>(voices_.delay[v], frames);
+        voices_.delay[v] -= static_cast<uint32_t>(begin);
+        if (begin == frames) {
+            ++v;
+            continue;
+        }
+        const bool alive = renderVoice(v, begin, frames);
+        k.mixAdd(left + begin, voiceBuf_.data() + begin, voices_.gainL[v], frames - begin);
+        k.mixAdd(right + begin, voiceBuf_.data() + begin, voices_.gainR[v], frames - begin);
+        if (alive) {
+            ++v;
+        } else {
+            removeVoice(v); // the last voice moves into v; render it next
+        }
+    }
+
+    if (lpCoef_ > 0.0f) {
+        for (size_t c = 0; c < 2; ++c) {
+            float *buf = mix_.channel(c);
+            float z = lpState_[c];
+            for (size_t i = 0; i < frames; ++i) {
+                z += lpCoef_ * (buf[i] - z);
+                buf[i] = z;
+            }
+            lpState_[c] = z;
+        }
+    }
+
+    k.mixAdd(out.channel(0), left, 1.0f, frames);
+    if (out.channels() > 1) k.mixAdd(out.channel(1), right, 1.0f, frames);
+}
+
+} // namespace audio
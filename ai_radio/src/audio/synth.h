@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "bus.h"
+
+namespace audio {
+
+// A synth preset (assets/presets/*.json): voice timbre, envelope, scale and
+// the step pattern ProceduralSynth plays it with. Loaded on a control
+// thread; the audio thread only reads it.
+struct SynthPatch {
+    std::string name;
+    // Oscillator mix (normalised at load) and two-operator FM; the
+    // modulator runs at fmRatio times the note frequency.
+    float sine = 1.0f;
+    float triangle = 0.0f;
+    float saw = 0.0f;
+    float fmRatio = 2.0f;
+    float fmIndex = 0.0f;
+    // Each note is `unison` voices spread over +-detuneCents and panned
+    // across +-stereoSpread.
+    int unison = 1;
+    float detuneCents = 0.0f;
+    float stereoSpread = 0.5f;
+    // Envelope in seconds; decay and release are exponential (time to -60 dB).
+    float attack = 0.5f;
+    float decay = 1.0f;
+    float sustain = 0.7f;
+    float release = 2.0f;
+    // Notes come from `intervals` (semitones) above MIDI `root`, over
+    // `octaves` octaves.
+    int root = 48;
+    std::vector<int> intervals{0, 2, 4, 7, 9};
+    int octaves = 2;
+    // Pattern: a step every stepBeats at tempoBpm triggers, with a
+    // probability set by the mood's pattern_density, a chord of chordMin to
+    // chordMax notes held for noteBeats.
+    float tempoBpm = 60.0f;
+    float stepBeats = 1.0f;
+    float noteBeats = 2.0f;
+    int chordMin = 1;
+    int chordMax = 2;
+    float gain = 0.25f;      // linear, from gain_db
+    float lowpassHz = 0.0f;  // one-pole on the synth's output; 0 is off
+
+    bool loaded = false;
+
+    // Reads a preset (from a mounted AssetPack if one has it). Missing keys
+    // keep their defaults; logs and returns false if the file is missing or
+    // not a JSON object.
+    static bool load(const std::string &path, SynthPatch &out);
+};
+
+// Polyphonic procedural synth: a seeded step pattern plays a SynthPatch
+// through a fixed pool of voices. Voice state is structure-of-arrays and
+// preallocated, so note-on, stealing and rendering never allocate. Each
+// voice renders in control blocks of kControlFrames with its envelope
+// ramped linearly and its phases in closed form (phase0 + i * inc), so the
+// per-sample loop has no loop-carried state and vectorises; voices are
+// summed with the SIMD mix kernels.
+class ProceduralSynth {
+public:
+    static constexpr size_t kMaxVoices = 256;
+    static constexpr size_t kControlFrames = 32;
+
+    // Not real-time safe (allocates the scratch buses).
+    ProceduralSynth(float sampleRate, size_t maxFrames);
+
+    // Audio thread. Switches to patch (which must outlive its use; nullptr
+    // silences the synth) and restarts the pattern from seed. Sounding
+    // voices are dropped, so switch under a crossfade.
+    void setPatch(const SynthPatch *patch, uint32_t seed, float patternDensity);
+    const SynthPatch *patch() const { return patch_; }
+
+    // Audio thread. Adds `frames` (<= maxFrames) of the pattern to out
+    // (mono buses get the left channel). density scales how often steps
+    // trigger, like the stem density.
+    void render(AudioBus &out, size_t frames, float density);
+
+    // Starts a voice per unison copy at sample `offset` of the next render;
+    // the pool steals the quietest voice when full.
+    void noteOn(float midiNote, float velocity, float holdSeconds, size_t offset = 0);
+    // Moves every voice to its release stage.
+    void releaseAll();
+
+    size_t activeVoices() const { return active_; }
+
+private:
+    enum Stage : uint8_t { Attack, Decay, Sustain, Release };
+
+    // Per-voice state, one array per field, index < active_ live.
+    struct Voices {
+        std::array<float, kMaxVoices> phase;    // [0, 1)
+        std::array<float, kMaxVoices> inc;      // cycles per sample
+        std::array<float, kMaxVoices> modPhase;
+        std::array<float, kMaxVoices> modInc;
+        std::array<float, kMaxVoices> env;
+        std::array<float, kMaxVoices> gainL;
+        std::array<float, kMaxVoices> gainR;
+        std::array<int32_t, kMaxVoices> hold;   // samples left before release
+        std::array<uint32_t, kMaxVoices> delay; // samples into the next render
+        std::array<uint8_t, kMaxVoices> stage;
+    };
+
+    size_t allocateVoice();
+    void removeVoice(size_t v);
+    void triggerStep(size_t offset, float density);
+    // Renders voice v's [begin, frames) into voiceBuf_; false once it has
+    // fully released.
+    bool renderVoice(size_t v, size_t begin, size_t frames);
+    uint32_t nextRandom();
+    float randomUnit() { return static_cast<float>(nextRandom() >> 8) / 16777216.0f; }
+
+    float sampleRate_;
+    const SynthPatch *patch_ = nullptr;
+    float patternDensity_ = 0.0f;
+    uint32_t rng_ = 1;
+    double samplesToStep_ = 0.0;
+
+    // From the patch, per sample or per control block.
+    float attackStep_ = 0.0f;
+    std::array<float, kControlFrames + 1> decayPow_{};   // decay coefficient^n
+    std::array<float, kControlFrames + 1> releasePow_{};
+    float lpCoef_ = 0.0f;
+    float lpState_[2] = {0.0f, 0.0f};
+
+    Voices voices_{};
+    size_t active_ = 0;
+    std::vector<float> voiceBuf_;
+    AudioBus mix_;
+};
+
+} // namespace audio
@@ -0,0 +1,65 @@
+#include "wav_format.h"
+#include "../util/logger.h"
+#include <algorithm>
+
+namespace audio {
+
+namespace {
+// WAV file format constants
+constexpr uint32_t RIFF_ID = 0x46464952;  // "RIFF"
+constexpr uint32_t WAVE_ID = 0x45564157;  // "WAVE"
+constexpr uint32_t FMT_ID  = 0x20746D66;  // "fmt "
+constexpr uint32_t DATA_ID = 0x61746164;  // "data"
+
+template<typename T>
+T readLE(const uint8_t* data) {
+    T result = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        result |= static_cast<T>(data[i]) << (8 * i);
+    }
+    return result;
+}
+} // namespace
+
+bool parseWavHeader(const uint8_t* data, size_t available, size_t fileSize, WavFormat& fmt) {
+    if (available < 44) return false;
+
+    // Check RIFF header
+    if (readLE<uint32_t>(&data[0]) != RIFF_ID) return false;
+    if (readLE<uint32_t>(&data[8]) != WAVE_ID) return false;
+
+    // Find fmt chunk
+    size_t pos = 12;
+    bool foundFmt = false;
+    while (pos + 8 <= available) {
+        uint32_t chunkId = readLE<uint32_t>(&data[pos]);
+        uint32_t chunkSize = readLE<uint32_t>(&data[pos + 4]);
+
+        if (chunkId == FMT_ID) {
+            if (chunkSize < 16 || pos + 8 + chunkSize > available) return false;
+
+            uint16_t audioFormat = readLE<uint16_t>(&data[pos + 8]);
+            if (audioFormat != 1 && audioFormat != 3) {
+                util::logError("WAV: Unsupported audio format (only PCM/float supported)");
+                return false;
+            }
+
+            fmt.channels = readLE<uint16_t>(&data[pos + 10]);
+            fmt.sampleRate = readLE<uint32_t>(&data[pos + 12]);
+            fmt.bitsPerSample = readLE<uint16_t>(&data[pos + 22]);
+            foundFmt = true;
+        } else if (chunkId == DATA_ID) {
+            if (!foundFmt) return false;
+            fmt.dataOffset = pos + 8;
+            fmt.dataSize = std::min<size_t>(chunkSize, fileSize - std::min(fileSize, fmt.dataOffset));
+            return true;
+        }
+
+        pos += 8 + static_cast<size_t>(chunkSize);
+        if (chunkSize % 2 == 1) pos++; // Padding byte
+    }
+
+    return false;
+}
+
+} // namespace audio
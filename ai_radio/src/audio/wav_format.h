@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace audio {
+
+// Layout of a PCM/float WAV file, as found by parseWavHeader.
+struct WavFormat {
+    uint16_t channels = 0;
+    uint32_t sampleRate = 0;
+    uint16_t bitsPerSample = 0;
+    size_t dataOffset = 0; // from the start of the file
+    size_t dataSize = 0;   // bytes, clipped to the file size
+};
+
+// Parses the RIFF header from the first `available` bytes of a file of
+// `fileSize` bytes (pass the same value twice for a whole-file buffer).
+// The data chunk must start within `available`. Logs unsupported formats.
+bool parseWavHeader(const uint8_t* data, size_t available, size_t fileSize, WavFormat& fmt);
+
+// One little-endian WAV sample as float (8-bit unsigned, 16/24-bit signed,
+// 32-bit float); other widths read as silence.
+inline float wavSampleToFloat(const uint8_t* p, uint16_t bitsPerSample) {
+    switch (bitsPerSample) {
+        case 8:
+            return (static_cast<float>(p[0]) - 128.0f) / 128.0f;
+        case 16:
+            return static_cast<float>(static_cast<int16_t>(p[0] | (p[1] << 8))) / 32768.0f;
+        case 24: {
+            const int32_t v = static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 8 | static_cast<uint32_t>(p[1]) << 16 |
+                                                   static_cast<uint32_t>(p[2]) << 24) >> 8;
+            return static_cast<float>(v) / 8388608.0f;
+        }
+        case 32: {
+            float v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        default:
+            return 0.0f;
+    }
+}
+
+} // namespace audio
@@ -0,0 +1,141 @@
+#include "worker_pool.h"
+#include "../util/logger.h"
+#include <algorithm>
+#include <chrono>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace audio {
+
+namespace {
+inline void cpuRelax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+constexpr uint64_t kIndexMask = 0xffff;
+
+inline uint64_t taskIndex(uint64_t word) { return word & kIndexMask; }
+inline uint64_t taskCount(uint64_t word) { return (word >> 16) & kIndexMask; }
+
+bool pinThread(std::thread &t, unsigned cpu) {
+#if defined(_WIN32)
+    return SetThreadAffinityMask(t.native_handle(), DWORD_PTR(1) << (cpu % (8 * sizeof(DWORD_PTR)))) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(t.native_handle(), sizeof(set), &set) == 0;
+#else
+    (void)t;
+    (void)cpu;
+    return false;
+#endif
+}
+} // namespace
+
+RtWorkerPool::RtWorkerPool(size_t workers, int firstCpu, uint32_t spinMicros)
+    : spinMicros_(spinMicros) {
+    const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    threads_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        threads_.emplace_back([this] { workerLoop(); });
+        if (firstCpu >= 0) {
+            const unsigned cpu = (static_cast<unsigned>(firstCpu) + static_cast<unsigned>(i)) % cpus;
+            if (!pinThread(threads_.back(), cpu)) {
+                util::logWarn("RtWorkerPool: could not pin worker " + std::to_string(i) +
+                              " to CPU " + std::to_string(cpu));
+            }
+        }
+    }
+}
+
+RtWorkerPool::~RtWorkerPool() {
+    stop_.store(true, std::memory_order_release);
+    for (auto &t : threads_) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void RtWorkerPool::run(TaskFn fn, void *ctx, size_t count) {
+    count = std::min(count, kMaxTasks);
+    if (count == 0) return;
+    if (threads_.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) fn(ctx, i);
+        return;
+    }
+
+    fn_ = fn;
+    ctx_ = ctx;
+    done_.store(0, std::memory_order_relaxed);
+    ++generation_;
+    claim_.store((generation_ << 32) | (static_cast<uint64_t>(count) << 16),
+                 std::memory_order_release);
+
+    drain();
+
+    // Only tasks a worker has already claimed are outstanding here.
+    while (done_.load(std::memory_order_acquire) < count) cpuRelax();
+}
+
+bool RtWorkerPool::drain() {
+    bool ranAny = false;
+    uint64_t word = claim_.load(std::memory_order_acquire);
+    while (taskIndex(word) < taskCount(word)) {
+        if (!claim_.compare_exchange_weak(word, word + 1, std::memory_order_acq_rel,
+                                          std::memory_order_acquire)) {
+            continue; // word reloaded; re-check
+        }
+        fn_(ctx_, static_cast<size_t>(taskIndex(word)));
+        done_.fetch_add(1, std::memory_order_release);
+        ranAny = true;
+        word = claim_.load(std::memory_order_acquire);
+    }
+    return ranAny;
+}
+
+void RtWorkerPool::workerLoop() {
+    using Clock = std::chrono::steady_clock;
+    auto lastWork = Clock::now();
+    const auto spinWindow = std::chrono::microseconds(spinMicros_);
+    uint32_t polls = 0;
+
+    while (!stop_.load(std::memory_order_acquire)) {
+        if (drain()) {
+            lastWork = Clock::now();
+            polls = 0;
+            continue;
+        }
+        // While hot, read the clock only every 1024 polls.
+        if (++polls < 1024) {
+            cpuRelax();
+            continue;
+        }
+        const auto idle = Clock::now() - lastWork;
+        if (idle < spinWindow) {
+            polls = 0;
+        } else if (idle < spinWindow * 4) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
+
+} // namespace audio
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace audio {
+
+// Fork-join pool for the audio thread. Workers are started (and optionally
+// pinned to CPUs) up front; run() hands them work by bumping an atomic
+// and never makes a syscall, allocates or locks.
+//
+// The caller takes tasks too, and a task only runs once some thread has
+// claimed it, so run() never waits on a worker that is asleep or
+// descheduled before starting: at worst the caller does every task itself.
+// It only spins for tasks already in flight on a worker.
+//
+// Idle workers spin for spinMicros after their last task (so they are hot
+// for the next audio block), then yield, then sleep in short naps.
+class RtWorkerPool {
+public:
+    using TaskFn = void (*)(void *ctx, size_t task);
+
+    // firstCpu < 0 leaves the workers unpinned; otherwise worker i is pinned
+    // to CPU (firstCpu + i) modulo the CPU count.
+    explicit RtWorkerPool(size_t workers, int firstCpu = -1, uint32_t spinMicros = 20000);
+    ~RtWorkerPool();
+
+    RtWorkerPool(const RtWorkerPool &) = delete;
+    RtWorkerPool &operator=(const RtWorkerPool &) = delete;
+
+    size_t workers() const { return threads_.size(); }
+
+    static constexpr size_t kMaxTasks = 0xffff;
+
+    // Audio thread: runs fn(ctx, 0..count-1) across the workers and the
+    // calling thread and returns when all tasks are done. Not reentrant;
+    // count is capped at kMaxTasks.
+    void run(TaskFn fn, void *ctx, size_t count);
+
+private:
+    void workerLoop();
+    // Claims and runs tasks of the published generation until none are
+    // left. Returns true if it ran any.
+    bool drain();
+
+    // Generation (high 32 bits) | task count (16 bits) | next task (16 bits).
+    // Claiming is a CAS on the whole word, so a task can only be taken for
+    // the generation it was published with.
+    std::atomic<uint64_t> claim_{0};
+    std::atomic<size_t> done_{0};
+    std::atomic<bool> stop_{false};
+    // Written by run() before claim_ is published and left alone until
+    // every task of that generation is done.
+    TaskFn fn_ = nullptr;
+    void *ctx_ = nullptr;
+    uint64_t generation_ = 0;
+    uint32_t spinMicros_;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace audio
@@ -12,7 +12,8 @@ MoodRecipe makeMood(const std::string &id,
                     float warmth,
                     float color,
                     std::vector<float> density,
-                    std::vector<std::string> transitions) {
+                    std::vector<std::string> transitions,
+                    MoodDsp dsp) {
     MoodRecipe m;
     m.id = id;
     m.displayName = display;
@@ -24,6 +25,7 @@ MoodRecipe makeMood(const std::string &id,
     m.allowedTransitions = std::move(transitions);
     m.narrativeFrequency = 0.05f;
     m.synth = {"default", 0, 0.3f};
+    m.dsp = dsp;
     return m;
 }
 
@@ -31,14 +33,19 @@ MoodRecipe makeMood(const std::string &id,
 
 MoodPack defaultMoodPack() {
     MoodPack pack;
+    // dsp: reverb wet/decay/predelay, master LP, binaural L/R, shelf Hz
     pack.moods.push_back(makeMood("focus_room", "Focus Room", 0.55f, 0.35f, 0.55f, 0.6f,
-                                  {0.35f, 0.55f}, {"rain_cave", "arcade_night"}));
+                                  {0.35f, 0.55f}, {"rain_cave", "arcade_night"},
+                                  {0.2f, 0.4f, 15.0f, 12000.0f, 200.0f, 240.0f, 6000.0f}));
     pack.moods.push_back(makeMood("rain_cave", "Rain Cave", 0.35f, 0.25f, 0.45f, 0.3f,
-                                  {0.25f, 0.4f, 0.25f}, {"focus_room", "sleep_ship"}));
+                                  {0.25f, 0.4f, 0.25f}, {"focus_room", "sleep_ship"},
+                                  {0.5f, 0.7f, 40.0f, 16000.0f, 120.0f, 126.0f, 6000.0f}));
     pack.moods.push_back(makeMood("arcade_night", "Arcade Night", 0.7f, 0.5f, 0.35f, 0.8f,
-                                  {0.4f, 0.75f}, {"focus_room", "rain_cave"}));
+                                  {0.4f, 0.75f}, {"focus_room", "rain_cave"},
+                                  {0.25f, 0.3f, 10.0f, 18000.0f, 150.0f, 175.0f, 6000.0f}));
     pack.moods.push_back(makeMood("sleep_ship", "Sleep Ship", 0.2f, 0.2f, 0.6f, 0.1f,
-                                  {0.15f, 0.25f, 0.35f, 0.2f}, {"rain_cave"}));
+                                  {0.15f, 0.25f, 0.35f, 0.2f}, {"rain_cave"},
+                                  {0.35f, 0.6f, 30.0f, 6000.0f, 80.0f, 82.0f, 6000.0f}));
     return pack;
 }
 
@@ -70,6 +77,14 @@ void MoodStateMachine::setTargetMood(const std::string &moodId) {
     fadeProgress_ = 0.0f;
 }
 
+void MoodStateMachine::setCurrentMood(const std::string &moodId) {
+    auto idx = findIndex(moodId);
+    if (!idx.has_value()) return;
+    currentIndex_ = idx.value();
+    targetIndex_ = idx.value();
+    fadeProgress_ = 1.0f;
+}
+
 void MoodStateMachine::update(float dtSeconds) {
     if (currentIndex_ == targetIndex_) {
         fadeProgress_ = 1.0f;
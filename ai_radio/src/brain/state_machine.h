@@ -12,12 +12,29 @@ struct StemConfig {
     float gainDb{0.0f};
     bool loop{true};
     float probability{1.0f};
+    // Files larger than this are streamed from disk instead of decoded into
+    // memory; negative never streams.
+    float streamAboveMb{32.0f};
 };
 
 struct SynthPreset {
     std::string presetFile;
     int seed{0};
     float patternDensity{0.5f};
+    // Play the synth over the stems too, not only when the mood has none.
+    bool layer{false};
+};
+
+// Per-mood DSP settings ("dsp" object in moods.json). The engine compiles
+// these into a table indexed by mood and glides between them.
+struct MoodDsp {
+    float reverbWet{0.3f};
+    float reverbDecay{0.5f};
+    float reverbPreDelayMs{20.0f};
+    float masterLpHz{18000.0f};
+    float binauralLeftHz{200.0f};
+    float binauralRightHz{240.0f}; // 40Hz offset (Gamma)
+    float shelfHz{6000.0f};
 };
 
 struct MoodRecipe {
@@ -32,6 +49,11 @@ struct MoodRecipe {
     float warmth{0.0f};
     float tension{0.0f};
     float energy{0.0f};
+    MoodDsp dsp;
+    // dsp.reverb_ir: impulse response for the convolution reverb, which
+    // then replaces the FDN for this mood. Kept out of MoodDsp, which the
+    // audio thread copies every block.
+    std::string reverbIr;
 };
 
 struct MoodPack {
@@ -45,11 +67,14 @@ public:
     explicit MoodStateMachine(MoodPack pack);
 
     void setTargetMood(const std::string &moodId);
+    // Jump straight to a mood without fading (startup and offline renders).
+    void setCurrentMood(const std::string &moodId);
     void update(float dtSeconds);
 
     const MoodRecipe &currentRecipe() const { return pack_.moods[currentIndex_]; }
     const MoodRecipe &targetRecipe() const { return pack_.moods[targetIndex_]; }
     float crossfade() const { return fadeProgress_; }
+    float fadeDuration() const { return fadeDuration_; }
 
 private:
     MoodPack pack_;
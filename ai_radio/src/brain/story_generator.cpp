@@ -95,8 +95,8 @@ void StoryGenerator::runGeneration(GenRequest req) {
                  s->moodId = req.mood;
                  s->audioFile = wavPath; // The fake audio (Phase 3 Part 1 limitation)
 
-                 if (s->player.load(s->audioFile)) {
-                     s->player.setLooping(false);
+                 std::error_code ec;
+                 if (std::filesystem::exists(s->audioFile, ec)) {
                      bank_.addStory(s);
                      util::logInfo("StoryGen: Added dynamic story: " + text.substr(0, 20) + "...");
                  }
@@ -1,4 +1,5 @@
 #include "mood_loader.h"
+#include "../audio/asset_pack.h"
 #include "../../vendor/vjson/vjson.h"
 #include "../util/logger.h"
 #include <fstream>
@@ -65,34 +66,42 @@ brain::MoodRecipe parseMood(const vjson::Value &obj) {
             stem.gainDb = stemVal["gain_db"].asFloat(0.0f);
             stem.loop = stemVal.has("loop") ? stemVal["loop"].asBool(true) : true;
             stem.probability = stemVal["probability"].asFloat(1.0f);
+            if (stemVal.has("stream_above_mb")) stem.streamAboveMb = stemVal["stream_above_mb"].asFloat(stem.streamAboveMb);
             mood.stems.push_back(stem);
         }
     }
 
+    // dsp (optional; missing keys keep the MoodDsp defaults)
+    if (obj.has("dsp") && obj["dsp"].isObject()) {
+        const auto &dv = obj["dsp"];
+        auto &dsp = mood.dsp;
+        dsp.reverbWet = std::clamp(getNumber(dv, "reverb_wet", dsp.reverbWet), 0.0f, 1.0f);
+        dsp.reverbDecay = std::clamp(getNumber(dv, "reverb_decay", dsp.reverbDecay), 0.05f, 0.95f);
+        dsp.reverbPreDelayMs = std::clamp(getNumber(dv, "reverb_predelay_ms", dsp.reverbPreDelayMs), 0.0f, 250.0f);
+        dsp.masterLpHz = std::clamp(getNumber(dv, "master_lp_hz", dsp.masterLpHz), 200.0f, 20000.0f);
+        dsp.shelfHz = std::clamp(getNumber(dv, "shelf_hz", dsp.shelfHz), 1000.0f, 16000.0f);
+        const auto binaural = getFloatArray(dv, "binaural_hz");
+        if (binaural.size() == 2) {
+            dsp.binauralLeftHz = std::clamp(binaural[0], 20.0f, 1000.0f);
+            dsp.binauralRightHz = std::clamp(binaural[1], 20.0f, 1000.0f);
+        }
+        mood.reverbIr = dv["reverb_ir"].asString("");
+    }
+
     // synth
     if (obj.has("synth") && obj["synth"].isObject()) {
         const auto &sv = obj["synth"];
         mood.synth.presetFile = sv["preset"].asString("");
         mood.synth.seed = sv["seed"].asInt(0);
         mood.synth.patternDensity = sv["pattern_density"].asFloat(0.4f);
+        mood.synth.layer = getBool(sv, "layer", false);
     }
 
     return mood;
 }
 
-} // namespace
-
-brain::MoodPack MoodLoader::loadFromFile(const std::string &path, bool &ok) {
-    ok = false;
-    std::ifstream f(path, std::ios::binary);
-    if (!f.good()) {
-        util::logWarn("Mood config not found: " + path + " (using defaults)");
-        return brain::defaultMoodPack();
-    }
-    std::stringstream ss;
-    ss << f.rdbuf();
-    std::string data = ss.str();
-
+// Parses mood pack JSON; ok is left false on failure.
+brain::MoodPack parsePack(const std::string &data, bool &ok) {
     auto parseResult = vjson::parse(data);
     if (!parseResult.has_value()) {
         util::logWarn("Failed to parse mood config JSON, using defaults");
@@ -131,4 +140,44 @@ brain::MoodPack MoodLoader::loadFromFile(const std::string &path, bool &ok) {
     return pack;
 }
 
+} // namespace
+
+brain::MoodPack MoodLoader::loadFromFile(const std::string &path, bool &ok) {
+    ok = false;
+    if (audio::AssetPack::isPackPath(path)) {
+        auto assets = audio::AssetPack::open(path);
+        if (!assets) {
+            util::logWarn("Mood pack " + path + " unusable (using defaults)");
+            return brain::defaultMoodPack();
+        }
+        std::string stale;
+        if (!assets->sourcesMatch(&stale)) {
+            util::logWarn("Mood pack " + path + " is older than " + stale + "; re-run keegan_pack");
+        }
+        return loadFromPack(std::move(assets), ok);
+    }
+
+    std::ifstream f(path, std::ios::binary);
+    if (!f.good()) {
+        util::logWarn("Mood config not found: " + path + " (using defaults)");
+        return brain::defaultMoodPack();
+    }
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return parsePack(ss.str(), ok);
+}
+
+brain::MoodPack MoodLoader::loadFromPack(std::shared_ptr<audio::AssetPack> assets, bool &ok) {
+    ok = false;
+    const audio::AssetPack::Entry *moods = assets ? assets->moods() : nullptr;
+    if (moods == nullptr) {
+        util::logWarn("Mood pack " + (assets ? assets->path() : std::string()) + " unusable (using defaults)");
+        return brain::defaultMoodPack();
+    }
+    // Mount it so stems and stories come from the mapping.
+    std::string data(reinterpret_cast<const char *>(moods->data), moods->size);
+    audio::AssetPack::mount(std::move(assets));
+    return parsePack(data, ok);
+}
+
 } // namespace config
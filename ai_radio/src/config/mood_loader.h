@@ -1,13 +1,26 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include "../brain/state_machine.h"
 
+namespace audio {
+class AssetPack;
+}
+
 namespace config {
 
 class MoodLoader {
 public:
+    // Reads a mood pack JSON file, or a .kpak baked by keegan_pack (which
+    // is then mounted, see audio::AssetPack). Falls back to the built-in
+    // pack, with ok false, on any error.
+    // A .kpak is checked against its sources first; see
+    // audio::AssetPack::sourcesMatch.
     static brain::MoodPack loadFromFile(const std::string &path, bool &ok);
+    // Reads the mood JSON of a pack the caller has already opened (and
+    // checked, if it wants to), and mounts it.
+    static brain::MoodPack loadFromPack(std::shared_ptr<audio::AssetPack> assets, bool &ok);
 };
 
 } // namespace config
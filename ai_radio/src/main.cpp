@@ -1,14 +1,21 @@
+#include "audio/asset_pack.h"
 #include "audio/engine.h"
 #include "audio/device.h"
+#include "audio/simd/simd.h"
 #include "config/mood_loader.h"
 #include "ui/tray.h"
 #include "ui/web_server.h"
 #include "util/logger.h"
 #include "util/platform.h"
+#include "util/startup_profile.h"
 #include "util/telemetry.h"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <filesystem>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
 #include <thread>
 
 #ifdef _WIN32
@@ -28,28 +35,51 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 #else
 int main() {
 #endif
+    // Startup phases are timed from here; see /api/startup.
+    util::StartupProfile &startup = util::StartupProfile::instance();
     util::fixWorkingDirectory();
     util::logInfo("Keegan starting up...");
+    util::logInfo(std::string("SIMD kernels: ") + audio::simd::isaName(audio::simd::kernels().isa));
     util::Telemetry::instance().init("exe");
 
-    // Load mood configuration
+    // Load mood configuration; a pack baked by keegan_pack wins unless a
+    // file it was baked from has been edited since.
+    double phaseStart = startup.nowMs();
     bool loaded = false;
-    auto pack = config::MoodLoader::loadFromFile("config/moods.json", loaded);
+    std::string packPath = "config/moods.json";
+    std::shared_ptr<audio::AssetPack> baked;
+    if (std::filesystem::exists("config/keegan.kpak")) {
+        baked = audio::AssetPack::open("config/keegan.kpak");
+        std::string stale;
+        if (baked && !baked->sourcesMatch(&stale)) {
+            util::logWarn("config/keegan.kpak is older than " + stale + "; using config/moods.json (re-run keegan_pack)");
+            baked.reset();
+        }
+        if (baked) packPath = "config/keegan.kpak";
+    }
+    auto pack = baked ? config::MoodLoader::loadFromPack(std::move(baked), loaded)
+                      : config::MoodLoader::loadFromFile(packPath, loaded);
+    startup.record("config", phaseStart, startup.nowMs());
 
-    // Initialize audio engine
+    // Initialize audio engine. Only the first mood's base stem is decoded
+    // here; the other stems and the story clips load in the background.
+    phaseStart = startup.nowMs();
     audio::Engine engine(48000.0f, 512);
     engine.setMoodPack(pack);
     engine.setIntensity(0.75f);
+    // Opt-in parallel stem rendering, e.g. KEEGAN_STEM_WORKERS=2.
+    if (const char *workers = std::getenv("KEEGAN_STEM_WORKERS")) {
+        engine.setStemWorkers(static_cast<size_t>(std::max(0, std::atoi(workers))));
+    }
     g_engine = &engine;
+    startup.record("engine", phaseStart, startup.nowMs());
     util::Telemetry::instance().record("engine_start", {
         {"mood", engine.currentMoodId()}
     });
 
-    // Start Web Server
-    uisrv::WebServer server(engine, 3000);
-    server.start();
-
-    // Initialize audio device
+    // Initialize audio device; it starts before anything else so audio
+    // comes up as early as possible.
+    phaseStart = startup.nowMs();
     audio::AudioDevice device(engine, 48000, 512);
     if (!device.init()) {
         util::logError("Audio init failed.");
@@ -61,9 +91,16 @@ int main() {
         util::logError("Audio start failed.");
         return 1;
     }
+    startup.record("device", phaseStart, startup.nowMs());
+
+    // Start Web Server
+    phaseStart = startup.nowMs();
+    uisrv::WebServer server(engine, 3000);
+    server.start();
+    startup.record("web_server", phaseStart, startup.nowMs());
 
-    util::logInfo(loaded ? "Loaded mood pack from config/moods.json"
-                         : "Using default embedded mood pack");
+    util::logInfo(loaded ? "Loaded mood pack from " + packPath
+                         : std::string("Using default embedded mood pack"));
 
 #ifdef _WIN32
     // Initialize system tray
@@ -0,0 +1,222 @@
+// keegan_host: several stations in one headless process.
+//
+// Each station is its own audio::Engine with its own metadata, mood pack
+// and optional raw PCM output; they share one paced render thread pool
+// (audio::StationHost), one HTTP front end and one WS server
+// (uisrv::WebServer), and one registry client thread.
+//
+//   keegan_host                                # config/stations.json
+//   keegan_host --config /etc/keegan/stations.json --port 3000
+//
+// Station routes live under /api/stations/<id>/...; WS clients subscribe to
+// ws://host:<port+1>/stations/<id>/events.
+
+#include "audio/sample_cache.h"
+#include "audio/stem_stream.h"
+#include "audio/station_host.h"
+#include "audio/simd/simd.h"
+#include "config/mood_loader.h"
+#include "ui/web_server.h"
+#include "util/logger.h"
+#include "util/startup_profile.h"
+#include "../../vendor/vjson/vjson.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct StationSpec {
+    uisrv::StationConfig meta;
+    std::string packPath = "config/moods.json";
+    std::string startMood;
+    float intensity = 0.75f;
+    float activity = 0.5f;
+    std::string pcmOut;
+};
+
+struct HostConfig {
+    float sampleRate = 48000.0f;
+    size_t blockFrames = 512;
+    int renderWorkers = -1; // -1: one per core, minus the render thread
+    int pinCpu = -1;
+    int port = 3000;
+    int sampleCacheMb = 0; // 0: KEEGAN_SAMPLE_CACHE_MB or the default
+    bool lockSamples = false; // or KEEGAN_SAMPLE_MLOCK=1
+    std::vector<StationSpec> stations;
+};
+
+std::atomic<bool> g_quit{false};
+
+void onSignal(int) {
+    g_quit.store(true);
+}
+
+std::string readTextFile(const std::string &path) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.good()) return "";
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+std::string getString(const vjson::Value &obj, const std::string &key, const std::string &def) {
+    return obj.has(key) ? obj[key].asString(def) : def;
+}
+
+float getFloat(const vjson::Value &obj, const std::string &key, float def) {
+    return obj.has(key) ? obj[key].asFloat(def) : def;
+}
+
+int getInt(const vjson::Value &obj, const std::string &key, int def) {
+    return obj.has(key) ? obj[key].asInt(def) : def;
+}
+
+bool getBool(const vjson::Value &obj, const std::string &key, bool def) {
+    return obj.has(key) ? obj[key].asBool(def) : def;
+}
+
+bool loadHostConfig(const std::string &path, HostConfig &out) {
+    auto raw = readTextFile(path);
+    if (raw.empty()) {
+        util::logError("keegan_host: cannot read " + path);
+        return false;
+    }
+    auto parsed = vjson::parse(raw);
+    if (!parsed.has_value() || !parsed->isObject()) {
+        util::logError("keegan_host: " + path + " is not a JSON object");
+        return false;
+    }
+    const auto &root = *parsed;
+    out.sampleRate = getFloat(root, "sampleRate", out.sampleRate);
+    out.blockFrames = static_cast<size_t>(std::max(16, getInt(root, "blockFrames", static_cast<int>(out.blockFrames))));
+    out.renderWorkers = getInt(root, "renderWorkers", out.renderWorkers);
+    out.pinCpu = getInt(root, "pinCpu", out.pinCpu);
+    out.port = getInt(root, "port", out.port);
+    out.sampleCacheMb = getInt(root, "sampleCacheMb", out.sampleCacheMb);
+    out.lockSamples = getBool(root, "lockSamples", out.lockSamples);
+    const std::string registryUrl = getString(root, "registryUrl", uisrv::StationConfig{}.registryUrl);
+
+    if (!root.has("stations") || !root["stations"].isArray()) {
+        util::logError("keegan_host: " + path + " has no stations array");
+        return false;
+    }
+    for (const auto &item : root["stations"].asArray()) {
+        if (!item.isObject()) continue;
+        StationSpec spec;
+        spec.meta.id = getString(item, "id", "");
+        spec.meta.name = getString(item, "name", spec.meta.name);
+        spec.meta.region = getString(item, "region", spec.meta.region);
+        spec.meta.frequency = getFloat(item, "frequency", spec.meta.frequency);
+        spec.meta.description = getString(item, "description", spec.meta.description);
+        spec.meta.streamUrl = getString(item, "streamUrl", "");
+        spec.meta.registryUrl = getString(item, "registryUrl", registryUrl);
+        spec.packPath = getString(item, "pack", spec.packPath);
+        spec.startMood = getString(item, "startMood", "");
+        spec.intensity = getFloat(item, "intensity", spec.intensity);
+        spec.activity = getFloat(item, "activity", spec.activity);
+        spec.pcmOut = getString(item, "pcmOut", "");
+        if (spec.meta.id.empty()) {
+            util::logWarn("keegan_host: skipping station without an id");
+            continue;
+        }
+        out.stations.push_back(std::move(spec));
+    }
+    return !out.stations.empty();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string configPath = "config/stations.json";
+    int portOverride = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc) {
+            configPath = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            portOverride = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "usage: keegan_host [--config PATH] [--port N]\n";
+            return 2;
+        }
+    }
+
+    util::StartupProfile &startup = util::StartupProfile::instance();
+    util::logInfo(std::string("SIMD kernels: ") + audio::simd::isaName(audio::simd::kernels().isa));
+    HostConfig cfg;
+    if (!loadHostConfig(configPath, cfg)) return 1;
+    if (portOverride > 0) cfg.port = portOverride;
+
+    if (cfg.sampleCacheMb > 0) {
+        audio::SampleCache::instance().setBudget(static_cast<size_t>(cfg.sampleCacheMb) << 20);
+    }
+    if (cfg.lockSamples) audio::SampleStorage::setLockPages(true);
+
+    // Stations using the same pack parse it once; their stems and stories
+    // share decoded samples through the process-wide SampleCache.
+    double phaseStart = startup.nowMs();
+    std::map<std::string, brain::MoodPack> packs;
+    audio::StationHost host(cfg.sampleRate, cfg.blockFrames);
+    std::vector<uisrv::WebServer::HostedStation> hosted;
+    for (const auto &spec : cfg.stations) {
+        auto it = packs.find(spec.packPath);
+        if (it == packs.end()) {
+            bool loaded = false;
+            it = packs.emplace(spec.packPath, config::MoodLoader::loadFromFile(spec.packPath, loaded)).first;
+        }
+        audio::Engine &engine = host.addStation(spec.meta.id, it->second, spec.startMood, spec.intensity,
+                                                  spec.activity, spec.pcmOut);
+        hosted.push_back({&engine, spec.meta});
+    }
+    startup.record("stations", phaseStart, startup.nowMs());
+
+    size_t workers = 0;
+    if (cfg.renderWorkers >= 0) {
+        workers = static_cast<size_t>(cfg.renderWorkers);
+    } else {
+        const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        workers = cores - 1;
+    }
+
+    phaseStart = startup.nowMs();
+    if (!host.start(workers, cfg.pinCpu)) return 1;
+    startup.record("render_threads", phaseStart, startup.nowMs());
+    phaseStart = startup.nowMs();
+    uisrv::WebServer server(std::move(hosted), cfg.port);
+    if (!server.start()) return 1;
+    startup.record("web_server", phaseStart, startup.nowMs());
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    util::logInfo("keegan_host: running " + std::to_string(host.stationCount()) + " stations. Ctrl+C to quit.");
+
+    auto lastReport = std::chrono::steady_clock::now();
+    while (!g_quit.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        const auto now = std::chrono::steady_clock::now();
+        if (now - lastReport >= std::chrono::seconds(30)) {
+            lastReport = now;
+            const auto stats = host.stats();
+            util::logInfo("keegan_host: render load " + std::to_string(stats.loadAvg * 100.0f) + "% avg, " +
+                          std::to_string(stats.loadPeak * 100.0f) + "% peak, " +
+                          std::to_string(stats.lateBlocks) + "/" + std::to_string(stats.blocks) + " late blocks");
+            util::logInfo("keegan_host: " + audio::SampleCache::instance().statsLine());
+            util::logInfo("keegan_host: " + audio::StemStream::statsLine());
+        }
+    }
+
+    server.stop();
+    host.stop();
+    util::logInfo("keegan_host: shutdown complete.");
+    return 0;
+}
@@ -0,0 +1,183 @@
+// keegan_pack: bakes a mood pack into one memory-mappable .kpak file.
+//
+// Decodes every stem, impulse response and story clip the pack references,
+// resamples it to the engine rate and writes it, together with the mood,
+// synth preset and story JSON, as the page-aligned blobs audio::AssetPack
+// maps at startup.
+//
+//   keegan_pack --out config/keegan.kpak
+//   keegan_pack --pack mods/deep_space.json --stories mods/deep_space_stories.json --out mods/deep_space.kpak
+
+#include "audio/asset_pack.h"
+#include "audio/sample_cache.h"
+#include "config/mood_loader.h"
+#include "util/logger.h"
+#include "../../vendor/vjson/vjson.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Where the engine reads stories from; the pack stores them under this name
+// whatever file they came from.
+const char *kStoriesName = "config/stories.json";
+
+struct Options {
+    std::string packPath = "config/moods.json";
+    std::string storiesPath = "config/stories.json";
+    std::string outPath = "config/keegan.kpak";
+    uint32_t sampleRate = 48000;
+};
+
+void printUsage() {
+    std::cout <<
+        "usage: keegan_pack [options]\n"
+        "  --pack PATH        mood pack JSON (default config/moods.json)\n"
+        "  --stories PATH     stories JSON, or \"\" for none (default config/stories.json)\n"
+        "  --rate HZ          engine rate to bake samples at (default 48000)\n"
+        "  --out PATH         output pack (default config/keegan.kpak)\n";
+}
+
+bool parseArgs(int argc, char **argv, Options &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&](const char *name) -> const char * {
+            if (i + 1 >= argc) {
+                std::cerr << "missing value for " << name << "\n";
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        const char *v = nullptr;
+        if (arg == "--pack") {
+            if (!(v = next("--pack"))) return false;
+            opt.packPath = v;
+        } else if (arg == "--stories") {
+            if (!(v = next("--stories"))) return false;
+            opt.storiesPath = v;
+        } else if (arg == "--rate") {
+            if (!(v = next("--rate"))) return false;
+            opt.sampleRate = static_cast<uint32_t>(std::max(0, std::atoi(v)));
+        } else if (arg == "--out") {
+            if (!(v = next("--out"))) return false;
+            opt.outPath = v;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        } else {
+            std::cerr << "unknown option: " << arg << "\n";
+            return false;
+        }
+    }
+    if (opt.sampleRate == 0) {
+        std::cerr << "--rate must be positive\n";
+        return false;
+    }
+    if (audio::AssetPack::isPackPath(opt.packPath)) {
+        std::cerr << "--pack must be a JSON mood pack, not a .kpak\n";
+        return false;
+    }
+    return true;
+}
+
+bool readText(const std::string &path, std::string &out) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.good()) return false;
+    std::stringstream ss;
+    ss << f.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+void addUnique(std::vector<std::string> &list, const std::string &path) {
+    if (!path.empty() && std::find(list.begin(), list.end(), path) == list.end()) list.push_back(path);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        printUsage();
+        return 2;
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::string moodsJson;
+    bool loaded = false;
+    const auto pack = config::MoodLoader::loadFromFile(opt.packPath, loaded);
+    if (!loaded || !readText(opt.packPath, moodsJson)) {
+        util::logError("keegan_pack: cannot read mood pack " + opt.packPath);
+        return 1;
+    }
+
+    audio::AssetPackWriter writer(opt.sampleRate);
+    writer.addMoods(opt.packPath, moodsJson);
+    std::vector<std::string> audioFiles;
+    std::vector<std::string> presetFiles;
+    for (const auto &mood : pack.moods) {
+        for (const auto &stem : mood.stems) addUnique(audioFiles, stem.file);
+        if (mood.synth.presetFile != "default") addUnique(presetFiles, mood.synth.presetFile);
+        if (!mood.reverbIr.empty()) addUnique(audioFiles, mood.reverbIr);
+    }
+
+    // Synth presets are small; a missing one is logged and left out, like a
+    // missing stem.
+    size_t failed = 0;
+    for (const auto &file : presetFiles) {
+        std::string presetJson;
+        if (!readText(file, presetJson)) {
+            util::logWarn("keegan_pack: cannot read synth preset " + file);
+            ++failed;
+            continue;
+        }
+        writer.addJson(file, std::move(presetJson));
+    }
+
+    if (!opt.storiesPath.empty()) {
+        std::string storiesJson;
+        if (!readText(opt.storiesPath, storiesJson)) {
+            util::logError("keegan_pack: cannot read stories " + opt.storiesPath);
+            return 1;
+        }
+        auto stories = vjson::parse(storiesJson);
+        if (!stories || !stories->isArray()) {
+            util::logError("keegan_pack: invalid JSON in " + opt.storiesPath);
+            return 1;
+        }
+        for (const auto &story : stories->asArray()) {
+            if (story.isObject()) addUnique(audioFiles, story["audio_file"].asString());
+        }
+        writer.addJson(kStoriesName, std::move(storiesJson), opt.storiesPath);
+    }
+
+    // Missing or broken files are left out (and logged); the engine skips
+    // them at runtime as it would on disk.
+    for (const auto &file : audioFiles) {
+        audio::SampleRef sample = audio::SampleCache::instance().load(file, opt.sampleRate);
+        if (!sample) {
+            ++failed;
+            continue;
+        }
+        writer.addSample(file, std::move(sample));
+    }
+
+    std::error_code ec;
+    const std::filesystem::path outDir = std::filesystem::path(opt.outPath).parent_path();
+    if (!outDir.empty()) std::filesystem::create_directories(outDir, ec);
+    size_t bytes = 0;
+    if (!writer.write(opt.outPath, &bytes)) return 1;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("%s: %zu entries (%zu audio files, %zu presets, %zu failed), %zu KiB at %u Hz in %.2f s\n",
+                opt.outPath.c_str(), writer.entries(), audioFiles.size(), presetFiles.size(), failed, bytes >> 10,
+                opt.sampleRate, seconds);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,1086 @@
+// keegan_render: headless, faster-than-realtime renderer.
+//
+// Drives audio::Engine::renderBlock in a tight loop (no AudioDevice) and writes
+// the result to WAV. Used to pre-render broadcast fallback loops and to measure
+// how much faster than realtime the DSP chain runs on a given box.
+//
+//   keegan_render --mood rain_cave --minutes 10 --out renders
+//   keegan_render --all --minutes 5 --jobs 4
+//   keegan_render --timeline focus_room@0,rain_cave@90,sleep_ship@240 --minutes 6
+
+#include "audio/convolution.h"
+#include "audio/engine.h"
+#include "audio/fastmath.h"
+#include "audio/limiter.h"
+#include "audio/oscillator.h"
+#include "audio/reverb.h"
+#include "audio/rt_check.h"
+#include "audio/sample_cache.h"
+#include "audio/stem_stream.h"
+#include "audio/synth.h"
+#include "audio/simd/simd.h"
+#include "config/mood_loader.h"
+#include "util/logger.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct TimelineEntry {
+    double atSeconds = 0.0;
+    std::string moodId;
+};
+
+struct RenderJob {
+    std::string name;
+    std::vector<TimelineEntry> timeline; // first entry is the start mood
+    std::string outPath;
+};
+
+struct RenderResult {
+    std::string name;
+    double renderedSeconds = 0.0;
+    double wallSeconds = 0.0;
+    audio::DspProfile profile;
+    bool ok = false;
+};
+
+// Largest WAV data chunk: the RIFF size field holds 36 + data bytes.
+constexpr uint32_t kMaxWavDataBytes = UINT32_MAX - 36;
+
+struct Options {
+    std::string packPath = "config/moods.json";
+    std::string outDir = "renders";
+    std::vector<std::string> moods;
+    std::string timeline;
+    bool allMoods = false;
+    double minutes = 1.0;
+    float sampleRate = 48000.0f;
+    size_t blockSize = 512;
+    unsigned jobs = 0;
+    float intensity = 0.75f;
+    float activity = 1.0f;
+    bool floatOutput = false;
+    bool profile = false;
+    bool simdCheck = false;
+    bool fastmathCheck = false;
+    std::vector<std::string> decodeBench;
+    bool oscBench = false;
+    bool synthBench = false;
+    bool reverbBench = false;
+    bool limiterBench = false;
+    size_t stemWorkers = 0;
+    int pinCpu = -1;
+};
+
+void printUsage() {
+    std::cout <<
+        "usage: keegan_render [options]\n"
+        "  --mood ID          render a mood (repeatable; moods render in parallel)\n"
+        "  --all              render every mood in the pack\n"
+        "  --timeline SPEC    scripted run, e.g. focus_room@0,rain_cave@90 (seconds)\n"
+        "  --minutes N        length of each render (default 1)\n"
+        "  --out DIR          output directory (default renders)\n"
+        "  --pack PATH        mood pack (default config/moods.json)\n"
+        "  --jobs N           parallel renders (default: hardware threads)\n"
+        "  --rate HZ          sample rate (default 48000)\n"
+        "  --block N          frames per renderBlock call (default 512)\n"
+        "  --intensity X      engine intensity 0..1 (default 0.75)\n"
+        "  --activity X       pinned input activity 0..1 (default 1)\n"
+        "  --float            write 32-bit float WAV instead of 16-bit PCM\n"
+        "  --profile          print per-stage DSP timings for each render\n"
+        "  --stem-workers N   render stems on N extra worker threads per engine\n"
+        "  --pin-cpu N        pin stem workers to CPUs N, N+1, ...\n"
+        "  --simd-check       verify every SIMD kernel set against scalar, time them, exit\n"
+        "  --fastmath-check   measure fastmath error bounds and cost against libm, exit\n"
+        "  --decode-bench F   time decoding audio file F (repeatable; WAV, FLAC, MP3, OGG), exit\n"
+        "  --osc-bench        time the sine oscillators against per-sample sin(), exit\n"
+        "  --synth-bench      time the procedural synth at 32-256 voices per 512-frame block, exit\n"
+        "  --reverb-bench     time the FDN, plate and convolution reverbs, exit\n"
+        "  --limiter-bench    measure true-peak overshoot and cost of the limiters, exit\n"
+        "Timeline moods must respect allowed_transitions in the pack.\n";
+}
+
+bool parseArgs(int argc, char **argv, Options &opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&](const char *name) -> const char * {
+            if (i + 1 >= argc) {
+                std::cerr << "missing value for " << name << "\n";
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        const char *v = nullptr;
+        if (arg == "--mood") {
+            if (!(v = next("--mood"))) return false;
+            opt.moods.push_back(v);
+        } else if (arg == "--all") {
+            opt.allMoods = true;
+        } else if (arg == "--timeline") {
+            if (!(v = next("--timeline"))) return false;
+            opt.timeline = v;
+        } else if (arg == "--minutes") {
+            if (!(v = next("--minutes"))) return false;
+            opt.minutes = std::atof(v);
+        } else if (arg == "--out") {
+            if (!(v = next("--out"))) return false;
+            opt.outDir = v;
+        } else if (arg == "--pack") {
+            if (!(v = next("--pack"))) return false;
+            opt.packPath = v;
+        } else if (arg == "--jobs") {
+            if (!(v = next("--jobs"))) return false;
+            opt.jobs = static_cast<unsigned>(std::max(1, std::atoi(v)));
+        } else if (arg == "--rate") {
+            if (!(v = next("--rate"))) return false;
+            opt.sampleRate = static_cast<float>(std::atof(v));
+        } else if (arg == "--block") {
+            if (!(v = next("--block"))) return false;
+            opt.blockSize = static_cast<size_t>(std::max(16, std::atoi(v)));
+        } else if (arg == "--intensity") {
+            if (!(v = next("--intensity"))) return false;
+            opt.intensity = static_cast<float>(std::atof(v));
+        } else if (arg == "--activity") {
+            if (!(v = next("--activity"))) return false;
+            opt.activity = static_cast<float>(std::atof(v));
+        } else if (arg == "--float") {
+            opt.floatOutput = true;
+        } else if (arg == "--profile") {
+            opt.profile = true;
+        } else if (arg == "--stem-workers") {
+            if (!(v = next("--stem-workers"))) return false;
+            opt.stemWorkers = static_cast<size_t>(std::max(0, std::atoi(v)));
+        } else if (arg == "--pin-cpu") {
+            if (!(v = next("--pin-cpu"))) return false;
+            opt.pinCpu = std::atoi(v);
+        } else if (arg == "--simd-check") {
+            opt.simdCheck = true;
+        } else if (arg == "--fastmath-check") {
+            opt.fastmathCheck = true;
+        } else if (arg == "--decode-bench") {
+            if (!(v = next("--decode-bench"))) return false;
+            opt.decodeBench.push_back(v);
+        } else if (arg == "--osc-bench") {
+            opt.oscBench = true;
+        } else if (arg == "--synth-bench") {
+            opt.synthBench = true;
+        } else if (arg == "--reverb-bench") {
+            opt.reverbBench = true;
+        } else if (arg == "--limiter-bench") {
+            opt.limiterBench = true;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        } else {
+            std::cerr << "unknown option: " << arg << "\n";
+            return false;
+        }
+    }
+    if (opt.minutes <= 0.0 || opt.sampleRate <= 0.0f) {
+        std::cerr << "--minutes and --rate must be positive\n";
+        return false;
+    }
+    const double dataBytes = opt.minutes * 60.0 * opt.sampleRate * 2.0 * (opt.floatOutput ? 4.0 : 2.0);
+    if (dataBytes > static_cast<double>(kMaxWavDataBytes)) {
+        std::cerr << "--minutes too long: a render must fit in a 4 GiB WAV file\n";
+        return false;
+    }
+    return true;
+}
+
+bool parseTimeline(const std::string &spec, std::vector<TimelineEntry> &out) {
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        TimelineEntry e;
+        auto at = item.find('@');
+        e.moodId = item.substr(0, at);
+        e.atSeconds = at == std::string::npos ? 0.0 : std::atof(item.c_str() + at + 1);
+        if (e.moodId.empty()) return false;
+        out.push_back(e);
+    }
+    std::stable_sort(out.begin(), out.end(), [](const TimelineEntry &a, const TimelineEntry &b) {
+        return a.atSeconds < b.atSeconds;
+    });
+    return !out.empty();
+}
+
+// Streams interleaved stereo to a WAV file; sizes are patched in finish().
+class WavWriter {
+public:
+    bool open(const std::string &path, uint32_t sampleRate, bool floatOutput) {
+        floatOutput_ = floatOutput;
+        sampleRate_ = sampleRate;
+        file_.open(path, std::ios::binary | std::ios::trunc);
+        if (!file_.good()) return false;
+        writeHeader(0);
+        return true;
+    }
+
+    // Returns false, writing nothing, once the data would outgrow the
+    // 32-bit RIFF sizes (about 4 GiB).
+    bool write(const float *interleaved, size_t frames) {
+        const size_t samples = frames * 2;
+        if (samples * bytesPerSample() > kMaxWavDataBytes - dataBytes_) return false;
+        if (floatOutput_) {
+            file_.write(reinterpret_cast<const char *>(interleaved),
+                        static_cast<std::streamsize>(samples * sizeof(float)));
+        } else {
+            pcm_.resize(samples);
+            for (size_t i = 0; i < samples; ++i) {
+                const float s = std::clamp(interleaved[i], -1.0f, 1.0f);
+                pcm_[i] = static_cast<int16_t>(s * 32767.0f);
+            }
+            file_.write(reinterpret_cast<const char *>(pcm_.data()),
+                        static_cast<std::streamsize>(samples * sizeof(int16_t)));
+        }
+        dataBytes_ += static_cast<uint32_t>(samples * bytesPerSample());
+        return true;
+    }
+
+    void finish() {
+        file_.seekp(0);
+        writeHeader(dataBytes_);
+        file_.close();
+    }
+
+private:
+    std::ofstream file_;
+    std::vector<int16_t> pcm_;
+    uint32_t sampleRate_ = 48000;
+    uint32_t dataBytes_ = 0;
+    bool floatOutput_ = false;
+
+    uint32_t bytesPerSample() const { return floatOutput_ ? 4u : 2u; }
+
+    void put16(uint16_t v) { file_.write(reinterpret_cast<const char *>(&v), 2); }
+    void put32(uint32_t v) { file_.write(reinterpret_cast<const char *>(&v), 4); }
+
+    void writeHeader(uint32_t dataBytes) {
+        const uint16_t channels = 2;
+        const uint16_t bits = static_cast<uint16_t>(bytesPerSample() * 8);
+        file_.write("RIFF", 4);
+        put32(36 + dataBytes);
+        file_.write("WAVE", 4);
+        file_.write("fmt ", 4);
+        put32(16);
+        put16(floatOutput_ ? 3 : 1);
+        put16(channels);
+        put32(sampleRate_);
+        put32(sampleRate_ * channels * bytesPerSample());
+        put16(static_cast<uint16_t>(channels * bytesPerSample()));
+        put16(bits);
+        file_.write("data", 4);
+        put32(dataBytes);
+    }
+};
+
+RenderResult runJob(const RenderJob &job, const brain::MoodPack &pack, const Options &opt) {
+    RenderResult result;
+    result.name = job.name;
+
+    audio::Engine engine(opt.sampleRate, opt.blockSize);
+    engine.setOffline(true, opt.activity);
+    // Inline loads keep transitions on the same tick from run to run.
+    engine.setAsyncStemLoading(false);
+    engine.setStemWorkers(opt.stemWorkers, opt.pinCpu);
+    engine.setMoodPack(pack, job.timeline.front().moodId);
+    engine.setIntensity(opt.intensity);
+
+    WavWriter wav;
+    if (!wav.open(job.outPath, static_cast<uint32_t>(opt.sampleRate), opt.floatOutput)) {
+        util::logError("keegan_render: cannot write " + job.outPath);
+        return result;
+    }
+
+    const uint64_t totalFrames = static_cast<uint64_t>(opt.minutes * 60.0 * opt.sampleRate);
+    const uint64_t tickFrames = static_cast<uint64_t>(opt.sampleRate * 0.1f); // main.cpp ticks at 100 ms
+    std::vector<float> block(opt.blockSize * 2);
+
+    size_t nextEvent = 1;
+    uint64_t rendered = 0;
+    uint64_t sinceTick = tickFrames; // tick before the first block
+    double renderSeconds = 0.0;
+
+    while (rendered < totalFrames) {
+        if (sinceTick >= tickFrames) {
+            // Mood changes due before the next tick go out with this one,
+            // stamped with their exact sample (the engine clock counts
+            // rendered frames).
+            const uint64_t horizon = rendered + tickFrames + opt.blockSize;
+            while (nextEvent < job.timeline.size()) {
+                const auto at = static_cast<uint64_t>(job.timeline[nextEvent].atSeconds * opt.sampleRate);
+                if (at >= horizon) break;
+                engine.setMood(job.timeline[nextEvent].moodId, at);
+                ++nextEvent;
+            }
+            engine.tick("", static_cast<float>(sinceTick) / opt.sampleRate);
+            sinceTick = 0;
+        }
+
+        const size_t frames = static_cast<size_t>(
+            std::min<uint64_t>(opt.blockSize, totalFrames - rendered));
+        const auto t0 = std::chrono::steady_clock::now();
+        engine.renderBlock(block.data(), frames);
+        renderSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (!wav.write(block.data(), frames)) {
+            util::logError("keegan_render: " + job.outPath + " would pass the 4 GiB WAV limit");
+            wav.finish();
+            return result;
+        }
+
+        rendered += frames;
+        sinceTick += frames;
+    }
+    wav.finish();
+
+    result.renderedSeconds = static_cast<double>(rendered) / opt.sampleRate;
+    result.wallSeconds = renderSeconds;
+    result.profile = engine.dspProfile();
+    result.ok = true;
+    return result;
+}
+
+// Equivalence of each runnable kernel set against the scalar reference, then
+// a rough per-kernel cost on engine-sized blocks.
+int runSimdCheck() {
+    namespace simd = audio::simd;
+    constexpr size_t kFrames = 512;
+    constexpr int kIterations = 20000;
+    std::vector<float> a(kFrames, 0.25f), b(kFrames, -0.5f), d(kFrames, 0.0f), out(2 * kFrames);
+    std::vector<int16_t> s16(kFrames, 8192);
+    std::vector<uint8_t> s24(3 * kFrames, 0x20);
+    volatile float sink = 0.0f;
+
+    bool ok = true;
+    std::printf("active: %s\n\n%-8s %-6s %10s %10s %10s %10s %10s %10s %10s %10s %10s %10s %10s %10s (ns/sample)\n",
+                simd::isaName(simd::kernels().isa), "isa", "equiv", "mixAdd", "mixI16", "mixI24", "xfade",
+                "interleave", "sumSq", "peak", "dot", "sinePair", "fdn", "cmac", "biquad");
+    for (const simd::Kernels *k : simd::availableKernels()) {
+        std::string failure;
+        const bool same = simd::verifyAgainstScalar(*k, &failure);
+        ok = ok && same;
+
+        auto time = [&](auto &&fn) {
+            const auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < kIterations; ++i) fn();
+            const auto t1 = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::nano>(t1 - t0).count() / (double(kIterations) * kFrames);
+        };
+        const double mix = time([&] { k->mixAdd(d.data(), a.data(), 0.5f, kFrames); });
+        const double mix16 = time([&] { k->mixAddI16(d.data(), s16.data(), 0.5f / 32768.0f, kFrames); });
+        const double mix24 = time([&] { k->mixAddI24(d.data(), s24.data(), 0.5f / 8388608.0f, kFrames); });
+        const double xfade = time([&] { k->crossfade(d.data(), a.data(), b.data(), 0.7f, 0.7f, kFrames); });
+        const double inter = time([&] { k->interleave2(out.data(), a.data(), b.data(), kFrames); });
+        const double sumSq = time([&] { sink = sink + k->sumSquares(a.data(), kFrames); });
+        const double peak = time([&] { sink = sink + k->peak(b.data(), kFrames); });
+        const double dot = time([&] { sink = sink + k->dot(a.data(), b.data(), kFrames); });
+        // Per output sample of one channel; the phasors are left unanchored,
+        // which is fine for timing.
+        simd::SinePairState osc{};
+        for (size_t l = 0; l < 8; ++l) {
+            osc.re[l] = osc.rotRe[l] = osc.stepRe[l] = 1.0f;
+        }
+        const double sine = time([&] { k->sinePair(osc, a.data(), b.data(), 0.0f, kFrames); }) / 2.0;
+        // Per stereo frame, on a reverb-sized ring.
+        std::vector<float> ring(4096 * simd::kFdnLines, 0.0f);
+        simd::FdnState net{};
+        net.ring = ring.data();
+        net.mask = 4095;
+        for (size_t l = 0; l < simd::kFdnLines; ++l) net.delay[l] = static_cast<uint32_t>(1400 + 300 * l);
+        const double fdn = time([&] { k->fdn(net, a.data(), d.data(), out.data(), kFrames); });
+        // Per complex bin.
+        const double cmac =
+            time([&] { k->complexMulAdd(d.data(), out.data(), a.data(), b.data(), b.data(), a.data(), kFrames); });
+        // Per stereo frame through both sections.
+        simd::BiquadState bq{};
+        for (size_t l = 0; l < simd::kBiquadLanes; ++l) {
+            bq.b0[l] = bq.b2[l] = 0.25f;
+            bq.b1[l] = 0.5f;
+            bq.a1[l] = -0.5f;
+            bq.a2[l] = 0.25f;
+        }
+        const double biquad = time([&] { k->biquad2x2(bq, d.data(), out.data(), kFrames); });
+        std::printf("%-8s %-6s %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                    simd::isaName(k->isa), same ? "ok" : "FAIL", mix, mix16, mix24, xfade, inter, sumSq, peak, dot,
+                    sine, fdn, cmac, biquad);
+        if (!same) std::printf("  %s\n", failure.c_str());
+    }
+    return ok ? 0 : 1;
+}
+
+// Worst error of each audio/fastmath.h function against double-precision
+// libm over its documented range, checked against the bound the header
+// states, then its cost next to the float libm call on a batch of inputs.
+int runFastmathCheck() {
+    namespace fm = audio::fastmath;
+    constexpr size_t kPoints = size_t(1) << 22;
+    constexpr size_t kBatch = 4096;
+    constexpr int kIterations = 2000;
+    std::vector<float> in(kBatch), out(kBatch);
+    volatile float sink = 0.0f;
+    bool ok = true;
+
+    std::printf("%-8s %-28s %12s %12s %-6s %10s %10s (ns/value)\n", "fn", "range", "max error", "bound", "",
+                "fastmath", "libm");
+    // error(x, y) measures y = fast(x); log-spaced sweeps need lo > 0.
+    auto check = [&](const char *name, float lo, float hi, bool logSweep, float bound, auto fast, auto libm,
+                     auto error) {
+        auto point = [&](size_t i, size_t count) {
+            const double t = static_cast<double>(i) / static_cast<double>(count - 1);
+            return static_cast<float>(logSweep ? lo * std::pow(static_cast<double>(hi) / lo, t) : lo + (hi - lo) * t);
+        };
+        double worst = 0.0;
+        for (size_t i = 0; i < kPoints; ++i) {
+            const float x = point(i, kPoints);
+            worst = std::max(worst, error(x, fast(x)));
+        }
+        const bool pass = worst <= bound;
+        ok = ok && pass;
+
+        for (size_t i = 0; i < kBatch; ++i) in[i] = point(i, kBatch);
+        auto time = [&](auto &&fn) {
+            const float *__restrict src = in.data();
+            float *__restrict dst = out.data();
+            const auto t0 = std::chrono::steady_clock::now();
+            for (int it = 0; it < kIterations; ++it) {
+                for (size_t i = 0; i < kBatch; ++i) dst[i] = fn(src[i]);
+                sink = sink + dst[it % kBatch];
+            }
+            const auto t1 = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::nano>(t1 - t0).count() / (double(kIterations) * kBatch);
+        };
+        char range[40];
+        std::snprintf(range, sizeof(range), "[%g, %g]", lo, hi);
+        std::printf("%-8s %-28s %12.3g %12.3g %-6s %10.3f %10.3f\n", name, range, worst, bound, pass ? "ok" : "FAIL",
+                    time(fast), time(libm));
+    };
+
+    check("exp2", -125.0f, 127.0f, false, fm::kExp2MaxRelError, [](float x) { return fm::exp2(x); },
+          [](float x) { return std::exp2(x); },
+          [](float x, float y) { return std::fabs(y / std::exp2(static_cast<double>(x)) - 1.0); });
+    check("log2", FLT_MIN, FLT_MAX, true, fm::kLog2MaxError, [](float x) { return fm::log2(x); },
+          [](float x) { return std::log2(x); },
+          [](float x, float y) {
+              const double r = std::log2(static_cast<double>(x));
+              return std::fabs(y - r) / std::max(1.0, std::fabs(r));
+          });
+    check("db2lin", -120.0f, 80.0f, false, fm::kDbMaxAbsErrorDb, [](float x) { return fm::db2lin(x); },
+          [](float x) { return std::pow(10.0f, x / 20.0f); },
+          [](float x, float y) { return std::fabs(20.0 * std::log10(static_cast<double>(y)) - x); });
+    check("lin2db", 1e-6f, 1e4f, true, fm::kDbMaxAbsErrorDb, [](float x) { return fm::lin2db(x); },
+          [](float x) { return 20.0f * std::log10(x); },
+          [](float x, float y) { return std::fabs(y - 20.0 * std::log10(static_cast<double>(x))); });
+    check("tanh", -12.0f, 12.0f, false, fm::kTanhMaxAbsError, [](float x) { return fm::tanh(x); },
+          [](float x) { return std::tanh(x); },
+          [](float x, float y) { return std::fabs(y - std::tanh(static_cast<double>(x))); });
+    check("sin", -fm::kSinMaxArg, fm::kSinMaxArg, false, fm::kSinMaxAbsError, [](float x) { return fm::sin(x); },
+          [](float x) { return std::sin(x); },
+          [](float x, float y) { return std::fabs(y - std::sin(static_cast<double>(x))); });
+    return ok ? 0 : 1;
+}
+
+// Load cost of each file against its size on disk, so a compressed copy of
+// a pack can be weighed against the WAV original.
+int runDecodeBench(const std::vector<std::string> &files) {
+    constexpr int kRuns = 3;
+    std::printf("%-40s %10s %10s %7s %10s %10s\n", "file", "disk KiB", "PCM KiB", "ratio", "decode ms", "x realtime");
+    bool ok = true;
+    for (const auto &path : files) {
+        std::error_code ec;
+        const uintmax_t diskBytes = std::filesystem::file_size(path, ec);
+        double best = 0.0;
+        size_t frames = 0;
+        double pcmBytes = 0.0;
+        double seconds = 0.0;
+        for (int run = 0; run < kRuns; ++run) {
+            audio::SampleBuffer decoded;
+            const auto t0 = std::chrono::steady_clock::now();
+            const bool decodedOk = audio::SampleCache::decode(path, decoded);
+            const auto t1 = std::chrono::steady_clock::now();
+            if (!decodedOk) break;
+            const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            if (run == 0 || ms < best) best = ms;
+            frames = decoded.frames;
+            pcmBytes = static_cast<double>(decoded.frames) * decoded.channels * decoded.bytesPerSample();
+            seconds = static_cast<double>(decoded.frames) / decoded.sampleRate;
+        }
+        if (ec || frames == 0) {
+            std::printf("%-40s failed\n", path.c_str());
+            ok = false;
+            continue;
+        }
+        std::printf("%-40s %10.0f %10.0f %7.2f %10.2f %10.0f\n", path.c_str(), static_cast<double>(diskBytes) / 1024.0,
+                    pcmBytes / 1024.0, static_cast<double>(diskBytes) / pcmBytes, best, seconds * 1000.0 / best);
+    }
+    return ok ? 0 : 1;
+}
+
+// Per-sample cost of the phasor oscillators against the per-sample sin()
+// loop they replaced, and each one's worst error against a double-precision
+// sine over a minute of output.
+int runOscBench() {
+    constexpr double kRate = 48000.0;
+    constexpr size_t kFrames = 512;
+    constexpr int kBlocks = 5625; // one minute
+    constexpr float kFreq[2] = {200.0f, 207.5f};
+    std::vector<float> left(kFrames), right(kFrames);
+
+    struct Result {
+        double ns = 0.0;
+        double maxError = 0.0;
+    };
+    // fn(block) fills left/right for that block. Error is measured on a
+    // first pass, time on a second with fresh state.
+    auto measure = [&](auto &&make) {
+        Result r;
+        auto fn = make();
+        for (int b = 0; b < kBlocks; ++b) {
+            std::fill(left.begin(), left.end(), 0.0f);
+            std::fill(right.begin(), right.end(), 0.0f);
+            fn();
+            for (size_t i = 0; i < kFrames; ++i) {
+                const double n = static_cast<double>(b) * kFrames + static_cast<double>(i);
+                const double wantL = std::sin(2.0 * 3.14159265358979323846 * kFreq[0] * n / kRate);
+                const double wantR = std::sin(2.0 * 3.14159265358979323846 * kFreq[1] * n / kRate);
+                r.maxError = std::max({r.maxError, std::fabs(left[i] - wantL), std::fabs(right[i] - wantR)});
+            }
+        }
+        auto timed = make();
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int b = 0; b < kBlocks; ++b) timed();
+        const auto t1 = std::chrono::steady_clock::now();
+        r.ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / (2.0 * kBlocks * kFrames);
+        return r;
+    };
+
+    // The loop Oscillator::processBlock used to run: sin() and a float
+    // phase per sample and channel.
+    const Result legacy = measure([&] {
+        return [&, phase = std::array<float, 2>{0.0f, 0.0f}]() mutable {
+            constexpr float kTwoPi = 6.2831853f;
+            float *out[2] = {left.data(), right.data()};
+            for (size_t c = 0; c < 2; ++c) {
+                const float delta = kTwoPi * kFreq[c] / static_cast<float>(kRate);
+                for (size_t i = 0; i < kFrames; ++i) {
+                    out[c][i] += std::sin(phase[c]);
+                    phase[c] += delta;
+                    if (phase[c] > kTwoPi) phase[c] -= kTwoPi;
+                }
+            }
+        };
+    });
+    auto tuned = [&](float freq) {
+        audio::Oscillator osc(static_cast<float>(kRate));
+        osc.setFrequency(freq);
+        return osc;
+    };
+    auto tunedPair = [&] {
+        audio::SineOscPair osc(static_cast<float>(kRate));
+        osc.setFrequencies(kFreq[0], kFreq[1]);
+        return osc;
+    };
+    const Result mono = measure([&] {
+        return [&, l = tuned(kFreq[0]), r = tuned(kFreq[1])]() mutable {
+            l.processBlock(left.data(), kFrames, 1.0f);
+            r.processBlock(right.data(), kFrames, 1.0f);
+        };
+    });
+    const Result pair = measure([&] {
+        return [&, osc = tunedPair()]() mutable { osc.processBlock(left.data(), right.data(), kFrames, 1.0f); };
+    });
+    // Glides every block (error is not meaningful: the pitch moves).
+    const Result glide = measure([&] {
+        return [&, osc = tunedPair(), up = false]() mutable {
+            up = !up;
+            osc.glideTo(kFreq[0] + (up ? 4.0f : 0.0f), kFreq[1] + (up ? 4.0f : 0.0f), kFrames);
+            osc.processBlock(left.data(), right.data(), kFrames, 1.0f);
+        };
+    });
+
+    std::printf("sine oscillators, %s kernels, %zu-frame blocks\n\n%-28s %12s %12s\n",
+                audio::simd::isaName(audio::simd::kernels().isa), kFrames, "", "ns/sample", "max error");
+    std::printf("%-28s %12.3f %12.2e\n", "std::sin per sample (old)", legacy.ns, legacy.maxError);
+    std::printf("%-28s %12.3f %12.2e\n", "Oscillator (phasor)", mono.ns, mono.maxError);
+    std::printf("%-28s %12.3f %12.2e\n", "SineOscPair (sinePair)", pair.ns, pair.maxError);
+    std::printf("%-28s %12.3f %12s\n", "SineOscPair, gliding", glide.ns, "-");
+    return 0;
+}
+
+// Cost of a 512-frame ProceduralSynth block with N voices held, for a plain
+// sine patch and the heaviest one (FM and all three waveforms), against the
+// block's realtime budget on one core.
+int runSynthBench(float sampleRate) {
+    constexpr size_t kFrames = 512;
+    constexpr int kBlocks = 400;
+    const double budgetMs = 1000.0 * kFrames / sampleRate;
+
+    audio::SynthPatch plain;
+    plain.attack = 0.01f;
+    plain.sustain = 1.0f;
+    plain.loaded = true;
+    audio::SynthPatch heavy = plain;
+    heavy.sine = 0.4f;
+    heavy.triangle = 0.3f;
+    heavy.saw = 0.3f;
+    heavy.fmIndex = 0.5f;
+    heavy.lowpassHz = 4000.0f;
+    // No pattern notes: only the voices started below play.
+    plain.tempoBpm = heavy.tempoBpm = 10.0f;
+    plain.stepBeats = heavy.stepBeats = 16.0f;
+
+    audio::AudioBus out(2, kFrames);
+    std::printf("procedural synth, %s kernels, %zu-frame blocks (budget %.2f ms)\n\n%-8s %-8s %12s %12s\n",
+                audio::simd::isaName(audio::simd::kernels().isa), kFrames, budgetMs, "patch", "voices",
+                "ms/block", "% budget");
+    for (const auto *patch : {&plain, &heavy}) {
+        for (size_t voices : {32, 64, 128, 256}) {
+            audio::ProceduralSynth synth(sampleRate, kFrames);
+            synth.setPatch(patch, 1, 0.0f);
+            for (size_t v = 0; v < voices; ++v) {
+                synth.noteOn(36.0f + static_cast<float>(v % 48), 1.0f, 3600.0f);
+            }
+            const auto t0 = std::chrono::steady_clock::now();
+            for (int b = 0; b < kBlocks; ++b) {
+                out.clear(kFrames);
+                synth.render(out, kFrames, 1.0f);
+            }
+            const auto t1 = std::chrono::steady_clock::now();
+            const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count() / kBlocks;
+            std::printf("%-8s %-8zu %12.3f %11.1f%%\n", patch == &plain ? "sine" : "fm+mix", synth.activeVoices(), ms,
+                        100.0 * ms / budgetMs);
+        }
+    }
+    return 0;
+}
+
+// Per-frame cost of a stereo 512-frame reverb block: the plate reverb the
+// engine used to run against the FDN, static and modulated, and while its
+// parameters glide. The FDN's cost does not depend on its settings.
+int runReverbBench(float sampleRate) {
+    constexpr size_t kFrames = 512;
+    constexpr int kBlocks = 2000;
+    audio::AudioBus bus(2, kFrames);
+    uint32_t seed = 1;
+    for (size_t c = 0; c < 2; ++c) {
+        for (size_t i = 0; i < kFrames; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            bus.channel(c)[i] = static_cast<float>(seed >> 8) / 16777216.0f - 0.5f;
+        }
+    }
+    // step(reverb, block) runs one block in place on the bus. Returns the
+    // mean and the 99th-percentile block, both in ns/frame; a plain maximum
+    // mostly measures preemption.
+    struct Timing {
+        double mean = 0.0;
+        double p99 = 0.0;
+    };
+    std::vector<double> blockNs(kBlocks);
+    auto measure = [&](auto &reverb, auto &&step) {
+        // Warm-up, so first-touch page faults stay out of the numbers.
+        for (int b = 0; b < 64; ++b) step(reverb, b);
+        double total = 0.0;
+        for (int b = 0; b < kBlocks; ++b) {
+            const auto t0 = std::chrono::steady_clock::now();
+            step(reverb, b);
+            const auto t1 = std::chrono::steady_clock::now();
+            blockNs[b] = std::chrono::duration<double, std::nano>(t1 - t0).count();
+            total += blockNs[b];
+        }
+        const auto p99 = blockNs.begin() + kBlocks * 99 / 100;
+        std::nth_element(blockNs.begin(), p99, blockNs.end());
+        Timing t;
+        t.mean = total / (static_cast<double>(kBlocks) * kFrames);
+        t.p99 = *p99 / static_cast<double>(kFrames);
+        return t;
+    };
+    auto steady = [&](auto &reverb, int) { reverb.process(bus, kFrames, 0.3f); };
+    // Retargets every block so the smoothers never settle.
+    auto gliding = [&](auto &reverb, int b) {
+        reverb.setParams(b & 1 ? 40.0f : 10.0f, b & 1 ? 0.8f : 0.3f, 0.25f);
+        reverb.process(bus, kFrames, b & 1 ? 0.5f : 0.2f);
+    };
+
+    audio::SimplePlateReverb plate(sampleRate);
+    audio::FdnReverb fdn(sampleRate);
+    audio::FdnReverb modulated(sampleRate);
+    modulated.setModulation(0.15f, 0.6f);
+    const double budgetNs = 1e9 / sampleRate;
+    std::printf("reverb, %s kernels, %zu-frame stereo blocks (budget %.0f ns/frame)\n\n%-28s %12s %12s %12s\n",
+                audio::simd::isaName(audio::simd::kernels().isa), kFrames, budgetNs, "", "ns/frame", "% budget",
+                "p99 block");
+    auto row = [&](const std::string &name, Timing t) {
+        std::printf("%-28s %12.2f %11.2f%% %11.2f%%\n", name.c_str(), t.mean, 100.0 * t.mean / budgetNs,
+                    100.0 * t.p99 / budgetNs);
+    };
+    row("plate (old)", measure(plate, steady));
+    row("plate, gliding", measure(plate, gliding));
+    row("fdn", measure(fdn, steady));
+    row("fdn, modulated", measure(modulated, steady));
+    row("fdn, modulated + gliding", measure(modulated, gliding));
+
+    // Convolution with decaying-noise IRs; its cost depends only on length.
+    auto convolve = [&](audio::ConvolutionReverb &reverb, int) { reverb.process(bus, kFrames, 0.3f); };
+    for (float seconds : {1.0f, 3.0f, audio::ConvolutionIr::kMaxSeconds}) {
+        const size_t taps = static_cast<size_t>(seconds * sampleRate);
+        std::vector<float> left(taps), right(taps);
+        for (size_t i = 0; i < taps; ++i) {
+            const float env = std::exp(-6.9f * static_cast<float>(i) / static_cast<float>(taps));
+            seed = seed * 1664525u + 1013904223u;
+            left[i] = env * (static_cast<float>(seed >> 8) / 16777216.0f - 0.5f);
+            seed = seed * 1664525u + 1013904223u;
+            right[i] = env * (static_cast<float>(seed >> 8) / 16777216.0f - 0.5f);
+        }
+        audio::ConvolutionIr ir;
+        ir.build(left.data(), right.data(), taps);
+        audio::ConvolutionReverb reverb(sampleRate);
+        reverb.reserve(taps);
+        reverb.setIr(&ir, 0);
+        char name[64];
+        std::snprintf(name, sizeof(name), "convolution, %.0f s IR", seconds);
+        row(name, measure(reverb, convolve));
+    }
+    return 0;
+}
+
+// True-peak accuracy and cost of the limiters. The test signal mixes high
+// tones, noise bursts (band-limited to 19.2 kHz at 48 kHz, like program
+// material) and a quarter-rate sine sampled 45 degrees off its peaks, so
+// most peaks fall between samples, pushed up to +6 dBFS. Output true peaks
+// are measured independently of the limiter's 4x detector, with a 16x,
+// 128-tap double-precision interpolator, on the limiter alone and on the
+// engine's final output, where the binaural bed is mixed in ahead of the
+// limiter and the result interleaved and clamped. Fails if either
+// exceeds its ceiling by more than kTruePeakToleranceDb: a 4x grid
+// can miss the top of a peak by up to 20 log10(cos(pi f / 4 fs)) dB, 0.43
+// dB at 0.4 fs, as BS.1770 meters do.
+int runLimiterBench(float sampleRate) {
+    constexpr size_t kFrames = 512;
+    constexpr int kBlocks = 2000;
+    constexpr float kCeilingDb = -1.0f;
+    constexpr double kTruePeakToleranceDb = 0.5;
+    constexpr double kPi = 3.14159265358979323846;
+    const size_t total = static_cast<size_t>(10.0f * sampleRate) / kFrames * kFrames;
+    auto sinc = [&](double d) { return std::fabs(d) < 1e-12 ? 1.0 : std::sin(kPi * d) / (kPi * d); };
+
+    std::array<std::vector<float>, 2> loud;
+    uint32_t seed = 7;
+    constexpr int kNoiseHalf = 128;
+    constexpr double kNoiseBand = 0.8; // of the Nyquist frequency
+    std::vector<double> white(total + 2 * kNoiseHalf);
+    for (size_t c = 0; c < 2; ++c) {
+        for (double &w : white) {
+            seed = seed * 1664525u + 1013904223u;
+            w = static_cast<double>(seed >> 8) / 8388608.0 - 1.0;
+        }
+        loud[c].resize(total);
+        for (size_t i = 0; i < total; ++i) {
+            const double t = static_cast<double>(i) / sampleRate;
+            const double section = std::fmod(t, 2.5);
+            double v = 0.0;
+            if (section < 1.0) {
+                v = 0.9 * std::sin(2.0 * kPi * (0.38 * sampleRate) * t + c) +
+                    0.9 * std::sin(2.0 * kPi * (0.3 * sampleRate) * t);
+            } else if (section < 2.0) {
+                double noise = 0.0;
+                for (int j = -kNoiseHalf; j <= kNoiseHalf; ++j) {
+                    const double w = std::cos(0.5 * kPi * j / kNoiseHalf);
+                    noise += white[i + kNoiseHalf + j] * kNoiseBand * sinc(kNoiseBand * j) * w * w;
+                }
+                v = 1.2 * noise * std::exp(-12.0 * std::fmod(section - 1.0, 0.25));
+            } else {
+                v = 1.9 * std::sin(0.5 * kPi * static_cast<double>(i) + 0.25 * kPi);
+            }
+            loud[c][i] = static_cast<float>(v);
+        }
+    }
+
+    // Windowed-sinc reference at 16x; the first and last 64 samples are
+    // skipped.
+    auto truePeakDb = [&](const std::vector<float> &x) {
+        constexpr int kUp = 16;
+        constexpr int kHalf = 64;
+        double peak = 0.0;
+        for (size_t i = kHalf; i + kHalf < x.size(); ++i) {
+            peak = std::max(peak, std::fabs(static_cast<double>(x[i])));
+            for (int r = 1; r < kUp; ++r) {
+                const double frac = static_cast<double>(r) / kUp;
+                double y = 0.0;
+                for (int j = -kHalf + 1; j <= kHalf; ++j) {
+                    const double d = static_cast<double>(j) - frac;
+                    const double w = std::cos(0.5 * kPi * d / kHalf);
+                    y += x[i + j] * sinc(d) * w * w;
+                }
+                peak = std::max(peak, std::fabs(y));
+            }
+        }
+        return 20.0 * std::log10(std::max(peak, 1e-12));
+    };
+    auto samplePeakDb = [](const std::vector<float> &x) {
+        float peak = 0.0f;
+        for (float v : x) peak = std::max(peak, std::fabs(v));
+        return 20.0 * std::log10(std::max(static_cast<double>(peak), 1e-12));
+    };
+
+    // Runs the whole signal through `limiter` in kFrames blocks; returns
+    // the output with the limiter's latency removed. With bed set, the
+    // blocks go through the tail of Engine::renderChunk instead: binaural
+    // bed, limiter, interleave and clamp.
+    auto run = [&](auto &limiter, size_t latency, bool bed = false) {
+        audio::AudioBus bus(2, kFrames);
+        audio::SineOscPair binaural(sampleRate);
+        binaural.setFrequencies(120.0f, 126.0f);
+        std::vector<float> interleaved(2 * kFrames);
+        const auto &k = audio::simd::kernels();
+        std::array<std::vector<float>, 2> out;
+        for (auto &o : out) o.assign(total, 0.0f);
+        for (size_t pos = 0; pos < total; pos += kFrames) {
+            for (size_t c = 0; c < 2; ++c) std::memcpy(bus.channel(c), loud[c].data() + pos, kFrames * sizeof(float));
+            if (bed) binaural.processBlock(bus.channel(0), bus.channel(1), kFrames, audio::Engine::kBinauralGain);
+            limiter.process(bus, kFrames);
+            if (bed) {
+                k.interleave2(interleaved.data(), bus.channel(0), bus.channel(1), kFrames);
+                k.clamp(interleaved.data(), -1.0f, 1.0f, 2 * kFrames);
+                for (size_t i = 0; i < kFrames; ++i) {
+                    out[0][pos + i] = interleaved[2 * i];
+                    out[1][pos + i] = interleaved[2 * i + 1];
+                }
+                continue;
+            }
+            for (size_t c = 0; c < 2; ++c) std::memcpy(out[c].data() + pos, bus.channel(c), kFrames * sizeof(float));
+        }
+        for (auto &o : out) o.erase(o.begin(), o.begin() + static_cast<std::ptrdiff_t>(latency));
+        return out;
+    };
+
+    bool ok = true;
+    std::printf("limiters, ceiling %.1f dBTP, 10 s stereo test signal\n\n%-22s %14s %14s\n", kCeilingDb, "",
+                "sample peak", "true peak");
+    auto report = [&](const char *name, const std::array<std::vector<float>, 2> &x, bool check) {
+        const double sp = std::max(samplePeakDb(x[0]), samplePeakDb(x[1]));
+        const double tp = std::max(truePeakDb(x[0]), truePeakDb(x[1]));
+        const bool pass = !check || tp <= kCeilingDb + kTruePeakToleranceDb;
+        ok = ok && pass;
+        std::printf("%-22s %10.2f dBFS %10.2f dBTP%s\n", name, sp, tp, check ? (pass ? "  ok" : "  OVER") : "");
+    };
+    report("input", loud, false);
+    audio::SoftLimiter soft(kCeilingDb, 0.05f);
+    report("soft limiter (old)", run(soft, 0), false);
+    audio::LookaheadLimiter lookahead(sampleRate, kCeilingDb);
+    report("lookahead limiter", run(lookahead, lookahead.latencyFrames()), true);
+    audio::LookaheadLimiter engineLimiter(sampleRate, kCeilingDb);
+    report("engine output", run(engineLimiter, engineLimiter.latencyFrames(), true), true);
+    std::printf("lookahead latency: %zu frames (%.2f ms)\n\n", lookahead.latencyFrames(),
+                1000.0 * static_cast<double>(lookahead.latencyFrames()) / sampleRate);
+
+    // Cost per 512-frame stereo block, with the bus under the ceiling (the
+    // usual case) and with every block limiting.
+    audio::AudioBus bus(2, kFrames);
+    auto time = [&](auto &limiter, float gain) {
+        auto fill = [&](int b) {
+            const size_t pos = static_cast<size_t>(b) * kFrames % total;
+            for (size_t c = 0; c < 2; ++c) {
+                for (size_t i = 0; i < kFrames; ++i) bus.channel(c)[i] = loud[c][pos + i] * gain;
+            }
+        };
+        std::vector<double> blockNs(kBlocks);
+        double sum = 0.0;
+        for (int b = -64; b < kBlocks; ++b) {
+            fill(b < 0 ? 0 : b);
+            const auto t0 = std::chrono::steady_clock::now();
+            limiter.process(bus, kFrames);
+            const auto t1 = std::chrono::steady_clock::now();
+            if (b < 0) continue; // warm-up
+            blockNs[b] = std::chrono::duration<double, std::nano>(t1 - t0).count();
+            sum += blockNs[b];
+        }
+        const auto p99 = blockNs.begin() + kBlocks * 99 / 100;
+        std::nth_element(blockNs.begin(), p99, blockNs.end());
+        return std::pair<double, double>(sum / (static_cast<double>(kBlocks) * kFrames), *p99 / kFrames);
+    };
+    const double budgetNs = 1e9 / sampleRate;
+    std::printf("%s kernels, %zu-frame stereo blocks (budget %.0f ns/frame)\n\n%-28s %12s %12s %12s\n",
+                audio::simd::isaName(audio::simd::kernels().isa), kFrames, budgetNs, "", "ns/frame", "% budget",
+                "p99 block");
+    auto row = [&](const char *name, std::pair<double, double> t) {
+        std::printf("%-28s %12.2f %11.2f%% %11.2f%%\n", name, t.first, 100.0 * t.first / budgetNs,
+                    100.0 * t.second / budgetNs);
+    };
+    audio::SoftLimiter softTimed(kCeilingDb, 0.05f);
+    row("soft limiter (old)", time(softTimed, 1.0f));
+    audio::LookaheadLimiter quiet(sampleRate, kCeilingDb);
+    row("lookahead, under ceiling", time(quiet, 0.25f));
+    audio::LookaheadLimiter limiting(sampleRate, kCeilingDb);
+    row("lookahead, limiting", time(limiting, 1.0f));
+    return ok ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        printUsage();
+        return 2;
+    }
+    if (opt.simdCheck) {
+        return runSimdCheck();
+    }
+    if (opt.fastmathCheck) {
+        return runFastmathCheck();
+    }
+    if (!opt.decodeBench.empty()) {
+        return runDecodeBench(opt.decodeBench);
+    }
+    if (opt.oscBench) {
+        return runOscBench();
+    }
+    if (opt.synthBench) {
+        return runSynthBench(opt.sampleRate);
+    }
+    if (opt.reverbBench) {
+        return runReverbBench(opt.sampleRate);
+    }
+    if (opt.limiterBench) {
+        return runLimiterBench(opt.sampleRate);
+    }
+    util::logInfo(std::string("SIMD kernels: ") + audio::simd::isaName(audio::simd::kernels().isa));
+
+    bool loaded = false;
+    auto pack = config::MoodLoader::loadFromFile(opt.packPath, loaded);
+    if (pack.moods.empty()) {
+        util::logError("keegan_render: mood pack is empty");
+        return 1;
+    }
+
+    // Streamed stems wait for the disk rather than underrun when rendering
+    // faster than real time.
+    audio::StemStream::setBlockingReads(true);
+
+    std::error_code ec;
+    std::filesystem::create_directories(opt.outDir, ec);
+
+    auto knownMood = [&](const std::string &id) {
+        return std::any_of(pack.moods.begin(), pack.moods.end(),
+                           [&](const brain::MoodRecipe &m) { return m.id == id; });
+    };
+
+    std::vector<RenderJob> jobs;
+    if (!opt.timeline.empty()) {
+        RenderJob job;
+        if (!parseTimeline(opt.timeline, job.timeline)) {
+            std::cerr << "invalid --timeline\n";
+            return 2;
+        }
+        // The engine would fall back to the first mood or ignore the change.
+        for (const auto &e : job.timeline) {
+            if (!knownMood(e.moodId)) {
+                std::cerr << "unknown mood in --timeline: " << e.moodId << "\n";
+                return 2;
+            }
+        }
+        job.name = "timeline";
+        jobs.push_back(std::move(job));
+    }
+    if (opt.allMoods) {
+        for (const auto &m : pack.moods) opt.moods.push_back(m.id);
+    }
+    if (jobs.empty() && opt.moods.empty()) {
+        opt.moods.push_back(pack.moods.front().id);
+    }
+    for (const auto &id : opt.moods) {
+        if (!knownMood(id)) {
+            std::cerr << "unknown mood: " << id << "\n";
+            return 2;
+        }
+        RenderJob job;
+        job.name = id;
+        job.timeline.push_back({0.0, id});
+        jobs.push_back(std::move(job));
+    }
+    for (auto &job : jobs) {
+        job.outPath = (std::filesystem::path(opt.outDir) / (job.name + ".wav")).string();
+    }
+
+    unsigned workers = opt.jobs ? opt.jobs : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::min<unsigned>(workers, static_cast<unsigned>(jobs.size()));
+
+    std::vector<RenderResult> results(jobs.size());
+    std::atomic<size_t> nextJob{0};
+    const auto wallStart = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned w = 0; w < workers; ++w) {
+        threads.emplace_back([&]() {
+            for (size_t i = nextJob.fetch_add(1); i < jobs.size(); i = nextJob.fetch_add(1)) {
+                results[i] = runJob(jobs[i], pack, opt);
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    // Realtime factor counts only time spent inside renderBlock (no WAV I/O).
+    double totalAudio = 0.0;
+    bool allOk = true;
+    std::printf("\n%-16s %10s %10s %10s\n", "render", "audio s", "dsp s", "x realtime");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto &r = results[i];
+        allOk = allOk && r.ok;
+        totalAudio += r.renderedSeconds;
+        const double factor = r.wallSeconds > 0.0 ? r.renderedSeconds / r.wallSeconds : 0.0;
+        std::printf("%-16s %10.1f %10.3f %10.1f  %s\n", r.name.c_str(), r.renderedSeconds,
+                    r.wallSeconds, factor, r.ok ? jobs[i].outPath.c_str() : "FAILED");
+    }
+    std::printf("%u worker(s), %.1f s audio in %.2f s wall (%.1fx realtime aggregate)\n",
+                workers, totalAudio, wall, wall > 0.0 ? totalAudio / wall : 0.0);
+    std::printf("%s\n", audio::SampleCache::instance().statsLine().c_str());
+    const auto streams = audio::StemStream::stats();
+    if (streams.opened > 0) {
+        std::printf("%s\n", audio::StemStream::statsLine().c_str());
+    }
+
+    if (opt.profile) {
+        // Window covers the last audio::DspProfiler::kWindow blocks of each render.
+        for (const auto &r : results) {
+            if (!r.ok) continue;
+            std::printf("\n%s (ns/sample)\n%-16s %10s %10s %10s\n", r.name.c_str(),
+                        "stage", "avg", "p99", "max");
+            for (const auto &st : r.profile.stages) {
+                std::printf("%-16s %10.2f %10.2f %10.2f\n", st.name, st.avgNsPerSample,
+                            st.p99NsPerSample, st.maxNsPerSample);
+            }
+            std::printf("load %.3f%% avg, %.3f%% p99 of realtime budget\n",
+                        r.profile.avgLoad * 100.0f, r.profile.p99Load * 100.0f);
+        }
+    }
+
+#if KEEGAN_RT_CHECKS
+    const auto violations = audio::rtcheck::violations();
+    std::printf("\nRT check: %llu violation(s) on the audio thread\n",
+                static_cast<unsigned long long>(audio::rtcheck::totalViolations()));
+    for (const auto &v : violations) {
+        std::printf("  %-16s %-14s %llu\n", audio::dspStageName(v.stage),
+                    audio::rtcheck::kindName(v.kind), static_cast<unsigned long long>(v.count));
+    }
+    allOk = allOk && violations.empty();
+#endif
+    return allOk ? 0 : 1;
+}
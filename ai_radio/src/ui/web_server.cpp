@@ -3,6 +3,9 @@
 #include "../../vendor/vjson/vjson.h"
 #include "../util/logger.h"
 #include "../util/telemetry.h"
+#include "../util/startup_profile.h"
+#include "../audio/sample_cache.h"
+#include "../audio/stem_stream.h"
 #include <filesystem>
 #include <sstream>
 #include <fstream>
@@ -277,8 +280,8 @@ std::string readTextFile(const std::string& path) {
     return ss.str();
 }
 
-std::string readCachedStationId() {
-    auto data = readTextFile("cache/station_id.txt");
+std::string readCachedStationId(const std::string& dir) {
+    auto data = readTextFile(dir + "/station_id.txt");
     if (data.empty()) return "";
     // Trim simple whitespace
     while (!data.empty() && (data.back() == '\n' || data.back() == '\r' || data.back() == ' ' || data.back() == '\t')) {
@@ -287,10 +290,10 @@ std::string readCachedStationId() {
     return data;
 }
 
-void writeCachedStationId(const std::string& id) {
+void writeCachedStationId(const std::string& dir, const std::string& id) {
     if (id.empty()) return;
-    std::filesystem::create_directories("cache");
-    std::ofstream f("cache/station_id.txt", std::ios::binary);
+    std::filesystem::create_directories(dir);
+    std::ofstream f(dir + "/station_id.txt", std::ios::binary);
     if (f.good()) {
         f << id;
     }
@@ -301,9 +304,9 @@ struct StationTokenCache {
     uint64_t expiresAtMs = 0;
 };
 
-StationTokenCache readCachedStationToken() {
+StationTokenCache readCachedStationToken(const std::string& dir) {
     StationTokenCache out;
-    auto raw = readTextFile("cache/station_token.json");
+    auto raw = readTextFile(dir + "/station_token.json");
     if (raw.empty()) return out;
     auto parsed = vjson::parse(raw);
     if (!parsed.has_value() || !parsed->isObject()) return out;
@@ -319,9 +322,9 @@ StationTokenCache readCachedStationToken() {
     return out;
 }
 
-void writeCachedStationToken(const std::string& token, uint64_t expiresAtMs) {
-    std::filesystem::create_directories("cache");
-    std::ofstream f("cache/station_token.json", std::ios::binary);
+void writeCachedStationToken(const std::string& dir, const std::string& token, uint64_t expiresAtMs) {
+    std::filesystem::create_directories(dir);
+    std::ofstream f(dir + "/station_token.json", std::ios::binary);
     if (!f.good()) return;
     f << "{";
     f << "\"token\":\"" << escapeJson(token) << "\",";
@@ -329,9 +332,9 @@ void writeCachedStationToken(const std::string& token, uint64_t expiresAtMs) {
     f << "}";
 }
 
-void clearCachedStationToken() {
+void clearCachedStationToken(const std::string& dir) {
     std::error_code ec;
-    std::filesystem::remove("cache/station_token.json", ec);
+    std::filesystem::remove(dir + "/station_token.json", ec);
 }
 
 float getNumber(const vjson::Value& obj, const std::string& key, float def = 0.0f) {
@@ -367,6 +370,29 @@ std::string stateJson(const audio::PublicState& state) {
     return ss.str();
 }
 
+std::string dspProfileJson(const audio::DspProfile& profile) {
+    std::stringstream ss;
+    ss << "{";
+    ss << "\"budgetNsPerSample\":" << profile.budgetNsPerSample << ",";
+    ss << "\"avgLoad\":" << profile.avgLoad << ",";
+    ss << "\"p99Load\":" << profile.p99Load << ",";
+    ss << "\"stages\":[";
+    for (size_t i = 0; i < profile.stages.size(); ++i) {
+        const auto& st = profile.stages[i];
+        if (i > 0) ss << ",";
+        ss << "{";
+        ss << "\"stage\":\"" << st.name << "\",";
+        ss << "\"avgNsPerSample\":" << st.avgNsPerSample << ",";
+        ss << "\"p99NsPerSample\":" << st.p99NsPerSample << ",";
+        ss << "\"maxNsPerSample\":" << st.maxNsPerSample << ",";
+        ss << "\"blocks\":" << st.blocks;
+        ss << "}";
+    }
+    ss << "]";
+    ss << "}";
+    return ss.str();
+}
+
 float timeOfDay01() {
     auto now = std::chrono::system_clock::now();
     std::time_t tt = std::chrono::system_clock::to_time_t(now);
@@ -439,7 +465,26 @@ std::string stationPayloadJson(const StationConfig& cfg,
 } // namespace
 
 WebServer::WebServer(audio::Engine& engine, int port)
-    : engine_(engine), port_(port), running_(false) {}
+    : port_(port), hosted_(false), running_(false) {
+    stations_.push_back(std::make_unique<Station>(engine));
+}
+
+WebServer::WebServer(std::vector<HostedStation> stations, int port)
+    : port_(port), hosted_(true), running_(false) {
+    for (auto& hosted : stations) {
+        const std::string& id = hosted.config.id;
+        if (!hosted.engine || id.empty() || id.find('.') != std::string::npos ||
+            id.find('/') != std::string::npos || findStation(id)) {
+            util::logError("WebServer: skipping station with missing, invalid or duplicate id '" + id + "'");
+            continue;
+        }
+        auto station = std::make_unique<Station>(*hosted.engine);
+        station->routeId = id;
+        station->cacheDir = "cache/stations/" + id;
+        station->stationConfig = std::move(hosted.config);
+        stations_.push_back(std::move(station));
+    }
+}
 
 WebServer::~WebServer() {
     stop();
@@ -447,19 +492,38 @@ WebServer::~WebServer() {
 
 bool WebServer::start() {
     if (running_) return true;
+    if (stations_.empty()) {
+        util::logError("WebServer: no stations to serve");
+        return false;
+    }
 
     running_ = true;
-    loadStationConfig();
+    loadSecrets();
+    for (auto& station : stations_) {
+        if (hosted_) {
+            // A registry-assigned id cached for this station wins over the
+            // configured one, as in single-station mode.
+            auto cached = readCachedStationId(station->cacheDir);
+            station->stationId = cached.empty() ? station->routeId : cached;
+            station->stationConfig.id = station->stationId;
+            loadCachedToken(*station);
+        } else {
+            loadStationConfig(*station);
+        }
+    }
     serverThread_ = std::thread(&WebServer::run, this);
     registryThread_ = std::thread(&WebServer::runRegistryClient, this);
-    wsServer_ = std::make_unique<WsServer>([this]() {
-        auto state = engine_.snapshot();
+    wsServer_ = std::make_unique<WsServer>([this](const std::string& channel) {
+        Station* station = channel.empty() ? stations_.front().get() : findStation(channel);
+        if (!station) return std::string();
+        auto state = station->engine.snapshot();
         return stateJson(state);
     }, port_ + 1, bridgeApiKey_);
     wsServer_->start();
     util::logInfo("WebServer: WS started on port " + std::to_string(port_ + 1));
     
-    util::logInfo("WebServer: Started on port " + std::to_string(port_));
+    util::logInfo("WebServer: Started on port " + std::to_string(port_) +
+                  (hosted_ ? " for " + std::to_string(stations_.size()) + " stations" : ""));
     return true;
 }
 
@@ -496,14 +560,40 @@ void WebServer::run() {
         addCors(res);
         return false;
     };
-    auto validateToken = [&](const std::string& token, TokenPayload& payload) {
+    auto validateToken = [&](Station& st, const std::string& token, TokenPayload& payload) {
         if (token.empty()) return false;
         if (!parseToken(token, payload, broadcastSecret_)) return false;
-        if (payload.stationId != stationId_) return false;
+        if (payload.stationId != st.stationId) return false;
         if (nowMs() > payload.expiresAt) return false;
         return true;
     };
 
+    // Station-scoped endpoints are served at /api<suffix> for the first
+    // station and at /api/stations/<id><suffix> for every hosted station.
+    using StationHandler = std::function<void(Station&, const httplib::Request&, httplib::Response&)>;
+    auto route = [&](bool post, const std::string& suffix, StationHandler handler) {
+        auto first = [this, handler](const httplib::Request& req, httplib::Response& res) {
+            handler(*stations_.front(), req, res);
+        };
+        auto scoped = [&, handler](const httplib::Request& req, httplib::Response& res) {
+            Station* st = findStation(req.path_params.count("station") ? req.path_params.at("station") : "");
+            if (!st) {
+                res.status = 404;
+                res.set_content("{\"error\":\"unknown_station\"}", "application/json");
+                addCors(res);
+                return;
+            }
+            handler(*st, req, res);
+        };
+        if (post) {
+            svr.Post("/api" + suffix, first);
+            svr.Post("/api/stations/:station" + suffix, scoped);
+        } else {
+            svr.Get("/api" + suffix, first);
+            svr.Get("/api/stations/:station" + suffix, scoped);
+        }
+    };
+
     svr.Options(R"(/api/.*)", [&](const httplib::Request& req, httplib::Response& res) {
         (void)req;
         addCors(res);
@@ -511,25 +601,25 @@ void WebServer::run() {
     });
 
     // API Endpoint: Get Current State
-    svr.Get("/api/state", [&](const httplib::Request& req, httplib::Response& res) {
+    route(false, "/state", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
         (void)req;
-        auto state = engine_.snapshot();
+        auto state = st.engine.snapshot();
         res.set_content(stateJson(state), "application/json");
         addCors(res);
     });
 
     // Toggle Play/Pause
-    svr.Post("/api/toggle", [&](const httplib::Request& req, httplib::Response& res) {
+    route(true, "/toggle", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
         (void)req;
         if (!requireAuth(req, res)) return;
-        bool playing = !engine_.isPlaying();
-        engine_.setPlaying(playing);
+        bool playing = !st.engine.isPlaying();
+        st.engine.setPlaying(playing);
         res.set_content(makeJson("playing", playing ? "true" : "false"), "application/json");
         addCors(res);
     });
 
     // Set mood
-    svr.Post("/api/mood", [&](const httplib::Request& req, httplib::Response& res) {
+    route(true, "/mood", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
         if (!requireAuth(req, res)) return;
         std::string mood;
         if (!req.body.empty()) {
@@ -546,29 +636,29 @@ void WebServer::run() {
             addCors(res);
             return;
         }
-        engine_.setMood(mood);
-        auto state = engine_.snapshot();
+        st.engine.setMood(mood);
+        auto state = st.engine.snapshot();
         res.set_content(stateJson(state), "application/json");
         addCors(res);
     });
 
     // Vibe vector (privacy-safe)
-    svr.Get("/api/vibe", [&](const httplib::Request& req, httplib::Response& res) {
+    route(false, "/vibe", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
         (void)req;
-        auto state = engine_.snapshot();
+        auto state = st.engine.snapshot();
         res.set_content(vibeJson(state), "application/json");
         addCors(res);
     });
 
     // Broadcast token stub
-    svr.Post("/api/broadcast/token", [&](const httplib::Request& req, httplib::Response& res) {
+    route(true, "/broadcast/token", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
         (void)req;
         if (!requireAuth(req, res)) return;
         uint64_t expiry = nowMs() + 10 * 60 * 1000;
-        std::string token = issueToken(stationId_, expiry, broadcastSecret_);
+        std::string token = issueToken(st.stationId, expiry, broadcastSecret_);
         {
-            std::lock_guard<std::mutex> lock(broadcastMutex_);
-            broadcastTokenExpiryMs_ = expiry;
+            std::lock_guard<std::mutex> lock(st.broadcastMutex);
+            st.broadcastTokenExpiryMs = expiry;
         }
         std::stringstream ss;
         ss << "{";
@@ -581,7 +671,7 @@ void WebServer::run() {
     });
 
     // Broadcast ingest info
-    svr.Get("/api/broadcast/ingest", [&](const httplib::Request& req, httplib::Response& res) {
+    route(false, "/broadcast/ingest", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
         if (!requireAuth(req, res)) return;
         std::string token = req.get_header_value("X-Broadcast-Token", "");
         if (token.empty()) {
@@ -596,12 +686,12 @@ void WebServer::run() {
         std::string sessionId;
         uint64_t startedAt = 0;
         {
-            std::lock_guard<std::mutex> lock(broadcastMutex_);
+            std::lock_guard<std::mutex> lock(st.broadcastMutex);
             TokenPayload payload;
-            valid = validateToken(token, payload);
-            broadcasting = broadcasting_;
-            sessionId = broadcastSessionId_;
-            startedAt = broadcastStartedMs_;
+            valid = validateToken(st, token, payload);
+            broadcasting = st.broadcasting;
+            sessionId = st.broadcastSessionId;
+            startedAt = st.broadcastStartedMs;
         }
         if (!valid) {
             res.status = 401;
@@ -631,7 +721,7 @@ void WebServer::run() {
     });
 
     // Broadcast start stub
-    svr.Post("/api/broadcast/start", [&](const httplib::Request& req, httplib::Response& res) {
+    route(true, "/broadcast/start", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
         (void)req;
         if (!requireAuth(req, res)) return;
         std::string token;
@@ -656,14 +746,14 @@ void WebServer::run() {
         }
         bool valid = false;
         {
-            std::lock_guard<std::mutex> lock(broadcastMutex_);
+            std::lock_guard<std::mutex> lock(st.broadcastMutex);
             TokenPayload payload;
-            valid = validateToken(token, payload);
+            valid = validateToken(st, token, payload);
             if (valid) {
-                broadcasting_ = true;
-                broadcastStartedMs_ = nowMs();
-                broadcastUpdatedMs_ = broadcastStartedMs_;
-                broadcastSessionId_ = "sess_" + randomHex(10);
+                st.broadcasting = true;
+                st.broadcastStartedMs = nowMs();
+                st.broadcastUpdatedMs = st.broadcastStartedMs;
+                st.broadcastSessionId = "sess_" + randomHex(10);
             }
         }
         if (!valid) {
@@ -676,18 +766,18 @@ void WebServer::run() {
             streamUrl = "http://localhost:8888/live/" + token + "/index.m3u8";
         }
         {
-            std::lock_guard<std::mutex> lock(stationMutex_);
-            stationConfig_.streamUrl = streamUrl;
+            std::lock_guard<std::mutex> lock(st.stationMutex);
+            st.stationConfig.streamUrl = streamUrl;
         }
         util::Telemetry::instance().record("broadcast_start", {
-            {"stationId", stationId_},
-            {"sessionId", broadcastSessionId_}
+            {"stationId", st.stationId},
+            {"sessionId", st.broadcastSessionId}
         });
         std::stringstream ss;
         ss << "{";
         ss << "\"broadcasting\":true,";
-        ss << "\"sessionId\":\"" << broadcastSessionId_ << "\",";
-        ss << "\"startedAtMs\":" << broadcastStartedMs_ << ",";
+        ss << "\"sessionId\":\"" << st.broadcastSessionId << "\",";
+        ss << "\"startedAtMs\":" << st.broadcastStartedMs << ",";
         ss << "\"streamUrl\":\"" << streamUrl << "\"";
         ss << "}";
         res.set_content(ss.str(), "application/json");
@@ -695,7 +785,7 @@ void WebServer::run() {
     });
 
     // Broadcast stop stub
-    svr.Post("/api/broadcast/stop", [&](const httplib::Request& req, httplib::Response& res) {
+    route(true, "/broadcast/stop", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
         (void)req;
         if (!requireAuth(req, res)) return;
         std::string token;
@@ -718,12 +808,12 @@ void WebServer::run() {
         }
         bool valid = false;
         {
-            std::lock_guard<std::mutex> lock(broadcastMutex_);
+            std::lock_guard<std::mutex> lock(st.broadcastMutex);
             TokenPayload payload;
-            valid = validateToken(token, payload);
+            valid = validateToken(st, token, payload);
             if (valid) {
-                broadcasting_ = false;
-                broadcastUpdatedMs_ = nowMs();
+                st.broadcasting = false;
+                st.broadcastUpdatedMs = nowMs();
             }
         }
         if (!valid) {
@@ -733,15 +823,15 @@ void WebServer::run() {
             return;
         }
         util::Telemetry::instance().record("broadcast_stop", {
-            {"stationId", stationId_},
-            {"sessionId", broadcastSessionId_}
+            {"stationId", st.stationId},
+            {"sessionId", st.broadcastSessionId}
         });
         res.set_content("{\"broadcasting\":false}", "application/json");
         addCors(res);
     });
 
     // Broadcast status
-    svr.Get("/api/broadcast/status", [&](const httplib::Request& req, httplib::Response& res) {
+    route(false, "/broadcast/status", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
         (void)req;
         if (!requireAuth(req, res)) return;
         bool broadcasting = false;
@@ -751,16 +841,16 @@ void WebServer::run() {
         uint64_t tokenExpiry = 0;
         std::string streamUrl;
         {
-            std::lock_guard<std::mutex> lock(broadcastMutex_);
-            broadcasting = broadcasting_;
-            sessionId = broadcastSessionId_;
-            startedAt = broadcastStartedMs_;
-            updatedAt = broadcastUpdatedMs_;
-            tokenExpiry = broadcastTokenExpiryMs_;
+            std::lock_guard<std::mutex> lock(st.broadcastMutex);
+            broadcasting = st.broadcasting;
+            sessionId = st.broadcastSessionId;
+            startedAt = st.broadcastStartedMs;
+            updatedAt = st.broadcastUpdatedMs;
+            tokenExpiry = st.broadcastTokenExpiryMs;
         }
         {
-            std::lock_guard<std::mutex> lock(stationMutex_);
-            streamUrl = stationConfig_.streamUrl;
+            std::lock_guard<std::mutex> lock(st.stationMutex);
+            streamUrl = st.stationConfig.streamUrl;
         }
         std::stringstream ss;
         ss << "{";
@@ -775,6 +865,70 @@ void WebServer::run() {
         addCors(res);
     });
 
+    // Per-stage DSP timings (rolling window, read without stopping audio)
+    route(false, "/dsp/profile", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
+        (void)req;
+        res.set_content(dspProfileJson(st.engine.dspProfile()), "application/json");
+        addCors(res);
+    });
+
+    // Stations served by this process
+    svr.Get("/api/stations", [&](const httplib::Request& req, httplib::Response& res) {
+        (void)req;
+        std::stringstream ss;
+        ss << "{\"stations\":[";
+        for (size_t i = 0; i < stations_.size(); ++i) {
+            Station& st = *stations_[i];
+            auto state = st.engine.snapshot();
+            std::string name;
+            {
+                std::lock_guard<std::mutex> lock(st.stationMutex);
+                name = st.stationConfig.name;
+            }
+            if (i > 0) ss << ",";
+            ss << "{";
+            ss << "\"id\":\"" << escapeJson(st.routeId) << "\",";
+            ss << "\"name\":\"" << escapeJson(name) << "\",";
+            ss << "\"mood\":\"" << escapeJson(state.moodId) << "\",";
+            ss << "\"energy\":" << state.energy << ",";
+            ss << "\"playing\":" << (state.playing ? "true" : "false");
+            ss << "}";
+        }
+        ss << "]}";
+        res.set_content(ss.str(), "application/json");
+        addCors(res);
+    });
+
+    // Process-wide decoded sample cache
+    svr.Get("/api/samples/cache", [&](const httplib::Request& req, httplib::Response& res) {
+        (void)req;
+        const auto s = audio::SampleCache::instance().stats();
+        const auto streams = audio::StemStream::stats();
+        std::stringstream ss;
+        ss << "{";
+        ss << "\"hits\":" << s.hits << ",";
+        ss << "\"misses\":" << s.misses << ",";
+        ss << "\"shared\":" << s.shared << ",";
+        ss << "\"packed\":" << s.packed << ",";
+        ss << "\"evictions\":" << s.evictions << ",";
+        ss << "\"entries\":" << s.entries << ",";
+        ss << "\"residentBytes\":" << s.residentBytes << ",";
+        ss << "\"budgetBytes\":" << s.budgetBytes << ",";
+        ss << "\"streams\":" << streams.streams << ",";
+        ss << "\"streamBufferBytes\":" << streams.bufferBytes << ",";
+        ss << "\"streamUnderruns\":" << streams.underruns;
+        ss << "}";
+        res.set_content(ss.str(), "application/json");
+        addCors(res);
+    });
+
+    // Startup phase timings and time to first audio
+    svr.Get("/api/startup", [&](const httplib::Request& req, httplib::Response& res) {
+        (void)req;
+        res.set_content(util::StartupProfile::instance().json(), "application/json");
+        addCors(res);
+    });
+
     // Health
     svr.Get("/api/health", [&](const httplib::Request& req, httplib::Response& res) {
         (void)req;
@@ -783,15 +937,15 @@ void WebServer::run() {
     });
 
     // Pairing start (creates code for current station)
-    svr.Post("/api/pairing/start", [&](const httplib::Request& req, httplib::Response& res) {
+    route(true, "/pairing/start", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
         (void)req;
         if (!requireAuth(req, res)) return;
         std::string registryUrl;
         std::string stationId;
         {
-            std::lock_guard<std::mutex> lock(stationMutex_);
-            registryUrl = stationConfig_.registryUrl;
-            stationId = stationId_;
+            std::lock_guard<std::mutex> lock(st.stationMutex);
+            registryUrl = st.stationConfig.registryUrl;
+            stationId = st.stationId;
         }
         if (registryUrl.empty() || stationId.empty()) {
             res.status = 400;
@@ -821,12 +975,12 @@ void WebServer::run() {
     });
 
     // Pairing claim (exchange code for station token)
-    svr.Post("/api/pairing/claim", [&](const httplib::Request& req, httplib::Response& res) {
+    route(true, "/pairing/claim", [&](Station& st, const httplib::Request& req, httplib::Response& res) {
         if (!requireAuth(req, res)) return;
         std::string registryUrl;
         {
-            std::lock_guard<std::mutex> lock(stationMutex_);
-            registryUrl = stationConfig_.registryUrl;
+            std::lock_guard<std::mutex> lock(st.stationMutex);
+            registryUrl = st.stationConfig.registryUrl;
         }
         if (registryUrl.empty()) {
             res.status = 400;
@@ -884,13 +1038,13 @@ void WebServer::run() {
             : 0;
         if (!stationId.empty() && !token.empty()) {
             {
-                std::lock_guard<std::mutex> lock(stationMutex_);
-                stationId_ = stationId;
-                stationConfig_.id = stationId;
-                stationToken_ = token;
-                stationTokenExpiryMs_ = expiresAt;
-                writeCachedStationId(stationId);
-                writeCachedStationToken(token, expiresAt);
+                std::lock_guard<std::mutex> lock(st.stationMutex);
+                st.stationId = stationId;
+                st.stationConfig.id = stationId;
+                st.stationToken = token;
+                st.stationTokenExpiryMs = expiresAt;
+                writeCachedStationId(st.cacheDir, stationId);
+                writeCachedStationToken(st.cacheDir, token, expiresAt);
             }
         }
         std::stringstream reply;
@@ -939,7 +1093,34 @@ void WebServer::run() {
     svr.listen("0.0.0.0", port_);
 }
 
-void WebServer::loadStationConfig() {
+WebServer::Station* WebServer::findStation(const std::string& routeId) {
+    for (auto& station : stations_) {
+        if (station->routeId == routeId) return station.get();
+    }
+    return nullptr;
+}
+
+void WebServer::loadSecrets() {
+    bridgeApiKey_ = getEnvVar("KEEGAN_BRIDGE_KEY");
+    registryApiKey_ = getEnvVar("KEEGAN_REGISTRY_KEY");
+    broadcastSecret_ = getEnvVar("KEEGAN_BROADCAST_SECRET");
+    if (broadcastSecret_.empty()) {
+        broadcastSecret_ = bridgeApiKey_;
+    }
+    if (broadcastSecret_.empty()) {
+        broadcastSecret_ = "dev_secret";
+    }
+}
+
+void WebServer::loadCachedToken(Station& station) {
+    auto cachedToken = readCachedStationToken(station.cacheDir);
+    if (!cachedToken.token.empty()) {
+        station.stationToken = cachedToken.token;
+        station.stationTokenExpiryMs = cachedToken.expiresAtMs;
+    }
+}
+
+void WebServer::loadStationConfig(Station& station) {
     StationConfig cfg;
     auto raw = readTextFile("config/station.json");
     if (!raw.empty()) {
@@ -976,71 +1157,67 @@ void WebServer::loadStationConfig() {
         }
     }
 
+    station.cacheDir = "cache";
     if (cfg.id.empty()) {
-        cfg.id = readCachedStationId();
+        cfg.id = readCachedStationId(station.cacheDir);
     }
     if (cfg.id.empty()) {
         cfg.id = "st_local_" + randomHex(6);
-        writeCachedStationId(cfg.id);
-    }
-    stationConfig_ = cfg;
-    stationId_ = cfg.id;
-
-    bridgeApiKey_ = getEnvVar("KEEGAN_BRIDGE_KEY");
-    registryApiKey_ = getEnvVar("KEEGAN_REGISTRY_KEY");
-    broadcastSecret_ = getEnvVar("KEEGAN_BROADCAST_SECRET");
-    if (broadcastSecret_.empty()) {
-        broadcastSecret_ = bridgeApiKey_;
-    }
-    if (broadcastSecret_.empty()) {
-        broadcastSecret_ = "dev_secret";
+        writeCachedStationId(station.cacheDir, cfg.id);
     }
+    station.stationConfig = cfg;
+    station.stationId = cfg.id;
+    station.routeId = cfg.id;
 
-    auto cachedToken = readCachedStationToken();
-    if (!cachedToken.token.empty()) {
-        stationToken_ = cachedToken.token;
-        stationTokenExpiryMs_ = cachedToken.expiresAtMs;
-    }
+    loadCachedToken(station);
 }
 
 void WebServer::runRegistryClient() {
-    std::string registryUrl;
-    {
-        std::lock_guard<std::mutex> lock(stationMutex_);
-        registryUrl = stationConfig_.registryUrl;
+    // One client per station; stations without a registry are skipped.
+    std::vector<std::unique_ptr<httplib::Client>> clients;
+    for (auto& station : stations_) {
+        std::string registryUrl;
+        {
+            std::lock_guard<std::mutex> lock(station->stationMutex);
+            registryUrl = station->stationConfig.registryUrl;
+        }
+        if (registryUrl.empty()) {
+            util::logWarn("Registry: registryUrl not set for " + station->routeId + ", skipping registration");
+            clients.push_back(nullptr);
+            continue;
+        }
+        auto cli = std::make_unique<httplib::Client>(registryUrl.c_str());
+        cli->set_connection_timeout(2, 0);
+        cli->set_read_timeout(5, 0);
+        cli->set_write_timeout(5, 0);
+        clients.push_back(std::move(cli));
     }
-    if (registryUrl.empty()) {
-        util::logWarn("Registry: registryUrl not set, skipping registration");
+    if (std::none_of(clients.begin(), clients.end(), [](const auto& cli) { return cli != nullptr; })) {
         return;
     }
 
-    httplib::Client cli(registryUrl.c_str());
-    cli.set_connection_timeout(2, 0);
-    cli.set_read_timeout(5, 0);
-    cli.set_write_timeout(5, 0);
-
-    auto pushUpdate = [&]() {
-        auto state = engine_.snapshot();
+    auto pushUpdate = [&](Station& st, httplib::Client& cli) {
+        auto state = st.engine.snapshot();
         StationConfig cfg;
         {
-            std::lock_guard<std::mutex> lock(stationMutex_);
-            cfg = stationConfig_;
+            std::lock_guard<std::mutex> lock(st.stationMutex);
+            cfg = st.stationConfig;
         }
         bool broadcasting = false;
         std::string sessionId;
         {
-            std::lock_guard<std::mutex> lock(broadcastMutex_);
-            broadcasting = broadcasting_;
-            sessionId = broadcastSessionId_;
+            std::lock_guard<std::mutex> lock(st.broadcastMutex);
+            broadcasting = st.broadcasting;
+            sessionId = st.broadcastSessionId;
         }
 
-        std::string payload = stationPayloadJson(cfg, state, stationId_, broadcasting, sessionId);
+        std::string payload = stationPayloadJson(cfg, state, st.stationId, broadcasting, sessionId);
         httplib::Headers headers;
         bool tokenValid = false;
         {
-            std::lock_guard<std::mutex> lock(stationMutex_);
-            if (!stationToken_.empty() && stationTokenExpiryMs_ > nowMs()) {
-                headers.emplace("X-Station-Token", stationToken_);
+            std::lock_guard<std::mutex> lock(st.stationMutex);
+            if (!st.stationToken.empty() && st.stationTokenExpiryMs > nowMs()) {
+                headers.emplace("X-Station-Token", st.stationToken);
                 tokenValid = true;
             }
         }
@@ -1054,10 +1231,10 @@ void WebServer::runRegistryClient() {
         }
         if (res->status == 401) {
             util::logWarn("Registry: station token rejected, clearing");
-            std::lock_guard<std::mutex> lock(stationMutex_);
-            stationToken_.clear();
-            stationTokenExpiryMs_ = 0;
-            clearCachedStationToken();
+            std::lock_guard<std::mutex> lock(st.stationMutex);
+            st.stationToken.clear();
+            st.stationTokenExpiryMs = 0;
+            clearCachedStationToken(st.cacheDir);
         }
         if (res->status != 200) {
             util::logWarn("Registry: registry rejected update (status " + std::to_string(res->status) + ")");
@@ -1068,20 +1245,25 @@ void WebServer::runRegistryClient() {
             const auto& root = *parsed;
             if (root.has("id")) {
                 std::string id = root["id"].asString("");
-                if (!id.empty() && id != stationId_) {
-                    stationId_ = id;
-                    writeCachedStationId(id);
+                if (!id.empty() && id != st.stationId) {
+                    st.stationId = id;
+                    writeCachedStationId(st.cacheDir, id);
                     util::logInfo("Registry: assigned station id " + id);
                 }
             }
         }
     };
+    auto pushAll = [&]() {
+        for (size_t i = 0; i < stations_.size() && running_; ++i) {
+            if (clients[i]) pushUpdate(*stations_[i], *clients[i]);
+        }
+    };
 
-    pushUpdate();
+    pushAll();
     while (running_) {
         std::this_thread::sleep_for(std::chrono::seconds(15));
         if (!running_) break;
-        pushUpdate();
+        pushAll();
     }
 }
 
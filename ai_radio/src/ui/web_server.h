@@ -6,6 +6,7 @@
 #include <atomic>
 #include <mutex>
 #include <cstdint>
+#include <vector>
 #include "../audio/engine.h"
 #include "ws_server.h"
 
@@ -23,36 +24,59 @@ struct StationConfig {
 
 class WebServer {
 public:
+    // Single station: metadata from config/station.json (plus env overrides),
+    // routes under /api/...
     WebServer(audio::Engine& engine, int port = 3000);
+
+    // Station host: one front end for several engines. Station ids must be
+    // unique and contain no '.'. Routes are under /api/stations/<id>/...;
+    // the plain /api/... routes address the first station. Station ids and
+    // tokens are cached per station under cache/stations/<id>/.
+    struct HostedStation {
+        audio::Engine* engine = nullptr;
+        StationConfig config;
+    };
+    WebServer(std::vector<HostedStation> stations, int port = 3000);
     ~WebServer();
 
     bool start();
     void stop();
 
 private:
-    audio::Engine& engine_;
+    struct Station {
+        Station(audio::Engine& e) : engine(e) {}
+        audio::Engine& engine;
+        std::string routeId; // fixed at startup; the registry may reassign stationId
+        std::string cacheDir;
+        StationConfig stationConfig;
+        std::string stationId;
+        std::mutex stationMutex;
+        std::mutex broadcastMutex;
+        bool broadcasting = false;
+        uint64_t broadcastStartedMs = 0;
+        uint64_t broadcastUpdatedMs = 0;
+        std::string broadcastSessionId;
+        uint64_t broadcastTokenExpiryMs = 0;
+        std::string stationToken;
+        uint64_t stationTokenExpiryMs = 0;
+    };
+
     int port_;
+    bool hosted_;
     std::atomic<bool> running_;
     std::thread serverThread_;
     std::thread registryThread_;
-    StationConfig stationConfig_;
-    std::string stationId_;
+    std::vector<std::unique_ptr<Station>> stations_;
     std::unique_ptr<WsServer> wsServer_;
-    std::mutex stationMutex_;
-    std::mutex broadcastMutex_;
-    bool broadcasting_ = false;
-    uint64_t broadcastStartedMs_ = 0;
-    uint64_t broadcastUpdatedMs_ = 0;
-    std::string broadcastSessionId_;
-    uint64_t broadcastTokenExpiryMs_ = 0;
     std::string bridgeApiKey_;
     std::string registryApiKey_;
     std::string broadcastSecret_;
-    std::string stationToken_;
-    uint64_t stationTokenExpiryMs_ = 0;
     
     void run();
-    void loadStationConfig();
+    void loadSecrets();
+    void loadStationConfig(Station& station);
+    void loadCachedToken(Station& station);
+    Station* findStation(const std::string& routeId);
     void runRegistryClient();
 };
 
@@ -168,6 +168,38 @@ std::string sha1Base64(const std::string& input) {
     return base64Encode(digest.data(), digest.size());
 }
 
+// Text frame, unmasked. Empty payloads produce no frame.
+std::string makeFrame(const std::string& payload) {
+    std::string frame;
+    if (payload.empty()) return frame;
+    frame.reserve(payload.size() + 16);
+    frame.push_back(static_cast<char>(0x81));
+
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<char>(payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+        frame.push_back(static_cast<char>(126));
+        frame.push_back(static_cast<char>((payload.size() >> 8) & 0xFF));
+        frame.push_back(static_cast<char>(payload.size() & 0xFF));
+    } else {
+        frame.push_back(static_cast<char>(127));
+        for (int i = 7; i >= 0; --i) {
+            frame.push_back(static_cast<char>((payload.size() >> (i * 8)) & 0xFF));
+        }
+    }
+    frame.append(payload);
+    return frame;
+}
+
+// "/stations/<id>/events?..." -> "<id>"; anything else -> "".
+std::string channelFromPath(const std::string& path) {
+    const std::string prefix = "/stations/";
+    std::string clean = path.substr(0, path.find('?'));
+    if (clean.rfind(prefix, 0) != 0) return "";
+    auto end = clean.find('/', prefix.size());
+    return clean.substr(prefix.size(), end == std::string::npos ? std::string::npos : end - prefix.size());
+}
+
 } // namespace
 
 WsServer::WsServer(PayloadProvider provider, int port, std::string authToken)
@@ -202,6 +234,10 @@ void WsServer::stop() {
     running_ = false;
 
     if (listenSock_ != kInvalidSocket) {
+#ifndef _WIN32
+        // close() alone does not wake a thread blocked in accept() on Linux.
+        shutdown(listenSock_, SHUT_RDWR);
+#endif
         closeSocket(listenSock_);
         listenSock_ = kInvalidSocket;
     }
@@ -210,8 +246,8 @@ void WsServer::stop() {
     if (broadcastThread_.joinable()) broadcastThread_.join();
 
     std::lock_guard<std::mutex> lock(clientsMutex_);
-    for (auto sock : clients_) {
-        closeSocket(sock);
+    for (auto& client : clients_) {
+        closeSocket(client.sock);
     }
     clients_.clear();
 
@@ -270,13 +306,14 @@ void WsServer::acceptLoop() {
             continue;
         }
 
-        if (!handshake(clientSock)) {
+        std::string channel;
+        if (!handshake(clientSock, channel)) {
             closeSocket(clientSock);
             continue;
         }
 
         std::lock_guard<std::mutex> lock(clientsMutex_);
-        clients_.push_back(clientSock);
+        clients_.push_back({clientSock, std::move(channel)});
     }
 }
 
@@ -285,35 +322,35 @@ void WsServer::broadcastLoop() {
         std::this_thread::sleep_for(std::chrono::milliseconds(500));
         if (!running_) break;
 
-        std::string payload = payloadProvider_ ? payloadProvider_() : std::string();
-        if (payload.empty()) {
+        std::vector<std::string> channels;
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex_);
+            for (const auto& client : clients_) {
+                if (std::find(channels.begin(), channels.end(), client.channel) == channels.end()) {
+                    channels.push_back(client.channel);
+                }
+            }
+        }
+        if (channels.empty() || !payloadProvider_) {
             continue;
         }
 
-        // Build WS frame (text, unmasked).
-        std::string frame;
-        frame.reserve(payload.size() + 16);
-        frame.push_back(static_cast<char>(0x81));
-
-        if (payload.size() < 126) {
-            frame.push_back(static_cast<char>(payload.size()));
-        } else if (payload.size() <= 0xFFFF) {
-            frame.push_back(static_cast<char>(126));
-            frame.push_back(static_cast<char>((payload.size() >> 8) & 0xFF));
-            frame.push_back(static_cast<char>(payload.size() & 0xFF));
-        } else {
-            frame.push_back(static_cast<char>(127));
-            for (int i = 7; i >= 0; --i) {
-                frame.push_back(static_cast<char>((payload.size() >> (i * 8)) & 0xFF));
-            }
+        // One frame per subscribed channel, built outside the clients lock.
+        std::vector<std::string> frames;
+        frames.reserve(channels.size());
+        for (const auto& channel : channels) {
+            frames.push_back(makeFrame(payloadProvider_(channel)));
         }
-        frame.append(payload);
 
         std::lock_guard<std::mutex> lock(clientsMutex_);
-        clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [&](SocketHandle sock) {
-            int sent = send(sock, frame.data(), static_cast<int>(frame.size()), 0);
+        clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [&](const Client& client) {
+            auto it = std::find(channels.begin(), channels.end(), client.channel);
+            if (it == channels.end()) return false; // joined after the snapshot
+            const std::string& frame = frames[static_cast<size_t>(it - channels.begin())];
+            if (frame.empty()) return false;
+            int sent = send(client.sock, frame.data(), static_cast<int>(frame.size()), 0);
             if (sent <= 0) {
-                closeSocket(sock);
+                closeSocket(client.sock);
                 return true;
             }
             return false;
@@ -321,7 +358,7 @@ void WsServer::broadcastLoop() {
     }
 }
 
-bool WsServer::handshake(SocketHandle clientSock) {
+bool WsServer::handshake(SocketHandle clientSock, std::string& channel) {
     std::array<char, 2048> buffer{};
     int received = recv(clientSock, buffer.data(), static_cast<int>(buffer.size() - 1), 0);
     if (received <= 0) return false;
@@ -344,6 +381,8 @@ bool WsServer::handshake(SocketHandle clientSock) {
         }
     }
 
+    channel = channelFromPath(path);
+
     auto headerValue = [&](const std::string& key) -> std::string {
         std::string needle = key + ":";
         auto pos = request.find(needle);
@@ -413,7 +452,9 @@ bool WsServer::handshake(SocketHandle clientSock) {
 
 void WsServer::removeClient(SocketHandle clientSock) {
     std::lock_guard<std::mutex> lock(clientsMutex_);
-    clients_.erase(std::remove(clients_.begin(), clients_.end(), clientSock), clients_.end());
+    clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [&](const Client& client) {
+        return client.sock == clientSock;
+    }), clients_.end());
     closeSocket(clientSock);
 }
 
@@ -22,7 +22,9 @@ namespace uisrv {
 
 class WsServer {
 public:
-    using PayloadProvider = std::function<std::string()>;
+    // Called with the channel a client subscribed to: the station id for
+    // /stations/<id>/events, or an empty string for any other path.
+    using PayloadProvider = std::function<std::string(const std::string& channel)>;
 
     WsServer(PayloadProvider provider, int port = 3001, std::string authToken = {});
     ~WsServer();
@@ -50,11 +52,15 @@ private:
 
     SocketHandle listenSock_ = kInvalidSocket;
     std::mutex clientsMutex_;
-    std::vector<SocketHandle> clients_;
+    struct Client {
+        SocketHandle sock;
+        std::string channel;
+    };
+    std::vector<Client> clients_;
 
     void acceptLoop();
     void broadcastLoop();
-    bool handshake(SocketHandle clientSock);
+    bool handshake(SocketHandle clientSock, std::string& channel);
     void removeClient(SocketHandle clientSock);
     void closeSocket(SocketHandle sock);
 };
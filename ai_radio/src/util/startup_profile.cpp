@@ -0,0 +1,93 @@
+#include "startup_profile.h"
+#include "logger.h"
+#include "telemetry.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+
+namespace util {
+
+namespace {
+int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string formatMs(double ms) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f", ms);
+    return buf;
+}
+} // namespace
+
+StartupProfile::StartupProfile() : startNs_(steadyNs()) {}
+
+StartupProfile& StartupProfile::instance() {
+    static StartupProfile profile;
+    return profile;
+}
+
+double StartupProfile::nowMs() const { return static_cast<double>(steadyNs() - startNs_) / 1e6; }
+
+void StartupProfile::record(const std::string& name, double startMs, double endMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& phase : phases_) {
+        if (phase.name == name) return;
+    }
+    phases_.push_back(Phase{name, startMs, std::max(0.0, endMs - startMs)});
+}
+
+void StartupProfile::markFirstAudio() {
+    if (firstAudioNs_.load(std::memory_order_relaxed) >= 0) return;
+    int64_t expected = -1;
+    firstAudioNs_.compare_exchange_strong(expected, steadyNs() - startNs_, std::memory_order_relaxed);
+}
+
+double StartupProfile::firstAudioMs() const {
+    const int64_t ns = firstAudioNs_.load(std::memory_order_relaxed);
+    return ns < 0 ? -1.0 : static_cast<double>(ns) / 1e6;
+}
+
+std::vector<StartupProfile::Phase> StartupProfile::phases() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return phases_;
+}
+
+std::string StartupProfile::json() const {
+    const auto list = phases();
+    const double firstAudio = firstAudioMs();
+    std::ostringstream ss;
+    ss << "{\"uptimeMs\":" << formatMs(nowMs()) << ",\"firstAudioMs\":";
+    if (firstAudio < 0) {
+        ss << "null";
+    } else {
+        ss << formatMs(firstAudio);
+    }
+    ss << ",\"phases\":[";
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (i > 0) ss << ",";
+        ss << "{\"name\":\"" << list[i].name << "\",\"startMs\":" << formatMs(list[i].startMs)
+           << ",\"durationMs\":" << formatMs(list[i].durationMs) << "}";
+    }
+    ss << "]}";
+    return ss.str();
+}
+
+void StartupProfile::reportOnce() {
+    const double firstAudio = firstAudioMs();
+    if (firstAudio < 0 || reported_.exchange(true)) return;
+
+    std::string line = "Startup: first audio after " + formatMs(firstAudio) + " ms";
+    std::vector<std::pair<std::string, std::string>> fields{{"first_audio_ms", formatMs(firstAudio)}};
+    const auto list = phases();
+    for (size_t i = 0; i < list.size(); ++i) {
+        line += (i == 0 ? " (" : ", ") + list[i].name + " " + formatMs(list[i].durationMs) + " ms";
+        fields.emplace_back(list[i].name + "_ms", formatMs(list[i].durationMs));
+    }
+    if (!list.empty()) line += ")";
+    logInfo(line);
+    Telemetry::instance().record("startup", fields);
+}
+
+} // namespace util
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace util {
+
+// Wall-clock breakdown of process startup, measured from the first call to
+// instance() (main makes it first thing): named phases, which may overlap
+// when they run in the background, and the time to the first rendered
+// audio block. Only the first phase of each name is kept, so per-station
+// or per-mood repeats do not overwrite the startup figure.
+//
+// Thread-safe. The audio thread only calls markFirstAudio(), which never
+// locks or allocates.
+class StartupProfile {
+public:
+    struct Phase {
+        std::string name;
+        double startMs = 0.0;
+        double durationMs = 0.0;
+    };
+
+    static StartupProfile& instance();
+
+    // Milliseconds since startup.
+    double nowMs() const;
+    // Records phase name as [startMs, endMs); later phases of the same name
+    // are ignored.
+    void record(const std::string& name, double startMs, double endMs);
+
+    // Audio thread: the first call fixes the time to first audio.
+    void markFirstAudio();
+    // Milliseconds from startup to the first audio block, or < 0 before it.
+    double firstAudioMs() const;
+
+    std::vector<Phase> phases() const;
+    std::string json() const;
+
+    // Once first audio has happened: logs the breakdown and records it as a
+    // telemetry event, the first time only. Call from a control thread.
+    void reportOnce();
+
+private:
+    StartupProfile();
+
+    const int64_t startNs_;
+    std::atomic<int64_t> firstAudioNs_{-1};
+    std::atomic<bool> reported_{false};
+    mutable std::mutex mutex_;
+    std::vector<Phase> phases_;
+};
+
+} // namespace util
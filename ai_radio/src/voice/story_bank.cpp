@@ -1,6 +1,10 @@
 #include "story_bank.h"
+#include "../audio/asset_pack.h"
+#include "../audio/stem_loader.h"
 #include "../../vendor/vjson/vjson.h"
 #include "../util/logger.h"
+#include "../util/startup_profile.h"
+#include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
@@ -12,18 +16,58 @@ StoryBank::StoryBank() {
     rng_ = std::mt19937(rd());
 }
 
+StoryBank::~StoryBank() {
+    stopPreload_ = true;
+    if (preload_.joinable()) preload_.join();
+}
+
+void StoryBank::preloadAudio() {
+    stopPreload_ = true;
+    if (preload_.joinable()) preload_.join();
+    stopPreload_ = false;
+
+    std::vector<std::string> files;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& s : stories_) {
+            if (std::find(files.begin(), files.end(), s->audioFile) == files.end()) files.push_back(s->audioFile);
+        }
+    }
+    if (files.empty()) return;
+
+    // Stories only warm the cache: the picked story's audio still loads
+    // (now a hit) under mutex_, and unpicked clips stay evictable.
+    preload_ = std::thread([this, files = std::move(files), rate = outputRate_] {
+        auto& profile = util::StartupProfile::instance();
+        const double startMs = profile.nowMs();
+        std::atomic<size_t> loaded{0};
+        audio::parallelFor(files.size(), [&](size_t i) {
+            if (stopPreload_) return;
+            if (audio::SampleCache::instance().load(files[i], rate)) ++loaded;
+        });
+        if (stopPreload_) return;
+        const double endMs = profile.nowMs();
+        profile.record("background_stories", startMs, endMs);
+        util::logInfo("StoryBank: Preloaded " + std::to_string(loaded.load()) + " of " + std::to_string(files.size()) +
+                      " story clips in " + std::to_string(static_cast<int>(endMs - startMs)) + " ms");
+    });
+}
+
 bool StoryBank::loadFromFile(const std::string& path) {
     std::lock_guard<std::mutex> lock(mutex_);
     stories_.clear();
 
-    std::ifstream f(path);
-    if (!f.good()) {
-        util::logWarn("StoryBank: Config not found: " + path);
-        return false;
+    std::string data;
+    if (!audio::AssetPack::findText(path, data)) {
+        std::ifstream f(path);
+        if (!f.good()) {
+            util::logWarn("StoryBank: Config not found: " + path);
+            return false;
+        }
+        std::stringstream ss;
+        ss << f.rdbuf();
+        data = ss.str();
     }
-    std::stringstream ss;
-    ss << f.rdbuf();
-    std::string data = ss.str();
 
     auto result = vjson::parse(data);
     if (!result || !result->isArray()) {
@@ -42,11 +86,11 @@ bool StoryBank::loadFromFile(const std::string& path) {
         s->moodId = val["mood"].asString("any");
         
         if (!s->text.empty() && !s->audioFile.empty()) {
-            if (s->player.load(s->audioFile)) {
-                s->player.setLooping(false); 
+            std::error_code ec;
+            if (audio::AssetPack::findMounted(s->audioFile) || std::filesystem::exists(s->audioFile, ec)) {
                 stories_.push_back(s);
             } else {
-                util::logWarn("StoryBank: Failed to load audio for story " + s->id);
+                util::logWarn("StoryBank: Missing audio for story " + s->id);
             }
         }
     }
@@ -55,7 +99,8 @@ bool StoryBank::loadFromFile(const std::string& path) {
     return true;
 }
 
-std::shared_ptr<Story> StoryBank::pickStory(const std::string& currentMoodId, float currentTime, float globalCooldown) {
+std::shared_ptr<Story> StoryBank::pickStory(const std::string& currentMoodId, float currentTime, float globalCooldown,
+                                            audio::SampleRef& audio) {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<std::shared_ptr<Story>> candidates;
 
@@ -69,11 +114,17 @@ std::shared_ptr<Story> StoryBank::pickStory(const std::string& currentMoodId, fl
         candidates.push_back(s);
     }
 
-    if (candidates.empty()) return nullptr;
-
-    // Pick random
-    std::uniform_int_distribution<size_t> dist(0, candidates.size() - 1);
-    return candidates[dist(rng_)];
+    // Pick random; a failed load removes the candidate and picks again.
+    while (!candidates.empty()) {
+        std::uniform_int_distribution<size_t> dist(0, candidates.size() - 1);
+        const size_t index = dist(rng_);
+        auto story = candidates[index];
+        audio = audio::SampleCache::instance().load(story->audioFile, outputRate_);
+        if (audio) return story;
+        util::logWarn("StoryBank: Failed to load audio for story " + story->id);
+        candidates.erase(candidates.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+    return nullptr;
 }
 
 void StoryBank::markPlayed(std::shared_ptr<Story> story, float currentTime) {
@@ -5,8 +5,10 @@
 #include <random>
 #include <optional>
 #include <mutex>
+#include <atomic>
 #include <memory>
-#include "../audio/stem_player.h"
+#include <thread>
+#include "../audio/sample_cache.h"
 
 namespace voice {
 
@@ -16,9 +18,6 @@ struct Story {
     std::string audioFile;
     std::string moodId;
     
-    // Audio data (pre-loaded)
-    audio::StemPlayer player;
-    
     // Runtime state
     float lastPlayedTime = -9999.0f; 
 };
@@ -26,12 +25,26 @@ struct Story {
 class StoryBank {
 public:
     StoryBank();
+    ~StoryBank();
 
-    // Load stories from a JSON config file and pre-load audio.
+    // Load stories from a JSON config file (from a mounted AssetPack if one
+    // has it). Audio is decoded lazily, when a story is picked.
     bool loadFromFile(const std::string& path);
 
-    // Pick a valid story for the current mood and time.
-    std::shared_ptr<Story> pickStory(const std::string& currentMoodId, float currentTime, float globalCooldown);
+    // Pick a valid story for the current mood and time and load its audio
+    // through the sample cache into `audio`. Stories whose audio fails to
+    // load are skipped. The caller owns the reference; the story itself
+    // holds no playback state, so re-picking one that is still playing is
+    // safe.
+    std::shared_ptr<Story> pickStory(const std::string& currentMoodId, float currentTime, float globalCooldown,
+                                     audio::SampleRef& audio);
+
+    // Rate story audio is resampled to when loaded (0 keeps the file's).
+    void setOutputRate(uint32_t rate) { outputRate_ = rate; }
+
+    // Decodes every loaded story's audio into the SampleCache on a
+    // background thread, so picking a story later does no I/O.
+    void preloadAudio();
 
     // Mark a story as played right now.
     void markPlayed(std::shared_ptr<Story> story, float currentTime);
@@ -44,7 +57,10 @@ public:
 private:
     std::vector<std::shared_ptr<Story>> stories_;
     std::mt19937 rng_;
+    uint32_t outputRate_ = 0;
     mutable std::mutex mutex_; 
+    std::atomic<bool> stopPreload_{false};
+    std::thread preload_;
 };
 
 } // namespace voice